@@ -21,6 +21,8 @@ static const char cmdMonitor[] = "monitor";
 #define TYPE_CHAR_INTEGER ('i')
 #define TYPE_CHAR_FLOATING_POINT ('f')
 #define TYPE_CHAR_STRING ('s')
+#define TYPE_CHAR_FLOATING_POINT_ARRAY ('F')
+#define TYPE_CHAR_INTEGER_ARRAY ('I')
 
 struct Value
 {
@@ -31,7 +33,10 @@ struct Value
         int32_t i;
         double f;
         const char* s;
+        double fa[DATAROUTER_ARRAY_MAX_LEN];
+        int32_t ia[DATAROUTER_ARRAY_MAX_LEN];
     } data;
+    size_t count; ///< Number of elements of an array value
 
 };
 
@@ -62,6 +67,8 @@ SPECIFYING VALUES:\n\
         Integer - 'i:19' or 'i:-81'\n\
         Floating Point - 'f:17.123' or 'f:-3.14159'\n\
         String - 's:some string'\n\
+        Floating Point Array - 'F:0.01,-0.02,9.81'\n\
+        Integer Array - 'I:1,2,3'\n\
 ";
 
 //--------------------------------------------------------------------------------------------------
@@ -194,6 +201,46 @@ static bool ParseValue(
             break;
         }
 
+        case TYPE_CHAR_FLOATING_POINT_ARRAY:
+        case TYPE_CHAR_INTEGER_ARRAY:
+        {
+            value->type = (valueStr[0] == TYPE_CHAR_FLOATING_POINT_ARRAY) ?
+                DATAROUTER_FLOAT_ARRAY : DATAROUTER_INTEGER_ARRAY;
+            value->count = 0;
+            const char* elem = valuePart;
+            while (true)
+            {
+                if (value->count == DATAROUTER_ARRAY_MAX_LEN || isspace(elem[0]))
+                {
+                    return false;
+                }
+                char* end;
+                if (value->type == DATAROUTER_FLOAT_ARRAY)
+                {
+                    value->data.fa[value->count] = strtod(elem, &end);
+                }
+                else
+                {
+                    value->data.ia[value->count] = strtol(elem, &end, 10);
+                }
+                if (end == elem)
+                {
+                    return false;
+                }
+                value->count++;
+                if (*end == '\0')
+                {
+                    break;
+                }
+                if (*end != ',')
+                {
+                    return false;
+                }
+                elem = end + 1;
+            }
+            break;
+        }
+
         default:
         {
             return false;
@@ -321,6 +368,42 @@ static void GetAndPrint(
             break;
         }
 
+        case TYPE_CHAR_FLOATING_POINT_ARRAY:
+        case TYPE_CHAR_INTEGER_ARRAY:
+        {
+            double fa[DATAROUTER_ARRAY_MAX_LEN];
+            int32_t ia[DATAROUTER_ARRAY_MAX_LEN];
+            size_t count = DATAROUTER_ARRAY_MAX_LEN;
+            if (typeStr[0] == TYPE_CHAR_FLOATING_POINT_ARRAY)
+            {
+                dataRouter_ReadFloatArray(key, fa, &count, &timestamp);
+            }
+            else
+            {
+                dataRouter_ReadIntegerArray(key, ia, &count, &timestamp);
+            }
+            // Leave room for the closing bracket
+            char aStr[DATAROUTER_ARRAY_MAX_LEN * 32];
+            size_t used = sprintf(aStr, "[");
+            for (size_t i = 0; i < count && used < sizeof(aStr) - 1; i++)
+            {
+                if (typeStr[0] == TYPE_CHAR_FLOATING_POINT_ARRAY)
+                {
+                    used += snprintf(
+                        &aStr[used], sizeof(aStr) - 1 - used, "%s%f", i ? "," : "", fa[i]);
+                }
+                else
+                {
+                    used += snprintf(
+                        &aStr[used], sizeof(aStr) - 1 - used, "%s%d", i ? "," : "", ia[i]);
+                }
+            }
+            used = (used < sizeof(aStr) - 1) ? used : sizeof(aStr) - 2;
+            sprintf(&aStr[used], "]");
+            PrintValue(key, aStr, timestamp);
+            break;
+        }
+
         default:
         {
             PrintUsage(stderr, "Invalid type specified\n", EXIT_FAILURE);
@@ -377,6 +460,14 @@ static void performSet(
     {
         dataRouter_WriteString(key, v.data.s, now);
     }
+    else if (v.type == DATAROUTER_FLOAT_ARRAY)
+    {
+        dataRouter_WriteFloatArray(key, v.data.fa, v.count, now);
+    }
+    else if (v.type == DATAROUTER_INTEGER_ARRAY)
+    {
+        dataRouter_WriteIntegerArray(key, v.data.ia, v.count, now);
+    }
 
     //exit(EXIT_SUCCESS); // See comment at end of COMPONENT_INIT
 }
@@ -412,6 +503,14 @@ static void TypeToTypeStr(
             typeStr[0] = TYPE_CHAR_STRING;
             break;
 
+        case DATAROUTER_FLOAT_ARRAY:
+            typeStr[0] = TYPE_CHAR_FLOATING_POINT_ARRAY;
+            break;
+
+        case DATAROUTER_INTEGER_ARRAY:
+            typeStr[0] = TYPE_CHAR_INTEGER_ARRAY;
+            break;
+
         default:
             typeStr[0] = '\0';
             break;
@@ -446,7 +545,6 @@ static void performMonitor(
     dataRouter_AddDataUpdateHandler(key, MonitorUpdateHandler, NULL);
 }
 
-
 COMPONENT_INIT
 {
 
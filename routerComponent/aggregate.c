@@ -0,0 +1,228 @@
+/**
+ * @file
+ *
+ * Each aggregated key has its own interval timer.  The values written to the key are folded into
+ * the statistics of the interval, which are handed to the aggregate handler when the timer expires
+ * and then reset, so only one record per key and interval is pushed upstream.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include <math.h>
+
+#include "aggregate.h"
+
+static void swi_mangoh_data_router_aggregate_end(swi_mangoh_data_router_dbItem_t*);
+static void swi_mangoh_data_router_aggregate_timer(le_timer_Ref_t);
+
+// Hands the statistics of the interval to the handler and resets them
+static void swi_mangoh_data_router_aggregate_end
+(
+    swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    swi_mangoh_data_router_aggregate_t* aggregate = dbItem->aggregate;
+
+    if (!aggregate->count)
+    {
+        goto cleanup;
+    }
+
+    aggregate->handler(dbItem, aggregate);
+    aggregate->numIntervals++;
+    aggregate->count = 0;
+    aggregate->mean = 0;
+    aggregate->m2 = 0;
+
+cleanup:
+    return;
+}
+
+static void swi_mangoh_data_router_aggregate_timer
+(
+    le_timer_Ref_t timerRef
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        (swi_mangoh_data_router_dbItem_t*)le_timer_GetContextPtr(timerRef);
+
+    LE_ASSERT(dbItem);
+    LE_ASSERT(dbItem->aggregate);
+    swi_mangoh_data_router_aggregate_end(dbItem);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Aggregate the values of a key over intervals of intervalSec seconds, or push every value again
+ * when intervalSec is 0.  The statistics of the current interval are handled right away.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t swi_mangoh_data_router_aggregate_set
+(
+    swi_mangoh_data_router_dbItem_t* dbItem,
+    uint32_t intervalSec,
+    bool variance,
+    swi_mangoh_data_router_aggregateHandler_t handler
+)
+{
+    le_result_t res = LE_OK;
+
+    LE_ASSERT(dbItem);
+    LE_ASSERT(handler);
+
+    if (intervalSec > SWI_MANGOH_DATA_ROUTER_AGGREGATE_INTERVAL_MAX_SEC)
+    {
+        LE_ERROR("ERROR key('%s') interval(%u) too long", dbItem->key, intervalSec);
+        res = LE_OUT_OF_RANGE;
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_aggregate_t* aggregate = dbItem->aggregate;
+    if (aggregate)
+    {
+        swi_mangoh_data_router_aggregate_end(dbItem);
+        le_timer_Stop(aggregate->timer);
+    }
+
+    if (!intervalSec)
+    {
+        if (aggregate)
+        {
+            le_timer_Delete(aggregate->timer);
+            free(aggregate);
+            dbItem->aggregate = NULL;
+        }
+
+        goto cleanup;
+    }
+
+    if (!aggregate)
+    {
+        aggregate = calloc(1, sizeof(swi_mangoh_data_router_aggregate_t));
+        if (!aggregate)
+        {
+            LE_ERROR("ERROR calloc() failed");
+            res = LE_NO_MEMORY;
+            goto cleanup;
+        }
+
+        aggregate->timer = le_timer_Create("DataRouterAggregate");
+        le_timer_SetRepeat(aggregate->timer, 0);
+        le_timer_SetContextPtr(aggregate->timer, dbItem);
+        le_timer_SetHandler(aggregate->timer, swi_mangoh_data_router_aggregate_timer);
+        dbItem->aggregate = aggregate;
+    }
+
+    aggregate->handler = handler;
+    aggregate->variance = variance;
+    le_timer_SetMsInterval(aggregate->timer, intervalSec * 1000);
+    le_timer_Start(aggregate->timer);
+    LE_INFO("key('%s') aggregated every %u s", dbItem->key, intervalSec);
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fold a value into the statistics of the interval, NaN values are left out
+ */
+//--------------------------------------------------------------------------------------------------
+void swi_mangoh_data_router_aggregate_add
+(
+    swi_mangoh_data_router_aggregate_t* aggregate,
+    double value,
+    uint32_t timestamp
+)
+{
+    LE_ASSERT(aggregate);
+
+    if (isnan(value))
+    {
+        goto cleanup;
+    }
+
+    if (!aggregate->count)
+    {
+        aggregate->min = value;
+        aggregate->max = value;
+        aggregate->start = timestamp;
+    }
+    else if (value < aggregate->min)
+    {
+        aggregate->min = value;
+    }
+    else if (value > aggregate->max)
+    {
+        aggregate->max = value;
+    }
+
+    aggregate->count++;
+    double delta = value - aggregate->mean;
+    aggregate->mean += delta / aggregate->count;
+    aggregate->m2 += delta * (value - aggregate->mean);
+    aggregate->last = value;
+    aggregate->end = timestamp;
+    aggregate->numValues++;
+
+cleanup:
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fold a boolean, integer or float value into the statistics of the interval, returns false for
+ * the other types which are not aggregated
+ */
+//--------------------------------------------------------------------------------------------------
+bool swi_mangoh_data_router_aggregate_addData
+(
+    swi_mangoh_data_router_aggregate_t* aggregate,
+    const swi_mangoh_data_router_data_t* data
+)
+{
+    bool added = true;
+
+    LE_ASSERT(aggregate);
+    LE_ASSERT(data);
+
+    switch (data->type)
+    {
+        case DATAROUTER_BOOLEAN:
+            swi_mangoh_data_router_aggregate_add(aggregate, data->bValue, data->timestamp);
+            break;
+
+        case DATAROUTER_INTEGER:
+            swi_mangoh_data_router_aggregate_add(aggregate, data->iValue, data->timestamp);
+            break;
+
+        case DATAROUTER_FLOAT:
+            swi_mangoh_data_router_aggregate_add(aggregate, data->fValue, data->timestamp);
+            break;
+
+        default:
+            added = false;
+            break;
+    }
+
+    return added;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Population variance of the values of the interval
+ */
+//--------------------------------------------------------------------------------------------------
+double swi_mangoh_data_router_aggregate_getVariance
+(
+    const swi_mangoh_data_router_aggregate_t* aggregate
+)
+{
+    LE_ASSERT(aggregate);
+    return aggregate->count ? aggregate->m2 / aggregate->count : 0;
+}
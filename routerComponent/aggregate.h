@@ -0,0 +1,68 @@
+/*
+ * @file aggregate.h
+ *
+ * Data router module.
+ *
+ * This module aggregates the updates of the mangOH data router keys into per interval statistics
+ * pushed upstream instead of the raw values.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_AGGREGATE_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_AGGREGATE_INCLUDE_GUARD
+
+#define SWI_MANGOH_DATA_ROUTER_AGGREGATE_INTERVAL_MAX_SEC 86400
+
+struct _swi_mangoh_data_router_aggregate_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router aggregate handler, called at the end of each interval holding values
+ */
+//-------------------------------------------------------------------------------------------------
+typedef void (*swi_mangoh_data_router_aggregateHandler_t)(
+    const swi_mangoh_data_router_dbItem_t*,
+    const struct _swi_mangoh_data_router_aggregate_t*);
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router aggregation of a key.  The statistics of the interval are updated in constant time
+ * by each value, the mean and variance with Welford's method, and are reset once handled.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_aggregate_t
+{
+    swi_mangoh_data_router_aggregateHandler_t handler; ///< Interval handler
+    le_timer_Ref_t timer;                 ///< Interval timer
+    bool variance;                        ///< Variance pushed with the statistics
+    uint32_t count;                       ///< Values in the interval
+    double min;                           ///< Smallest value
+    double max;                           ///< Largest value
+    double mean;                          ///< Mean value
+    double m2;                            ///< Sum of the squared differences to the mean
+    double last;                          ///< Last value
+    uint32_t start;                       ///< Timestamp of the first value
+    uint32_t end;                         ///< Timestamp of the last value
+    uint64_t numValues;                   ///< Values aggregated
+    uint32_t numIntervals;                ///< Intervals handled
+} swi_mangoh_data_router_aggregate_t;
+
+le_result_t swi_mangoh_data_router_aggregate_set(
+    swi_mangoh_data_router_dbItem_t*,
+    uint32_t,
+    bool,
+    swi_mangoh_data_router_aggregateHandler_t);
+void swi_mangoh_data_router_aggregate_add(swi_mangoh_data_router_aggregate_t*, double, uint32_t);
+bool swi_mangoh_data_router_aggregate_addData(
+    swi_mangoh_data_router_aggregate_t*,
+    const swi_mangoh_data_router_data_t*);
+double swi_mangoh_data_router_aggregate_getVariance(const swi_mangoh_data_router_aggregate_t*);
+
+#endif
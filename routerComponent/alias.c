@@ -0,0 +1,195 @@
+/**
+ * @file
+ *
+ * Keys are long hierarchical strings sent in full with every push.  The dictionary gives each
+ * pushed key a short numeric alias, announced with the first push of the key on each connection
+ * and used instead of the key afterwards.  The server forgets the aliases when the connection is
+ * lost, so a reconnect starts a new epoch and every alias is announced again on its next push.
+ *
+ * Aliases are never reassigned during a session, keys pushed once the dictionary is full are sent
+ * in full.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include "alias.h"
+
+static uint32_t* swi_mangoh_data_router_alias_find(swi_mangoh_data_router_alias_t*, const char*);
+
+// Returns the key slot, holding 0 when the key has no alias
+static uint32_t* swi_mangoh_data_router_alias_find
+(
+    swi_mangoh_data_router_alias_t* alias,
+    const char* key
+)
+{
+    uint32_t mask = alias->indexSize - 1;
+    uint32_t slot = le_hashmap_HashString(key) & mask;
+
+    while (alias->index[slot] && strcmp(alias->entries[alias->index[slot] - 1].key, key))
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return &alias->index[slot];
+}
+
+le_result_t swi_mangoh_data_router_alias_init
+(
+    swi_mangoh_data_router_alias_t* alias,
+    uint32_t maxAliases
+)
+{
+    le_result_t res = LE_OK;
+
+    LE_ASSERT(alias);
+
+    memset(alias, 0, sizeof(swi_mangoh_data_router_alias_t));
+    if (!maxAliases)
+    {
+        goto cleanup;
+    }
+
+    // At most half full, so that the probe sequences stay short
+    alias->indexSize = 1;
+    while (alias->indexSize < 2 * maxAliases)
+    {
+        alias->indexSize <<= 1;
+    }
+
+    alias->entries = calloc(maxAliases, sizeof(swi_mangoh_data_router_aliasEntry_t));
+    alias->index = calloc(alias->indexSize, sizeof(uint32_t));
+    if (!alias->entries || !alias->index)
+    {
+        LE_ERROR("ERROR calloc() failed");
+        swi_mangoh_data_router_alias_destroy(alias);
+        res = LE_NO_MEMORY;
+        goto cleanup;
+    }
+
+    alias->maxAliases = maxAliases;
+    alias->epoch = 1;
+
+cleanup:
+    return res;
+}
+
+// Called when connected, the aliases announced on the previous connections are unknown to the
+// server
+void swi_mangoh_data_router_alias_reset
+(
+    swi_mangoh_data_router_alias_t* alias
+)
+{
+    LE_ASSERT(alias);
+
+    if (alias->maxAliases)
+    {
+        alias->epoch++;
+    }
+}
+
+// Returns the alias, or NULL when the key is sent in full
+swi_mangoh_data_router_aliasEntry_t* swi_mangoh_data_router_alias_encode
+(
+    swi_mangoh_data_router_alias_t* alias,
+    const char* key,
+    char* aliasedKey,
+    size_t len
+)
+{
+    swi_mangoh_data_router_aliasEntry_t* entry = NULL;
+
+    LE_ASSERT(alias);
+    LE_ASSERT(key);
+    LE_ASSERT(aliasedKey);
+
+    // Keys starting with the prefix would read as aliases
+    if (!alias->maxAliases || (key[0] == SWI_MANGOH_DATA_ROUTER_ALIAS_PREFIX))
+    {
+        goto cleanup;
+    }
+
+    uint32_t* slot = swi_mangoh_data_router_alias_find(alias, key);
+    if (*slot)
+    {
+        entry = &alias->entries[*slot - 1];
+    }
+    else if (alias->numAliases < alias->maxAliases)
+    {
+        entry = &alias->entries[alias->numAliases++];
+        strncpy(entry->key, key, sizeof(entry->key) - 1);
+        *slot = alias->numAliases;
+    }
+    else
+    {
+        goto cleanup;
+    }
+
+    uint32_t index = entry - alias->entries;
+    if (entry->epoch == alias->epoch)
+    {
+        snprintf(aliasedKey, len, "%c%u", SWI_MANGOH_DATA_ROUTER_ALIAS_PREFIX, index);
+    }
+    else
+    {
+        snprintf(
+            aliasedKey,
+            len,
+            "%c%u%c%s",
+            SWI_MANGOH_DATA_ROUTER_ALIAS_PREFIX,
+            index,
+            SWI_MANGOH_DATA_ROUTER_ALIAS_SEPARATOR,
+            key);
+    }
+
+cleanup:
+    return entry;
+}
+
+// Called once the aliased key is sent, the alias is announced on this connection
+void swi_mangoh_data_router_alias_sent
+(
+    swi_mangoh_data_router_alias_t* alias,
+    swi_mangoh_data_router_aliasEntry_t* entry,
+    const char* aliasedKey
+)
+{
+    LE_ASSERT(alias);
+    LE_ASSERT(entry);
+    LE_ASSERT(aliasedKey);
+
+    if (entry->epoch != alias->epoch)
+    {
+        entry->epoch = alias->epoch;
+        alias->numAnnounced++;
+    }
+
+    alias->bytesSaved += (int64_t)strlen(entry->key) - (int64_t)strlen(aliasedKey);
+}
+
+void swi_mangoh_data_router_alias_destroy
+(
+    swi_mangoh_data_router_alias_t* alias
+)
+{
+    LE_ASSERT(alias);
+
+    if (alias->numAnnounced)
+    {
+        LE_INFO(
+            "aliases(%u), announced(%u), key bytes saved(%lld)",
+            alias->numAliases,
+            alias->numAnnounced,
+            (long long)alias->bytesSaved);
+    }
+
+    free(alias->entries);
+    free(alias->index);
+    memset(alias, 0, sizeof(swi_mangoh_data_router_alias_t));
+}
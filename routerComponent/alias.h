@@ -0,0 +1,70 @@
+/*
+ * @file alias.h
+ *
+ * Data router module.
+ *
+ * This module is the key alias dictionary of the mangOH data router pushes.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_ALIAS_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_ALIAS_INCLUDE_GUARD
+
+#define SWI_MANGOH_DATA_ROUTER_ALIAS_PREFIX '@'
+#define SWI_MANGOH_DATA_ROUTER_ALIAS_SEPARATOR '='
+
+// Aliased key length: prefix, alias, separator, key and terminating '\0'
+#define SWI_MANGOH_DATA_ROUTER_ALIAS_KEY_MAX_LEN (SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN + 16)
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router key alias
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_aliasEntry_t
+{
+    char key[SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN];  ///< Key
+    uint32_t epoch;                                ///< Connection the alias was announced on,
+                                                   ///  0 when never announced
+} swi_mangoh_data_router_aliasEntry_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router key alias dictionary.  The alias of a key is its entry index, announced on the first
+ * send of each connection as "@<alias>=<key>" and referenced as "@<alias>" afterwards.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_alias_t
+{
+    swi_mangoh_data_router_aliasEntry_t* entries;  ///< Aliases
+    uint32_t maxAliases;                           ///< Maximum number of aliases
+    uint32_t numAliases;                           ///< Number of aliases
+    uint32_t* index;                               ///< Aliased keys, open addressing table of
+                                                   ///  entry + 1
+    uint32_t indexSize;                            ///< Aliased keys table size, power of 2
+    uint32_t epoch;                                ///< Current connection
+    uint32_t numAnnounced;                         ///< Aliases announced
+    int64_t bytesSaved;                            ///< Key bytes saved, announcements included
+} swi_mangoh_data_router_alias_t;
+
+le_result_t swi_mangoh_data_router_alias_init(swi_mangoh_data_router_alias_t*, uint32_t);
+void swi_mangoh_data_router_alias_reset(swi_mangoh_data_router_alias_t*);
+swi_mangoh_data_router_aliasEntry_t* swi_mangoh_data_router_alias_encode(
+    swi_mangoh_data_router_alias_t*,
+    const char*,
+    char*,
+    size_t);
+void swi_mangoh_data_router_alias_sent(
+    swi_mangoh_data_router_alias_t*,
+    swi_mangoh_data_router_aliasEntry_t*,
+    const char*);
+void swi_mangoh_data_router_alias_destroy(swi_mangoh_data_router_alias_t*);
+
+#endif
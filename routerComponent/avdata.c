@@ -0,0 +1,492 @@
+/**
+ * @file
+ *
+ * The avdata transport pushes the updates to AirVantage through le_avdata timeseries records
+ * instead of one MQTT message per value.  Updates are recorded with their timestamp and the
+ * record is pushed once it reaches the push bytes, on the push timer, or when le_avdata reports
+ * it full.  Until the AirVantage session is started the updates wait in a queue with the same
+ * size and drop policies as the MQTT queue, and are recorded in order once it starts.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include "avdata.h"
+
+static size_t swi_mangoh_data_router_avdata_valueBytes(
+    const char*,
+    const swi_mangoh_data_router_data_t*);
+static le_result_t swi_mangoh_data_router_avdata_recordValue(
+    swi_mangoh_data_router_avdata_t*,
+    const char*,
+    const swi_mangoh_data_router_data_t*);
+static void swi_mangoh_data_router_avdata_recordScalar(
+    swi_mangoh_data_router_avdata_t*,
+    const char*,
+    const swi_mangoh_data_router_data_t*);
+static void swi_mangoh_data_router_avdata_record(
+    swi_mangoh_data_router_avdata_t*,
+    const char*,
+    const swi_mangoh_data_router_data_t*);
+static void swi_mangoh_data_router_avdata_pushResultHandler(le_avdata_PushStatus_t, void*);
+static void swi_mangoh_data_router_avdata_push(void*);
+static void swi_mangoh_data_router_avdata_pushTimerHandler(le_timer_Ref_t);
+static void swi_mangoh_data_router_avdata_sessionStateHandler(le_avdata_SessionState_t, void*);
+static void* swi_mangoh_data_router_avdata_start(
+    void*,
+    const char*,
+    const char*,
+    const char*,
+    swi_mangoh_data_router_db_t*);
+static le_result_t swi_mangoh_data_router_avdata_write(
+    void*,
+    const char*,
+    const swi_mangoh_data_router_dbItem_t*);
+static void swi_mangoh_data_router_avdata_writeBatch(
+    void*,
+    const char*,
+    const swi_mangoh_data_router_dbItem_t*,
+    const double*,
+    const uint32_t*,
+    size_t);
+static uint32_t swi_mangoh_data_router_avdata_getFill(void*);
+static void swi_mangoh_data_router_avdata_end(void*);
+
+const swi_mangoh_data_router_transportOps_t swi_mangoh_data_router_avdataTransportOps = {
+    .start      = swi_mangoh_data_router_avdata_start,
+    .write      = swi_mangoh_data_router_avdata_write,
+    .writeBatch = swi_mangoh_data_router_avdata_writeBatch,
+    .flush      = swi_mangoh_data_router_avdata_push,
+    .getFill    = swi_mangoh_data_router_avdata_getFill,
+    .end        = swi_mangoh_data_router_avdata_end,
+};
+
+// Returns about the CBOR size of a recorded value: its path, its timestamp and its value
+static size_t swi_mangoh_data_router_avdata_valueBytes
+(
+    const char* path,
+    const swi_mangoh_data_router_data_t* data
+)
+{
+    size_t len = strlen(path) + 9;
+
+    switch (data->type)
+    {
+        case DATAROUTER_BOOLEAN:
+            len += 1;
+            break;
+
+        case DATAROUTER_INTEGER:
+            len += 5;
+            break;
+
+        case DATAROUTER_STRING:
+            len += strlen(data->sValue) + 2;
+            break;
+
+        default:
+            len += 9;
+            break;
+    }
+
+    return len;
+}
+
+static le_result_t swi_mangoh_data_router_avdata_recordValue
+(
+    swi_mangoh_data_router_avdata_t* avdata,
+    const char* path,
+    const swi_mangoh_data_router_data_t* data
+)
+{
+    uint64_t timestampMs = (uint64_t)data->timestamp * 1000;
+    le_result_t res = LE_FAULT;
+
+    switch (data->type)
+    {
+        case DATAROUTER_BOOLEAN:
+            res = le_avdata_RecordBool(avdata->record, path, data->bValue, timestampMs);
+            break;
+
+        case DATAROUTER_INTEGER:
+            res = le_avdata_RecordInt(avdata->record, path, data->iValue, timestampMs);
+            break;
+
+        case DATAROUTER_FLOAT:
+            res = le_avdata_RecordFloat(avdata->record, path, data->fValue, timestampMs);
+            break;
+
+        case DATAROUTER_STRING:
+            res = le_avdata_RecordString(avdata->record, path, data->sValue, timestampMs);
+            break;
+
+        default:
+            LE_ERROR("ERROR path('%s') unsupported type(%d)", path, data->type);
+            break;
+    }
+
+    return res;
+}
+
+static void swi_mangoh_data_router_avdata_recordScalar
+(
+    swi_mangoh_data_router_avdata_t* avdata,
+    const char* path,
+    const swi_mangoh_data_router_data_t* data
+)
+{
+    le_result_t res = swi_mangoh_data_router_avdata_recordValue(avdata, path, data);
+    if ((res == LE_NO_MEMORY) && avdata->recordValues)
+    {
+        // The record is full, the value starts the next record
+        swi_mangoh_data_router_avdata_push(avdata);
+        res = swi_mangoh_data_router_avdata_recordValue(avdata, path, data);
+    }
+
+    if (res != LE_OK)
+    {
+        LE_ERROR("ERROR record('%s') failed(%d)", path, res);
+        goto cleanup;
+    }
+
+    avdata->recordValues++;
+    avdata->recordBytes += swi_mangoh_data_router_avdata_valueBytes(path, data);
+    avdata->numRecorded++;
+
+    if (avdata->recordBytes >= avdata->pushBytes)
+    {
+        swi_mangoh_data_router_avdata_push(avdata);
+    }
+
+cleanup:
+    return;
+}
+
+static void swi_mangoh_data_router_avdata_record
+(
+    swi_mangoh_data_router_avdata_t* avdata,
+    const char* key,
+    const swi_mangoh_data_router_data_t* data
+)
+{
+    char path[SWI_MANGOH_DATA_ROUTER_AVDATA_PATH_MAX_LEN];
+
+    if ((data->type != DATAROUTER_FLOAT_ARRAY) && (data->type != DATAROUTER_INTEGER_ARRAY))
+    {
+        swi_mangoh_data_router_avdata_recordScalar(avdata, key, data);
+        goto cleanup;
+    }
+
+    // Timeseries hold scalars, array elements are recorded under key/index
+    for (uint32_t i = 0; i < data->count; i++)
+    {
+        swi_mangoh_data_router_data_t elem = { .timestamp = data->timestamp };
+
+        if (data->type == DATAROUTER_FLOAT_ARRAY)
+        {
+            elem.type = DATAROUTER_FLOAT;
+            elem.fValue = data->faValue[i];
+        }
+        else
+        {
+            elem.type = DATAROUTER_INTEGER;
+            elem.iValue = data->iaValue[i];
+        }
+
+        snprintf(path, sizeof(path), "%s/%u", key, i);
+        swi_mangoh_data_router_avdata_recordScalar(avdata, path, &elem);
+    }
+
+cleanup:
+    return;
+}
+
+static void swi_mangoh_data_router_avdata_pushResultHandler
+(
+    le_avdata_PushStatus_t status,
+    void* context
+)
+{
+    swi_mangoh_data_router_avdata_t* avdata = (swi_mangoh_data_router_avdata_t*)context;
+
+    LE_ASSERT(avdata);
+
+    if (status == LE_AVDATA_PUSH_SUCCESS)
+    {
+        avdata->numRecordsPushed++;
+    }
+    else
+    {
+        avdata->numRecordsFailed++;
+        LE_WARN("record push failed(%d), failed(%u)", status, avdata->numRecordsFailed);
+    }
+}
+
+// Pushes the record once the AirVantage session is started, it is kept until then
+static void swi_mangoh_data_router_avdata_push
+(
+    void* context
+)
+{
+    swi_mangoh_data_router_avdata_t* avdata = (swi_mangoh_data_router_avdata_t*)context;
+
+    LE_ASSERT(avdata);
+
+    if (!avdata->recordValues || !avdata->sessionStarted)
+    {
+        goto cleanup;
+    }
+
+    LE_DEBUG("push record values(%u), bytes(%zu)", avdata->recordValues, avdata->recordBytes);
+    le_result_t res = le_avdata_PushRecord(
+        avdata->record, swi_mangoh_data_router_avdata_pushResultHandler, avdata);
+    if (res != LE_OK)
+    {
+        avdata->numRecordsFailed++;
+        LE_ERROR(
+            "ERROR le_avdata_PushRecord() failed(%d), dropped(%u values)",
+            res,
+            avdata->recordValues);
+    }
+
+    le_avdata_DeleteRecord(avdata->record);
+    avdata->record = le_avdata_CreateRecord();
+    avdata->recordValues = 0;
+    avdata->recordBytes = 0;
+
+cleanup:
+    return;
+}
+
+static void swi_mangoh_data_router_avdata_pushTimerHandler
+(
+    le_timer_Ref_t timer
+)
+{
+    swi_mangoh_data_router_avdata_push(le_timer_GetContextPtr(timer));
+}
+
+static void swi_mangoh_data_router_avdata_sessionStateHandler
+(
+    le_avdata_SessionState_t state,
+    void* context
+)
+{
+    swi_mangoh_data_router_avdata_t* avdata = (swi_mangoh_data_router_avdata_t*)context;
+    const swi_mangoh_data_router_queueEntry_t* entry = NULL;
+
+    LE_ASSERT(avdata);
+
+    if (state != LE_AVDATA_SESSION_STARTED)
+    {
+        LE_INFO("AirVantage session stopped");
+        avdata->sessionStarted = false;
+        goto cleanup;
+    }
+
+    LE_INFO("AirVantage session started, queued(%u)", avdata->outstandingRequests.numEntries);
+    avdata->sessionStarted = true;
+
+    // The values recorded before the session stopped go first, then the queued updates
+    swi_mangoh_data_router_avdata_push(avdata);
+    while ((entry = swi_mangoh_data_router_queue_pop(&avdata->outstandingRequests)))
+    {
+        swi_mangoh_data_router_avdata_record(avdata, entry->key, &entry->data);
+    }
+
+    swi_mangoh_data_router_avdata_push(avdata);
+
+cleanup:
+    return;
+}
+
+void swi_mangoh_data_router_avdata_init
+(
+    swi_mangoh_data_router_avdata_t* avdata
+)
+{
+    LE_ASSERT(avdata);
+
+    memset(avdata, 0, sizeof(swi_mangoh_data_router_avdata_t));
+}
+
+static void* swi_mangoh_data_router_avdata_start
+(
+    void* context,
+    const char* appId,
+    const char* url,
+    const char* password,
+    swi_mangoh_data_router_db_t* db
+)
+{
+    swi_mangoh_data_router_avdata_t* avdata = (swi_mangoh_data_router_avdata_t*)context;
+
+    LE_ASSERT(avdata);
+
+    if (avdata->numSessions++)
+    {
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_queue_init(
+        &avdata->outstandingRequests,
+        SWI_MANGOH_DATA_ROUTER_AVDATA_CFG_QUEUE_SIZE,
+        SWI_MANGOH_DATA_ROUTER_AVDATA_CFG_DROP_POLICY,
+        SWI_MANGOH_DATA_ROUTER_AVDATA_QUEUED_REQUESTS_MAX_NUM);
+
+    int32_t pushBytes = le_cfg_QuickGetInt(
+        SWI_MANGOH_DATA_ROUTER_AVDATA_CFG_PUSH_BYTES, SWI_MANGOH_DATA_ROUTER_AVDATA_PUSH_BYTES);
+    if (pushBytes <= 0)
+    {
+        LE_WARN("invalid avdata push bytes(%d)", pushBytes);
+        pushBytes = SWI_MANGOH_DATA_ROUTER_AVDATA_PUSH_BYTES;
+    }
+
+    int32_t pushIntervalMs = le_cfg_QuickGetInt(
+        SWI_MANGOH_DATA_ROUTER_AVDATA_CFG_PUSH_INTERVAL,
+        SWI_MANGOH_DATA_ROUTER_AVDATA_PUSH_INTERVAL_MS);
+    if (pushIntervalMs <= 0)
+    {
+        LE_WARN("invalid avdata push interval(%d)", pushIntervalMs);
+        pushIntervalMs = SWI_MANGOH_DATA_ROUTER_AVDATA_PUSH_INTERVAL_MS;
+    }
+
+    avdata->pushBytes = pushBytes;
+    avdata->record = le_avdata_CreateRecord();
+    avdata->recordValues = 0;
+    avdata->recordBytes = 0;
+    avdata->numRecorded = 0;
+    avdata->numRecordsPushed = 0;
+    avdata->numRecordsFailed = 0;
+
+    avdata->pushTimer = le_timer_Create("DataRouterAvDataPush");
+    le_timer_SetMsInterval(avdata->pushTimer, pushIntervalMs);
+    le_timer_SetRepeat(avdata->pushTimer, 0);
+    le_timer_SetContextPtr(avdata->pushTimer, avdata);
+    le_timer_SetHandler(avdata->pushTimer, swi_mangoh_data_router_avdata_pushTimerHandler);
+    le_timer_Start(avdata->pushTimer);
+
+    LE_DEBUG("avdata push bytes(%zu), push interval(%d ms)", avdata->pushBytes, pushIntervalMs);
+    avdata->sessionStarted = false;
+    avdata->sessionHandler = le_avdata_AddSessionStateHandler(
+        swi_mangoh_data_router_avdata_sessionStateHandler, avdata);
+    avdata->sessionRef = le_avdata_RequestSession();
+    if (!avdata->sessionRef)
+    {
+        // The updates stay queued until the session is started by another client
+        LE_WARN("le_avdata_RequestSession() failed");
+    }
+
+cleanup:
+    return avdata;
+}
+
+static le_result_t swi_mangoh_data_router_avdata_write
+(
+    void* client,
+    const char* key,
+    const swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    swi_mangoh_data_router_avdata_t* avdata = (swi_mangoh_data_router_avdata_t*)client;
+    le_result_t res = LE_OK;
+
+    if (!avdata->sessionStarted)
+    {
+        res = swi_mangoh_data_router_queue_push(&avdata->outstandingRequests, key, &dbItem->data);
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_avdata_record(avdata, key, &dbItem->data);
+
+cleanup:
+    return res;
+}
+
+static void swi_mangoh_data_router_avdata_writeBatch
+(
+    void* client,
+    const char* key,
+    const swi_mangoh_data_router_dbItem_t* dbItem,
+    const double* values,
+    const uint32_t* timestamps,
+    size_t numSamples
+)
+{
+    swi_mangoh_data_router_avdata_t* avdata = (swi_mangoh_data_router_avdata_t*)client;
+
+    if (!avdata->sessionStarted)
+    {
+        // Only the latest value of the block is kept while queuing
+        LE_DEBUG("queue('%s') latest of %zu samples", key, numSamples);
+        swi_mangoh_data_router_queue_push(&avdata->outstandingRequests, key, &dbItem->data);
+        goto cleanup;
+    }
+
+    // Each sample is recorded with its own timestamp
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        swi_mangoh_data_router_data_t data = { .type = DATAROUTER_FLOAT };
+
+        data.fValue = values[i];
+        data.timestamp = timestamps[i];
+        swi_mangoh_data_router_avdata_recordScalar(avdata, key, &data);
+    }
+
+cleanup:
+    return;
+}
+
+static uint32_t swi_mangoh_data_router_avdata_getFill
+(
+    void* context
+)
+{
+    swi_mangoh_data_router_avdata_t* avdata = (swi_mangoh_data_router_avdata_t*)context;
+
+    return swi_mangoh_data_router_queue_getFill(&avdata->outstandingRequests);
+}
+
+static void swi_mangoh_data_router_avdata_end
+(
+    void* client
+)
+{
+    swi_mangoh_data_router_avdata_t* avdata = (swi_mangoh_data_router_avdata_t*)client;
+
+    LE_ASSERT(avdata->numSessions);
+    if (--avdata->numSessions)
+    {
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_avdata_push(avdata);
+    LE_INFO(
+        "avdata recorded(%llu), records pushed(%u), failed(%u), not pushed(%u values)",
+        (unsigned long long)avdata->numRecorded,
+        avdata->numRecordsPushed,
+        avdata->numRecordsFailed,
+        avdata->recordValues);
+
+    le_timer_Delete(avdata->pushTimer);
+    avdata->pushTimer = NULL;
+    le_avdata_RemoveSessionStateHandler(avdata->sessionHandler);
+    avdata->sessionHandler = NULL;
+    if (avdata->sessionRef)
+    {
+        le_avdata_ReleaseSession(avdata->sessionRef);
+        avdata->sessionRef = NULL;
+    }
+
+    avdata->sessionStarted = false;
+    le_avdata_DeleteRecord(avdata->record);
+    avdata->record = NULL;
+    swi_mangoh_data_router_queue_destroy(&avdata->outstandingRequests);
+
+cleanup:
+    return;
+}
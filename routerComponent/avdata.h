@@ -0,0 +1,62 @@
+/*
+ * @file avdata.h
+ *
+ * Data router module.
+ *
+ * This module is the AirVantage le_avdata timeseries transport of the mangOH data router pushes.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+#include "queue.h"
+#include "transport.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_AVDATA_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_AVDATA_INCLUDE_GUARD
+
+#define SWI_MANGOH_DATA_ROUTER_AVDATA_NAME "avdata"
+#define SWI_MANGOH_DATA_ROUTER_AVDATA_QUEUED_REQUESTS_MAX_NUM 30
+#define SWI_MANGOH_DATA_ROUTER_AVDATA_PATH_MAX_LEN (SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN + 16)
+
+#define SWI_MANGOH_DATA_ROUTER_AVDATA_CFG_QUEUE_SIZE "/AvData/queueSize"
+#define SWI_MANGOH_DATA_ROUTER_AVDATA_CFG_DROP_POLICY "/AvData/dropPolicy"
+#define SWI_MANGOH_DATA_ROUTER_AVDATA_CFG_PUSH_INTERVAL "/AvData/pushIntervalMs"
+#define SWI_MANGOH_DATA_ROUTER_AVDATA_CFG_PUSH_BYTES "/AvData/pushBytes"
+
+#define SWI_MANGOH_DATA_ROUTER_AVDATA_PUSH_INTERVAL_MS 10000
+#define SWI_MANGOH_DATA_ROUTER_AVDATA_PUSH_BYTES 1024
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router le_avdata transport.  Updates are recorded into a timeseries record which is pushed
+ * once it holds about the push bytes and on the push timer, and queued while the AirVantage
+ * session is not started.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_avdata_t
+{
+    uint32_t numSessions;                              ///< Sessions using the transport
+    le_avdata_RequestSessionObjRef_t sessionRef;       ///< AirVantage session request
+    le_avdata_SessionStateHandlerRef_t sessionHandler; ///< AirVantage session state handler
+    bool sessionStarted;                               ///< AirVantage session started
+    swi_mangoh_data_router_queue_t outstandingRequests; ///< Updates waiting for the session
+    le_avdata_RecordRef_t record;                      ///< Timeseries record being filled
+    uint32_t recordValues;                             ///< Values in the record
+    size_t recordBytes;                                ///< Approximate encoded record size
+    size_t pushBytes;                                  ///< Record size pushed right away
+    le_timer_Ref_t pushTimer;                          ///< Record push timer
+    uint64_t numRecorded;                              ///< Values recorded
+    uint32_t numRecordsPushed;                         ///< Records acknowledged by the server
+    uint32_t numRecordsFailed;                         ///< Records not pushed or rejected
+} swi_mangoh_data_router_avdata_t;
+
+void swi_mangoh_data_router_avdata_init(swi_mangoh_data_router_avdata_t*);
+
+extern const swi_mangoh_data_router_transportOps_t swi_mangoh_data_router_avdataTransportOps;
+
+#endif
@@ -0,0 +1,244 @@
+/**
+ * @file
+ *
+ * The connection state machine decides when to connect and disconnect, its owner performs the
+ * actions it returns.  It neither reads the clock nor touches a timer, so a sequence of events
+ * always produces the same actions and delays for a given random seed.
+ *
+ *  event           IDLE        CONNECTING    CONNECTED     BACKOFF       DISCONNECTING
+ *  start           CONNECTING  -             -             -             CONNECTING
+ *  connected       (discon.)   CONNECTED     -             CONNECTED     CONNECTED
+ *  disconnected    -           BACKOFF, wait BACKOFF, wait -             wait
+ *  timer           -           -             -             CONNECTING    connect
+ *  network up      -           -             -             short wait    short wait (1)
+ *  stop            -           IDLE, discon. IDLE, discon. IDLE, discon. IDLE, discon.
+ *  drain           -           DISCONNECTING -             DISCONNECTING IDLE, discon.
+ *
+ * (1) only while waiting for the reconnect timer, not while a connect is in progress.
+ *
+ * Once connected with queued requests, the owner forwards them and stops the connection when the
+ * last one is sent.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include "conn.h"
+
+static const char* swi_mangoh_data_router_conn_stateName(swi_mangoh_data_router_conn_state_e);
+static uint32_t swi_mangoh_data_router_conn_random(swi_mangoh_data_router_conn_t*, uint32_t);
+static uint32_t swi_mangoh_data_router_conn_backoff(swi_mangoh_data_router_conn_t*);
+
+static const char* swi_mangoh_data_router_conn_stateName
+(
+    swi_mangoh_data_router_conn_state_e state
+)
+{
+    switch (state)
+    {
+        case SWI_MANGOH_DATA_ROUTER_CONN_STATE_IDLE:
+            return "idle";
+
+        case SWI_MANGOH_DATA_ROUTER_CONN_STATE_CONNECTING:
+            return "connecting";
+
+        case SWI_MANGOH_DATA_ROUTER_CONN_STATE_CONNECTED:
+            return "connected";
+
+        case SWI_MANGOH_DATA_ROUTER_CONN_STATE_BACKOFF:
+            return "backoff";
+
+        case SWI_MANGOH_DATA_ROUTER_CONN_STATE_DISCONNECTING:
+            return "disconnecting";
+    }
+
+    return "unknown";
+}
+
+// Returns a random number between 0 and max included
+static uint32_t swi_mangoh_data_router_conn_random
+(
+    swi_mangoh_data_router_conn_t* conn,
+    uint32_t max
+)
+{
+    // xorshift32
+    conn->random ^= conn->random << 13;
+    conn->random ^= conn->random >> 17;
+    conn->random ^= conn->random << 5;
+
+    return (max == UINT32_MAX) ? conn->random : conn->random % (max + 1);
+}
+
+static uint32_t swi_mangoh_data_router_conn_backoff
+(
+    swi_mangoh_data_router_conn_t* conn
+)
+{
+    uint32_t intervalMs = conn->minIntervalMs;
+
+    for (uint32_t i = 0; (i < conn->numFailures) && (intervalMs < conn->maxIntervalMs); i++)
+    {
+        intervalMs = (intervalMs > conn->maxIntervalMs / 2) ? conn->maxIntervalMs : 2 * intervalMs;
+    }
+
+    conn->numFailures++;
+    return intervalMs - intervalMs / 2 + swi_mangoh_data_router_conn_random(conn, intervalMs / 2);
+}
+
+void swi_mangoh_data_router_conn_init
+(
+    swi_mangoh_data_router_conn_t* conn,
+    uint32_t minIntervalMs,
+    uint32_t maxIntervalMs,
+    uint32_t networkRetryMs,
+    uint32_t seed
+)
+{
+    LE_ASSERT(conn);
+
+    memset(conn, 0, sizeof(swi_mangoh_data_router_conn_t));
+    conn->minIntervalMs = minIntervalMs ? minIntervalMs : 1;
+    conn->maxIntervalMs =
+        (maxIntervalMs < conn->minIntervalMs) ? conn->minIntervalMs : maxIntervalMs;
+    conn->networkRetryMs = networkRetryMs;
+
+    // xorshift32 never leaves 0
+    conn->random = seed ? seed : 1;
+}
+
+swi_mangoh_data_router_conn_action_e swi_mangoh_data_router_conn_handleEvent
+(
+    swi_mangoh_data_router_conn_t* conn,
+    swi_mangoh_data_router_conn_event_e event
+)
+{
+    swi_mangoh_data_router_conn_action_e action = SWI_MANGOH_DATA_ROUTER_CONN_ACTION_NONE;
+
+    LE_ASSERT(conn);
+
+    swi_mangoh_data_router_conn_state_e state = conn->state;
+
+    switch (event)
+    {
+        case SWI_MANGOH_DATA_ROUTER_CONN_EVENT_START:
+            // A session started while disconnecting keeps the connection, connect right away
+            // rather than waiting for the pending connect or reconnect timer
+            if ((state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_IDLE) ||
+                (state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_DISCONNECTING))
+            {
+                conn->numFailures = 0;
+                conn->numAttempts++;
+                conn->state = SWI_MANGOH_DATA_ROUTER_CONN_STATE_CONNECTING;
+                action = SWI_MANGOH_DATA_ROUTER_CONN_ACTION_CONNECT;
+            }
+            break;
+
+        case SWI_MANGOH_DATA_ROUTER_CONN_EVENT_CONNECTED:
+            if ((state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_CONNECTING) ||
+                (state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_BACKOFF) ||
+                (state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_DISCONNECTING))
+            {
+                conn->numFailures = 0;
+                conn->state = SWI_MANGOH_DATA_ROUTER_CONN_STATE_CONNECTED;
+            }
+            else if (state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_IDLE)
+            {
+                conn->state = SWI_MANGOH_DATA_ROUTER_CONN_STATE_IDLE;
+                action = SWI_MANGOH_DATA_ROUTER_CONN_ACTION_DISCONNECT;
+            }
+            break;
+
+        case SWI_MANGOH_DATA_ROUTER_CONN_EVENT_DISCONNECTED:
+            if ((state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_CONNECTING) ||
+                (state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_CONNECTED) ||
+                (state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_DISCONNECTING))
+            {
+                if (state != SWI_MANGOH_DATA_ROUTER_CONN_STATE_DISCONNECTING)
+                {
+                    conn->state = SWI_MANGOH_DATA_ROUTER_CONN_STATE_BACKOFF;
+                }
+
+                conn->delayMs = swi_mangoh_data_router_conn_backoff(conn);
+                action = SWI_MANGOH_DATA_ROUTER_CONN_ACTION_WAIT;
+            }
+            break;
+
+        case SWI_MANGOH_DATA_ROUTER_CONN_EVENT_TIMER:
+            if ((state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_BACKOFF) ||
+                (state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_DISCONNECTING))
+            {
+                if (state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_BACKOFF)
+                {
+                    conn->state = SWI_MANGOH_DATA_ROUTER_CONN_STATE_CONNECTING;
+                }
+
+                conn->numAttempts++;
+                action = SWI_MANGOH_DATA_ROUTER_CONN_ACTION_CONNECT;
+            }
+            break;
+
+        case SWI_MANGOH_DATA_ROUTER_CONN_EVENT_NETWORK_UP:
+            // The broker was likely unreachable because the network was down, retry soon with
+            // the backoff restarted, still jittered since a whole cell may come back at once
+            if ((state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_BACKOFF) ||
+                ((state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_DISCONNECTING) && conn->waiting))
+            {
+                conn->numFailures = 0;
+                conn->delayMs = swi_mangoh_data_router_conn_random(conn, conn->networkRetryMs);
+                action = SWI_MANGOH_DATA_ROUTER_CONN_ACTION_WAIT;
+            }
+            break;
+
+        case SWI_MANGOH_DATA_ROUTER_CONN_EVENT_STOP:
+        case SWI_MANGOH_DATA_ROUTER_CONN_EVENT_DRAIN:
+            // Connected, the owner stops once the queued requests are forwarded
+            if ((state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_IDLE) ||
+                ((event == SWI_MANGOH_DATA_ROUTER_CONN_EVENT_DRAIN) &&
+                 (state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_CONNECTED)))
+            {
+                break;
+            }
+
+            if ((event == SWI_MANGOH_DATA_ROUTER_CONN_EVENT_DRAIN) &&
+                ((state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_CONNECTING) ||
+                 (state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_BACKOFF)))
+            {
+                conn->state = SWI_MANGOH_DATA_ROUTER_CONN_STATE_DISCONNECTING;
+                break;
+            }
+
+            conn->state = SWI_MANGOH_DATA_ROUTER_CONN_STATE_IDLE;
+            action = SWI_MANGOH_DATA_ROUTER_CONN_ACTION_DISCONNECT;
+            break;
+    }
+
+    // Only a wait leaves the reconnect timer running, the owner stops it for the other actions
+    if (action != SWI_MANGOH_DATA_ROUTER_CONN_ACTION_NONE)
+    {
+        conn->waiting = (action == SWI_MANGOH_DATA_ROUTER_CONN_ACTION_WAIT);
+    }
+
+    if (conn->state != state)
+    {
+        LE_DEBUG(
+            "connection %s -> %s",
+            swi_mangoh_data_router_conn_stateName(state),
+            swi_mangoh_data_router_conn_stateName(conn->state));
+    }
+
+    return action;
+}
+
+bool swi_mangoh_data_router_conn_isConnected
+(
+    const swi_mangoh_data_router_conn_t* conn
+)
+{
+    LE_ASSERT(conn);
+    return conn->state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_CONNECTED;
+}
@@ -0,0 +1,75 @@
+/*
+ * @file conn.h
+ *
+ * Data router module.
+ *
+ * This module is the upstream connection state machine of the mangOH data router.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_CONN_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_CONN_INCLUDE_GUARD
+
+typedef enum _swi_mangoh_data_router_conn_state_e {
+    SWI_MANGOH_DATA_ROUTER_CONN_STATE_IDLE = 0,      ///< No session
+    SWI_MANGOH_DATA_ROUTER_CONN_STATE_CONNECTING,    ///< Waiting for the connect result
+    SWI_MANGOH_DATA_ROUTER_CONN_STATE_CONNECTED,     ///< Connected
+    SWI_MANGOH_DATA_ROUTER_CONN_STATE_BACKOFF,       ///< Waiting for the reconnect timer
+    SWI_MANGOH_DATA_ROUTER_CONN_STATE_DISCONNECTING, ///< Session ended, reconnecting to forward
+                                                     ///  the queued requests before disconnecting
+} swi_mangoh_data_router_conn_state_e;
+
+typedef enum _swi_mangoh_data_router_conn_event_e {
+    SWI_MANGOH_DATA_ROUTER_CONN_EVENT_START = 0,    ///< Session started
+    SWI_MANGOH_DATA_ROUTER_CONN_EVENT_CONNECTED,    ///< Session state connected
+    SWI_MANGOH_DATA_ROUTER_CONN_EVENT_DISCONNECTED, ///< Session state disconnected
+    SWI_MANGOH_DATA_ROUTER_CONN_EVENT_TIMER,        ///< Reconnect timer expired
+    SWI_MANGOH_DATA_ROUTER_CONN_EVENT_NETWORK_UP,   ///< Data connection up
+    SWI_MANGOH_DATA_ROUTER_CONN_EVENT_STOP,         ///< Session ended
+    SWI_MANGOH_DATA_ROUTER_CONN_EVENT_DRAIN,        ///< Session ended with queued requests
+} swi_mangoh_data_router_conn_event_e;
+
+typedef enum _swi_mangoh_data_router_conn_action_e {
+    SWI_MANGOH_DATA_ROUTER_CONN_ACTION_NONE = 0,   ///< Nothing to do
+    SWI_MANGOH_DATA_ROUTER_CONN_ACTION_CONNECT,    ///< Stop the reconnect timer and connect
+    SWI_MANGOH_DATA_ROUTER_CONN_ACTION_WAIT,       ///< (Re)start the reconnect timer for delayMs
+    SWI_MANGOH_DATA_ROUTER_CONN_ACTION_DISCONNECT, ///< Stop the reconnect timer and disconnect
+} swi_mangoh_data_router_conn_action_e;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router upstream connection.  The reconnect delay doubles with each failed attempt from the
+ * minimum up to the maximum interval, with equal jitter: a random delay between half and all of
+ * the interval, so that devices losing the broker together do not reconnect together.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_conn_t
+{
+    swi_mangoh_data_router_conn_state_e state; ///< Connection state
+    uint32_t minIntervalMs;                   ///< First reconnect interval
+    uint32_t maxIntervalMs;                   ///< Maximum reconnect interval
+    uint32_t networkRetryMs;                  ///< Maximum reconnect delay after a network up
+    uint32_t numFailures;                     ///< Failed attempts since the last connection
+    uint32_t delayMs;                         ///< Reconnect delay of the last wait action
+    bool waiting;                             ///< Reconnect timer started by the last action
+    uint32_t random;                          ///< Jitter random number generator state
+    uint32_t numAttempts;                     ///< Connect attempts
+} swi_mangoh_data_router_conn_t;
+
+void swi_mangoh_data_router_conn_init(
+    swi_mangoh_data_router_conn_t*,
+    uint32_t,
+    uint32_t,
+    uint32_t,
+    uint32_t);
+swi_mangoh_data_router_conn_action_e swi_mangoh_data_router_conn_handleEvent(
+    swi_mangoh_data_router_conn_t*,
+    swi_mangoh_data_router_conn_event_e);
+bool swi_mangoh_data_router_conn_isConnected(const swi_mangoh_data_router_conn_t*);
+
+#endif
@@ -10,8 +10,132 @@
 #include "legato.h"
 #include "db.h"
 
+#include <math.h>
+
 static void swi_mangoh_data_router_db_restorePersistedData(swi_mangoh_data_router_db_t*);
 static void swi_mangoh_data_router_db_restoreEncryptedData(swi_mangoh_data_router_db_t*);
+static void swi_mangoh_data_router_db_retire(swi_mangoh_data_router_db_t*, void*);
+static void swi_mangoh_data_router_db_indexSlot(
+    swi_mangoh_data_router_dbIndex_t*,
+    swi_mangoh_data_router_dbItem_t*);
+static void swi_mangoh_data_router_db_indexItem(
+    swi_mangoh_data_router_db_t*,
+    swi_mangoh_data_router_dbItem_t*);
+static void swi_mangoh_data_router_db_removeDirtyItem(
+    swi_mangoh_data_router_db_t*,
+    swi_mangoh_data_router_dbItem_t*);
+
+static void swi_mangoh_data_router_db_retire
+(
+    swi_mangoh_data_router_db_t* db,
+    void* block
+)
+{
+    swi_mangoh_data_router_dbRetired_t* retired =
+        calloc(1, sizeof(swi_mangoh_data_router_dbRetired_t));
+    LE_ASSERT(retired);
+
+    retired->block = block;
+    retired->link = LE_SLS_LINK_INIT;
+    le_sls_Stack(&db->retired, &retired->link);
+}
+
+static void swi_mangoh_data_router_db_removeDirtyItem
+(
+    swi_mangoh_data_router_db_t* db,
+    swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    le_sls_Link_t* prevLinkPtr = NULL;
+    le_sls_Link_t* linkPtr = le_sls_Peek(&db->dirtyItems);
+
+    while (linkPtr && (linkPtr != &dbItem->dirtyLink))
+    {
+        prevLinkPtr = linkPtr;
+        linkPtr = le_sls_PeekNext(&db->dirtyItems, linkPtr);
+    }
+
+    if (linkPtr)
+    {
+        if (prevLinkPtr)
+        {
+            le_sls_RemoveAfter(&db->dirtyItems, prevLinkPtr);
+        }
+        else
+        {
+            le_sls_Pop(&db->dirtyItems);
+        }
+    }
+
+    dbItem->dirty = false;
+}
+
+static void swi_mangoh_data_router_db_indexSlot
+(
+    swi_mangoh_data_router_dbIndex_t* index,
+    swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    uint32_t mask = index->size - 1;
+    uint32_t slot = le_hashmap_HashString(dbItem->key) & mask;
+
+    while (index->items[slot])
+    {
+        if (!strcmp(index->items[slot]->key, dbItem->key))
+        {
+            // Replaced data item
+            __atomic_store_n(&index->items[slot], dbItem, __ATOMIC_RELEASE);
+            return;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    // The slot is published once the data item is complete
+    __atomic_store_n(&index->items[slot], dbItem, __ATOMIC_RELEASE);
+    index->numItems++;
+}
+
+static void swi_mangoh_data_router_db_indexItem
+(
+    swi_mangoh_data_router_db_t* db,
+    swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    swi_mangoh_data_router_dbIndex_t* index = db->index;
+
+    // Keep the index at most half full to keep probe sequences short
+    if (!index || ((index->numItems + 1) * 2 > index->size))
+    {
+        uint32_t size = index ? index->size * 2 : SWI_MANGOH_DATA_ROUTER_DB_INDEX_INIT_SIZE;
+        swi_mangoh_data_router_dbIndex_t* newIndex = calloc(
+            1, sizeof(swi_mangoh_data_router_dbIndex_t) + size * sizeof(dbItem));
+        if (!newIndex)
+        {
+            LE_ERROR("ERROR calloc() failed, key('%s') not readable by reader", dbItem->key);
+            return;
+        }
+
+        newIndex->size = size;
+        if (index)
+        {
+            for (uint32_t i = 0; i < index->size; i++)
+            {
+                if (index->items[i])
+                {
+                    swi_mangoh_data_router_db_indexSlot(newIndex, index->items[i]);
+                }
+            }
+
+            swi_mangoh_data_router_db_retire(db, index);
+        }
+
+        __atomic_store_n(&db->index, newIndex, __ATOMIC_RELEASE);
+        index = newIndex;
+    }
+
+    swi_mangoh_data_router_db_indexSlot(index, dbItem);
+}
 
 static void swi_mangoh_data_router_db_restoreEncryptedData
 (
@@ -33,6 +157,7 @@ static void swi_mangoh_data_router_db_restoreEncryptedData
         goto cleanup;
     }
 
+    len = SWI_MANGOH_DATA_ROUTER_SEC_STORE_MAX_KEYS_LEN;
     res = le_secStore_Read(
         SWI_MANGOH_DATA_ROUTER_SEC_STORE_BASE_NAME, (uint8_t*)encryptedKeys, &len);
     if (res != LE_OK)
@@ -53,21 +178,27 @@ static void swi_mangoh_data_router_db_restoreEncryptedData
                 goto cleanup;
             }
 
+            // The data item is already published to the reader thread, it is kept without a value
+            // when its data can not be read
+            len = sizeof(swi_mangoh_data_router_data_t);
             res = le_secStore_Read(key, (uint8_t*)&dbItem->data, &len);
-            if (res != LE_OK)
+            if ((res == LE_OK) && (len == sizeof(swi_mangoh_data_router_data_t)))
             {
-                LE_ERROR("ERROR le_secStore_Read() failed(%d)", res);
-                goto cleanup;
+                dbItem->hasValue = true;
+                dbItem->storageType = DATAROUTER_PERSIST_ENCRYPTED;
+                dbItem->persistedStorageType = DATAROUTER_PERSIST_ENCRYPTED;
+            }
+            else
+            {
+                LE_ERROR("ERROR le_secStore_Read('%s') failed(%d) len(%zu)", key, res, len);
+                memset(&dbItem->data, 0, sizeof(swi_mangoh_data_router_data_t));
             }
 
-            LE_ASSERT(len == sizeof(swi_mangoh_data_router_data_t));
             key = strtok(NULL, SWI_MANGOH_DATA_ROUTER_SEC_STORE_KEYS_SEPARATOR);
         }
     }
 
 cleanup:
-    if (res != LE_OK)
-        free(dbItem);
     free(encryptedKeys);
 }
 
@@ -101,6 +232,8 @@ static void swi_mangoh_data_router_db_restorePersistedData
             goto cleanup;
         }
 
+        dbItem->storageType = DATAROUTER_PERSIST;
+        dbItem->persistedStorageType = DATAROUTER_PERSIST;
         dbItem->data.type = le_cfg_GetInt(iterRef, SWI_MANGOH_DATA_ROUTER_CFG_TYPE, 0);
         switch (dbItem->data.type)
         {
@@ -152,15 +285,54 @@ static void swi_mangoh_data_router_db_restorePersistedData
                     key,
                     dbItem->data.sValue);
                 break;
+
+            case DATAROUTER_FLOAT_ARRAY:
+            case DATAROUTER_INTEGER_ARRAY:
+            {
+                char path[SWI_MANGOH_DATA_ROUTER_CFG_MAX_PATH_LEN] = {0};
+
+                snprintf(
+                    path,
+                    sizeof(path),
+                    "%s/%s",
+                    SWI_MANGOH_DATA_ROUTER_CFG_VALUE,
+                    SWI_MANGOH_DATA_ROUTER_CFG_COUNT);
+                dbItem->data.count = le_cfg_GetInt(iterRef, path, 0);
+                if (dbItem->data.count > DATAROUTER_ARRAY_MAX_LEN)
+                {
+                    LE_ERROR("ERROR key('%s') array count(%u)", key, dbItem->data.count);
+                    dbItem->data.count = 0;
+                }
+
+                for (uint32_t i = 0; i < dbItem->data.count; i++)
+                {
+                    snprintf(path, sizeof(path), "%s/%u", SWI_MANGOH_DATA_ROUTER_CFG_VALUE, i);
+                    if (dbItem->data.type == DATAROUTER_FLOAT_ARRAY)
+                    {
+                        dbItem->data.faValue[i] = le_cfg_GetFloat(iterRef, path, 0.0);
+                    }
+                    else
+                    {
+                        dbItem->data.iaValue[i] = le_cfg_GetInt(iterRef, path, 0);
+                    }
+                }
+
+                LE_DEBUG(
+                    "restore(%u) key('%s'), count(%u)",
+                    dbItem->storageType,
+                    key,
+                    dbItem->data.count);
+                break;
+            }
         }
 
         dbItem->data.timestamp = le_cfg_GetInt(iterRef, SWI_MANGOH_DATA_ROUTER_CFG_TIMESTAMP, 0);
+        dbItem->hasValue = true;
 
         res = le_cfg_GoToNextSibling(iterRef);
     }
 
     le_cfg_CommitTxn(iterRef);
-    le_cfg_QuickDeleteNode(SWI_MANGOH_DATA_ROUTER_CFG_BASE_NAME);
 
 cleanup:
     return;
@@ -191,16 +363,36 @@ swi_mangoh_data_router_dbItem_t* swi_mangoh_data_router_db_createDataItem
 
     LE_DEBUG("create data item('%s')", allocKey);
     dbItem->handlers = LE_SLS_LIST_INIT;
+    dbItem->key = allocKey;
 
     ret = le_hashmap_Put(db->database, allocKey, dbItem);
     if (ret)
     {
         LE_WARN("le_hashmap_Put() replaced key(''%s')", allocKey);
-        free(ret);
+
+        // Keep the existing key string and handle so that registered handles stay valid
+        dbItem->key = ret->key;
+        dbItem->handle = ret->handle;
+        dbItem->persistedStorageType = ret->persistedStorageType;
+        if (ret->dirty)
+        {
+            swi_mangoh_data_router_db_removeDirtyItem(db, ret);
+        }
+
+        if (dbItem->handle != DATAROUTER_INVALID_HANDLE)
+        {
+            __atomic_store_n(&db->handles[dbItem->handle - 1], dbItem, __ATOMIC_RELEASE);
+        }
+
+        // The reader thread may still be reading the replaced data item
+        swi_mangoh_data_router_db_indexItem(db, dbItem);
+        swi_mangoh_data_router_db_retire(db, ret);
         free(allocKey);  // Existing key string is used
         goto cleanup;
     }
 
+    swi_mangoh_data_router_db_indexItem(db, dbItem);
+
 cleanup:
     return dbItem;
 }
@@ -216,6 +408,177 @@ swi_mangoh_data_router_dbItem_t* swi_mangoh_data_router_db_getDataItem
     return le_hashmap_Get(db->database, key);
 }
 
+swi_mangoh_data_router_dbItem_t* swi_mangoh_data_router_db_getDataItemByHandle
+(
+    swi_mangoh_data_router_db_t* db,
+    uint32_t handle
+)
+{
+    LE_ASSERT(db);
+
+    if ((handle == DATAROUTER_INVALID_HANDLE) || (handle > db->numHandles))
+    {
+        return NULL;
+    }
+
+    return db->handles[handle - 1];
+}
+
+const swi_mangoh_data_router_dbItem_t* swi_mangoh_data_router_db_lookupDataItem
+(
+    swi_mangoh_data_router_db_t* db,
+    const char* key
+)
+{
+    const swi_mangoh_data_router_dbItem_t* dbItem = NULL;
+
+    LE_ASSERT(db);
+    LE_ASSERT(key);
+
+    swi_mangoh_data_router_dbIndex_t* index = __atomic_load_n(&db->index, __ATOMIC_ACQUIRE);
+    if (index)
+    {
+        uint32_t mask = index->size - 1;
+        uint32_t slot = le_hashmap_HashString(key) & mask;
+
+        while ((dbItem = __atomic_load_n(&index->items[slot], __ATOMIC_ACQUIRE)))
+        {
+            if (!strcmp(dbItem->key, key))
+            {
+                break;
+            }
+
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    return dbItem;
+}
+
+const swi_mangoh_data_router_dbItem_t* swi_mangoh_data_router_db_lookupDataItemByHandle
+(
+    swi_mangoh_data_router_db_t* db,
+    uint32_t handle
+)
+{
+    LE_ASSERT(db);
+
+    // A table loaded after the number of handles is at least as large as that number
+    uint32_t numHandles = __atomic_load_n(&db->numHandles, __ATOMIC_ACQUIRE);
+    if ((handle == DATAROUTER_INVALID_HANDLE) || (handle > numHandles))
+    {
+        return NULL;
+    }
+
+    swi_mangoh_data_router_dbItem_t** handles = __atomic_load_n(&db->handles, __ATOMIC_ACQUIRE);
+    return __atomic_load_n(&handles[handle - 1], __ATOMIC_ACQUIRE);
+}
+
+void swi_mangoh_data_router_db_beginUpdate
+(
+    swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    LE_ASSERT(dbItem);
+    LE_ASSERT(!(dbItem->seq & 1));
+
+    // An odd sequence number must be visible before any of the data changes
+    __atomic_store_n(&dbItem->seq, dbItem->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void swi_mangoh_data_router_db_endUpdate
+(
+    swi_mangoh_data_router_db_t* db,
+    swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    LE_ASSERT(db);
+    LE_ASSERT(dbItem);
+    LE_ASSERT(dbItem->seq & 1);
+    __atomic_store_n(&dbItem->seq, dbItem->seq + 1, __ATOMIC_RELEASE);
+    dbItem->hasValue = true;
+
+    // Persisted items, and items that have to be removed from persistent storage, are written by
+    // the next persistence snapshot
+    if (!dbItem->dirty &&
+        ((dbItem->storageType != DATAROUTER_CACHE) ||
+         (dbItem->persistedStorageType != DATAROUTER_CACHE)))
+    {
+        dbItem->dirty = true;
+        dbItem->dirtyLink = LE_SLS_LINK_INIT;
+        le_sls_Queue(&db->dirtyItems, &dbItem->dirtyLink);
+    }
+}
+
+void swi_mangoh_data_router_db_readData
+(
+    const swi_mangoh_data_router_dbItem_t* dbItem,
+    swi_mangoh_data_router_data_t* data
+)
+{
+    uint32_t seq;
+
+    LE_ASSERT(dbItem);
+    LE_ASSERT(data);
+
+    // Retry until the copy was not overlapped by an update
+    do
+    {
+        seq = __atomic_load_n(&dbItem->seq, __ATOMIC_ACQUIRE);
+        memcpy(data, &dbItem->data, sizeof(swi_mangoh_data_router_data_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    }
+    while ((seq & 1) || (seq != __atomic_load_n(&dbItem->seq, __ATOMIC_RELAXED)));
+}
+
+uint32_t swi_mangoh_data_router_db_registerHandle
+(
+    swi_mangoh_data_router_db_t* db,
+    swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    LE_ASSERT(db);
+    LE_ASSERT(dbItem);
+
+    if (dbItem->handle != DATAROUTER_INVALID_HANDLE)
+    {
+        goto cleanup;
+    }
+
+    if (db->numHandles == db->maxHandles)
+    {
+        // The reader thread may still use the current table, so it is copied rather than
+        // reallocated
+        uint32_t maxHandles = db->maxHandles ?
+            db->maxHandles * 2 : SWI_MANGOH_DATA_ROUTER_DB_HANDLES_INIT_SIZE;
+        swi_mangoh_data_router_dbItem_t** handles =
+            calloc(maxHandles, sizeof(swi_mangoh_data_router_dbItem_t*));
+        if (!handles)
+        {
+            LE_ERROR("ERROR calloc() failed");
+            goto cleanup;
+        }
+
+        if (db->handles)
+        {
+            memcpy(handles, db->handles, db->numHandles * sizeof(swi_mangoh_data_router_dbItem_t*));
+            swi_mangoh_data_router_db_retire(db, db->handles);
+        }
+
+        __atomic_store_n(&db->handles, handles, __ATOMIC_RELEASE);
+        db->maxHandles = maxHandles;
+    }
+
+    db->handles[db->numHandles] = dbItem;
+    dbItem->handle = db->numHandles + 1;
+    __atomic_store_n(&db->numHandles, dbItem->handle, __ATOMIC_RELEASE);
+    LE_DEBUG("register key('%s') -> handle(%u)", dbItem->key, dbItem->handle);
+
+cleanup:
+    return dbItem->handle;
+}
+
 void swi_mangoh_data_router_db_setStorageType
 (
     swi_mangoh_data_router_dbItem_t* dbItem,
@@ -276,6 +639,32 @@ void swi_mangoh_data_router_db_setStringValue
     strcpy(dbItem->data.sValue, value);
 }
 
+void swi_mangoh_data_router_db_setFloatArrayValue
+(
+    swi_mangoh_data_router_dbItem_t* dbItem,
+    const double* values,
+    size_t count
+)
+{
+    LE_ASSERT(dbItem);
+    LE_ASSERT(count <= DATAROUTER_ARRAY_MAX_LEN);
+    memcpy(dbItem->data.faValue, values, count * sizeof(double));
+    dbItem->data.count = count;
+}
+
+void swi_mangoh_data_router_db_setIntegerArrayValue
+(
+    swi_mangoh_data_router_dbItem_t* dbItem,
+    const int32_t* values,
+    size_t count
+)
+{
+    LE_ASSERT(dbItem);
+    LE_ASSERT(count <= DATAROUTER_ARRAY_MAX_LEN);
+    memcpy(dbItem->data.iaValue, values, count * sizeof(int32_t));
+    dbItem->data.count = count;
+}
+
 void swi_mangoh_data_router_db_setTimestamp(
     swi_mangoh_data_router_dbItem_t* dbItem,
     uint32_t timestamp
@@ -285,6 +674,279 @@ void swi_mangoh_data_router_db_setTimestamp(
     dbItem->data.timestamp = timestamp;
 }
 
+le_result_t swi_mangoh_data_router_db_enableHistory
+(
+    swi_mangoh_data_router_dbItem_t* dbItem,
+    uint32_t maxSamples
+)
+{
+    le_result_t res = LE_OK;
+
+    LE_ASSERT(dbItem);
+
+    if (!maxSamples || (maxSamples > SWI_MANGOH_DATA_ROUTER_DB_HISTORY_MAX_SAMPLES))
+    {
+        LE_ERROR("ERROR invalid history size(%u)", maxSamples);
+        res = LE_OUT_OF_RANGE;
+        goto cleanup;
+    }
+
+    if (dbItem->history && (dbItem->history->maxSamples == maxSamples))
+    {
+        goto cleanup;
+    }
+
+    // The ring and its sample arrays are allocated together
+    swi_mangoh_data_router_history_t* history = calloc(
+        1,
+        sizeof(swi_mangoh_data_router_history_t) +
+            maxSamples * (sizeof(double) + sizeof(uint32_t)));
+    if (!history)
+    {
+        LE_ERROR("ERROR calloc() failed");
+        res = LE_NO_MEMORY;
+        goto cleanup;
+    }
+
+    history->maxSamples = maxSamples;
+    history->values = (double*)(history + 1);
+    history->timestamps = (uint32_t*)(history->values + maxSamples);
+
+    LE_DEBUG("key('%s') history(%u)", dbItem->key, maxSamples);
+    swi_mangoh_data_router_history_t* oldHistory = dbItem->history;
+    dbItem->history = history;
+    if (oldHistory)
+    {
+        // Keep the most recent samples that fit in the new ring
+        for (uint32_t i = 0; i < oldHistory->numSamples; i++)
+        {
+            uint32_t idx = (oldHistory->head + i) % oldHistory->maxSamples;
+            swi_mangoh_data_router_db_appendHistory(
+                dbItem, &oldHistory->values[idx], &oldHistory->timestamps[idx], 1);
+        }
+
+        free(oldHistory);
+    }
+
+cleanup:
+    return res;
+}
+
+void swi_mangoh_data_router_db_appendHistory
+(
+    swi_mangoh_data_router_dbItem_t* dbItem,
+    const double* values,
+    const uint32_t* timestamps,
+    size_t numSamples
+)
+{
+    LE_ASSERT(dbItem);
+
+    swi_mangoh_data_router_history_t* history = dbItem->history;
+    if (!history)
+    {
+        return;
+    }
+
+    // Only the last maxSamples samples of the block can survive
+    if (numSamples > history->maxSamples)
+    {
+        values += numSamples - history->maxSamples;
+        timestamps += numSamples - history->maxSamples;
+        numSamples = history->maxSamples;
+    }
+
+    uint32_t tail = (history->head + history->numSamples) % history->maxSamples;
+    while (numSamples)
+    {
+        // Copy up to the end of the ring, then wrap around
+        size_t chunk = history->maxSamples - tail;
+        if (chunk > numSamples)
+        {
+            chunk = numSamples;
+        }
+
+        memcpy(&history->values[tail], values, chunk * sizeof(double));
+        memcpy(&history->timestamps[tail], timestamps, chunk * sizeof(uint32_t));
+
+        history->numSamples += chunk;
+        if (history->numSamples > history->maxSamples)
+        {
+            history->head = (history->head + history->numSamples - history->maxSamples) %
+                history->maxSamples;
+            history->numSamples = history->maxSamples;
+        }
+
+        tail = (tail + chunk) % history->maxSamples;
+        values += chunk;
+        timestamps += chunk;
+        numSamples -= chunk;
+    }
+}
+
+size_t swi_mangoh_data_router_db_readHistory
+(
+    const swi_mangoh_data_router_dbItem_t* dbItem,
+    uint32_t since,
+    double* values,
+    uint32_t* timestamps,
+    size_t maxSamples
+)
+{
+    size_t numSamples = 0;
+
+    LE_ASSERT(dbItem);
+
+    const swi_mangoh_data_router_history_t* history = dbItem->history;
+    if (history)
+    {
+        for (uint32_t i = 0; (i < history->numSamples) && (numSamples < maxSamples); i++)
+        {
+            uint32_t idx = (history->head + i) % history->maxSamples;
+            if (history->timestamps[idx] >= since)
+            {
+                values[numSamples] = history->values[idx];
+                timestamps[numSamples] = history->timestamps[idx];
+                numSamples++;
+            }
+        }
+    }
+
+    return numSamples;
+}
+
+// Sets the report by exception threshold, every update is pushed again when it is negative
+le_result_t swi_mangoh_data_router_db_setReportThreshold
+(
+    swi_mangoh_data_router_dbItem_t* dbItem,
+    double threshold
+)
+{
+    le_result_t res = LE_OK;
+
+    LE_ASSERT(dbItem);
+
+    if (isnan(threshold))
+    {
+        res = LE_OUT_OF_RANGE;
+        goto cleanup;
+    }
+
+    if (threshold < 0)
+    {
+        free(dbItem->report);
+        dbItem->report = NULL;
+        goto cleanup;
+    }
+
+    if (!dbItem->report)
+    {
+        dbItem->report = calloc(1, sizeof(swi_mangoh_data_router_report_t));
+        if (!dbItem->report)
+        {
+            LE_ERROR("ERROR calloc() failed");
+            res = LE_NO_MEMORY;
+            goto cleanup;
+        }
+    }
+
+    LE_DEBUG("key('%s') report threshold(%g)", dbItem->key, threshold);
+    dbItem->report->threshold = threshold;
+    dbItem->report->reported = false;
+
+cleanup:
+    return res;
+}
+
+// Returns whether the current value has to be pushed, and then records it as the last pushed value
+bool swi_mangoh_data_router_db_checkReport
+(
+    swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    const uint8_t* bytes = NULL;
+    size_t len = 0;
+    double value = 0;
+    uint32_t hash = 2166136261U;
+    bool changed = true;
+
+    LE_ASSERT(dbItem);
+
+    const swi_mangoh_data_router_data_t* data = &dbItem->data;
+    swi_mangoh_data_router_report_t* report = dbItem->report;
+    if (!report)
+    {
+        goto cleanup;
+    }
+
+    switch (data->type)
+    {
+        case DATAROUTER_BOOLEAN:
+            value = data->bValue;
+            break;
+
+        case DATAROUTER_INTEGER:
+            value = data->iValue;
+            break;
+
+        case DATAROUTER_FLOAT:
+            value = data->fValue;
+            break;
+
+        case DATAROUTER_STRING:
+            bytes = (const uint8_t*)data->sValue;
+            len = strnlen(data->sValue, sizeof(data->sValue));
+            break;
+
+        case DATAROUTER_FLOAT_ARRAY:
+            bytes = (const uint8_t*)data->faValue;
+            len = data->count * sizeof(data->faValue[0]);
+            break;
+
+        case DATAROUTER_INTEGER_ARRAY:
+            bytes = (const uint8_t*)data->iaValue;
+            len = data->count * sizeof(data->iaValue[0]);
+            break;
+    }
+
+    // FNV-1a
+    for (size_t i = 0; i < len; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619U;
+    }
+
+    if (report->reported && (report->type == data->type))
+    {
+        if (bytes)
+        {
+            changed = (hash != report->hash);
+        }
+        else if (data->type == DATAROUTER_BOOLEAN)
+        {
+            changed = (value != report->value);
+        }
+        else
+        {
+            changed = (fabs(value - report->value) > report->threshold) ||
+                (isnan(value) != isnan(report->value));
+        }
+    }
+
+    if (!changed)
+    {
+        report->numSuppressed++;
+        goto cleanup;
+    }
+
+    report->reported = true;
+    report->type = data->type;
+    report->value = value;
+    report->hash = hash;
+
+cleanup:
+    return changed;
+}
+
 void swi_mangoh_data_router_db_init
 (
     swi_mangoh_data_router_db_t* db
@@ -292,6 +954,8 @@ void swi_mangoh_data_router_db_init
 {
     LE_ASSERT(db);
 
+    db->retired = LE_SLS_LIST_INIT;
+    db->dirtyItems = LE_SLS_LIST_INIT;
     db->database = le_hashmap_Create(
         SWI_MANGOH_DATA_ROUTER_DB_MAP_NAME,
         SWI_MANGOH_DATA_ROUTER_DB_MAP_SIZE,
@@ -301,173 +965,211 @@ void swi_mangoh_data_router_db_init
     swi_mangoh_data_router_db_restoreEncryptedData(db);
 }
 
-// NOTE: This function doesn't actually free the memory associated with the keys or values in the
-// db.  The process is exiting anyway so the memory will be reclaimed by the OS.
-void swi_mangoh_data_router_db_destroy
+void swi_mangoh_data_router_db_storeData
 (
-    swi_mangoh_data_router_db_t* db
+    const char* key,
+    dataRouter_Storage_t storageType,
+    const swi_mangoh_data_router_data_t* data
 )
 {
-    char* encryptedKeys = NULL;
-    uint32_t encryptedKeysLen = sizeof('\0');
-
-    LE_ASSERT(db);
+    LE_ASSERT(key);
+    LE_ASSERT(data);
 
-    if (!le_hashmap_isEmpty(db->database))
+    switch (storageType)
     {
-        le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(db->database);
-
-        encryptedKeys = calloc(1, SWI_MANGOH_DATA_ROUTER_SEC_STORE_MAX_KEYS_LEN);
-        if (!encryptedKeys)
+        case DATAROUTER_PERSIST:
         {
-            LE_ERROR("ERROR calloc() failed");
-            goto cleanup;
-        }
+            char path[SWI_MANGOH_DATA_ROUTER_CFG_MAX_PATH_LEN] = {0};
 
-        int32_t res = le_hashmap_NextNode(iter);
-        while (res == LE_OK)
-        {
-            const char* key = (const char*)le_hashmap_GetKey(iter);
-            swi_mangoh_data_router_dbItem_t* dbItem =
-                (swi_mangoh_data_router_dbItem_t*)le_hashmap_GetValue(iter);
-            if (key && dbItem)
+            // All the nodes of the key are committed together
+            snprintf(path, sizeof(path), "%s/%s", SWI_MANGOH_DATA_ROUTER_CFG_BASE_NAME, key);
+            le_cfg_IteratorRef_t iterRef = le_cfg_CreateWriteTxn(path);
+
+            // TODO: is this necessary?  seems like we are associating the key with the key?
+            le_cfg_SetString(iterRef, SWI_MANGOH_DATA_ROUTER_CFG_KEY, key);
+            le_cfg_SetInt(iterRef, SWI_MANGOH_DATA_ROUTER_CFG_TYPE, data->type);
+            switch (data->type)
             {
-                switch (dbItem->storageType)
-                {
-                    case DATAROUTER_PERSIST:
-                    {
-                        char path[SWI_MANGOH_DATA_ROUTER_CFG_MAX_PATH_LEN] = {0};
-
-                        // TODO: is this necessary?  seems like we are associating the key with the
-                        // key?
-                        snprintf(
-                            path,
-                            SWI_MANGOH_DATA_ROUTER_CFG_MAX_PATH_LEN,
-                            "%s/%s/%s",
-                            SWI_MANGOH_DATA_ROUTER_CFG_BASE_NAME,
-                            key,
-                            SWI_MANGOH_DATA_ROUTER_CFG_KEY);
-                        le_cfg_QuickSetString(path, key);
-
-                        snprintf(
-                            path,
-                            SWI_MANGOH_DATA_ROUTER_CFG_MAX_PATH_LEN,
-                            "%s/%s/%s",
-                            SWI_MANGOH_DATA_ROUTER_CFG_BASE_NAME,
-                            key,
-                            SWI_MANGOH_DATA_ROUTER_CFG_TYPE);
-                        le_cfg_QuickSetInt(path, dbItem->data.type);
-
-                        snprintf(
-                            path,
-                            SWI_MANGOH_DATA_ROUTER_CFG_MAX_PATH_LEN,
-                            "%s/%s/%s",
-                            SWI_MANGOH_DATA_ROUTER_CFG_BASE_NAME,
-                            key,
-                            SWI_MANGOH_DATA_ROUTER_CFG_VALUE);
-                        switch (dbItem->data.type)
-                        {
-                            case DATAROUTER_BOOLEAN:
-                                LE_DEBUG(
-                                    "store(%u) key('%s'), value('%s')",
-                                    dbItem->storageType,
-                                    key,
-                                    dbItem->data.bValue ? "true" : "false");
-                                le_cfg_QuickSetBool(path, dbItem->data.bValue);
-                                break;
-
-                            case DATAROUTER_INTEGER:
-                                LE_DEBUG(
-                                    "store(%u) key('%s'), value(%d)",
-                                    dbItem->storageType,
-                                    key,
-                                    dbItem->data.iValue);
-                                le_cfg_QuickSetInt(path, dbItem->data.iValue);
-                                break;
-
-                            case DATAROUTER_FLOAT:
-                                LE_DEBUG(
-                                    "store(%u) key('%s'), value(%f)",
-                                    dbItem->storageType,
-                                    key,
-                                    dbItem->data.fValue);
-                                le_cfg_QuickSetFloat(path, dbItem->data.fValue);
-                                break;
-
-                            case DATAROUTER_STRING:
-                                LE_DEBUG(
-                                    "store(%u) key('%s'), value('%s')",
-                                    dbItem->storageType,
-                                    key,
-                                    dbItem->data.sValue);
-                                le_cfg_QuickSetString(path, dbItem->data.sValue);
-                                break;
-                        }
+                case DATAROUTER_BOOLEAN:
+                    LE_DEBUG(
+                        "store(%u) key('%s'), value('%s')",
+                        storageType,
+                        key,
+                        data->bValue ? "true" : "false");
+                    le_cfg_SetBool(iterRef, SWI_MANGOH_DATA_ROUTER_CFG_VALUE, data->bValue);
+                    break;
 
-                        snprintf(
-                            path,
-                            SWI_MANGOH_DATA_ROUTER_CFG_MAX_PATH_LEN,
-                            "%s/%s/%s",
-                            SWI_MANGOH_DATA_ROUTER_CFG_BASE_NAME,
-                            key,
-                            SWI_MANGOH_DATA_ROUTER_CFG_TIMESTAMP);
-                        le_cfg_QuickSetInt(path, dbItem->data.timestamp);
-                        break;
-                    }
+                case DATAROUTER_INTEGER:
+                    LE_DEBUG("store(%u) key('%s'), value(%d)", storageType, key, data->iValue);
+                    le_cfg_SetInt(iterRef, SWI_MANGOH_DATA_ROUTER_CFG_VALUE, data->iValue);
+                    break;
+
+                case DATAROUTER_FLOAT:
+                    LE_DEBUG("store(%u) key('%s'), value(%f)", storageType, key, data->fValue);
+                    le_cfg_SetFloat(iterRef, SWI_MANGOH_DATA_ROUTER_CFG_VALUE, data->fValue);
+                    break;
+
+                case DATAROUTER_STRING:
+                    LE_DEBUG("store(%u) key('%s'), value('%s')", storageType, key, data->sValue);
+                    le_cfg_SetString(iterRef, SWI_MANGOH_DATA_ROUTER_CFG_VALUE, data->sValue);
+                    break;
 
-                    case DATAROUTER_PERSIST_ENCRYPTED:
+                case DATAROUTER_FLOAT_ARRAY:
+                case DATAROUTER_INTEGER_ARRAY:
+                {
+                    LE_DEBUG("store(%u) key('%s'), count(%u)", storageType, key, data->count);
+                    snprintf(
+                        path,
+                        sizeof(path),
+                        "%s/%s",
+                        SWI_MANGOH_DATA_ROUTER_CFG_VALUE,
+                        SWI_MANGOH_DATA_ROUTER_CFG_COUNT);
+                    le_cfg_SetInt(iterRef, path, data->count);
+
+                    for (uint32_t i = 0; i < data->count; i++)
                     {
-                        res = le_secStore_Write(
-                            key,
-                            (const uint8_t*)&dbItem->data,
-                            sizeof(swi_mangoh_data_router_data_t));
-                        if (res != LE_OK)
+                        snprintf(path, sizeof(path), "%s/%u", SWI_MANGOH_DATA_ROUTER_CFG_VALUE, i);
+                        if (data->type == DATAROUTER_FLOAT_ARRAY)
                         {
-                            LE_ERROR("ERROR le_secStore_Write() failed(%d)", res);
-                            goto cleanup;
+                            le_cfg_SetFloat(iterRef, path, data->faValue[i]);
                         }
-
-                        uint32_t keyLen = strlen(key);
-                        if (encryptedKeysLen + keyLen >
-                            SWI_MANGOH_DATA_ROUTER_SEC_STORE_MAX_KEYS_LEN)
+                        else
                         {
-                            LE_ERROR(
-                                "ERROR maximum keys reached(%u > %u)",
-                                encryptedKeysLen + keyLen,
-                                SWI_MANGOH_DATA_ROUTER_SEC_STORE_MAX_KEYS_LEN);
-                            goto cleanup;
+                            le_cfg_SetInt(iterRef, path, data->iaValue[i]);
                         }
-
-                        strcat(encryptedKeys, key);
-                        strcat(encryptedKeys, SWI_MANGOH_DATA_ROUTER_SEC_STORE_KEYS_SEPARATOR);
-                        encryptedKeysLen += keyLen + 1;
-                        break;
                     }
-
-                    default:
-                        break;
+                    break;
                 }
             }
 
-            res = le_hashmap_NextNode(iter);
+            le_cfg_SetInt(iterRef, SWI_MANGOH_DATA_ROUTER_CFG_TIMESTAMP, data->timestamp);
+            le_cfg_CommitTxn(iterRef);
+            break;
         }
 
-        if (encryptedKeysLen)
+        case DATAROUTER_PERSIST_ENCRYPTED:
         {
-            res = le_secStore_Write(
-                SWI_MANGOH_DATA_ROUTER_SEC_STORE_BASE_NAME,
-                (const uint8_t*)encryptedKeys,
-                encryptedKeysLen);
+            LE_DEBUG("store(%u) key('%s')", storageType, key);
+            le_result_t res = le_secStore_Write(
+                key, (const uint8_t*)data, sizeof(swi_mangoh_data_router_data_t));
             if (res != LE_OK)
             {
                 LE_ERROR("ERROR le_secStore_Write() failed(%d)", res);
-                goto cleanup;
             }
+            break;
         }
+
+        default:
+            break;
     }
+}
 
-cleanup:
-    if (encryptedKeys)
-        free(encryptedKeys);
-    return;
+void swi_mangoh_data_router_db_deleteData
+(
+    const char* key,
+    dataRouter_Storage_t storageType
+)
+{
+    LE_ASSERT(key);
+
+    switch (storageType)
+    {
+        case DATAROUTER_PERSIST:
+        {
+            char path[SWI_MANGOH_DATA_ROUTER_CFG_MAX_PATH_LEN] = {0};
+
+            LE_DEBUG("delete(%u) key('%s')", storageType, key);
+            snprintf(path, sizeof(path), "%s/%s", SWI_MANGOH_DATA_ROUTER_CFG_BASE_NAME, key);
+            le_cfg_QuickDeleteNode(path);
+            break;
+        }
+
+        case DATAROUTER_PERSIST_ENCRYPTED:
+        {
+            LE_DEBUG("delete(%u) key('%s')", storageType, key);
+            le_result_t res = le_secStore_Delete(key);
+            if ((res != LE_OK) && (res != LE_NOT_FOUND))
+            {
+                LE_ERROR("ERROR le_secStore_Delete() failed(%d)", res);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void swi_mangoh_data_router_db_storeEncryptedKeys
+(
+    const char* encryptedKeys,
+    size_t len
+)
+{
+    LE_ASSERT(encryptedKeys);
+
+    LE_DEBUG("store encrypted keys(%zu)", len);
+    le_result_t res = le_secStore_Write(
+        SWI_MANGOH_DATA_ROUTER_SEC_STORE_BASE_NAME, (const uint8_t*)encryptedKeys, len);
+    if (res != LE_OK)
+    {
+        LE_ERROR("ERROR le_secStore_Write() failed(%d)", res);
+    }
+}
+
+size_t swi_mangoh_data_router_db_getEncryptedKeys
+(
+    swi_mangoh_data_router_db_t* db,
+    char* encryptedKeys,
+    size_t len
+)
+{
+    size_t encryptedKeysLen = 1;  // Terminating '\0'
+
+    LE_ASSERT(db);
+    LE_ASSERT(encryptedKeys);
+
+    encryptedKeys[0] = '\0';
+
+    le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(db->database);
+    while (le_hashmap_NextNode(iter) == LE_OK)
+    {
+        const char* key = (const char*)le_hashmap_GetKey(iter);
+        const swi_mangoh_data_router_dbItem_t* dbItem =
+            (const swi_mangoh_data_router_dbItem_t*)le_hashmap_GetValue(iter);
+        if (key && dbItem && (dbItem->storageType == DATAROUTER_PERSIST_ENCRYPTED))
+        {
+            size_t keyLen = strlen(key);
+            if (encryptedKeysLen + keyLen + 1 > len)
+            {
+                LE_ERROR("ERROR maximum keys reached(%zu > %zu)", encryptedKeysLen + keyLen, len);
+                break;
+            }
+
+            strcat(encryptedKeys, key);
+            strcat(encryptedKeys, SWI_MANGOH_DATA_ROUTER_SEC_STORE_KEYS_SEPARATOR);
+            encryptedKeysLen += keyLen + 1;
+        }
+    }
+
+    return encryptedKeysLen;
+}
+
+swi_mangoh_data_router_dbItem_t* swi_mangoh_data_router_db_popDirtyItem
+(
+    swi_mangoh_data_router_db_t* db
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem = NULL;
+
+    LE_ASSERT(db);
+
+    le_sls_Link_t* linkPtr = le_sls_Pop(&db->dirtyItems);
+    if (linkPtr)
+    {
+        dbItem = CONTAINER_OF(linkPtr, swi_mangoh_data_router_dbItem_t, dirtyLink);
+        dbItem->dirty = false;
+    }
+
+    return dbItem;
 }
@@ -25,9 +25,13 @@
 #define SWI_MANGOH_DATA_ROUTER_CFG_TYPE "type"
 #define SWI_MANGOH_DATA_ROUTER_CFG_VALUE "value"
 #define SWI_MANGOH_DATA_ROUTER_CFG_TIMESTAMP "timestamp"
+#define SWI_MANGOH_DATA_ROUTER_CFG_COUNT "count"
 
 #define SWI_MANGOH_DATA_ROUTER_DB_MAP_NAME "WorkflowMgrDB"
 #define SWI_MANGOH_DATA_ROUTER_DB_MAP_SIZE 63
+#define SWI_MANGOH_DATA_ROUTER_DB_HANDLES_INIT_SIZE 64
+#define SWI_MANGOH_DATA_ROUTER_DB_HISTORY_MAX_SAMPLES 4096
+#define SWI_MANGOH_DATA_ROUTER_DB_INDEX_INIT_SIZE 128
 
 #define SWI_MANGOH_DATA_ROUTER_APP_NAME_LEN 64
 #define SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN 128
@@ -47,10 +51,49 @@ typedef struct _swi_mangoh_data_router_data_t
         double  fValue;
         int32_t iValue;  ///< Data integer value
         bool    bValue;  ///< Data boolean values
+        struct
+        {
+            uint32_t count;  ///< Number of array elements
+            union
+            {
+                double  faValue[DATAROUTER_ARRAY_MAX_LEN];  ///< Data float array values
+                int32_t iaValue[DATAROUTER_ARRAY_MAX_LEN];  ///< Data integer array values
+            };
+        };
     };
     time_t timestamp;  ///< Data timestamp
 } swi_mangoh_data_router_data_t;
 
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router float sample history, a ring of the last samples written to a key
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_history_t
+{
+    uint32_t maxSamples;  ///< Ring size
+    uint32_t numSamples;  ///< Number of samples in the ring
+    uint32_t head;        ///< Index of the oldest sample
+    double* values;       ///< Sample values
+    uint32_t* timestamps; ///< Sample timestamps
+} swi_mangoh_data_router_history_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router report by exception state of a key, an update is only pushed when it differs from
+ * the last pushed value by more than the threshold.  Strings and arrays are compared by hash.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_report_t
+{
+    double threshold;           ///< Smallest change pushed, 0 for any change
+    bool reported;              ///< A value was pushed since the threshold was set
+    dataRouter_DataType_t type; ///< Type of the last pushed value
+    double value;               ///< Last pushed boolean, integer or float value
+    uint32_t hash;              ///< Hash of the last pushed string or array
+    uint32_t numSuppressed;     ///< Updates not pushed
+} swi_mangoh_data_router_report_t;
+
 //-------------------------------------------------------------------------------------------------
 /**
  * Data Router database item
@@ -59,11 +102,58 @@ typedef struct _swi_mangoh_data_router_data_t
 typedef struct _swi_mangoh_data_router_dbItem_t
 {
     swi_mangoh_data_router_data_t data; ///< Data value
+    bool hasValue;                      ///< Data written or restored, zeroed until then
     le_sls_List_t handlers;             ///< Data update handlers ::
                                         ///  swi_mangoh_data_router_dataUpdateHandler_t
     dataRouter_Storage_t storageType;   ///< Data storage
+    const char* key;                    ///< Data key, owned by the database map
+    uint32_t handle;                    ///< Data key handle, DATAROUTER_INVALID_HANDLE until the
+                                        ///  key is registered
+    swi_mangoh_data_router_history_t* history; ///< Sample history, NULL unless enabled
+    swi_mangoh_data_router_report_t* report; ///< Report by exception state, NULL when every
+                                        ///  update is pushed
+    struct _swi_mangoh_data_router_aggregate_t* aggregate; ///< Upstream aggregation, NULL
+                                        ///  unless enabled
+    uint32_t seq;                       ///< Data sequence lock, odd while data is being updated
+    dataRouter_Storage_t persistedStorageType; ///< Storage the data was last persisted to
+    bool dirty;                         ///< Data not persisted yet flag
+    le_sls_Link_t dirtyLink;            ///< Linked list link to next dirty item
+    bool notifyPending;                 ///< Update notification deferred to the end of a batch
+    le_sls_Link_t notifyLink;           ///< Linked list link to next item to notify
+    uint32_t syncedSeq;                 ///< Data sequence in the last full state snapshot
+    dataRouter_Priority_t priority;     ///< Upstream priority class
+    uint32_t priorityGeneration;        ///< Priority rules generation the class was matched with
+    uint32_t deriveMask;                ///< Derived keys computed from the item, a bit per slot
+    struct _swi_mangoh_data_router_ruleRef_t* rules; ///< Rules whose condition reads the item,
+                                        ///  NULL when none
 } swi_mangoh_data_router_dbItem_t;
 
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router database key index used by the reader thread.  Slots are only ever filled while
+ * the index is published, when it fills up a larger copy is published in its place.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_dbIndex_t
+{
+    uint32_t size;                            ///< Number of slots, a power of 2
+    uint32_t numItems;                        ///< Number of filled slots
+    swi_mangoh_data_router_dbItem_t* items[]; ///< Open addressing slots
+} swi_mangoh_data_router_dbIndex_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router database block replaced while the reader thread may still be using it.  Retired
+ * blocks are kept until exit, the retired index and handle tables are bounded by the size of the
+ * live ones and data items are only replaced when a key is restored twice.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_dbRetired_t
+{
+    void* block;        ///< Retired index, handle table or data item
+    le_sls_Link_t link; ///< Linked list link to next element
+} swi_mangoh_data_router_dbRetired_t;
+
 //-------------------------------------------------------------------------------------------------
 /**
  * Data Router database module
@@ -73,11 +163,37 @@ typedef struct _swi_mangoh_data_router_db_t
 {
     le_hashmap_Ref_t database; ///< Data cache: key :: string, value ::
                                ///  swi_mangoh_data_router_dbItem_t
+    swi_mangoh_data_router_dbItem_t** handles; ///< Handle table, handle N is stored at index N - 1
+    uint32_t numHandles;       ///< Number of handles in use
+    uint32_t maxHandles;       ///< Allocated size of the handle table
+    swi_mangoh_data_router_dbIndex_t* index; ///< Key index published to the reader thread
+    le_sls_List_t retired;     ///< Blocks replaced while readers may use them ::
+                               ///  swi_mangoh_data_router_dbRetired_t
+    le_sls_List_t dirtyItems;  ///< Items to persist :: swi_mangoh_data_router_dbItem_t
 } swi_mangoh_data_router_db_t;
 
 swi_mangoh_data_router_dbItem_t* swi_mangoh_data_router_db_getDataItem(
     swi_mangoh_data_router_db_t*,
     const char*);
+swi_mangoh_data_router_dbItem_t* swi_mangoh_data_router_db_getDataItemByHandle(
+    swi_mangoh_data_router_db_t*,
+    uint32_t);
+const swi_mangoh_data_router_dbItem_t* swi_mangoh_data_router_db_lookupDataItem(
+    swi_mangoh_data_router_db_t*,
+    const char*);
+const swi_mangoh_data_router_dbItem_t* swi_mangoh_data_router_db_lookupDataItemByHandle(
+    swi_mangoh_data_router_db_t*,
+    uint32_t);
+void swi_mangoh_data_router_db_beginUpdate(swi_mangoh_data_router_dbItem_t*);
+void swi_mangoh_data_router_db_endUpdate(
+    swi_mangoh_data_router_db_t*,
+    swi_mangoh_data_router_dbItem_t*);
+void swi_mangoh_data_router_db_readData(
+    const swi_mangoh_data_router_dbItem_t*,
+    swi_mangoh_data_router_data_t*);
+uint32_t swi_mangoh_data_router_db_registerHandle(
+    swi_mangoh_data_router_db_t*,
+    swi_mangoh_data_router_dbItem_t*);
 void swi_mangoh_data_router_db_setStorageType(
     swi_mangoh_data_router_dbItem_t*,
     dataRouter_Storage_t);
@@ -88,12 +204,42 @@ void swi_mangoh_data_router_db_setBooleanValue(swi_mangoh_data_router_dbItem_t*,
 void swi_mangoh_data_router_db_setIntegerValue(swi_mangoh_data_router_dbItem_t*, int32_t);
 void swi_mangoh_data_router_db_setFloatValue(swi_mangoh_data_router_dbItem_t*, double);
 void swi_mangoh_data_router_db_setStringValue(swi_mangoh_data_router_dbItem_t*, const char*);
+void swi_mangoh_data_router_db_setFloatArrayValue(
+    swi_mangoh_data_router_dbItem_t*,
+    const double*,
+    size_t);
+void swi_mangoh_data_router_db_setIntegerArrayValue(
+    swi_mangoh_data_router_dbItem_t*,
+    const int32_t*,
+    size_t);
 void swi_mangoh_data_router_db_setTimestamp(swi_mangoh_data_router_dbItem_t*, uint32_t);
+le_result_t swi_mangoh_data_router_db_enableHistory(swi_mangoh_data_router_dbItem_t*, uint32_t);
+void swi_mangoh_data_router_db_appendHistory(
+    swi_mangoh_data_router_dbItem_t*,
+    const double*,
+    const uint32_t*,
+    size_t);
+size_t swi_mangoh_data_router_db_readHistory(
+    const swi_mangoh_data_router_dbItem_t*,
+    uint32_t,
+    double*,
+    uint32_t*,
+    size_t);
+le_result_t swi_mangoh_data_router_db_setReportThreshold(swi_mangoh_data_router_dbItem_t*, double);
+bool swi_mangoh_data_router_db_checkReport(swi_mangoh_data_router_dbItem_t*);
 
 swi_mangoh_data_router_dbItem_t* swi_mangoh_data_router_db_createDataItem(
     swi_mangoh_data_router_db_t*,
     const char*);
 void swi_mangoh_data_router_db_init(swi_mangoh_data_router_db_t*);
-void swi_mangoh_data_router_db_destroy(swi_mangoh_data_router_db_t*);
+swi_mangoh_data_router_dbItem_t* swi_mangoh_data_router_db_popDirtyItem(
+    swi_mangoh_data_router_db_t*);
+size_t swi_mangoh_data_router_db_getEncryptedKeys(swi_mangoh_data_router_db_t*, char*, size_t);
+void swi_mangoh_data_router_db_storeData(
+    const char*,
+    dataRouter_Storage_t,
+    const swi_mangoh_data_router_data_t*);
+void swi_mangoh_data_router_db_deleteData(const char*, dataRouter_Storage_t);
+void swi_mangoh_data_router_db_storeEncryptedKeys(const char*, size_t);
 
 #endif
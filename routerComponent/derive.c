@@ -0,0 +1,955 @@
+/**
+ * @file
+ *
+ * A derived key is defined by an expression over source keys, e.g.
+ * "{power/ch1} + {power/ch2}", "{temp} * 1.8 + 32" or "avg({temp}, 10)".  Sources are written in
+ * braces, the windowed aggregates avg, sum, min and max take the last values of a source.  The
+ * expression is compiled once to a stack program, and the derived values are floats.
+ *
+ * Updates of the sources only record the value in the windows and mark the derived keys dirty, so
+ * a request or a batch updating several sources evaluates each derived key once.  Derived keys of
+ * derived keys are evaluated after their sources, as their level is higher.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include <math.h>
+
+#include "derive.h"
+#include "text.h"
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Derived key expression compiler
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_deriveParser_t
+{
+    swi_mangoh_data_router_db_t* db;           ///< Database module
+    swi_mangoh_data_router_derived_t* derived; ///< Derived key being compiled
+    const char* pos;                           ///< Expression position
+} swi_mangoh_data_router_deriveParser_t;
+
+static const char* const swi_mangoh_data_router_derive_windowNames[] =
+{
+    "avg",
+    "sum",
+    "min",
+    "max",
+};
+
+static bool swi_mangoh_data_router_derive_getNumber(const swi_mangoh_data_router_data_t*, double*);
+static le_result_t swi_mangoh_data_router_derive_emit(
+    swi_mangoh_data_router_deriveParser_t*,
+    swi_mangoh_data_router_deriveOp_e,
+    double,
+    uint32_t);
+static le_result_t swi_mangoh_data_router_derive_parseSource(
+    swi_mangoh_data_router_deriveParser_t*,
+    uint32_t*);
+static le_result_t swi_mangoh_data_router_derive_parseWindow(
+    swi_mangoh_data_router_deriveParser_t*,
+    swi_mangoh_data_router_deriveWindowFunc_e);
+static le_result_t swi_mangoh_data_router_derive_parsePrimary(
+    swi_mangoh_data_router_deriveParser_t*);
+static le_result_t swi_mangoh_data_router_derive_parseTerm(swi_mangoh_data_router_deriveParser_t*);
+static le_result_t swi_mangoh_data_router_derive_parseExpr(swi_mangoh_data_router_deriveParser_t*);
+static swi_mangoh_data_router_derived_t* swi_mangoh_data_router_derive_find(
+    const swi_mangoh_data_router_derive_t*,
+    const swi_mangoh_data_router_dbItem_t*);
+static bool swi_mangoh_data_router_derive_dependsOn(
+    const swi_mangoh_data_router_derive_t*,
+    const swi_mangoh_data_router_derived_t*,
+    const swi_mangoh_data_router_dbItem_t*);
+static void swi_mangoh_data_router_derive_sort(swi_mangoh_data_router_derive_t*);
+static void swi_mangoh_data_router_derive_free(swi_mangoh_data_router_derive_t*, uint32_t);
+static le_result_t swi_mangoh_data_router_derive_run(
+    const swi_mangoh_data_router_derived_t*,
+    double*);
+static void swi_mangoh_data_router_derive_evaluate(void*, void*);
+
+static bool swi_mangoh_data_router_derive_getNumber
+(
+    const swi_mangoh_data_router_data_t* data,
+    double* value
+)
+{
+    bool res = true;
+
+    switch (data->type)
+    {
+        case DATAROUTER_BOOLEAN:
+            *value = data->bValue ? 1 : 0;
+            break;
+
+        case DATAROUTER_INTEGER:
+            *value = data->iValue;
+            break;
+
+        case DATAROUTER_FLOAT:
+            *value = data->fValue;
+            break;
+
+        default:
+            res = false;
+            break;
+    }
+
+    return res;
+}
+
+static le_result_t swi_mangoh_data_router_derive_emit
+(
+    swi_mangoh_data_router_deriveParser_t* parser,
+    swi_mangoh_data_router_deriveOp_e op,
+    double value,
+    uint32_t index
+)
+{
+    swi_mangoh_data_router_derived_t* derived = parser->derived;
+    le_result_t res = LE_OK;
+
+    if (derived->programLen >= SWI_MANGOH_DATA_ROUTER_DERIVE_PROGRAM_MAX_LEN)
+    {
+        LE_ERROR("ERROR expression too long");
+        res = LE_BAD_PARAMETER;
+        goto cleanup;
+    }
+
+    derived->program[derived->programLen].op = op;
+    derived->program[derived->programLen].value = value;
+    derived->program[derived->programLen].index = index;
+    derived->programLen++;
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a source key in braces, and get its index in the sources of the derived key
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t swi_mangoh_data_router_derive_parseSource
+(
+    swi_mangoh_data_router_deriveParser_t* parser,
+    uint32_t* index
+)
+{
+    swi_mangoh_data_router_derived_t* derived = parser->derived;
+    char key[SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN] = {0};
+    le_result_t res = LE_OK;
+
+    const char* end = (*parser->pos == '{') ? strchr(parser->pos, '}') : NULL;
+    size_t len = end ? (size_t)(end - parser->pos - 1) : 0;
+    if (!len || (len >= sizeof(key)))
+    {
+        LE_ERROR("ERROR invalid source key at '%s'", parser->pos);
+        res = LE_BAD_PARAMETER;
+        goto cleanup;
+    }
+
+    memcpy(key, parser->pos + 1, len);
+    parser->pos = end + 1;
+
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(parser->db, key);
+    bool seen = dbItem && dbItem->hasValue;
+    if (!dbItem)
+    {
+        dbItem = swi_mangoh_data_router_db_createDataItem(parser->db, key);
+        if (!dbItem)
+        {
+            LE_ERROR("ERROR swi_mangoh_data_router_db_createDataItem() failed");
+            res = LE_NO_MEMORY;
+            goto cleanup;
+        }
+    }
+
+    for (*index = 0; *index < derived->numSources; (*index)++)
+    {
+        if (derived->sources[*index] == dbItem)
+        {
+            goto cleanup;
+        }
+    }
+
+    if (derived->numSources >= SWI_MANGOH_DATA_ROUTER_DERIVE_SOURCES_MAX_NUM)
+    {
+        LE_ERROR("ERROR too many source keys");
+        res = LE_BAD_PARAMETER;
+        goto cleanup;
+    }
+
+    derived->sources[derived->numSources] = dbItem;
+    if (seen)
+    {
+        derived->seenSources |= (1U << derived->numSources);
+    }
+    derived->numSources++;
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse the "({key}, length)" arguments of a window aggregate
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t swi_mangoh_data_router_derive_parseWindow
+(
+    swi_mangoh_data_router_deriveParser_t* parser,
+    swi_mangoh_data_router_deriveWindowFunc_e func
+)
+{
+    swi_mangoh_data_router_derived_t* derived = parser->derived;
+    uint32_t source = 0;
+    uint64_t len = 0;
+    le_result_t res = LE_BAD_PARAMETER;
+
+    if (derived->numWindows >= SWI_MANGOH_DATA_ROUTER_DERIVE_WINDOWS_MAX_NUM)
+    {
+        LE_ERROR("ERROR too many windows");
+        goto cleanup;
+    }
+
+    parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+    if (*parser->pos != '(')
+    {
+        LE_ERROR("ERROR expected '(' at '%s'", parser->pos);
+        goto cleanup;
+    }
+
+    parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos + 1);
+    res = swi_mangoh_data_router_derive_parseSource(parser, &source);
+    if (res != LE_OK)
+    {
+        goto cleanup;
+    }
+
+    res = LE_BAD_PARAMETER;
+    parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+    if (*parser->pos != ',')
+    {
+        LE_ERROR("ERROR expected ',' at '%s'", parser->pos);
+        goto cleanup;
+    }
+
+    parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos + 1);
+    if ((swi_mangoh_data_router_text_scanUint(parser->pos, &parser->pos, &len) != LE_OK) ||
+        !len || (len > SWI_MANGOH_DATA_ROUTER_DERIVE_WINDOW_MAX_LEN))
+    {
+        LE_ERROR("ERROR invalid window length at '%s'", parser->pos);
+        goto cleanup;
+    }
+
+    parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+    if (*parser->pos != ')')
+    {
+        LE_ERROR("ERROR expected ')' at '%s'", parser->pos);
+        goto cleanup;
+    }
+    parser->pos++;
+
+    swi_mangoh_data_router_deriveWindow_t* window = &derived->windows[derived->numWindows];
+    window->func = func;
+    window->source = source;
+    window->len = len;
+    res = swi_mangoh_data_router_derive_emit(
+        parser, SWI_MANGOH_DATA_ROUTER_DERIVE_OP_WINDOW, 0, derived->numWindows);
+    derived->numWindows++;
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a number, a source key, a window aggregate, a negation or an expression in parentheses
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t swi_mangoh_data_router_derive_parsePrimary
+(
+    swi_mangoh_data_router_deriveParser_t* parser
+)
+{
+    le_result_t res = LE_BAD_PARAMETER;
+    uint32_t index = 0;
+    double value = 0;
+
+    parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+    if (*parser->pos == '-')
+    {
+        parser->pos++;
+        res = swi_mangoh_data_router_derive_parsePrimary(parser);
+        if (res == LE_OK)
+        {
+            res = swi_mangoh_data_router_derive_emit(
+                parser, SWI_MANGOH_DATA_ROUTER_DERIVE_OP_NEG, 0, 0);
+        }
+    }
+    else if (*parser->pos == '(')
+    {
+        parser->pos++;
+        res = swi_mangoh_data_router_derive_parseExpr(parser);
+        if (res != LE_OK)
+        {
+            goto cleanup;
+        }
+
+        // The ')' is only consumed when present, the position stays within the expression
+        parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+        if (*parser->pos != ')')
+        {
+            LE_ERROR("ERROR expected ')' at '%s'", parser->pos);
+            res = LE_BAD_PARAMETER;
+            goto cleanup;
+        }
+        parser->pos++;
+    }
+    else if (*parser->pos == '{')
+    {
+        res = swi_mangoh_data_router_derive_parseSource(parser, &index);
+        if (res == LE_OK)
+        {
+            res = swi_mangoh_data_router_derive_emit(
+                parser, SWI_MANGOH_DATA_ROUTER_DERIVE_OP_SOURCE, 0, index);
+        }
+    }
+    else if ((*parser->pos >= '0') && (*parser->pos <= '9'))
+    {
+        res = swi_mangoh_data_router_text_scanDouble(parser->pos, &parser->pos, &value);
+        if (res == LE_OK)
+        {
+            res = swi_mangoh_data_router_derive_emit(
+                parser, SWI_MANGOH_DATA_ROUTER_DERIVE_OP_CONST, value, 0);
+        }
+        else
+        {
+            LE_ERROR("ERROR invalid number at '%s'", parser->pos);
+            res = LE_BAD_PARAMETER;
+        }
+    }
+    else
+    {
+        const char* const* names = swi_mangoh_data_router_derive_windowNames;
+        for (uint32_t i = 0; i < NUM_ARRAY_MEMBERS(swi_mangoh_data_router_derive_windowNames); i++)
+        {
+            size_t len = strlen(names[i]);
+            if (!strncmp(parser->pos, names[i], len))
+            {
+                parser->pos += len;
+                res = swi_mangoh_data_router_derive_parseWindow(parser, i);
+                goto cleanup;
+            }
+        }
+
+        LE_ERROR("ERROR unexpected '%s'", parser->pos);
+    }
+
+cleanup:
+    return res;
+}
+
+static le_result_t swi_mangoh_data_router_derive_parseTerm
+(
+    swi_mangoh_data_router_deriveParser_t* parser
+)
+{
+    le_result_t res = swi_mangoh_data_router_derive_parsePrimary(parser);
+
+    while (res == LE_OK)
+    {
+        parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+        char op = *parser->pos;
+        if ((op != '*') && (op != '/'))
+        {
+            break;
+        }
+
+        parser->pos++;
+        res = swi_mangoh_data_router_derive_parsePrimary(parser);
+        if (res == LE_OK)
+        {
+            res = swi_mangoh_data_router_derive_emit(
+                parser,
+                (op == '*') ? SWI_MANGOH_DATA_ROUTER_DERIVE_OP_MUL :
+                              SWI_MANGOH_DATA_ROUTER_DERIVE_OP_DIV,
+                0,
+                0);
+        }
+    }
+
+    return res;
+}
+
+static le_result_t swi_mangoh_data_router_derive_parseExpr
+(
+    swi_mangoh_data_router_deriveParser_t* parser
+)
+{
+    le_result_t res = swi_mangoh_data_router_derive_parseTerm(parser);
+
+    while (res == LE_OK)
+    {
+        parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+        char op = *parser->pos;
+        if ((op != '+') && (op != '-'))
+        {
+            break;
+        }
+
+        parser->pos++;
+        res = swi_mangoh_data_router_derive_parseTerm(parser);
+        if (res == LE_OK)
+        {
+            res = swi_mangoh_data_router_derive_emit(
+                parser,
+                (op == '+') ? SWI_MANGOH_DATA_ROUTER_DERIVE_OP_ADD :
+                              SWI_MANGOH_DATA_ROUTER_DERIVE_OP_SUB,
+                0,
+                0);
+        }
+    }
+
+    return res;
+}
+
+static swi_mangoh_data_router_derived_t* swi_mangoh_data_router_derive_find
+(
+    const swi_mangoh_data_router_derive_t* derive,
+    const swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    swi_mangoh_data_router_derived_t* derived = NULL;
+
+    for (uint32_t i = 0; i < derive->numDerived; i++)
+    {
+        if (derive->derived[i]->dbItem == dbItem)
+        {
+            derived = derive->derived[i];
+            break;
+        }
+    }
+
+    return derived;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a derived key is computed from an item, directly or through other derived keys
+ */
+//--------------------------------------------------------------------------------------------------
+static bool swi_mangoh_data_router_derive_dependsOn
+(
+    const swi_mangoh_data_router_derive_t* derive,
+    const swi_mangoh_data_router_derived_t* derived,
+    const swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    bool res = false;
+
+    for (uint32_t i = 0; !res && (i < derived->numSources); i++)
+    {
+        const swi_mangoh_data_router_derived_t* source =
+            swi_mangoh_data_router_derive_find(derive, derived->sources[i]);
+
+        res = (derived->sources[i] == dbItem) ||
+              (source && swi_mangoh_data_router_derive_dependsOn(derive, source, dbItem));
+    }
+
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update the levels of the derived keys and their evaluation order.  The graph has no cycles, so
+ * the levels settle within one pass per derived key.
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_derive_sort
+(
+    swi_mangoh_data_router_derive_t* derive
+)
+{
+    bool changed = true;
+
+    for (uint32_t pass = 0; changed && (pass <= derive->numDerived); pass++)
+    {
+        changed = false;
+        for (uint32_t i = 0; i < derive->numDerived; i++)
+        {
+            swi_mangoh_data_router_derived_t* derived = derive->derived[i];
+            uint32_t level = 0;
+
+            for (uint32_t j = 0; j < derived->numSources; j++)
+            {
+                const swi_mangoh_data_router_derived_t* source =
+                    swi_mangoh_data_router_derive_find(derive, derived->sources[j]);
+                if (source && (source->level + 1 > level))
+                {
+                    level = source->level + 1;
+                }
+            }
+
+            changed = changed || (level != derived->level);
+            derived->level = level;
+        }
+    }
+
+    for (uint32_t i = 0; i < derive->numDerived; i++)
+    {
+        uint32_t slot = i;
+        uint32_t j = i;
+
+        for (; (j > 0) && (derive->derived[derive->order[j - 1]]->level >
+                           derive->derived[slot]->level);
+             j--)
+        {
+            derive->order[j] = derive->order[j - 1];
+        }
+        derive->order[j] = slot;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Free the derived key of a slot.  The last derived key moves to the freed slot, so the slots stay
+ * packed and the source masks are updated to match.  The derived item keeps its last value as a
+ * plain key, and the keys derived from it stop being evaluated until it is written again.
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_derive_free
+(
+    swi_mangoh_data_router_derive_t* derive,
+    uint32_t slot
+)
+{
+    swi_mangoh_data_router_derived_t* derived = derive->derived[slot];
+    uint32_t last = derive->numDerived - 1;
+
+    for (uint32_t i = 0; i < derived->numSources; i++)
+    {
+        derived->sources[i]->deriveMask &= ~(1U << slot);
+    }
+
+    if (slot != last)
+    {
+        swi_mangoh_data_router_derived_t* moved = derive->derived[last];
+        for (uint32_t i = 0; i < moved->numSources; i++)
+        {
+            moved->sources[i]->deriveMask &= ~(1U << last);
+            moved->sources[i]->deriveMask |= (1U << slot);
+        }
+
+        derive->derived[slot] = moved;
+    }
+
+    derive->derived[last] = NULL;
+    derive->numDerived--;
+    swi_mangoh_data_router_derive_sort(derive);
+    LE_INFO("key('%s') no longer derived", derived->dbItem->key);
+    free(derived);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run the program of a derived key on the current values of its sources
+ *
+ * @return
+ *      - LE_OK on success
+ *      - LE_FORMAT_ERROR if a source is not a number or a window is empty
+ *      - LE_OUT_OF_RANGE if the result is not finite
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t swi_mangoh_data_router_derive_run
+(
+    const swi_mangoh_data_router_derived_t* derived,
+    double* value
+)
+{
+    double stack[SWI_MANGOH_DATA_ROUTER_DERIVE_PROGRAM_MAX_LEN];
+    uint32_t depth = 0;
+    le_result_t res = LE_OK;
+
+    for (uint32_t i = 0; i < derived->programLen; i++)
+    {
+        const swi_mangoh_data_router_deriveInstr_t* instr = &derived->program[i];
+        const swi_mangoh_data_router_deriveWindow_t* window = NULL;
+
+        switch (instr->op)
+        {
+            case SWI_MANGOH_DATA_ROUTER_DERIVE_OP_CONST:
+                stack[depth++] = instr->value;
+                break;
+
+            case SWI_MANGOH_DATA_ROUTER_DERIVE_OP_SOURCE:
+                if (!swi_mangoh_data_router_derive_getNumber(
+                        &derived->sources[instr->index]->data, &stack[depth++]))
+                {
+                    res = LE_FORMAT_ERROR;
+                    goto cleanup;
+                }
+                break;
+
+            case SWI_MANGOH_DATA_ROUTER_DERIVE_OP_WINDOW:
+                window = &derived->windows[instr->index];
+                if (!window->count)
+                {
+                    res = LE_FORMAT_ERROR;
+                    goto cleanup;
+                }
+
+                // Summed over the ring rather than kept running, so that rounding doesn't drift
+                stack[depth] = window->values[0];
+                for (uint32_t j = 1; j < window->count; j++)
+                {
+                    double v = window->values[j];
+                    switch (window->func)
+                    {
+                        case SWI_MANGOH_DATA_ROUTER_DERIVE_WINDOW_MIN:
+                            stack[depth] = (v < stack[depth]) ? v : stack[depth];
+                            break;
+
+                        case SWI_MANGOH_DATA_ROUTER_DERIVE_WINDOW_MAX:
+                            stack[depth] = (v > stack[depth]) ? v : stack[depth];
+                            break;
+
+                        default:
+                            stack[depth] += v;
+                            break;
+                    }
+                }
+
+                if (window->func == SWI_MANGOH_DATA_ROUTER_DERIVE_WINDOW_AVG)
+                {
+                    stack[depth] /= window->count;
+                }
+                depth++;
+                break;
+
+            case SWI_MANGOH_DATA_ROUTER_DERIVE_OP_NEG:
+                stack[depth - 1] = -stack[depth - 1];
+                break;
+
+            default:
+                depth--;
+                switch (instr->op)
+                {
+                    case SWI_MANGOH_DATA_ROUTER_DERIVE_OP_ADD:
+                        stack[depth - 1] += stack[depth];
+                        break;
+
+                    case SWI_MANGOH_DATA_ROUTER_DERIVE_OP_SUB:
+                        stack[depth - 1] -= stack[depth];
+                        break;
+
+                    case SWI_MANGOH_DATA_ROUTER_DERIVE_OP_MUL:
+                        stack[depth - 1] *= stack[depth];
+                        break;
+
+                    default:
+                        stack[depth - 1] /= stack[depth];
+                        break;
+                }
+                break;
+        }
+    }
+
+    LE_ASSERT(depth == 1);
+    *value = stack[0];
+    if (!isfinite(*value))
+    {
+        res = LE_OUT_OF_RANGE;
+    }
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Evaluate the dirty derived keys in level order, queued to the event loop by the first source
+ * update
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_derive_evaluate
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    swi_mangoh_data_router_derive_t* derive = (swi_mangoh_data_router_derive_t*)param1Ptr;
+    LE_ASSERT(derive);
+
+    for (uint32_t i = 0; i < derive->numDerived; i++)
+    {
+        swi_mangoh_data_router_derived_t* derived = derive->derived[derive->order[i]];
+        uint32_t allSources = (1U << derived->numSources) - 1;
+        double value = 0;
+
+        if (!derived->dirty || (derived->seenSources != allSources))
+        {
+            continue;
+        }
+
+        derived->dirty = false;
+        le_result_t res = swi_mangoh_data_router_derive_run(derived, &value);
+        if (res != LE_OK)
+        {
+            LE_DEBUG("key('%s') not evaluated(%d)", derived->dbItem->key, res);
+            continue;
+        }
+
+        derived->numEvaluations++;
+        swi_mangoh_data_router_db_beginUpdate(derived->dbItem);
+        swi_mangoh_data_router_db_setDataType(derived->dbItem, DATAROUTER_FLOAT);
+        swi_mangoh_data_router_db_setFloatValue(derived->dbItem, value);
+        swi_mangoh_data_router_db_setTimestamp(derived->dbItem, derived->timestamp);
+        swi_mangoh_data_router_db_endUpdate(derive->db, derived->dbItem);
+
+        // Marks the derived keys of higher levels, evaluated later in this pass
+        derive->handler(derived->dbItem->key, derived->dbItem);
+    }
+
+    derive->scheduled = false;
+}
+
+void swi_mangoh_data_router_derive_init
+(
+    swi_mangoh_data_router_derive_t* derive,
+    swi_mangoh_data_router_db_t* db,
+    swi_mangoh_data_router_deriveHandler_t handler
+)
+{
+    LE_ASSERT(derive);
+    LE_ASSERT(db);
+    LE_ASSERT(handler);
+
+    memset(derive, 0, sizeof(swi_mangoh_data_router_derive_t));
+    derive->db = db;
+    derive->handler = handler;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Define a derived key of an owner from an expression over source keys
+ *
+ * @return
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the expression is invalid or the key is one of its own sources
+ *      - LE_DUPLICATE if the key is already derived
+ *      - LE_NO_MEMORY if there are too many derived keys or a key could not be created
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t swi_mangoh_data_router_derive_define
+(
+    swi_mangoh_data_router_derive_t* derive,
+    void* owner,
+    const char* key,
+    const char* expression
+)
+{
+    LE_ASSERT(derive);
+    LE_ASSERT(key);
+    LE_ASSERT(expression);
+
+    swi_mangoh_data_router_derived_t* derived = NULL;
+    le_result_t res = LE_OK;
+
+    if (derive->numDerived >= SWI_MANGOH_DATA_ROUTER_DERIVE_MAX_NUM)
+    {
+        LE_ERROR("ERROR too many derived keys");
+        res = LE_NO_MEMORY;
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(derive->db, key);
+    if (!dbItem)
+    {
+        dbItem = swi_mangoh_data_router_db_createDataItem(derive->db, key);
+        if (!dbItem)
+        {
+            LE_ERROR("ERROR swi_mangoh_data_router_db_createDataItem() failed");
+            res = LE_NO_MEMORY;
+            goto cleanup;
+        }
+    }
+
+    if (swi_mangoh_data_router_derive_find(derive, dbItem))
+    {
+        LE_ERROR("ERROR key('%s') already derived", key);
+        res = LE_DUPLICATE;
+        goto cleanup;
+    }
+
+    derived = calloc(1, sizeof(swi_mangoh_data_router_derived_t));
+    LE_ASSERT(derived);
+    derived->dbItem = dbItem;
+    derived->owner = owner;
+
+    swi_mangoh_data_router_deriveParser_t parser = { derive->db, derived, expression };
+    res = swi_mangoh_data_router_derive_parseExpr(&parser);
+    if ((res == LE_OK) && *swi_mangoh_data_router_text_skipSpaces(parser.pos))
+    {
+        LE_ERROR("ERROR unexpected '%s'", parser.pos);
+        res = LE_BAD_PARAMETER;
+    }
+
+    if (res != LE_OK)
+    {
+        goto cleanup;
+    }
+
+    if (swi_mangoh_data_router_derive_dependsOn(derive, derived, dbItem))
+    {
+        LE_ERROR("ERROR key('%s') depends on itself", key);
+        res = LE_BAD_PARAMETER;
+        goto cleanup;
+    }
+
+    uint32_t slot = derive->numDerived++;
+    derive->derived[slot] = derived;
+    for (uint32_t i = 0; i < derived->numSources; i++)
+    {
+        derived->sources[i]->deriveMask |= (1U << slot);
+    }
+    swi_mangoh_data_router_derive_sort(derive);
+    LE_INFO(
+        "key('%s') derived from sources(%u) level(%u) program(%u)",
+        key,
+        derived->numSources,
+        derived->level,
+        derived->programLen);
+
+    // Compute the initial value when the sources already hold one
+    derived->dirty = true;
+    if (!derive->scheduled)
+    {
+        derive->scheduled = true;
+        le_event_QueueFunction(swi_mangoh_data_router_derive_evaluate, derive, NULL);
+    }
+    derived = NULL;
+
+cleanup:
+    free(derived);
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a derived key of an owner
+ *
+ * @return
+ *      - LE_OK on success
+ *      - LE_NOT_FOUND if the owner has not derived the key
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t swi_mangoh_data_router_derive_remove
+(
+    swi_mangoh_data_router_derive_t* derive,
+    void* owner,
+    const char* key
+)
+{
+    LE_ASSERT(derive);
+    LE_ASSERT(key);
+
+    le_result_t res = LE_NOT_FOUND;
+
+    for (uint32_t slot = 0; slot < derive->numDerived; slot++)
+    {
+        const swi_mangoh_data_router_derived_t* derived = derive->derived[slot];
+        if ((derived->owner == owner) && !strcmp(derived->dbItem->key, key))
+        {
+            swi_mangoh_data_router_derive_free(derive, slot);
+            res = LE_OK;
+            break;
+        }
+    }
+
+    return res;
+}
+
+void swi_mangoh_data_router_derive_removeOwner
+(
+    swi_mangoh_data_router_derive_t* derive,
+    void* owner
+)
+{
+    LE_ASSERT(derive);
+
+    // Walked down, the derived key moved to a freed slot has already been checked
+    for (uint32_t slot = derive->numDerived; slot-- > 0;)
+    {
+        if (derive->derived[slot]->owner == owner)
+        {
+            swi_mangoh_data_router_derive_free(derive, slot);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record an item update in the windows of the keys derived from it and mark them dirty
+ */
+//--------------------------------------------------------------------------------------------------
+void swi_mangoh_data_router_derive_update
+(
+    swi_mangoh_data_router_derive_t* derive,
+    const swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    LE_ASSERT(derive);
+    LE_ASSERT(dbItem);
+
+    double value = 0;
+    bool numeric = swi_mangoh_data_router_derive_getNumber(&dbItem->data, &value);
+
+    uint32_t mask = dbItem->deriveMask;
+    for (uint32_t slot = 0; mask; slot++, mask >>= 1)
+    {
+        if (!(mask & 1))
+        {
+            continue;
+        }
+
+        swi_mangoh_data_router_derived_t* derived = derive->derived[slot];
+        for (uint32_t i = 0; i < derived->numSources; i++)
+        {
+            if ((derived->sources[i] == dbItem) && dbItem->hasValue)
+            {
+                derived->seenSources |= (1U << i);
+                for (uint32_t j = 0; numeric && (j < derived->numWindows); j++)
+                {
+                    swi_mangoh_data_router_deriveWindow_t* window = &derived->windows[j];
+                    if (window->source == i)
+                    {
+                        window->values[window->next] = value;
+                        window->next = (window->next + 1) % window->len;
+                        if (window->count < window->len)
+                        {
+                            window->count++;
+                        }
+                    }
+                }
+            }
+        }
+
+        derived->timestamp = dbItem->data.timestamp;
+        derived->dirty = true;
+    }
+
+    if (dbItem->deriveMask && !derive->scheduled)
+    {
+        derive->scheduled = true;
+        le_event_QueueFunction(swi_mangoh_data_router_derive_evaluate, derive, NULL);
+    }
+}
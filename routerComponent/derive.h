@@ -0,0 +1,155 @@
+/*
+ * @file derive.h
+ *
+ * Data router module.
+ *
+ * This module maintains the derived keys of the mangOH data router, computed from source keys.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_DERIVE_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_DERIVE_INCLUDE_GUARD
+
+// Derived keys are tracked in a 32 bit mask of each source item
+#define SWI_MANGOH_DATA_ROUTER_DERIVE_MAX_NUM 32
+#define SWI_MANGOH_DATA_ROUTER_DERIVE_SOURCES_MAX_NUM 8
+#define SWI_MANGOH_DATA_ROUTER_DERIVE_WINDOWS_MAX_NUM 4
+#define SWI_MANGOH_DATA_ROUTER_DERIVE_WINDOW_MAX_LEN 64
+#define SWI_MANGOH_DATA_ROUTER_DERIVE_PROGRAM_MAX_LEN 64
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router derived key expression instructions, run on a value stack
+ */
+//-------------------------------------------------------------------------------------------------
+typedef enum _swi_mangoh_data_router_deriveOp_e
+{
+    SWI_MANGOH_DATA_ROUTER_DERIVE_OP_CONST = 0,      ///< Push a constant
+    SWI_MANGOH_DATA_ROUTER_DERIVE_OP_SOURCE,         ///< Push the value of a source key
+    SWI_MANGOH_DATA_ROUTER_DERIVE_OP_WINDOW,         ///< Push the aggregate of a window
+    SWI_MANGOH_DATA_ROUTER_DERIVE_OP_ADD,
+    SWI_MANGOH_DATA_ROUTER_DERIVE_OP_SUB,
+    SWI_MANGOH_DATA_ROUTER_DERIVE_OP_MUL,
+    SWI_MANGOH_DATA_ROUTER_DERIVE_OP_DIV,
+    SWI_MANGOH_DATA_ROUTER_DERIVE_OP_NEG,
+} swi_mangoh_data_router_deriveOp_e;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router derived key window aggregates
+ */
+//-------------------------------------------------------------------------------------------------
+typedef enum _swi_mangoh_data_router_deriveWindowFunc_e
+{
+    SWI_MANGOH_DATA_ROUTER_DERIVE_WINDOW_AVG = 0,
+    SWI_MANGOH_DATA_ROUTER_DERIVE_WINDOW_SUM,
+    SWI_MANGOH_DATA_ROUTER_DERIVE_WINDOW_MIN,
+    SWI_MANGOH_DATA_ROUTER_DERIVE_WINDOW_MAX,
+} swi_mangoh_data_router_deriveWindowFunc_e;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router derived key expression instruction
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_deriveInstr_t
+{
+    swi_mangoh_data_router_deriveOp_e op; ///< Operation
+    double value;                         ///< Constant
+    uint32_t index;                       ///< Source or window index
+} swi_mangoh_data_router_deriveInstr_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router derived key window, the last values of a source key
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_deriveWindow_t
+{
+    swi_mangoh_data_router_deriveWindowFunc_e func; ///< Aggregate of the window values
+    uint32_t source;                                ///< Source index
+    uint32_t len;                                   ///< Window length
+    uint32_t count;                                 ///< Values in the window
+    uint32_t next;                                  ///< Ring slot of the next value
+    double values[SWI_MANGOH_DATA_ROUTER_DERIVE_WINDOW_MAX_LEN]; ///< Window values ring
+} swi_mangoh_data_router_deriveWindow_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router derived key.  The level is 0 for keys computed from plain keys only, and one more
+ * than the highest level of its derived sources otherwise.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_derived_t
+{
+    swi_mangoh_data_router_dbItem_t* dbItem;  ///< Derived key item
+    void* owner;                              ///< Session that defined the key
+    swi_mangoh_data_router_dbItem_t* sources[SWI_MANGOH_DATA_ROUTER_DERIVE_SOURCES_MAX_NUM];
+                                              ///< Source key items
+    uint32_t numSources;                      ///< Number of sources
+    uint32_t seenSources;                     ///< Mask of the sources holding a value
+    swi_mangoh_data_router_deriveWindow_t windows[SWI_MANGOH_DATA_ROUTER_DERIVE_WINDOWS_MAX_NUM];
+                                              ///< Windows over the sources
+    uint32_t numWindows;                      ///< Number of windows
+    swi_mangoh_data_router_deriveInstr_t program[SWI_MANGOH_DATA_ROUTER_DERIVE_PROGRAM_MAX_LEN];
+                                              ///< Compiled expression
+    uint32_t programLen;                      ///< Number of instructions
+    uint32_t level;                           ///< Dependency level, evaluation order
+    bool dirty;                               ///< A source changed since the last evaluation
+    uint32_t timestamp;                       ///< Latest source timestamp
+    uint32_t numEvaluations;                  ///< Evaluations
+} swi_mangoh_data_router_derived_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router derived key update handler
+ */
+//-------------------------------------------------------------------------------------------------
+typedef void (*swi_mangoh_data_router_deriveHandler_t)(
+    const char*,
+    const swi_mangoh_data_router_dbItem_t*);
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router derived keys.  Source updates mark their derived keys dirty, and the dirty keys are
+ * evaluated once in level order from the event loop, after the updates of the current request or
+ * batch.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_derive_t
+{
+    swi_mangoh_data_router_db_t* db;                ///< Database module
+    swi_mangoh_data_router_deriveHandler_t handler; ///< Derived key update handler
+    swi_mangoh_data_router_derived_t* derived[SWI_MANGOH_DATA_ROUTER_DERIVE_MAX_NUM];
+                                                    ///< Derived keys, by slot of the source masks
+    uint32_t numDerived;                            ///< Number of derived keys
+    uint32_t order[SWI_MANGOH_DATA_ROUTER_DERIVE_MAX_NUM]; ///< Slots in level order
+    bool scheduled;                                 ///< Evaluation queued or running
+} swi_mangoh_data_router_derive_t;
+
+void swi_mangoh_data_router_derive_init(
+    swi_mangoh_data_router_derive_t*,
+    swi_mangoh_data_router_db_t*,
+    swi_mangoh_data_router_deriveHandler_t);
+le_result_t swi_mangoh_data_router_derive_define(
+    swi_mangoh_data_router_derive_t*,
+    void*,
+    const char*,
+    const char*);
+le_result_t swi_mangoh_data_router_derive_remove(
+    swi_mangoh_data_router_derive_t*,
+    void*,
+    const char*);
+void swi_mangoh_data_router_derive_removeOwner(swi_mangoh_data_router_derive_t*, void*);
+void swi_mangoh_data_router_derive_update(
+    swi_mangoh_data_router_derive_t*,
+    const swi_mangoh_data_router_dbItem_t*);
+
+#endif
@@ -0,0 +1,225 @@
+/**
+ * @file
+ *
+ * Subscribers attach a predicate when they register, so that the updates they would discard are
+ * dropped in the router instead of being sent to them.  Updates of a type the predicate does not
+ * apply to never match.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include "filter.h"
+
+static bool swi_mangoh_data_router_filter_getNumber(const swi_mangoh_data_router_data_t*, double*);
+static bool swi_mangoh_data_router_filter_getState(
+    const swi_mangoh_data_router_filter_t*,
+    const swi_mangoh_data_router_data_t*,
+    bool*);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the numeric value of a boolean, integer or float update
+ */
+//--------------------------------------------------------------------------------------------------
+static bool swi_mangoh_data_router_filter_getNumber
+(
+    const swi_mangoh_data_router_data_t* data,
+    double* value
+)
+{
+    bool res = true;
+
+    switch (data->type)
+    {
+        case DATAROUTER_BOOLEAN:
+            *value = data->bValue ? 1 : 0;
+            break;
+
+        case DATAROUTER_INTEGER:
+            *value = data->iValue;
+            break;
+
+        case DATAROUTER_FLOAT:
+            *value = data->fValue;
+            break;
+
+        default:
+            res = false;
+            break;
+    }
+
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the state of an update tracked by an edge or a range filter
+ */
+//--------------------------------------------------------------------------------------------------
+static bool swi_mangoh_data_router_filter_getState
+(
+    const swi_mangoh_data_router_filter_t* filter,
+    const swi_mangoh_data_router_data_t* data,
+    bool* state
+)
+{
+    bool res = false;
+    double value = 0;
+
+    switch (filter->type)
+    {
+        case DATAROUTER_FILTER_RISING_EDGE:
+        case DATAROUTER_FILTER_FALLING_EDGE:
+        case DATAROUTER_FILTER_EDGE:
+            if (data->type == DATAROUTER_BOOLEAN)
+            {
+                *state = data->bValue;
+                res = true;
+            }
+            break;
+
+        case DATAROUTER_FILTER_ENTER_RANGE:
+        case DATAROUTER_FILTER_EXIT_RANGE:
+            if (swi_mangoh_data_router_filter_getNumber(data, &value))
+            {
+                *state = (value >= filter->low) && (value <= filter->high);
+                res = true;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set up a filter from the predicate given by a subscriber and the current value of the key, NULL
+ * when the key has no value yet
+ *
+ * @return
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the predicate or the range is invalid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t swi_mangoh_data_router_filter_init
+(
+    swi_mangoh_data_router_filter_t* filter,
+    dataRouter_Filter_t type,
+    double low,
+    double high,
+    const char* match,
+    const swi_mangoh_data_router_data_t* current
+)
+{
+    LE_ASSERT(filter);
+    LE_ASSERT(match);
+
+    le_result_t res = LE_OK;
+
+    memset(filter, 0, sizeof(swi_mangoh_data_router_filter_t));
+    if ((type < DATAROUTER_FILTER_ABOVE) || (type > DATAROUTER_FILTER_EQUALS))
+    {
+        LE_ERROR("ERROR invalid filter(%d)", type);
+        res = LE_BAD_PARAMETER;
+        goto cleanup;
+    }
+
+    if (((type == DATAROUTER_FILTER_ENTER_RANGE) || (type == DATAROUTER_FILTER_EXIT_RANGE)) &&
+        !(low <= high))
+    {
+        LE_ERROR("ERROR invalid range(%g..%g)", low, high);
+        res = LE_BAD_PARAMETER;
+        goto cleanup;
+    }
+
+    filter->enabled = true;
+    filter->type = type;
+    filter->low = low;
+    filter->high = high;
+    strncpy(filter->match, match, sizeof(filter->match) - 1);
+    if (current)
+    {
+        filter->initialized =
+            swi_mangoh_data_router_filter_getState(filter, current, &filter->state);
+    }
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Evaluate the filter of a subscriber on an update, and track the state of the edge and range
+ * filters.  The first value of an unknown state is a transition, e.g. it enters the range when in
+ * the range.
+ *
+ * @return
+ *      true if the update is to be dispatched to the subscriber
+ */
+//--------------------------------------------------------------------------------------------------
+bool swi_mangoh_data_router_filter_match
+(
+    swi_mangoh_data_router_filter_t* filter,
+    const swi_mangoh_data_router_data_t* data
+)
+{
+    LE_ASSERT(filter);
+    LE_ASSERT(data);
+
+    bool matched = false;
+    bool state = false;
+    double value = 0;
+
+    switch (filter->type)
+    {
+        case DATAROUTER_FILTER_ABOVE:
+            matched = swi_mangoh_data_router_filter_getNumber(data, &value) &&
+                      (value > filter->low);
+            break;
+
+        case DATAROUTER_FILTER_BELOW:
+            matched = swi_mangoh_data_router_filter_getNumber(data, &value) &&
+                      (value < filter->low);
+            break;
+
+        case DATAROUTER_FILTER_EQUALS:
+            matched = (data->type == DATAROUTER_STRING) && !strcmp(data->sValue, filter->match);
+            break;
+
+        default:
+            if (swi_mangoh_data_router_filter_getState(filter, data, &state))
+            {
+                if (!filter->initialized || (state != filter->state))
+                {
+                    matched = (filter->type == DATAROUTER_FILTER_EDGE) ||
+                              ((filter->type == DATAROUTER_FILTER_RISING_EDGE) && state) ||
+                              ((filter->type == DATAROUTER_FILTER_FALLING_EDGE) && !state) ||
+                              ((filter->type == DATAROUTER_FILTER_ENTER_RANGE) && state) ||
+                              ((filter->type == DATAROUTER_FILTER_EXIT_RANGE) && !state);
+                }
+
+                filter->state = state;
+                filter->initialized = true;
+            }
+            break;
+    }
+
+    if (matched)
+    {
+        filter->numMatched++;
+    }
+    else
+    {
+        filter->numFiltered++;
+    }
+
+    return matched;
+}
@@ -0,0 +1,52 @@
+/*
+ * @file filter.h
+ *
+ * Data router module.
+ *
+ * This module evaluates the update filters of the mangOH data router subscribers.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_FILTER_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_FILTER_INCLUDE_GUARD
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router update filter of a subscriber.  The edge and range filters match on the transitions
+ * of the state, which starts from the key value when the filter is attached, or else is unknown
+ * until the first value.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_filter_t
+{
+    bool enabled;                                    ///< Filter attached
+    dataRouter_Filter_t type;                        ///< Filter predicate
+    double low;                                      ///< Threshold, or range lower bound
+    double high;                                     ///< Range upper bound
+    char match[SWI_MANGOH_DATA_ROUTER_DATA_MAX_LEN]; ///< String to match
+    bool state;                                      ///< Last boolean value, or last value in
+                                                     ///  the range
+    bool initialized;                                ///< State set from a value
+    uint32_t numMatched;                             ///< Updates dispatched
+    uint32_t numFiltered;                            ///< Updates not dispatched
+} swi_mangoh_data_router_filter_t;
+
+le_result_t swi_mangoh_data_router_filter_init(
+    swi_mangoh_data_router_filter_t*,
+    dataRouter_Filter_t,
+    double,
+    double,
+    const char*,
+    const swi_mangoh_data_router_data_t*);
+bool swi_mangoh_data_router_filter_match(
+    swi_mangoh_data_router_filter_t*,
+    const swi_mangoh_data_router_data_t*);
+
+#endif
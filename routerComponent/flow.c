@@ -0,0 +1,109 @@
+/**
+ * @file
+ *
+ * The congestion state has hysteresis between the high and the low watermarks, so that producers
+ * are not signalled on every update while the fill hovers around a single threshold.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include "flow.h"
+
+static void swi_mangoh_data_router_flow_checkTimer(le_timer_Ref_t);
+
+static void swi_mangoh_data_router_flow_checkTimer
+(
+    le_timer_Ref_t timerRef
+)
+{
+    swi_mangoh_data_router_flow_t* flow =
+        (swi_mangoh_data_router_flow_t*)le_timer_GetContextPtr(timerRef);
+
+    LE_ASSERT(flow);
+    swi_mangoh_data_router_flow_check(flow);
+}
+
+void swi_mangoh_data_router_flow_init
+(
+    swi_mangoh_data_router_flow_t* flow,
+    swi_mangoh_data_router_flowFillFunc_t fill,
+    swi_mangoh_data_router_flowHandler_t handler
+)
+{
+    LE_ASSERT(flow);
+    LE_ASSERT(fill);
+    LE_ASSERT(handler);
+
+    memset(flow, 0, sizeof(swi_mangoh_data_router_flow_t));
+    flow->fill = fill;
+    flow->handler = handler;
+
+    int32_t highWatermark = le_cfg_QuickGetInt(
+        SWI_MANGOH_DATA_ROUTER_FLOW_CFG_HIGH_WATERMARK, SWI_MANGOH_DATA_ROUTER_FLOW_HIGH_WATERMARK);
+    int32_t lowWatermark = le_cfg_QuickGetInt(
+        SWI_MANGOH_DATA_ROUTER_FLOW_CFG_LOW_WATERMARK, SWI_MANGOH_DATA_ROUTER_FLOW_LOW_WATERMARK);
+    if ((highWatermark <= 0) || (highWatermark > 100) || (lowWatermark < 0) ||
+        (lowWatermark >= highWatermark))
+    {
+        LE_WARN("invalid watermarks high(%d) low(%d)", highWatermark, lowWatermark);
+        highWatermark = SWI_MANGOH_DATA_ROUTER_FLOW_HIGH_WATERMARK;
+        lowWatermark = SWI_MANGOH_DATA_ROUTER_FLOW_LOW_WATERMARK;
+    }
+
+    int32_t checkIntervalMs = le_cfg_QuickGetInt(
+        SWI_MANGOH_DATA_ROUTER_FLOW_CFG_CHECK_INTERVAL,
+        SWI_MANGOH_DATA_ROUTER_FLOW_CHECK_INTERVAL_MS);
+    if (checkIntervalMs <= 0)
+    {
+        LE_WARN("invalid check interval(%d)", checkIntervalMs);
+        checkIntervalMs = SWI_MANGOH_DATA_ROUTER_FLOW_CHECK_INTERVAL_MS;
+    }
+
+    flow->highWatermark = highWatermark;
+    flow->lowWatermark = lowWatermark;
+    LE_DEBUG("flow control watermarks high(%u%%) low(%u%%)",
+             flow->highWatermark, flow->lowWatermark);
+
+    flow->checkTimer = le_timer_Create("DataRouterFlowControl");
+    le_timer_SetMsInterval(flow->checkTimer, checkIntervalMs);
+    le_timer_SetRepeat(flow->checkTimer, 0);
+    le_timer_SetContextPtr(flow->checkTimer, flow);
+    le_timer_SetHandler(flow->checkTimer, swi_mangoh_data_router_flow_checkTimer);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update the congestion state from the fill of the upstream queues, returns true while congested
+ */
+//--------------------------------------------------------------------------------------------------
+bool swi_mangoh_data_router_flow_check
+(
+    swi_mangoh_data_router_flow_t* flow
+)
+{
+    LE_ASSERT(flow);
+
+    uint32_t fill = flow->fill();
+    if (!flow->congested && (fill >= flow->highWatermark))
+    {
+        flow->congested = true;
+        flow->numCongestions++;
+        LE_INFO("upstream congested, fill(%u%%) congestions(%u)", fill, flow->numCongestions);
+        le_timer_Start(flow->checkTimer);
+        flow->handler(true);
+    }
+    else if (flow->congested && (fill <= flow->lowWatermark))
+    {
+        flow->congested = false;
+        LE_INFO("upstream drained, fill(%u%%)", fill);
+        le_timer_Stop(flow->checkTimer);
+        flow->handler(false);
+    }
+
+    return flow->congested;
+}
@@ -0,0 +1,65 @@
+/*
+ * @file flow.h
+ *
+ * Data router module.
+ *
+ * This module signals the producers of the mangOH data router when the upstream queues fill up.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_FLOW_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_FLOW_INCLUDE_GUARD
+
+#define SWI_MANGOH_DATA_ROUTER_FLOW_CFG_HIGH_WATERMARK "/FlowControl/highWatermark"
+#define SWI_MANGOH_DATA_ROUTER_FLOW_CFG_LOW_WATERMARK "/FlowControl/lowWatermark"
+#define SWI_MANGOH_DATA_ROUTER_FLOW_CFG_CHECK_INTERVAL "/FlowControl/checkIntervalMs"
+
+#define SWI_MANGOH_DATA_ROUTER_FLOW_HIGH_WATERMARK 80
+#define SWI_MANGOH_DATA_ROUTER_FLOW_LOW_WATERMARK 50
+#define SWI_MANGOH_DATA_ROUTER_FLOW_CHECK_INTERVAL_MS 1000
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router flow control fill function, returns the percentage in use of the fullest upstream
+ * queue
+ */
+//-------------------------------------------------------------------------------------------------
+typedef uint32_t (*swi_mangoh_data_router_flowFillFunc_t)(void);
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router flow control handler, called when the upstream queues become congested or drain
+ */
+//-------------------------------------------------------------------------------------------------
+typedef void (*swi_mangoh_data_router_flowHandler_t)(bool);
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router flow control.  The upstream queues become congested when their fill reaches the
+ * high watermark, and drain once it falls to the low watermark.  The fill is checked on each push
+ * and, while congested, on the check timer since the queues drain without pushes.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_flow_t
+{
+    swi_mangoh_data_router_flowFillFunc_t fill; ///< Fill function
+    swi_mangoh_data_router_flowHandler_t handler; ///< Congestion handler
+    uint32_t highWatermark;                    ///< Fill percentage entering congestion
+    uint32_t lowWatermark;                     ///< Fill percentage leaving congestion
+    bool congested;                            ///< Upstream queues congested
+    le_timer_Ref_t checkTimer;                 ///< Fill check timer, running while congested
+    uint32_t numCongestions;                   ///< Times the queues became congested
+} swi_mangoh_data_router_flow_t;
+
+void swi_mangoh_data_router_flow_init(
+    swi_mangoh_data_router_flow_t*,
+    swi_mangoh_data_router_flowFillFunc_t,
+    swi_mangoh_data_router_flowHandler_t);
+bool swi_mangoh_data_router_flow_check(swi_mangoh_data_router_flow_t*);
+
+#endif
@@ -0,0 +1,182 @@
+/**
+ * @file
+ *
+ * The router serves all the sessions from a single thread, so a client writing in a tight loop
+ * delays the requests of the other apps.  Each session gets a token bucket per request type,
+ * configured by app name, and the requests over the limit are rejected before they touch the
+ * database, the subscribers or the transports.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include "limit.h"
+
+static const char* const swi_mangoh_data_router_limit_names[] =
+{
+    "write",
+    "read",
+    "subscribe",
+};
+
+static double swi_mangoh_data_router_limit_getCfg(const char*, const char*, const char*);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a limit setting of an app, or else the setting of all the apps, 0 when neither is set
+ */
+//--------------------------------------------------------------------------------------------------
+static double swi_mangoh_data_router_limit_getCfg
+(
+    const char* appName,
+    const char* request,
+    const char* setting
+)
+{
+    char path[SWI_MANGOH_DATA_ROUTER_LIMIT_CFG_PATH_MAX_LEN] = {0};
+
+    snprintf(
+        path, sizeof(path), "%s/%s%s", SWI_MANGOH_DATA_ROUTER_LIMIT_CFG_BASE, request, setting);
+    int32_t value = le_cfg_QuickGetInt(path, 0);
+
+    snprintf(
+        path,
+        sizeof(path),
+        "%s/%s/%s%s",
+        SWI_MANGOH_DATA_ROUTER_LIMIT_CFG_APPS,
+        appName,
+        request,
+        setting);
+    value = le_cfg_QuickGetInt(path, value);
+
+    return (value > 0) ? value : 0;
+}
+
+void swi_mangoh_data_router_limit_init
+(
+    swi_mangoh_data_router_limit_t* limit,
+    const char* appName
+)
+{
+    LE_ASSERT(limit);
+    LE_ASSERT(appName);
+
+    memset(limit, 0, sizeof(swi_mangoh_data_router_limit_t));
+    strncpy(limit->appName, appName, sizeof(limit->appName) - 1);
+    for (uint32_t i = 0; i < SWI_MANGOH_DATA_ROUTER_LIMIT_REQUEST_NUM; i++)
+    {
+        swi_mangoh_data_router_limitBucket_t* bucket = &limit->buckets[i];
+        const char* request = swi_mangoh_data_router_limit_names[i];
+
+        bucket->rate = swi_mangoh_data_router_limit_getCfg(appName, request, "Rate");
+        bucket->burst = swi_mangoh_data_router_limit_getCfg(appName, request, "Burst");
+        if (bucket->rate && (bucket->burst < 1))
+        {
+            // Allow one second of requests at once by default
+            bucket->burst = (bucket->rate < 1) ? 1 : bucket->rate;
+        }
+
+        bucket->tokens = bucket->burst;
+        bucket->refilled = le_clk_GetRelativeTime();
+        if (bucket->rate)
+        {
+            LE_INFO(
+                "app(%s) %s limit rate(%g/s) burst(%g)",
+                appName,
+                request,
+                bucket->rate,
+                bucket->burst);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Take a token for a request of a session
+ *
+ * @return
+ *      true if the request is admitted, false if the session is over its limit
+ */
+//--------------------------------------------------------------------------------------------------
+bool swi_mangoh_data_router_limit_admit
+(
+    swi_mangoh_data_router_limit_t* limit,
+    swi_mangoh_data_router_limitRequest_e request
+)
+{
+    LE_ASSERT(limit);
+    LE_ASSERT(request < SWI_MANGOH_DATA_ROUTER_LIMIT_REQUEST_NUM);
+
+    swi_mangoh_data_router_limitBucket_t* bucket = &limit->buckets[request];
+    bool admitted = true;
+
+    if (bucket->rate)
+    {
+        le_clk_Time_t now = le_clk_GetRelativeTime();
+        le_clk_Time_t elapsed = le_clk_Sub(now, bucket->refilled);
+
+        bucket->refilled = now;
+        bucket->tokens += bucket->rate * (elapsed.sec + elapsed.usec / 1000000.0);
+        if (bucket->tokens > bucket->burst)
+        {
+            bucket->tokens = bucket->burst;
+        }
+
+        if (bucket->tokens >= 1)
+        {
+            bucket->tokens -= 1;
+        }
+        else
+        {
+            admitted = false;
+        }
+    }
+
+    if (admitted)
+    {
+        bucket->numAdmitted++;
+        bucket->throttled = false;
+    }
+    else
+    {
+        bucket->numRejected++;
+        if (!bucket->throttled)
+        {
+            // Only warn once per run of rejected requests
+            LE_WARN(
+                "app(%s) over its %s limit, rejected(%u)",
+                limit->appName,
+                swi_mangoh_data_router_limit_names[request],
+                bucket->numRejected);
+            bucket->throttled = true;
+        }
+    }
+
+    return admitted;
+}
+
+void swi_mangoh_data_router_limit_log
+(
+    const swi_mangoh_data_router_limit_t* limit
+)
+{
+    LE_ASSERT(limit);
+
+    for (uint32_t i = 0; i < SWI_MANGOH_DATA_ROUTER_LIMIT_REQUEST_NUM; i++)
+    {
+        const swi_mangoh_data_router_limitBucket_t* bucket = &limit->buckets[i];
+        if (bucket->numRejected)
+        {
+            LE_INFO(
+                "app(%s) %s admitted(%u) rejected(%u)",
+                limit->appName,
+                swi_mangoh_data_router_limit_names[i],
+                bucket->numAdmitted,
+                bucket->numRejected);
+        }
+    }
+}
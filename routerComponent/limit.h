@@ -0,0 +1,73 @@
+/*
+ * @file limit.h
+ *
+ * Data router module.
+ *
+ * This module rate limits the requests of the mangOH data router sessions.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_LIMIT_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_LIMIT_INCLUDE_GUARD
+
+// Defaults of all the apps, overridden by /RateLimit/apps/<app name>/<request>Rate|Burst
+#define SWI_MANGOH_DATA_ROUTER_LIMIT_CFG_BASE "/RateLimit"
+#define SWI_MANGOH_DATA_ROUTER_LIMIT_CFG_APPS "/RateLimit/apps"
+#define SWI_MANGOH_DATA_ROUTER_LIMIT_CFG_PATH_MAX_LEN 128
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router rate limited requests
+ */
+//-------------------------------------------------------------------------------------------------
+typedef enum _swi_mangoh_data_router_limitRequest_e
+{
+    SWI_MANGOH_DATA_ROUTER_LIMIT_WRITE = 0,     ///< Writes, by key or by handle
+    SWI_MANGOH_DATA_ROUTER_LIMIT_READ,          ///< Reads, by key or by handle
+    SWI_MANGOH_DATA_ROUTER_LIMIT_SUBSCRIBE,     ///< Update and flow control handler registrations
+    SWI_MANGOH_DATA_ROUTER_LIMIT_REQUEST_NUM,
+} swi_mangoh_data_router_limitRequest_e;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router token bucket.  Tokens are added at the rate up to the burst, and each admitted
+ * request takes one.  A rate of 0 admits all the requests.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_limitBucket_t
+{
+    double rate;              ///< Tokens added per second
+    double burst;             ///< Maximum tokens
+    double tokens;            ///< Available tokens
+    le_clk_Time_t refilled;   ///< Last refill
+    bool throttled;           ///< Rejecting since the last admitted request
+    uint32_t numAdmitted;     ///< Requests admitted
+    uint32_t numRejected;     ///< Requests rejected
+} swi_mangoh_data_router_limitBucket_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router session rate limits
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_limit_t
+{
+    char appName[SWI_MANGOH_DATA_ROUTER_APP_NAME_LEN]; ///< Application of the session
+    swi_mangoh_data_router_limitBucket_t buckets[SWI_MANGOH_DATA_ROUTER_LIMIT_REQUEST_NUM];
+                                        ///< Token bucket of each request
+} swi_mangoh_data_router_limit_t;
+
+void swi_mangoh_data_router_limit_init(swi_mangoh_data_router_limit_t*, const char*);
+bool swi_mangoh_data_router_limit_admit(
+    swi_mangoh_data_router_limit_t*,
+    swi_mangoh_data_router_limitRequest_e);
+void swi_mangoh_data_router_limit_log(const swi_mangoh_data_router_limit_t*);
+
+#endif
@@ -12,6 +12,8 @@
 #include "router.h"
 #include "mqtt.h"
 
+#include <zlib.h>
+
 static void swi_mangoh_data_router_mqttIncomingMsgHdlr(
     const char*,
     const char*,
@@ -19,130 +21,323 @@ static void swi_mangoh_data_router_mqttIncomingMsgHdlr(
     const char*,
     void*);
 static void swi_mangoh_data_router_mqttSessionStateHdlr(bool, int32_t, int32_t, void*);
+static le_result_t swi_mangoh_data_router_mqttScanEntry(
+    const char*,
+    const char**,
+    char*,
+    swi_mangoh_data_router_data_t*,
+    swi_mangoh_data_router_mqtt_t*);
+static le_result_t swi_mangoh_data_router_mqttApplyBatch(
+    const char*,
+    le_sls_List_t*,
+    uint32_t*,
+    swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttIncomingBatch(const char*, swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttFormatValue(
+    const swi_mangoh_data_router_data_t*,
+    char*,
+    size_t);
+static void swi_mangoh_data_router_mqttSpoolOpen(swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttSpill(
+    swi_mangoh_data_router_queue_t*,
+    dataRouter_Priority_t,
+    swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttSpillAll(swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttSpillTimer(le_timer_Ref_t);
+static void swi_mangoh_data_router_mqttQueueReserve(
+    swi_mangoh_data_router_queue_t*,
+    dataRouter_Priority_t,
+    swi_mangoh_data_router_mqtt_t*);
+static uint32_t swi_mangoh_data_router_mqttReplay(
+    swi_mangoh_data_router_mqtt_t*,
+    dataRouter_Priority_t,
+    uint32_t);
+static void swi_mangoh_data_router_mqttQueueAggregate(
+    const char*,
+    dataRouter_Priority_t,
+    swi_mangoh_data_router_mqtt_t*);
+static uint32_t swi_mangoh_data_router_mqttDrainAggregates(
+    swi_mangoh_data_router_mqtt_t*,
+    dataRouter_Priority_t,
+    uint32_t,
+    le_clk_Time_t);
+static void swi_mangoh_data_router_mqttDequeued(
+    swi_mangoh_data_router_mqtt_classStats_t*,
+    le_clk_Time_t,
+    le_clk_Time_t);
+static bool swi_mangoh_data_router_mqttDrainSlice(swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttDrainDone(swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttDrainTimer(le_timer_Ref_t);
+static void swi_mangoh_data_router_mqttDrain(swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttFreeClient(swi_mangoh_data_router_mqtt_client_t*);
+static uint32_t swi_mangoh_data_router_mqttClientNumQueued(
+    const swi_mangoh_data_router_mqtt_client_t*);
+static uint32_t swi_mangoh_data_router_mqttNumQueued(swi_mangoh_data_router_mqtt_t*);
+static le_result_t swi_mangoh_data_router_mqttOpen(
+    const char*,
+    const char*,
+    swi_mangoh_data_router_mqtt_t*,
+    swi_mangoh_data_router_db_t*);
+static void swi_mangoh_data_router_mqttClose(swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttConnEvent(
+    swi_mangoh_data_router_conn_event_e,
+    swi_mangoh_data_router_mqtt_t*);
+static int32_t swi_mangoh_data_router_mqttSendKey(
+    const char*,
+    const char*,
+    swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttSend(
+    const char*,
+    const char*,
+    dataRouter_Priority_t,
+    swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttBatchInit(swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttBatchAdd(
+    const char*,
+    const swi_mangoh_data_router_data_t*,
+    dataRouter_Priority_t,
+    swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttBatchFlush(swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttBatchTimer(le_timer_Ref_t);
+static bool swi_mangoh_data_router_mqttIsSpooling(
+    swi_mangoh_data_router_mqtt_t*,
+    dataRouter_Priority_t);
+static bool swi_mangoh_data_router_mqttIsQueuing(
+    swi_mangoh_data_router_mqtt_client_t*,
+    dataRouter_Priority_t);
+static void swi_mangoh_data_router_mqttSendData(
+    const char*,
+    const swi_mangoh_data_router_data_t*,
+    dataRouter_Priority_t,
+    swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttPublish(
+    const char*,
+    const swi_mangoh_data_router_data_t*,
+    dataRouter_Priority_t,
+    swi_mangoh_data_router_mqtt_t*);
+static void swi_mangoh_data_router_mqttSendSamples(
+    const char*,
+    const char*,
+    dataRouter_Priority_t,
+    swi_mangoh_data_router_queue_t*,
+    swi_mangoh_data_router_mqtt_t*);
+static void* swi_mangoh_data_router_mqttTransportStart(
+    void*,
+    const char*,
+    const char*,
+    const char*,
+    swi_mangoh_data_router_db_t*);
+static le_result_t swi_mangoh_data_router_mqttTransportWrite(
+    void*,
+    const char*,
+    const swi_mangoh_data_router_dbItem_t*);
+static void swi_mangoh_data_router_mqttTransportWriteBatch(
+    void*,
+    const char*,
+    const swi_mangoh_data_router_dbItem_t*,
+    const double*,
+    const uint32_t*,
+    size_t);
+static void swi_mangoh_data_router_mqttTransportFlush(void*);
+static void swi_mangoh_data_router_mqttTransportSnapshot(
+    void*,
+    const char*,
+    const swi_mangoh_data_router_dbItem_t*);
+static void swi_mangoh_data_router_mqttTransportSnapshotEnd(void*);
+static void swi_mangoh_data_router_mqttTransportAggregate(
+    void*,
+    const char*,
+    const swi_mangoh_data_router_aggregate_t*);
+static uint32_t swi_mangoh_data_router_mqttTransportGetFill(void*);
+static void swi_mangoh_data_router_mqttTransportEnd(void*);
+static void swi_mangoh_data_router_mqttSnapshotSend(swi_mangoh_data_router_mqtt_t*);
 
-static void swi_mangoh_data_router_mqttIncomingMsgHdlr(
-    const char* topic,
-    const char* key,
-    const char* value,
-    const char* timestamp,
-    void*       context)
+const swi_mangoh_data_router_transportOps_t swi_mangoh_data_router_mqttTransportOps = {
+    .start       = swi_mangoh_data_router_mqttTransportStart,
+    .write       = swi_mangoh_data_router_mqttTransportWrite,
+    .writeBatch  = swi_mangoh_data_router_mqttTransportWriteBatch,
+    .flush       = swi_mangoh_data_router_mqttTransportFlush,
+    .snapshot    = swi_mangoh_data_router_mqttTransportSnapshot,
+    .snapshotEnd = swi_mangoh_data_router_mqttTransportSnapshotEnd,
+    .aggregate   = swi_mangoh_data_router_mqttTransportAggregate,
+    .getFill     = swi_mangoh_data_router_mqttTransportGetFill,
+    .end         = swi_mangoh_data_router_mqttTransportEnd,
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format a data value as an MQTT payload, a string as is and other values as JSON, e.g. 9.81 or
+ * [0.01,-0.02,9.81]
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttFormatValue(
+    const swi_mangoh_data_router_data_t* data,
+    char*                                value,
+    size_t                               len)
 {
-    swi_mangoh_data_router_mqtt_t* mqtt = (swi_mangoh_data_router_mqtt_t*)context;
+    swi_mangoh_data_router_text_t text;
 
-    LE_ASSERT(topic);
-    LE_ASSERT(key);
-    LE_ASSERT(value);
-    LE_ASSERT(timestamp);
+    swi_mangoh_data_router_text_init(&text, value, len);
+    if (data->type == DATAROUTER_STRING)
+    {
+        swi_mangoh_data_router_text_encodeRaw(&text, data->sValue);
+    }
+    else
+    {
+        swi_mangoh_data_router_text_encodeValue(&text, data);
+    }
 
-    LE_DEBUG("MQTT --> key('%s'), value('%s'), timestamp('%s')", key, value, timestamp);
+    if (!swi_mangoh_data_router_text_isValid(&text))
+    {
+        LE_WARN("value truncated(%zu)", len);
+    }
+}
 
-    swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_db_getDataItem(mqtt->db, key);
-    if (!dbItem)
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a spool per priority class, in a subdirectory of the spool path named after the class.  The
+ * maximum number of segments is shared evenly between the classes.  The client queues are spilled
+ * to the spools on the spill timer while disconnected, which bounds the updates lost on a power
+ * loss, 0 spilling them only when full and when closing.
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttSpoolOpen(
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    char     spoolPath[SWI_MANGOH_DATA_ROUTER_SPOOL_PATH_LEN] = {0};
+    uint32_t priority                                         = 0;
+
+    le_result_t res = le_cfg_QuickGetString(
+        SWI_MANGOH_DATA_ROUTER_MQTT_CFG_SPOOL_PATH,
+        spoolPath,
+        sizeof(spoolPath),
+        SWI_MANGOH_DATA_ROUTER_MQTT_SPOOL_PATH);
+    if ((res != LE_OK) || !strlen(spoolPath))
     {
-        LE_ERROR("ERROR swi_mangoh_data_router_db_getDataItem() failed");
+        LE_INFO("spool disabled, requests queued in memory");
         goto cleanup;
     }
 
-    switch (dbItem->data.type)
+    int32_t maxSegments = le_cfg_QuickGetInt(
+        SWI_MANGOH_DATA_ROUTER_MQTT_CFG_SPOOL_MAX_SEGMENTS,
+        SWI_MANGOH_DATA_ROUTER_MQTT_SPOOL_MAX_SEGMENTS) / SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM;
+    if (maxSegments < 1)
     {
-        case DATAROUTER_BOOLEAN:
-            dbItem->data.bValue = strcmp(value, "true") ? false : true;
-            break;
+        maxSegments = 1;
+    }
 
-        case DATAROUTER_INTEGER:
-            dbItem->data.iValue = atoi(value);
-            break;
+    // The sessions share the connection and its spools, replayed on the next connection
+    for (priority = 0; priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM; priority++)
+    {
+        char classPath[SWI_MANGOH_DATA_ROUTER_SPOOL_PATH_LEN] = {0};
 
-        case DATAROUTER_FLOAT:
-            dbItem->data.fValue = atof(value);
+        if (snprintf(classPath, sizeof(classPath), "%s/%s", spoolPath,
+                     swi_mangoh_data_router_priority_getName(priority)) >= (int)sizeof(classPath))
+        {
+            LE_ERROR("ERROR spool path('%s') too long", spoolPath);
             break;
+        }
 
-        case DATAROUTER_STRING:
-            strcpy(dbItem->data.sValue, value);
+        res = swi_mangoh_data_router_spool_open(&mqtt->spool[priority], classPath, maxSegments);
+        if (res != LE_OK)
+        {
+            LE_ERROR("ERROR swi_mangoh_data_router_spool_open() failed(%d)", res);
             break;
+        }
+    }
+
+    if (priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM)
+    {
+        while (priority--)
+        {
+            swi_mangoh_data_router_spool_close(&mqtt->spool[priority]);
+        }
+
+        goto cleanup;
     }
 
-    dbItem->data.timestamp = atoi(timestamp);
+    mqtt->spoolOpen = true;
 
-    swi_mangoh_data_router_notifySubscribers(key, dbItem);
+    uint32_t spillIntervalMs = le_cfg_QuickGetInt(
+        SWI_MANGOH_DATA_ROUTER_MQTT_CFG_SPILL_INTERVAL,
+        SWI_MANGOH_DATA_ROUTER_MQTT_SPILL_INTERVAL_MS);
+    if (spillIntervalMs)
+    {
+        mqtt->spillTimer = le_timer_Create("DataRouterMqttSpill");
+        le_timer_SetMsInterval(mqtt->spillTimer, spillIntervalMs);
+        le_timer_SetContextPtr(mqtt->spillTimer, mqtt);
+        le_timer_SetHandler(mqtt->spillTimer, swi_mangoh_data_router_mqttSpillTimer);
+    }
 
 cleanup:
     return;
 }
 
-static void swi_mangoh_data_router_mqttSessionStateHdlr(
-    bool    isConnected,
-    int32_t errorCode,
-    int32_t subErrorCode,
-    void*   context)
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append the requests of a client queue to the spool of their priority class, oldest first.  The
+ * drain replays the spool of a class before its queues.
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttSpill(
+    swi_mangoh_data_router_queue_t* queue,
+    dataRouter_Priority_t           priority,
+    swi_mangoh_data_router_mqtt_t*  mqtt)
 {
-    swi_mangoh_data_router_mqtt_t* mqtt = (swi_mangoh_data_router_mqtt_t*)context;
-    le_result_t                    res  = LE_OK;
-
-    LE_ASSERT(context);
-
-    LE_INFO("MQTT --> connected(%d), error code(%d/%d)", isConnected, errorCode, subErrorCode);
-    mqtt->connecting = false;
-    mqtt->connected  = isConnected;
+    const swi_mangoh_data_router_queueEntry_t* entry      = NULL;
+    uint32_t                                   numSpilled = 0;
 
-    if (mqtt->connected)
+    while ((entry = swi_mangoh_data_router_queue_pop(queue)))
     {
-        le_sls_Link_t* linkPtr = le_sls_Pop(&mqtt->outstandingRequests);
-        while (linkPtr)
-        {
-            char value[SWI_MANGOH_DATA_ROUTER_DATA_MAX_LEN] = {0};
-            swi_mangoh_data_router_mqtt_dataLink_t* dataElem =
-                CONTAINER_OF(linkPtr, swi_mangoh_data_router_mqtt_dataLink_t, link);
-            int32_t error = 0;
-
-            switch (dataElem->data.type)
-            {
-                case DATAROUTER_BOOLEAN:
-                    strncpy(
-                        value,
-                        dataElem->data.bValue ? "true" : "false",
-                        SWI_MANGOH_DATA_ROUTER_DATA_MAX_LEN);
-                    LE_ASSERT(value[SWI_MANGOH_DATA_ROUTER_DATA_MAX_LEN - 1] == '\0');
-                    break;
-
-                case DATAROUTER_INTEGER:
-                    snprintf(value, sizeof(value), "%d", dataElem->data.iValue);
-                    break;
-
-                case DATAROUTER_FLOAT:
-                    snprintf(value, sizeof(value), "%f", dataElem->data.fValue);
-                    break;
-
-                case DATAROUTER_STRING:
-                    strcpy(value, dataElem->data.sValue);
-                    break;
-            }
-
-            LE_DEBUG("<-- key/value('%s'/'%s')", dataElem->key, value);
-            mqtt_Send(dataElem->key, value, &error);
-            if (error)
-            {
-                LE_ERROR("mqtt_Send() failed(%d)", error);
-            }
+        char        value[SWI_MANGOH_DATA_ROUTER_MQTT_VALUE_MAX_LEN] = {0};
+        const char* spooled                                         = value;
 
-            free(dataElem);
-            linkPtr = le_sls_Pop(&mqtt->outstandingRequests);
+        if (entry->message)
+        {
+            spooled = entry->data.sValue;
+        }
+        else
+        {
+            swi_mangoh_data_router_mqttFormatValue(&entry->data, value, sizeof(value));
         }
 
-        if (mqtt->disconnect)
+        le_result_t res =
+            swi_mangoh_data_router_spool_append(&mqtt->spool[priority], entry->key, spooled);
+        if (res != LE_OK)
         {
-            LE_DEBUG("disconnect MQTT session");
-            mqtt_Disconnect();
+            LE_ERROR("ERROR swi_mangoh_data_router_spool_append() failed(%d)", res);
+            continue;
         }
+
+        numSpilled++;
     }
-    else
+
+    if (numSpilled)
     {
-        LE_DEBUG("reconnect MQTT session");
-        res = le_timer_Start(mqtt->reconnectTimer);
-        if (res != LE_OK)
+        LE_DEBUG("spill %s requests(%u)", swi_mangoh_data_router_priority_getName(priority),
+                 numSpilled);
+        mqtt->classStats[priority].numSpooled += numSpilled;
+        mqtt->replaying[priority] = true;
+    }
+}
+
+static void swi_mangoh_data_router_mqttSpillAll(
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    if (!mqtt->spoolOpen)
+    {
+        goto cleanup;
+    }
+
+    for (le_dls_Link_t* link = le_dls_Peek(&mqtt->clients); link;
+         link                = le_dls_PeekNext(&mqtt->clients, link))
+    {
+        swi_mangoh_data_router_mqtt_client_t* client =
+            CONTAINER_OF(link, swi_mangoh_data_router_mqtt_client_t, link);
+        for (uint32_t priority = 0; priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM; priority++)
         {
-            LE_ERROR("ERROR le_timer_Start() failed(%d)", res);
-            goto cleanup;
+            swi_mangoh_data_router_mqttSpill(
+                &client->outstandingRequests[priority], priority, mqtt);
         }
     }
 
@@ -150,189 +345,1955 @@ cleanup:
     return;
 }
 
-
-void swi_mangoh_data_router_mqttReconnect(le_timer_Ref_t timerRef)
+static void swi_mangoh_data_router_mqttSpillTimer(
+    le_timer_Ref_t timerRef)
 {
     swi_mangoh_data_router_mqtt_t* mqtt =
         (swi_mangoh_data_router_mqtt_t*)le_timer_GetContextPtr(timerRef);
 
     LE_ASSERT(mqtt);
 
-    LE_DEBUG("connect -> AV('%s')", mqtt->password);
-    mqtt_Connect(mqtt->password);
-    mqtt->connecting = true;
+    // Once connected, the drain forwards the queued requests
+    if (!swi_mangoh_data_router_conn_isConnected(&mqtt->conn))
+    {
+        swi_mangoh_data_router_mqttSpillAll(mqtt);
+    }
 }
 
-void swi_mangoh_data_router_mqttSessionStart(
-    const char*                    appId,
-    const char*                    url,
-    const char*                    password,
-    swi_mangoh_data_router_mqtt_t* mqtt,
-    swi_mangoh_data_router_db_t*   db)
+//--------------------------------------------------------------------------------------------------
+/**
+ * Make room for a request in a client queue.  With a spool, a full queue is spilled to the spool
+ * instead of dropping a request, and the queued requests are spilled on the spill timer.
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttQueueReserve(
+    swi_mangoh_data_router_queue_t* queue,
+    dataRouter_Priority_t           priority,
+    swi_mangoh_data_router_mqtt_t*  mqtt)
 {
-    le_result_t res = LE_OK;
-
-    LE_ASSERT(appId);
-    LE_ASSERT(url);
-    LE_ASSERT(password);
-    LE_ASSERT(mqtt);
-    LE_ASSERT(db);
-
-    mqtt->reconnectTimer = le_timer_Create(appId);
-    res = le_timer_SetHandler(mqtt->reconnectTimer, swi_mangoh_data_router_mqttReconnect);
-    if (res != LE_OK)
+    if (!mqtt->spoolOpen)
     {
-        LE_ERROR("ERROR le_timer_SetHandler() failed(%d)", res);
         goto cleanup;
     }
 
-    le_clk_Time_t interval = {.sec  = SWI_MANGOH_DATA_ROUTER_MQTT_RECONNECT_INTERVAL_SECS,
-                              .usec = 0};
-    res = le_timer_SetInterval(mqtt->reconnectTimer, interval);
-    if (res != LE_OK)
+    if (queue->numEntries >= queue->size)
     {
-        LE_ERROR("ERROR le_timer_SetInterval() failed(%d)", res);
-        goto cleanup;
+        swi_mangoh_data_router_mqttSpill(queue, priority, mqtt);
     }
 
-    res = le_timer_SetContextPtr(mqtt->reconnectTimer, mqtt);
-    if (res != LE_OK)
+    if (mqtt->spillTimer && !le_timer_IsRunning(mqtt->spillTimer))
     {
-        LE_ERROR("ERROR le_timer_SetContextPtr() failed(%d)", res);
-        goto cleanup;
+        le_timer_Start(mqtt->spillTimer);
     }
 
-    mqtt->sessionStateHdlrRef =
-        mqtt_AddSessionStateHandler(swi_mangoh_data_router_mqttSessionStateHdlr, mqtt);
-    if (!mqtt->sessionStateHdlrRef)
+cleanup:
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forward up to numRequests spooled requests of a priority class, returns the number forwarded
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t swi_mangoh_data_router_mqttReplay(
+    swi_mangoh_data_router_mqtt_t* mqtt,
+    dataRouter_Priority_t          priority,
+    uint32_t                       numRequests)
+{
+    swi_mangoh_data_router_spool_t* spool = &mqtt->spool[priority];
+    le_result_t                     res   = LE_OK;
+    uint32_t                        i     = 0;
+
+    for (i = 0; i < numRequests; i++)
     {
-        LE_ERROR("ERROR mqtt_AddSessionStateHandler() failed");
-        goto cleanup;
+        char    key[SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN]           = {0};
+        char    value[SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_MAX_LEN] = {0};
+        int32_t error                                            = 0;
+
+        res = swi_mangoh_data_router_spool_peek(spool, key, sizeof(key), value, sizeof(value));
+        if (res != LE_OK)
+        {
+            break;
+        }
+
+        LE_DEBUG("<-- replay %s key/value('%s'/'%s')",
+                 swi_mangoh_data_router_priority_getName(priority), key, value);
+        error = swi_mangoh_data_router_mqttSendKey(key, value, mqtt);
+        if (error)
+        {
+            // Left in the spool, sent again on the next slice
+            LE_ERROR("mqtt_Send() failed(%d)", error);
+            goto cleanup;
+        }
+
+        swi_mangoh_data_router_spool_ack(spool);
+        mqtt->numDrained++;
     }
 
-    mqtt->incomingMsgHdlrRef =
-        mqtt_AddIncomingMessageHandler(swi_mangoh_data_router_mqttIncomingMsgHdlr, mqtt);
-    if (!mqtt->incomingMsgHdlrRef)
+    if ((res != LE_OK) && (res != LE_NOT_FOUND))
     {
-        LE_ERROR("ERROR mqtt_AddIncomingMessageHandler() failed");
+        // The remaining records are replayed on the next connection
+        LE_ERROR("ERROR swi_mangoh_data_router_spool_peek() failed(%d)", res);
+        mqtt->replaying[priority] = false;
         goto cleanup;
     }
 
-    mqtt->db                  = db;
-    mqtt->outstandingRequests = LE_SLS_LIST_INIT;
-    strcpy(mqtt->url, url);
-    strcpy(mqtt->password, password);
-
-    LE_DEBUG("url('%s')", mqtt->url);
-    mqtt_Config(
-        mqtt->url,
-        SWI_MANGOH_DATA_ROUTER_MQTT_PORT_NUMBER,
-        SWI_MANGOH_DATA_ROUTER_MQTT_KEEP_ALIVE,
-        0);
-
-    LE_DEBUG("connect -> AV('%s')", mqtt->password);
-    mqtt_Connect(mqtt->password);
-    mqtt->connecting = true;
+    if (swi_mangoh_data_router_spool_isEmpty(spool))
+    {
+        mqtt->replaying[priority] = false;
+        swi_mangoh_data_router_spool_flush(spool);
+    }
 
 cleanup:
-    return;
+    return i;
 }
 
-void swi_mangoh_data_router_mqttWrite(
-    const char*                      key,
-    const swi_mangoh_data_router_dbItem_t* dbItem,
-    swi_mangoh_data_router_mqtt_t*   mqtt)
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a request with the key replaced by its alias when key aliases are enabled.  Requests are
+ * spooled with their key, since the aliases only live as long as the connection.
+ */
+//--------------------------------------------------------------------------------------------------
+static int32_t swi_mangoh_data_router_mqttSendKey(
+    const char*                    key,
+    const char*                    value,
+    swi_mangoh_data_router_mqtt_t* mqtt)
 {
-    LE_ASSERT(dbItem);
-    LE_ASSERT(mqtt);
+    char    aliasedKey[SWI_MANGOH_DATA_ROUTER_ALIAS_KEY_MAX_LEN] = {0};
+    int32_t error                                               = 0;
 
-    if (mqtt->connected)
+    swi_mangoh_data_router_aliasEntry_t* entry = swi_mangoh_data_router_alias_encode(
+        &mqtt->aliases, key, aliasedKey, sizeof(aliasedKey));
+    if (!entry)
     {
-        char    value[SWI_MANGOH_DATA_ROUTER_DATA_MAX_LEN] = {0};
-        int32_t error                                      = 0;
+        mqtt_Send(key, value, &error);
+        goto cleanup;
+    }
 
-        switch (dbItem->data.type)
-        {
-            case DATAROUTER_BOOLEAN:
-                strncpy(
-                    value,
-                    dbItem->data.bValue ? "true" : "false",
-                    SWI_MANGOH_DATA_ROUTER_DATA_MAX_LEN);
-                LE_ASSERT(value[SWI_MANGOH_DATA_ROUTER_DATA_MAX_LEN - 1] == '\0');
-                break;
+    LE_DEBUG("key('%s') alias('%s')", key, aliasedKey);
+    mqtt_Send(aliasedKey, value, &error);
+    if (!error)
+    {
+        swi_mangoh_data_router_alias_sent(&mqtt->aliases, entry, aliasedKey);
+    }
 
-            case DATAROUTER_INTEGER:
-                snprintf(value, sizeof(value), "%d", dbItem->data.iValue);
-                break;
+cleanup:
+    return error;
+}
 
-            case DATAROUTER_FLOAT:
-                snprintf(value, sizeof(value), "%f", dbItem->data.fValue);
-                break;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a request, or append it to the spool of its priority class when the class is spooling or
+ * when the send fails
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttSend(
+    const char*                    key,
+    const char*                    value,
+    dataRouter_Priority_t          priority,
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    int32_t error = 0;
 
-            case DATAROUTER_STRING:
-                strcpy(value, dbItem->data.sValue);
-                break;
+    if (!swi_mangoh_data_router_mqttIsSpooling(mqtt, priority))
+    {
+        LE_DEBUG("MQTT <-- key('%s'), value('%s')", key, value);
+        error = swi_mangoh_data_router_mqttSendKey(key, value, mqtt);
+        if (!error)
+        {
+            goto cleanup;
         }
 
-        LE_DEBUG(
-            "MQTT <-- key('%s'), value('%s'), timestamp(%lu)", key, value, dbItem->data.timestamp);
-        mqtt_Send(key, value, &error);
-        if (error)
+        LE_ERROR("mqtt_Send() failed(%d)", error);
+        if (!mqtt->spoolOpen)
         {
-            LE_ERROR("mqtt_Send() failed(%d)", error);
+            goto cleanup;
         }
     }
-    else
+
+    LE_DEBUG("spool %s('%s')", swi_mangoh_data_router_priority_getName(priority), key);
+    le_result_t res = swi_mangoh_data_router_spool_append(&mqtt->spool[priority], key, value);
+    if (res != LE_OK)
     {
-        if (le_sls_NumLinks(&mqtt->outstandingRequests) <
-            SWI_MANGOH_DATA_ROUTER_MQTT_QUEUED_REQUESTS_MAX_NUM)
-        {
-            swi_mangoh_data_router_mqtt_dataLink_t* dataElem =
-                calloc(1, sizeof(swi_mangoh_data_router_mqtt_dataLink_t));
-            if (!dataElem)
-            {
-                LE_ERROR("ERROR calloc() failed");
-                goto cleanup;
-            }
+        LE_ERROR("ERROR swi_mangoh_data_router_spool_append() failed(%d)", res);
+        goto cleanup;
+    }
 
-            LE_DEBUG("queue('%s')", key);
-            strcpy(dataElem->key, key);
-            memcpy(&dataElem->data, &dbItem->data, sizeof(swi_mangoh_data_router_data_t));
-            dataElem->link = LE_SLS_LINK_INIT;
-            le_sls_Queue(&mqtt->outstandingRequests, &dataElem->link);
-        }
-        else
-        {
-            LE_WARN("cannot queue('%s') data update", key);
-        }
+    mqtt->classStats[priority].numSpooled++;
+
+cleanup:
+    return;
+}
+
+static void swi_mangoh_data_router_mqttBatchInit(
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    mqtt->batchLen      = 0;
+    mqtt->batchWindowMs = le_cfg_QuickGetInt(
+        SWI_MANGOH_DATA_ROUTER_MQTT_CFG_BATCH_WINDOW, SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_WINDOW_MS);
+    mqtt->batchBytes = le_cfg_QuickGetInt(
+        SWI_MANGOH_DATA_ROUTER_MQTT_CFG_BATCH_BYTES, SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_BYTES);
+    if ((mqtt->batchBytes < SWI_MANGOH_DATA_ROUTER_MQTT_VALUE_MAX_LEN) ||
+        (mqtt->batchBytes >= SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_MAX_LEN))
+    {
+        LE_WARN("invalid batch bytes(%zu)", mqtt->batchBytes);
+        mqtt->batchBytes = SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_BYTES;
+    }
+
+    if (!mqtt->batchWindowMs)
+    {
+        LE_DEBUG("batching disabled");
+        goto cleanup;
     }
 
+    LE_DEBUG("batch window(%u ms), bytes(%zu)", mqtt->batchWindowMs, mqtt->batchBytes);
+    mqtt->batchTimer = le_timer_Create("DataRouterMqttBatch");
+    le_timer_SetMsInterval(mqtt->batchTimer, mqtt->batchWindowMs);
+    le_timer_SetContextPtr(mqtt->batchTimer, mqtt);
+    le_timer_SetHandler(mqtt->batchTimer, swi_mangoh_data_router_mqttBatchTimer);
+
 cleanup:
     return;
 }
 
-bool swi_mangoh_data_router_mqttSessionEnd(swi_mangoh_data_router_mqtt_t* mqtt)
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add an update to the batch as ["key",timestamp,value], e.g. [["a",1500000000,2.5]].  The batch
+ * is flushed first when the update does not fit in the batch bytes.  A batch takes the most urgent
+ * class of its updates.
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttBatchAdd(
+    const char*                          key,
+    const swi_mangoh_data_router_data_t* data,
+    dataRouter_Priority_t                priority,
+    swi_mangoh_data_router_mqtt_t*       mqtt)
 {
-    bool ret = true;
+    char                          entry[SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_ENTRY_MAX_LEN] = {0};
+    swi_mangoh_data_router_text_t text;
 
-    LE_ASSERT(mqtt);
+    swi_mangoh_data_router_text_init(&text, entry, sizeof(entry));
+    swi_mangoh_data_router_text_encodeChar(&text, '[');
+    swi_mangoh_data_router_text_encodeString(&text, key);
+    swi_mangoh_data_router_text_encodeChar(&text, ',');
+    swi_mangoh_data_router_text_encodeUint(&text, data->timestamp);
+    swi_mangoh_data_router_text_encodeChar(&text, ',');
+    swi_mangoh_data_router_text_encodeValue(&text, data);
+    swi_mangoh_data_router_text_encodeChar(&text, ']');
 
-    if (mqtt->connecting && !le_sls_IsEmpty(&mqtt->outstandingRequests))
+    // "[" or "," before the entry and "]" after the batch
+    size_t used = text.used;
+    if ((used >= sizeof(entry)) || (used + 2 > mqtt->batchBytes))
     {
-        LE_DEBUG("delayed MQTT session disconnect");
-        mqtt->disconnect = true;
-        ret              = false;
+        LE_DEBUG("key('%s') too long to batch", key);
+        swi_mangoh_data_router_mqttSendData(key, data, priority, mqtt);
+        goto cleanup;
     }
-    else
+
+    if (mqtt->batchLen + used + 2 > mqtt->batchBytes)
+    {
+        swi_mangoh_data_router_mqttBatchFlush(mqtt);
+    }
+
+    if (!mqtt->batchLen || (priority < mqtt->batchPriority))
     {
-        LE_DEBUG("disconnect MQTT session");
-        mqtt_Disconnect();
+        mqtt->batchPriority = priority;
+    }
 
-        LE_DEBUG("remove MQTT session");
-        mqtt_RemoveSessionStateHandler(mqtt->sessionStateHdlrRef);
-        mqtt_RemoveIncomingMessageHandler(mqtt->incomingMsgHdlrRef);
-        le_timer_Delete(mqtt->reconnectTimer);
+    mqtt->batch[mqtt->batchLen] = mqtt->batchLen ? ',' : '[';
+    memcpy(&mqtt->batch[mqtt->batchLen + 1], entry, used);
+    mqtt->batchLen += used + 1;
+
+    if (!le_timer_IsRunning(mqtt->batchTimer))
+    {
+        le_timer_Start(mqtt->batchTimer);
     }
 
-    return ret;
+cleanup:
+    return;
+}
+
+static void swi_mangoh_data_router_mqttBatchFlush(
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    if (!mqtt->batchLen)
+    {
+        goto cleanup;
+    }
+
+    le_timer_Stop(mqtt->batchTimer);
+    mqtt->batch[mqtt->batchLen++] = ']';
+    mqtt->batch[mqtt->batchLen]   = '\0';
+    swi_mangoh_data_router_mqttSend(
+        SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_KEY,
+        (const char*)mqtt->batch,
+        mqtt->batchPriority,
+        mqtt);
+    mqtt->batchLen = 0;
+
+cleanup:
+    return;
+}
+
+static void swi_mangoh_data_router_mqttBatchTimer(le_timer_Ref_t timerRef)
+{
+    swi_mangoh_data_router_mqtt_t* mqtt =
+        (swi_mangoh_data_router_mqtt_t*)le_timer_GetContextPtr(timerRef);
+
+    LE_ASSERT(mqtt);
+    swi_mangoh_data_router_mqttBatchFlush(mqtt);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Requests are spooled while disconnected, and until the spooled requests of their priority class
+ * are replayed to keep them in order
+ */
+//--------------------------------------------------------------------------------------------------
+static bool swi_mangoh_data_router_mqttIsSpooling(
+    swi_mangoh_data_router_mqtt_t* mqtt,
+    dataRouter_Priority_t          priority)
+{
+    return mqtt->spoolOpen &&
+           (!swi_mangoh_data_router_conn_isConnected(&mqtt->conn) ||
+            !swi_mangoh_data_router_spool_isEmpty(&mqtt->spool[priority]));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Updates are queued while disconnected, and until the spool and the client queue of their
+ * priority class are drained to keep them in order.  With a spool, the queues are a write-behind
+ * buffer: the updates of a key are coalesced under the keep latest policy before they are spilled.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool swi_mangoh_data_router_mqttIsQueuing(
+    swi_mangoh_data_router_mqtt_client_t* client,
+    dataRouter_Priority_t                 priority)
+{
+    swi_mangoh_data_router_mqtt_t* mqtt = client->mqtt;
+
+    return !swi_mangoh_data_router_conn_isConnected(&mqtt->conn) ||
+           client->outstandingRequests[priority].numEntries ||
+           (mqtt->spoolOpen && !swi_mangoh_data_router_spool_isEmpty(&mqtt->spool[priority]));
+}
+
+static void swi_mangoh_data_router_mqttSendData(
+    const char*                          key,
+    const swi_mangoh_data_router_data_t* data,
+    dataRouter_Priority_t                priority,
+    swi_mangoh_data_router_mqtt_t*       mqtt)
+{
+    char value[SWI_MANGOH_DATA_ROUTER_MQTT_VALUE_MAX_LEN] = {0};
+
+    swi_mangoh_data_router_mqttFormatValue(data, value, sizeof(value));
+    LE_DEBUG("key('%s'), timestamp(%lu)", key, data->timestamp);
+    swi_mangoh_data_router_mqttSend(key, value, priority, mqtt);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Publish an update, batched when batching is enabled.  While its priority class is spooling, the
+ * update is spooled on its own so that a batch of another class does not take it out of order.
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttPublish(
+    const char*                          key,
+    const swi_mangoh_data_router_data_t* data,
+    dataRouter_Priority_t                priority,
+    swi_mangoh_data_router_mqtt_t*       mqtt)
+{
+    if (mqtt->batchWindowMs && !swi_mangoh_data_router_mqttIsSpooling(mqtt, priority))
+    {
+        swi_mangoh_data_router_mqttBatchAdd(key, data, priority, mqtt);
+    }
+    else
+    {
+        swi_mangoh_data_router_mqttSendData(key, data, priority, mqtt);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Scan an inbound batch entry, ["key",timestamp,value] or ["key",timestamp,value,type] with the
+ * data type number, e.g. ["a",1500000000,2.5,2].  The value has the type of the key when the type
+ * is not given, the key has to exist then.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t swi_mangoh_data_router_mqttScanEntry(
+    const char*                    str,
+    const char**                   end,
+    char*                          key,
+    swi_mangoh_data_router_data_t* data,
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    const char* pos       = str;
+    uint64_t    timestamp = 0;
+    uint64_t    type      = 0;
+    le_result_t res       = LE_FORMAT_ERROR;
+
+    if (*pos++ != '[')
+    {
+        goto cleanup;
+    }
+
+    pos = swi_mangoh_data_router_text_skipSpaces(pos);
+    res = swi_mangoh_data_router_text_scanString(
+        pos, &pos, key, SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN);
+    if (res != LE_OK)
+    {
+        goto cleanup;
+    }
+
+    pos = swi_mangoh_data_router_text_skipSpaces(pos);
+    if (*pos++ != ',')
+    {
+        res = LE_FORMAT_ERROR;
+        goto cleanup;
+    }
+
+    pos = swi_mangoh_data_router_text_skipSpaces(pos);
+    res = swi_mangoh_data_router_text_scanUint(pos, &pos, &timestamp);
+    if (res != LE_OK)
+    {
+        goto cleanup;
+    }
+
+    pos = swi_mangoh_data_router_text_skipSpaces(pos);
+    if (*pos++ != ',')
+    {
+        res = LE_FORMAT_ERROR;
+        goto cleanup;
+    }
+
+    // The type follows the value, the value is scanned once the type is known
+    const char* value = swi_mangoh_data_router_text_skipSpaces(pos);
+    const char* skipEnd = NULL;
+    res = swi_mangoh_data_router_text_skipValue(value, &skipEnd);
+    if (res != LE_OK)
+    {
+        goto cleanup;
+    }
+
+    const swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(mqtt->db, key);
+    pos = swi_mangoh_data_router_text_skipSpaces(skipEnd);
+    if (*pos == ',')
+    {
+        pos = swi_mangoh_data_router_text_skipSpaces(pos + 1);
+        res = swi_mangoh_data_router_text_scanUint(pos, &pos, &type);
+        if ((res == LE_OK) && (type > DATAROUTER_INTEGER_ARRAY))
+        {
+            res = LE_OUT_OF_RANGE;
+        }
+
+        if (res != LE_OK)
+        {
+            goto cleanup;
+        }
+
+        data->type = type;
+        pos = swi_mangoh_data_router_text_skipSpaces(pos);
+    }
+    else if (dbItem)
+    {
+        data->type = dbItem->data.type;
+    }
+    else
+    {
+        res = LE_NOT_FOUND;
+        goto cleanup;
+    }
+
+    const char* valueEnd = NULL;
+    res = swi_mangoh_data_router_text_scanValue(value, &valueEnd, data);
+    if ((res == LE_OK) && (valueEnd != skipEnd))
+    {
+        res = LE_FORMAT_ERROR;
+    }
+
+    if (res != LE_OK)
+    {
+        goto cleanup;
+    }
+
+    if (*pos++ != ']')
+    {
+        res = LE_FORMAT_ERROR;
+        goto cleanup;
+    }
+
+    data->timestamp = timestamp;
+    *end = pos;
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Walk an inbound batch, a JSON array of entries.  The entries are only checked when notifyItems
+ * is NULL, otherwise they are applied in order and the updated items are queued once to
+ * notifyItems.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t swi_mangoh_data_router_mqttApplyBatch(
+    const char*                    value,
+    le_sls_List_t*                 notifyItems,
+    uint32_t*                      numEntries,
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    const char* pos = swi_mangoh_data_router_text_skipSpaces(value);
+    le_result_t res = LE_FORMAT_ERROR;
+
+    *numEntries = 0;
+    if (*pos++ != '[')
+    {
+        goto cleanup;
+    }
+
+    pos = swi_mangoh_data_router_text_skipSpaces(pos);
+    while (*pos != ']')
+    {
+        char                          key[SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN] = {0};
+        swi_mangoh_data_router_data_t data;
+
+        if (*numEntries && (*pos++ != ','))
+        {
+            res = LE_FORMAT_ERROR;
+            goto cleanup;
+        }
+
+        pos = swi_mangoh_data_router_text_skipSpaces(pos);
+        res = swi_mangoh_data_router_mqttScanEntry(pos, &pos, key, &data, mqtt);
+        if (res != LE_OK)
+        {
+            LE_ERROR("ERROR batch entry(%u) key('%s') invalid, failed(%d)", *numEntries, key, res);
+            goto cleanup;
+        }
+
+        (*numEntries)++;
+        pos = swi_mangoh_data_router_text_skipSpaces(pos);
+        if (!notifyItems)
+        {
+            continue;
+        }
+
+        swi_mangoh_data_router_dbItem_t* dbItem =
+            swi_mangoh_data_router_db_getDataItem(mqtt->db, key);
+        if (!dbItem)
+        {
+            dbItem = swi_mangoh_data_router_db_createDataItem(mqtt->db, key);
+            if (!dbItem)
+            {
+                LE_ERROR("ERROR swi_mangoh_data_router_db_createDataItem() failed");
+                mqtt->numInboundRejected++;
+                continue;
+            }
+        }
+
+        swi_mangoh_data_router_db_beginUpdate(dbItem);
+        memcpy(&dbItem->data, &data, sizeof(swi_mangoh_data_router_data_t));
+        swi_mangoh_data_router_db_endUpdate(mqtt->db, dbItem);
+        mqtt->numInboundUpdates++;
+
+        if (!dbItem->notifyPending)
+        {
+            dbItem->notifyPending = true;
+            dbItem->notifyLink    = LE_SLS_LINK_INIT;
+            le_sls_Queue(notifyItems, &dbItem->notifyLink);
+        }
+    }
+
+    if (*swi_mangoh_data_router_text_skipSpaces(pos + 1))
+    {
+        res = LE_FORMAT_ERROR;
+        goto cleanup;
+    }
+
+    res = LE_OK;
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Apply an inbound batch, e.g. a bulk configuration push, as one update.  The batch is checked
+ * first and rejected as a whole when an entry does not parse or names an unknown key without a
+ * type.  The entries are then applied in order, the last update of a key wins, and the
+ * subscribers of each updated key are notified once after the whole batch is applied, so that
+ * they read a consistent state instead of being called back for every entry.
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttIncomingBatch(
+    const char*                    value,
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    le_clk_Time_t start       = le_clk_GetRelativeTime();
+    le_sls_List_t notifyItems = LE_SLS_LIST_INIT;
+    uint32_t      numEntries  = 0;
+    uint32_t      numNotified = 0;
+
+    le_result_t res = swi_mangoh_data_router_mqttApplyBatch(value, NULL, &numEntries, mqtt);
+    if (res != LE_OK)
+    {
+        LE_ERROR("ERROR batch rejected, failed(%d)", res);
+        mqtt->numInboundRejected++;
+        goto cleanup;
+    }
+
+    res = swi_mangoh_data_router_mqttApplyBatch(value, &notifyItems, &numEntries, mqtt);
+    LE_ASSERT(res == LE_OK);
+
+    le_sls_Link_t* link = NULL;
+    while ((link = le_sls_Pop(&notifyItems)))
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem =
+            CONTAINER_OF(link, swi_mangoh_data_router_dbItem_t, notifyLink);
+
+        dbItem->notifyPending = false;
+        swi_mangoh_data_router_notifySubscribers(dbItem->key, dbItem);
+        numNotified++;
+    }
+
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), start);
+    uint64_t      us      = (uint64_t)elapsed.sec * 1000000 + elapsed.usec;
+
+    mqtt->numInboundBatches++;
+    mqtt->inboundBatchUs += us;
+    LE_INFO(
+        "batch applied(%u) keys(%u) in %llu us (%llu updates/s), total batches(%u) updates(%llu) "
+        "rejected(%u)",
+        numEntries,
+        numNotified,
+        (unsigned long long)us,
+        (unsigned long long)(numEntries * 1000000ULL / (us ? us : 1)),
+        mqtt->numInboundBatches,
+        (unsigned long long)mqtt->numInboundUpdates,
+        mqtt->numInboundRejected);
+
+cleanup:
+    return;
+}
+
+static void swi_mangoh_data_router_mqttIncomingMsgHdlr(
+    const char* topic,
+    const char* key,
+    const char* value,
+    const char* timestamp,
+    void*       context)
+{
+    swi_mangoh_data_router_mqtt_t* mqtt = (swi_mangoh_data_router_mqtt_t*)context;
+
+    LE_ASSERT(topic);
+    LE_ASSERT(key);
+    LE_ASSERT(value);
+    LE_ASSERT(timestamp);
+
+    LE_DEBUG("MQTT --> key('%s'), value('%s'), timestamp('%s')", key, value, timestamp);
+
+    if (!strcmp(key, SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_KEY))
+    {
+        swi_mangoh_data_router_mqttIncomingBatch(value, mqtt);
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_db_getDataItem(mqtt->db, key);
+    if (!dbItem)
+    {
+        LE_ERROR("ERROR swi_mangoh_data_router_db_getDataItem() failed");
+        mqtt->numInboundRejected++;
+        goto cleanup;
+    }
+
+    // The update is rejected when the value or the timestamp does not parse
+    swi_mangoh_data_router_data_t data = {.type = dbItem->data.type};
+    le_result_t                   res  = swi_mangoh_data_router_text_parseValue(value, &data);
+    if (res != LE_OK)
+    {
+        LE_ERROR(
+            "ERROR key('%s') invalid value('%s'), type(%d), failed(%d)",
+            key,
+            value,
+            data.type,
+            res);
+        mqtt->numInboundRejected++;
+        goto cleanup;
+    }
+
+    uint64_t seconds = 0;
+    res = swi_mangoh_data_router_text_parseUint(timestamp, &seconds);
+    if (res != LE_OK)
+    {
+        LE_ERROR("ERROR key('%s') invalid timestamp('%s'), failed(%d)", key, timestamp, res);
+        mqtt->numInboundRejected++;
+        goto cleanup;
+    }
+
+    data.timestamp = seconds;
+    swi_mangoh_data_router_db_beginUpdate(dbItem);
+    memcpy(&dbItem->data, &data, sizeof(swi_mangoh_data_router_data_t));
+    swi_mangoh_data_router_db_endUpdate(mqtt->db, dbItem);
+    mqtt->numInboundUpdates++;
+
+    swi_mangoh_data_router_notifySubscribers(key, dbItem);
+
+cleanup:
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Account the time a dequeued request waited in the statistics of its priority class
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttDequeued(
+    swi_mangoh_data_router_mqtt_classStats_t* stats,
+    le_clk_Time_t                             queued,
+    le_clk_Time_t                             now)
+{
+    le_clk_Time_t waited   = le_clk_Sub(now, queued);
+    uint32_t      queuedMs = waited.sec * 1000 + waited.usec / 1000;
+
+    stats->numQueued++;
+    stats->queuedMs += queuedMs;
+    if (queuedMs > stats->maxQueuedMs)
+    {
+        stats->maxQueuedMs = queuedMs;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue an aggregate record produced while disconnected without a spool.  Like the client queues,
+ * a full class drops its oldest record for the new one.
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttQueueAggregate(
+    const char*                    value,
+    dataRouter_Priority_t          priority,
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    swi_mangoh_data_router_mqtt_queuedAggregate_t* record = NULL;
+
+    if (mqtt->numQueuedAggregates[priority] >= SWI_MANGOH_DATA_ROUTER_MQTT_QUEUED_REQUESTS_MAX_NUM)
+    {
+        LE_WARN("drop %s aggregate", swi_mangoh_data_router_priority_getName(priority));
+        record = CONTAINER_OF(le_sls_Pop(&mqtt->queuedAggregates[priority]),
+                              swi_mangoh_data_router_mqtt_queuedAggregate_t, link);
+        mqtt->numQueuedAggregates[priority]--;
+    }
+    else
+    {
+        record = calloc(1, sizeof(swi_mangoh_data_router_mqtt_queuedAggregate_t));
+        if (!record)
+        {
+            LE_ERROR("ERROR calloc() failed");
+            goto cleanup;
+        }
+    }
+
+    LE_DEBUG("queue %s aggregate", swi_mangoh_data_router_priority_getName(priority));
+    LE_ASSERT(strlen(value) < sizeof(record->value));
+    strcpy(record->value, value);
+    record->queued = le_clk_GetRelativeTime();
+    record->link   = LE_SLS_LINK_INIT;
+    le_sls_Queue(&mqtt->queuedAggregates[priority], &record->link);
+    mqtt->numQueuedAggregates[priority]++;
+
+cleanup:
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forward up to numRequests queued aggregate records of a priority class, returns the number
+ * forwarded
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t swi_mangoh_data_router_mqttDrainAggregates(
+    swi_mangoh_data_router_mqtt_t* mqtt,
+    dataRouter_Priority_t          priority,
+    uint32_t                       numRequests,
+    le_clk_Time_t                  now)
+{
+    uint32_t i = 0;
+
+    for (i = 0; (i < numRequests) && mqtt->numQueuedAggregates[priority]; i++)
+    {
+        swi_mangoh_data_router_mqtt_queuedAggregate_t* record =
+            CONTAINER_OF(le_sls_Pop(&mqtt->queuedAggregates[priority]),
+                         swi_mangoh_data_router_mqtt_queuedAggregate_t, link);
+        mqtt->numQueuedAggregates[priority]--;
+
+        swi_mangoh_data_router_mqttSend(
+            SWI_MANGOH_DATA_ROUTER_MQTT_AGGREGATE_KEY, record->value, priority, mqtt);
+        mqtt->numAggregates++;
+        mqtt->numDrained++;
+        swi_mangoh_data_router_mqttDequeued(&mqtt->classStats[priority], record->queued, now);
+        free(record);
+    }
+
+    return i;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forward a slice of the requests queued or spooled while disconnected, returns true once they
+ * are all forwarded.  The requests are forwarded by strict priority, the critical requests before
+ * the normal ones and those before the bulk ones.  Within a class, the spooled requests come
+ * first, then the aggregate records queued without a spool, then the clients take turns of one
+ * request each, so that a client with a full queue does not hold back the others.  The ended
+ * clients are freed once their queues are forwarded.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool swi_mangoh_data_router_mqttDrainSlice(
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    uint32_t      numRequests =
+        mqtt->drainRate * SWI_MANGOH_DATA_ROUTER_MQTT_DRAIN_INTERVAL_MS / 1000;
+    size_t        numClients = le_dls_NumLinks(&mqtt->clients);
+    le_clk_Time_t now        = le_clk_GetRelativeTime();
+
+    if (!numRequests)
+    {
+        numRequests = 1;
+    }
+
+    for (uint32_t priority = 0; numRequests && (priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM);
+         priority++)
+    {
+        swi_mangoh_data_router_mqtt_classStats_t* stats   = &mqtt->classStats[priority];
+        size_t                                    numIdle = 0;
+
+        if (mqtt->replaying[priority])
+        {
+            numRequests -= swi_mangoh_data_router_mqttReplay(mqtt, priority, numRequests);
+            if (mqtt->replaying[priority])
+            {
+                break;
+            }
+        }
+
+        numRequests -= swi_mangoh_data_router_mqttDrainAggregates(mqtt, priority, numRequests, now);
+
+        // The list is rotated on each turn, the next slice goes on with the next client
+        while (numRequests && (numIdle < numClients))
+        {
+            le_dls_Link_t* link = le_dls_Pop(&mqtt->clients);
+            le_dls_Queue(&mqtt->clients, link);
+
+            swi_mangoh_data_router_mqtt_client_t* client =
+                CONTAINER_OF(link, swi_mangoh_data_router_mqtt_client_t, link);
+            const swi_mangoh_data_router_queueEntry_t* entry =
+                swi_mangoh_data_router_queue_pop(&client->outstandingRequests[priority]);
+            if (!entry)
+            {
+                numIdle++;
+                continue;
+            }
+
+            numIdle = 0;
+            if (entry->message)
+            {
+                swi_mangoh_data_router_mqttSend(entry->key, entry->data.sValue, priority, mqtt);
+            }
+            else
+            {
+                swi_mangoh_data_router_mqttPublish(entry->key, &entry->data, priority, mqtt);
+            }
+            mqtt->numDrained++;
+            numRequests--;
+            swi_mangoh_data_router_mqttDequeued(stats, entry->queued, now);
+        }
+    }
+
+    le_dls_Link_t* link = le_dls_Peek(&mqtt->clients);
+    while (link)
+    {
+        swi_mangoh_data_router_mqtt_client_t* client =
+            CONTAINER_OF(link, swi_mangoh_data_router_mqtt_client_t, link);
+        link = le_dls_PeekNext(&mqtt->clients, link);
+        if (client->ended && !swi_mangoh_data_router_mqttClientNumQueued(client))
+        {
+            swi_mangoh_data_router_mqttFreeClient(client);
+        }
+    }
+
+    swi_mangoh_data_router_mqttBatchFlush(mqtt);
+
+    bool done = !swi_mangoh_data_router_mqttNumQueued(mqtt);
+    for (uint32_t priority = 0; priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM; priority++)
+    {
+        done = done && !mqtt->replaying[priority];
+    }
+
+    return done;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * All the queued requests are forwarded, the connection is closed when the last session ended
+ * while requests were queued
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttDrainDone(
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    le_timer_Stop(mqtt->drainTimer);
+
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), mqtt->drainStart);
+    mqtt->drainMs = elapsed.sec * 1000 + elapsed.usec / 1000;
+    if (mqtt->numDrained)
+    {
+        LE_INFO("drained(%u) in %u ms", mqtt->numDrained, mqtt->drainMs);
+        for (uint32_t priority = 0; priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM; priority++)
+        {
+            const swi_mangoh_data_router_mqtt_classStats_t* stats = &mqtt->classStats[priority];
+            if (stats->numQueued || stats->numSpooled)
+            {
+                LE_INFO(
+                    "%s sent(%llu) spooled(%llu) queued(%llu) wait mean(%llu ms) max(%u ms)",
+                    swi_mangoh_data_router_priority_getName(priority),
+                    (unsigned long long)stats->numSent,
+                    (unsigned long long)stats->numSpooled,
+                    (unsigned long long)stats->numQueued,
+                    (unsigned long long)(stats->numQueued ? stats->queuedMs / stats->numQueued
+                                                          : 0),
+                    stats->maxQueuedMs);
+            }
+        }
+    }
+
+    if (!mqtt->numSessions)
+    {
+        swi_mangoh_data_router_mqttClose(mqtt);
+    }
+}
+
+static void swi_mangoh_data_router_mqttDrainTimer(
+    le_timer_Ref_t timerRef)
+{
+    swi_mangoh_data_router_mqtt_t* mqtt =
+        (swi_mangoh_data_router_mqtt_t*)le_timer_GetContextPtr(timerRef);
+
+    LE_ASSERT(mqtt);
+    if (swi_mangoh_data_router_mqttDrainSlice(mqtt))
+    {
+        swi_mangoh_data_router_mqttDrainDone(mqtt);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start forwarding the requests queued while disconnected.  They are forwarded in slices on the
+ * drain timer, at the drain rate, so that a large backlog neither blocks the clients nor bursts
+ * the modem, and the updates of the clients with an empty queue are sent between the slices.
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttDrain(
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    // The server forgets the key aliases with the connection, they are announced again
+    swi_mangoh_data_router_alias_reset(&mqtt->aliases);
+
+    mqtt->numDrained = 0;
+    mqtt->drainStart = le_clk_GetRelativeTime();
+    for (uint32_t priority = 0; priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM; priority++)
+    {
+        mqtt->replaying[priority] =
+            mqtt->spoolOpen && !swi_mangoh_data_router_spool_isEmpty(&mqtt->spool[priority]);
+    }
+
+    if (swi_mangoh_data_router_mqttDrainSlice(mqtt))
+    {
+        swi_mangoh_data_router_mqttDrainDone(mqtt);
+    }
+    else
+    {
+        LE_DEBUG("drain queued requests, rate(%u)", mqtt->drainRate);
+        le_timer_Start(mqtt->drainTimer);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run a connection event through the connection state machine and perform the resulting action
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttConnEvent(
+    swi_mangoh_data_router_conn_event_e event,
+    swi_mangoh_data_router_mqtt_t*      mqtt)
+{
+    switch (swi_mangoh_data_router_conn_handleEvent(&mqtt->conn, event))
+    {
+        case SWI_MANGOH_DATA_ROUTER_CONN_ACTION_NONE:
+            break;
+
+        case SWI_MANGOH_DATA_ROUTER_CONN_ACTION_CONNECT:
+            LE_DEBUG("connect -> AV('%s')", mqtt->password);
+            le_timer_Stop(mqtt->reconnectTimer);
+            mqtt_Connect(mqtt->password);
+            break;
+
+        case SWI_MANGOH_DATA_ROUTER_CONN_ACTION_WAIT:
+            LE_DEBUG("reconnect MQTT session in %u ms", mqtt->conn.delayMs);
+            le_timer_Stop(mqtt->reconnectTimer);
+            le_timer_SetMsInterval(mqtt->reconnectTimer, mqtt->conn.delayMs);
+            le_timer_Start(mqtt->reconnectTimer);
+            break;
+
+        case SWI_MANGOH_DATA_ROUTER_CONN_ACTION_DISCONNECT:
+            LE_DEBUG("disconnect MQTT session");
+            le_timer_Stop(mqtt->reconnectTimer);
+            mqtt_Disconnect();
+            break;
+    }
+}
+
+static void swi_mangoh_data_router_mqttSessionStateHdlr(
+    bool    isConnected,
+    int32_t errorCode,
+    int32_t subErrorCode,
+    void*   context)
+{
+    swi_mangoh_data_router_mqtt_t* mqtt = (swi_mangoh_data_router_mqtt_t*)context;
+
+    LE_ASSERT(context);
+
+    LE_INFO("MQTT --> connected(%d), error code(%d/%d)", isConnected, errorCode, subErrorCode);
+
+    if (isConnected)
+    {
+        // Also when the last session ended while connecting, the connection is closed once the
+        // queued requests are forwarded
+        swi_mangoh_data_router_mqttConnEvent(SWI_MANGOH_DATA_ROUTER_CONN_EVENT_CONNECTED, mqtt);
+        if (swi_mangoh_data_router_conn_isConnected(&mqtt->conn))
+        {
+            swi_mangoh_data_router_mqttDrain(mqtt);
+        }
+    }
+    else
+    {
+        le_timer_Stop(mqtt->drainTimer);
+        swi_mangoh_data_router_mqttConnEvent(SWI_MANGOH_DATA_ROUTER_CONN_EVENT_DISCONNECTED, mqtt);
+    }
+}
+
+static void swi_mangoh_data_router_mqttDataConnHdlr(
+    const char* intfName,
+    bool        isConnected,
+    void*       context)
+{
+    swi_mangoh_data_router_mqtt_t* mqtt = (swi_mangoh_data_router_mqtt_t*)context;
+
+    LE_ASSERT(mqtt);
+
+    LE_DEBUG("data connection('%s') connected(%d)", intfName, isConnected);
+    if (isConnected)
+    {
+        swi_mangoh_data_router_mqttConnEvent(SWI_MANGOH_DATA_ROUTER_CONN_EVENT_NETWORK_UP, mqtt);
+    }
+}
+
+void swi_mangoh_data_router_mqttReconnect(le_timer_Ref_t timerRef)
+{
+    swi_mangoh_data_router_mqtt_t* mqtt =
+        (swi_mangoh_data_router_mqtt_t*)le_timer_GetContextPtr(timerRef);
+
+    LE_ASSERT(mqtt);
+    swi_mangoh_data_router_mqttConnEvent(SWI_MANGOH_DATA_ROUTER_CONN_EVENT_TIMER, mqtt);
+}
+
+static le_result_t swi_mangoh_data_router_mqttOpen(
+    const char*                    url,
+    const char*                    password,
+    swi_mangoh_data_router_mqtt_t* mqtt,
+    swi_mangoh_data_router_db_t*   db)
+{
+    le_result_t res = LE_OK;
+
+    mqtt->reconnectTimer = le_timer_Create("DataRouterMqttReconnect");
+    res = le_timer_SetHandler(mqtt->reconnectTimer, swi_mangoh_data_router_mqttReconnect);
+    if (res != LE_OK)
+    {
+        LE_ERROR("ERROR le_timer_SetHandler() failed(%d)", res);
+        goto cleanup;
+    }
+
+    res = le_timer_SetContextPtr(mqtt->reconnectTimer, mqtt);
+    if (res != LE_OK)
+    {
+        LE_ERROR("ERROR le_timer_SetContextPtr() failed(%d)", res);
+        goto cleanup;
+    }
+
+    mqtt->drainRate = le_cfg_QuickGetInt(
+        SWI_MANGOH_DATA_ROUTER_MQTT_CFG_DRAIN_RATE, SWI_MANGOH_DATA_ROUTER_MQTT_DRAIN_RATE);
+    mqtt->drainTimer = le_timer_Create("DataRouterMqttDrain");
+    le_timer_SetMsInterval(mqtt->drainTimer, SWI_MANGOH_DATA_ROUTER_MQTT_DRAIN_INTERVAL_MS);
+    le_timer_SetRepeat(mqtt->drainTimer, 0);
+    le_timer_SetContextPtr(mqtt->drainTimer, mqtt);
+    le_timer_SetHandler(mqtt->drainTimer, swi_mangoh_data_router_mqttDrainTimer);
+
+    mqtt->sessionStateHdlrRef =
+        mqtt_AddSessionStateHandler(swi_mangoh_data_router_mqttSessionStateHdlr, mqtt);
+    if (!mqtt->sessionStateHdlrRef)
+    {
+        LE_ERROR("ERROR mqtt_AddSessionStateHandler() failed");
+        res = LE_FAULT;
+        goto cleanup;
+    }
+
+    mqtt->incomingMsgHdlrRef =
+        mqtt_AddIncomingMessageHandler(swi_mangoh_data_router_mqttIncomingMsgHdlr, mqtt);
+    if (!mqtt->incomingMsgHdlrRef)
+    {
+        LE_ERROR("ERROR mqtt_AddIncomingMessageHandler() failed");
+        res = LE_FAULT;
+        goto cleanup;
+    }
+
+    // Devices of a fleet share their configuration and often their boot time, the jitter is
+    // seeded with the clock sub-second part
+    le_clk_Time_t now = le_clk_GetAbsoluteTime();
+    swi_mangoh_data_router_conn_init(
+        &mqtt->conn,
+        le_cfg_QuickGetInt(
+            SWI_MANGOH_DATA_ROUTER_MQTT_CFG_RECONNECT_MIN,
+            SWI_MANGOH_DATA_ROUTER_MQTT_RECONNECT_MIN_MS),
+        le_cfg_QuickGetInt(
+            SWI_MANGOH_DATA_ROUTER_MQTT_CFG_RECONNECT_MAX,
+            SWI_MANGOH_DATA_ROUTER_MQTT_RECONNECT_MAX_MS),
+        le_cfg_QuickGetInt(
+            SWI_MANGOH_DATA_ROUTER_MQTT_CFG_NETWORK_RETRY,
+            SWI_MANGOH_DATA_ROUTER_MQTT_NETWORK_RETRY_MS),
+        (uint32_t)(now.sec ^ (now.usec << 12) ^ le_clk_GetRelativeTime().usec));
+
+    mqtt->dataConnHdlrRef =
+        le_data_AddConnectionStateHandler(swi_mangoh_data_router_mqttDataConnHdlr, mqtt);
+    if (!mqtt->dataConnHdlrRef)
+    {
+        LE_WARN("le_data_AddConnectionStateHandler() failed, no fast retry on network up");
+    }
+
+    mqtt->db = db;
+    swi_mangoh_data_router_mqttSpoolOpen(mqtt);
+    swi_mangoh_data_router_mqttBatchInit(mqtt);
+    if (swi_mangoh_data_router_alias_init(
+            &mqtt->aliases,
+            le_cfg_QuickGetInt(
+                SWI_MANGOH_DATA_ROUTER_MQTT_CFG_MAX_KEY_ALIASES,
+                SWI_MANGOH_DATA_ROUTER_MQTT_MAX_KEY_ALIASES)) != LE_OK)
+    {
+        LE_WARN("key aliases disabled");
+    }
+
+    strcpy(mqtt->url, url);
+    strcpy(mqtt->password, password);
+
+    LE_DEBUG("url('%s')", mqtt->url);
+    mqtt_Config(
+        mqtt->url,
+        SWI_MANGOH_DATA_ROUTER_MQTT_PORT_NUMBER,
+        SWI_MANGOH_DATA_ROUTER_MQTT_KEEP_ALIVE,
+        0);
+    mqtt->open = true;
+
+cleanup:
+    if (res != LE_OK)
+    {
+        swi_mangoh_data_router_mqttClose(mqtt);
+    }
+
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close the connection once no session uses it and the queued requests are forwarded
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttClose(
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    if (mqtt->numSessions || (mqtt->conn.state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_DISCONNECTING))
+    {
+        goto cleanup;
+    }
+
+    if (mqtt->open)
+    {
+        swi_mangoh_data_router_mqttBatchFlush(mqtt);
+        swi_mangoh_data_router_mqttConnEvent(SWI_MANGOH_DATA_ROUTER_CONN_EVENT_STOP, mqtt);
+        LE_DEBUG("connect attempts(%u)", mqtt->conn.numAttempts);
+    }
+
+    // Requests still queued are forwarded on the next connection when spooled, or else dropped
+    swi_mangoh_data_router_mqttSpillAll(mqtt);
+    while (!le_dls_IsEmpty(&mqtt->clients))
+    {
+        swi_mangoh_data_router_mqtt_client_t* client =
+            CONTAINER_OF(le_dls_Peek(&mqtt->clients), swi_mangoh_data_router_mqtt_client_t, link);
+        uint32_t numQueued = swi_mangoh_data_router_mqttClientNumQueued(client);
+        if (numQueued)
+        {
+            LE_WARN("drop app('%s') requests(%u)", client->appId, numQueued);
+        }
+
+        swi_mangoh_data_router_mqttFreeClient(client);
+    }
+
+    for (uint32_t priority = 0; priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM; priority++)
+    {
+        if (mqtt->numQueuedAggregates[priority])
+        {
+            LE_WARN("drop %s aggregates(%u)", swi_mangoh_data_router_priority_getName(priority),
+                    mqtt->numQueuedAggregates[priority]);
+        }
+
+        le_sls_Link_t* link = NULL;
+        while ((link = le_sls_Pop(&mqtt->queuedAggregates[priority])))
+        {
+            free(CONTAINER_OF(link, swi_mangoh_data_router_mqtt_queuedAggregate_t, link));
+        }
+
+        mqtt->numQueuedAggregates[priority] = 0;
+    }
+
+    LE_DEBUG("remove MQTT connection");
+    if (mqtt->batchTimer)
+    {
+        le_timer_Delete(mqtt->batchTimer);
+        mqtt->batchTimer = NULL;
+    }
+
+    if (mqtt->dataConnHdlrRef)
+    {
+        le_data_RemoveConnectionStateHandler(mqtt->dataConnHdlrRef);
+        mqtt->dataConnHdlrRef = NULL;
+    }
+
+    if (mqtt->sessionStateHdlrRef)
+    {
+        mqtt_RemoveSessionStateHandler(mqtt->sessionStateHdlrRef);
+        mqtt->sessionStateHdlrRef = NULL;
+    }
+
+    if (mqtt->incomingMsgHdlrRef)
+    {
+        mqtt_RemoveIncomingMessageHandler(mqtt->incomingMsgHdlrRef);
+        mqtt->incomingMsgHdlrRef = NULL;
+    }
+
+    if (mqtt->reconnectTimer)
+    {
+        le_timer_Delete(mqtt->reconnectTimer);
+        mqtt->reconnectTimer = NULL;
+    }
+
+    if (mqtt->drainTimer)
+    {
+        le_timer_Delete(mqtt->drainTimer);
+        mqtt->drainTimer = NULL;
+    }
+
+    if (mqtt->spillTimer)
+    {
+        le_timer_Delete(mqtt->spillTimer);
+        mqtt->spillTimer = NULL;
+    }
+
+    swi_mangoh_data_router_alias_destroy(&mqtt->aliases);
+
+    if (mqtt->spoolOpen)
+    {
+        for (uint32_t priority = 0; priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM; priority++)
+        {
+            swi_mangoh_data_router_spool_close(&mqtt->spool[priority]);
+        }
+
+        mqtt->spoolOpen = false;
+    }
+
+    mqtt->open = false;
+
+cleanup:
+    return;
+}
+
+static void swi_mangoh_data_router_mqttFreeClient(
+    swi_mangoh_data_router_mqtt_client_t* client)
+{
+    LE_DEBUG("free client app('%s')", client->appId);
+    le_dls_Remove(&client->mqtt->clients, &client->link);
+    for (uint32_t priority = 0; priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM; priority++)
+    {
+        swi_mangoh_data_router_queue_destroy(&client->outstandingRequests[priority]);
+    }
+
+    free(client);
+}
+
+static uint32_t swi_mangoh_data_router_mqttClientNumQueued(
+    const swi_mangoh_data_router_mqtt_client_t* client)
+{
+    uint32_t numQueued = 0;
+
+    for (uint32_t priority = 0; priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM; priority++)
+    {
+        numQueued += client->outstandingRequests[priority].numEntries;
+    }
+
+    return numQueued;
+}
+
+static uint32_t swi_mangoh_data_router_mqttNumQueued(
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    uint32_t numQueued = 0;
+
+    for (le_dls_Link_t* link = le_dls_Peek(&mqtt->clients); link;
+         link                = le_dls_PeekNext(&mqtt->clients, link))
+    {
+        numQueued += swi_mangoh_data_router_mqttClientNumQueued(
+            CONTAINER_OF(link, swi_mangoh_data_router_mqtt_client_t, link));
+    }
+
+    for (uint32_t priority = 0; priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM; priority++)
+    {
+        numQueued += mqtt->numQueuedAggregates[priority];
+    }
+
+    return numQueued;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start pushing the updates of a session.  The first session opens the connection, the following
+ * sessions share it and are refused when they name another URL or password, as their updates
+ * would otherwise go to the broker and the account of the first session.
+ */
+//--------------------------------------------------------------------------------------------------
+swi_mangoh_data_router_mqtt_client_t* swi_mangoh_data_router_mqttSessionStart(
+    const char*                    appId,
+    const char*                    url,
+    const char*                    password,
+    swi_mangoh_data_router_mqtt_t* mqtt,
+    swi_mangoh_data_router_db_t*   db)
+{
+    LE_ASSERT(appId);
+    LE_ASSERT(url);
+    LE_ASSERT(password);
+    LE_ASSERT(mqtt);
+    LE_ASSERT(db);
+
+    swi_mangoh_data_router_mqtt_client_t* client =
+        calloc(1, sizeof(swi_mangoh_data_router_mqtt_client_t));
+    if (!client)
+    {
+        LE_ERROR("ERROR calloc() failed");
+        goto cleanup;
+    }
+
+    if (!mqtt->open)
+    {
+        le_result_t res = swi_mangoh_data_router_mqttOpen(url, password, mqtt, db);
+        if (res != LE_OK)
+        {
+            LE_ERROR("ERROR swi_mangoh_data_router_mqttOpen() failed(%d)", res);
+            free(client);
+            client = NULL;
+            goto cleanup;
+        }
+    }
+    else if (strcmp(mqtt->url, url) || strcmp(mqtt->password, password))
+    {
+        LE_ERROR(
+            "ERROR app('%s') url('%s') or password differs from the connection to url('%s'), "
+            "failed(%d)",
+            appId,
+            url,
+            mqtt->url,
+            LE_DUPLICATE);
+        free(client);
+        client = NULL;
+        goto cleanup;
+    }
+
+    strncpy(client->appId, appId, sizeof(client->appId) - 1);
+    client->mqtt = mqtt;
+    client->link = LE_DLS_LINK_INIT;
+    swi_mangoh_data_router_queue_init(
+        &client->outstandingRequests[DATAROUTER_PRIORITY_CRITICAL],
+        SWI_MANGOH_DATA_ROUTER_MQTT_CFG_CRITICAL_QUEUE_SIZE,
+        SWI_MANGOH_DATA_ROUTER_MQTT_CFG_CRITICAL_DROP_POLICY,
+        SWI_MANGOH_DATA_ROUTER_MQTT_QUEUED_REQUESTS_MAX_NUM);
+    swi_mangoh_data_router_queue_init(
+        &client->outstandingRequests[DATAROUTER_PRIORITY_NORMAL],
+        SWI_MANGOH_DATA_ROUTER_MQTT_CFG_QUEUE_SIZE,
+        SWI_MANGOH_DATA_ROUTER_MQTT_CFG_DROP_POLICY,
+        SWI_MANGOH_DATA_ROUTER_MQTT_QUEUED_REQUESTS_MAX_NUM);
+    swi_mangoh_data_router_queue_init(
+        &client->outstandingRequests[DATAROUTER_PRIORITY_BULK],
+        SWI_MANGOH_DATA_ROUTER_MQTT_CFG_BULK_QUEUE_SIZE,
+        SWI_MANGOH_DATA_ROUTER_MQTT_CFG_BULK_DROP_POLICY,
+        SWI_MANGOH_DATA_ROUTER_MQTT_QUEUED_REQUESTS_MAX_NUM);
+    le_dls_Queue(&mqtt->clients, &client->link);
+
+    mqtt->numSessions++;
+    LE_DEBUG("app('%s') sessions(%u)", appId, mqtt->numSessions);
+    swi_mangoh_data_router_mqttConnEvent(SWI_MANGOH_DATA_ROUTER_CONN_EVENT_START, mqtt);
+
+cleanup:
+    return client;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send an update, or queue it in the queue of its priority class.  Critical updates are not
+ * batched.  Returns LE_OVERFLOW when the queue dropped an update.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t swi_mangoh_data_router_mqttWrite(
+    const char*                            key,
+    const swi_mangoh_data_router_dbItem_t* dbItem,
+    swi_mangoh_data_router_mqtt_client_t*  client)
+{
+    le_result_t res = LE_OK;
+
+    LE_ASSERT(dbItem);
+    LE_ASSERT(client);
+
+    swi_mangoh_data_router_mqtt_t* mqtt     = client->mqtt;
+    dataRouter_Priority_t          priority = dbItem->priority;
+
+    if (swi_mangoh_data_router_mqttIsQueuing(client, priority))
+    {
+        swi_mangoh_data_router_mqttQueueReserve(
+            &client->outstandingRequests[priority], priority, mqtt);
+        res = swi_mangoh_data_router_queue_push(
+            &client->outstandingRequests[priority], key, &dbItem->data);
+        goto cleanup;
+    }
+
+    if (priority == DATAROUTER_PRIORITY_CRITICAL)
+    {
+        swi_mangoh_data_router_mqttSendData(key, &dbItem->data, priority, mqtt);
+    }
+    else
+    {
+        swi_mangoh_data_router_mqttPublish(key, &dbItem->data, priority, mqtt);
+    }
+
+    mqtt->classStats[priority].numSent++;
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Percentage in use of the fullest client queue or spool
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t swi_mangoh_data_router_mqttGetFill(
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    uint32_t fill = 0;
+
+    LE_ASSERT(mqtt);
+
+    for (uint32_t priority = 0; mqtt->spoolOpen && (priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM);
+         priority++)
+    {
+        uint32_t spoolFill = swi_mangoh_data_router_spool_getFill(&mqtt->spool[priority]);
+        if (spoolFill > fill)
+        {
+            fill = spoolFill;
+        }
+    }
+
+    for (le_dls_Link_t* link = le_dls_Peek(&mqtt->clients); link;
+         link                = le_dls_PeekNext(&mqtt->clients, link))
+    {
+        const swi_mangoh_data_router_mqtt_client_t* client =
+            CONTAINER_OF(link, swi_mangoh_data_router_mqtt_client_t, link);
+        for (uint32_t priority = 0; priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM; priority++)
+        {
+            uint32_t queueFill =
+                swi_mangoh_data_router_queue_getFill(&client->outstandingRequests[priority]);
+            if (queueFill > fill)
+            {
+                fill = queueFill;
+            }
+        }
+    }
+
+    return fill;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a message of packed samples, or queue it as it is when a queue is given
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_mqttSendSamples(
+    const char*                     key,
+    const char*                     value,
+    dataRouter_Priority_t           priority,
+    swi_mangoh_data_router_queue_t* queue,
+    swi_mangoh_data_router_mqtt_t*  mqtt)
+{
+    if (queue)
+    {
+        LE_DEBUG("queue('%s') samples", key);
+        swi_mangoh_data_router_mqttQueueReserve(queue, priority, mqtt);
+        swi_mangoh_data_router_queue_pushMessage(queue, key, value);
+    }
+    else
+    {
+        swi_mangoh_data_router_mqttSend(key, value, priority, mqtt);
+    }
+}
+
+void swi_mangoh_data_router_mqttWriteSamples(
+    const char*                            key,
+    const swi_mangoh_data_router_dbItem_t* dbItem,
+    const double*                          values,
+    const uint32_t*                        timestamps,
+    size_t                                 numSamples,
+    swi_mangoh_data_router_mqtt_client_t*  client)
+{
+    char                          value[SWI_MANGOH_DATA_ROUTER_MQTT_VALUE_MAX_LEN] = {0};
+    swi_mangoh_data_router_text_t text;
+
+    LE_ASSERT(dbItem);
+    LE_ASSERT(client);
+
+    swi_mangoh_data_router_mqtt_t*  mqtt     = client->mqtt;
+    dataRouter_Priority_t           priority = dbItem->priority;
+    swi_mangoh_data_router_queue_t* queue    = NULL;
+    size_t                          maxLen   = sizeof(value);
+
+    // While queuing the block is queued as packed messages, which are neither coalesced nor
+    // batched, in the shorter queued string values
+    if (swi_mangoh_data_router_mqttIsQueuing(client, priority))
+    {
+        LE_DEBUG("queue('%s') %zu samples", key, numSamples);
+        queue  = &client->outstandingRequests[priority];
+        maxLen = SWI_MANGOH_DATA_ROUTER_DATA_MAX_LEN;
+    }
+    else if (mqtt->batchWindowMs && !swi_mangoh_data_router_mqttIsSpooling(mqtt, priority))
+    {
+        // Each sample is a batch entry with its own timestamp
+        for (size_t i = 0; i < numSamples; i++)
+        {
+            swi_mangoh_data_router_data_t data = {.type = DATAROUTER_FLOAT};
+
+            data.fValue    = values[i];
+            data.timestamp = timestamps[i];
+            swi_mangoh_data_router_mqttPublish(key, &data, priority, mqtt);
+        }
+
+        goto cleanup;
+    }
+
+    // Samples are sent as "[[timestamp,value],...]", packing as many samples in each message as
+    // the value length allows
+    swi_mangoh_data_router_text_init(&text, value, sizeof(value));
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        size_t used = text.used;
+
+        swi_mangoh_data_router_text_encodeChar(&text, used ? ',' : '[');
+        swi_mangoh_data_router_text_encodeChar(&text, '[');
+        swi_mangoh_data_router_text_encodeUint(&text, timestamps[i]);
+        swi_mangoh_data_router_text_encodeChar(&text, ',');
+        swi_mangoh_data_router_text_encodeDouble(&text, values[i]);
+        swi_mangoh_data_router_text_encodeChar(&text, ']');
+
+        // The sample is sent in the next message when the message would be too long with it
+        if (used && (text.used + sizeof("]") > maxLen))
+        {
+            text.used   = used;
+            value[used] = '\0';
+            swi_mangoh_data_router_text_encodeChar(&text, ']');
+            swi_mangoh_data_router_mqttSendSamples(key, value, priority, queue, mqtt);
+
+            swi_mangoh_data_router_text_init(&text, value, sizeof(value));
+            i--;
+        }
+    }
+
+    if (text.used)
+    {
+        swi_mangoh_data_router_text_encodeChar(&text, ']');
+        swi_mangoh_data_router_mqttSendSamples(key, value, priority, queue, mqtt);
+    }
+
+cleanup:
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop pushing the updates of a session.  The requests it queued while disconnected are still
+ * forwarded, the last session only closes the connection once they are.
+ */
+//--------------------------------------------------------------------------------------------------
+void swi_mangoh_data_router_mqttSessionEnd(
+    swi_mangoh_data_router_mqtt_client_t* client)
+{
+    LE_ASSERT(client);
+
+    swi_mangoh_data_router_mqtt_t* mqtt = client->mqtt;
+    LE_ASSERT(mqtt->numSessions);
+
+    mqtt->numSessions--;
+    LE_DEBUG("app('%s') sessions(%u)", client->appId, mqtt->numSessions);
+    client->ended = true;
+    if (!swi_mangoh_data_router_mqttClientNumQueued(client))
+    {
+        swi_mangoh_data_router_mqttFreeClient(client);
+    }
+
+    if (mqtt->numSessions)
+    {
+        goto cleanup;
+    }
+
+    if (swi_mangoh_data_router_mqttNumQueued(mqtt))
+    {
+        // Closed once the requests are forwarded, the drain is already running when connected
+        swi_mangoh_data_router_mqttConnEvent(SWI_MANGOH_DATA_ROUTER_CONN_EVENT_DRAIN, mqtt);
+        if ((mqtt->conn.state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_DISCONNECTING) ||
+            swi_mangoh_data_router_conn_isConnected(&mqtt->conn))
+        {
+            LE_DEBUG("delayed MQTT disconnect");
+            goto cleanup;
+        }
+    }
+
+    swi_mangoh_data_router_mqttClose(mqtt);
+
+cleanup:
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send the batched requests, spill the queued requests and write the buffered spool records, e.g.
+ * before exiting
+ */
+//--------------------------------------------------------------------------------------------------
+void swi_mangoh_data_router_mqttFlush(
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    LE_ASSERT(mqtt);
+
+    if (!mqtt->open)
+    {
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_mqttBatchFlush(mqtt);
+    swi_mangoh_data_router_mqttSpillAll(mqtt);
+    for (uint32_t priority = 0; mqtt->spoolOpen && (priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM);
+         priority++)
+    {
+        swi_mangoh_data_router_spool_flush(&mqtt->spool[priority]);
+    }
+
+cleanup:
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add an item to the full state snapshot, as a ["key",timestamp,value,type] entry like the entries
+ * of the inbound batches.  The entries are sent on the snapshot key as JSON arrays of up to the
+ * snapshot length, deflated then base64 encoded.  Items are skipped while disconnected, the next
+ * snapshot brings the server up to date.
+ */
+//--------------------------------------------------------------------------------------------------
+void swi_mangoh_data_router_mqttSnapshotAdd(
+    const char*                            key,
+    const swi_mangoh_data_router_dbItem_t* dbItem,
+    swi_mangoh_data_router_mqtt_t*         mqtt)
+{
+    char                          entry[SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_ENTRY_MAX_LEN] = {0};
+    swi_mangoh_data_router_text_t text;
+
+    LE_ASSERT(key);
+    LE_ASSERT(dbItem);
+    LE_ASSERT(mqtt);
+
+    if (!mqtt->open || !swi_mangoh_data_router_conn_isConnected(&mqtt->conn))
+    {
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_text_init(&text, entry, sizeof(entry));
+    swi_mangoh_data_router_text_encodeChar(&text, '[');
+    swi_mangoh_data_router_text_encodeString(&text, key);
+    swi_mangoh_data_router_text_encodeChar(&text, ',');
+    swi_mangoh_data_router_text_encodeUint(&text, dbItem->data.timestamp);
+    swi_mangoh_data_router_text_encodeChar(&text, ',');
+    swi_mangoh_data_router_text_encodeValue(&text, &dbItem->data);
+    swi_mangoh_data_router_text_encodeChar(&text, ',');
+    swi_mangoh_data_router_text_encodeUint(&text, dbItem->data.type);
+    swi_mangoh_data_router_text_encodeChar(&text, ']');
+    if (!swi_mangoh_data_router_text_isValid(&text))
+    {
+        LE_WARN("key('%s') too long to snapshot", key);
+        goto cleanup;
+    }
+
+    // Entries are preceded by "[" or "," and the array ends with "]"
+    if (mqtt->snapshotLen + 1 + text.used + 1 > sizeof(mqtt->snapshot))
+    {
+        swi_mangoh_data_router_mqttSnapshotSend(mqtt);
+    }
+
+    mqtt->snapshot[mqtt->snapshotLen] = mqtt->snapshotLen ? ',' : '[';
+    mqtt->snapshotLen++;
+    memcpy(&mqtt->snapshot[mqtt->snapshotLen], entry, text.used);
+    mqtt->snapshotLen += text.used;
+    mqtt->numSnapshotEntries++;
+
+cleanup:
+    return;
+}
+
+static void swi_mangoh_data_router_mqttSnapshotSend(
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    uint8_t  deflated[SWI_MANGOH_DATA_ROUTER_MQTT_SNAPSHOT_DEFLATE_MAX_LEN];
+    char     value[SWI_MANGOH_DATA_ROUTER_TEXT_BASE64_LEN(
+        SWI_MANGOH_DATA_ROUTER_MQTT_SNAPSHOT_DEFLATE_MAX_LEN)];
+    z_stream stream = {0};
+
+    if (!mqtt->snapshotLen)
+    {
+        goto cleanup;
+    }
+
+    mqtt->snapshot[mqtt->snapshotLen++] = ']';
+
+    // A message is deflated at once, a window as large as the message is enough
+    int error = deflateInit2(
+        &stream,
+        Z_BEST_COMPRESSION,
+        Z_DEFLATED,
+        SWI_MANGOH_DATA_ROUTER_MQTT_SNAPSHOT_WINDOW_BITS,
+        SWI_MANGOH_DATA_ROUTER_MQTT_SNAPSHOT_MEM_LEVEL,
+        Z_DEFAULT_STRATEGY);
+    if (error != Z_OK)
+    {
+        LE_ERROR("ERROR deflateInit2() failed(%d)", error);
+        goto cleanup;
+    }
+
+    stream.next_in   = (Bytef*)mqtt->snapshot;
+    stream.avail_in  = mqtt->snapshotLen;
+    stream.next_out  = deflated;
+    stream.avail_out = sizeof(deflated);
+    error            = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if (error != Z_STREAM_END)
+    {
+        LE_ERROR("ERROR deflate() failed(%d)", error);
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_text_base64(deflated, stream.total_out, value, sizeof(value));
+    swi_mangoh_data_router_mqttSend(
+        SWI_MANGOH_DATA_ROUTER_MQTT_SNAPSHOT_KEY, value, DATAROUTER_PRIORITY_NORMAL, mqtt);
+
+    mqtt->numSnapshotMsgs++;
+    mqtt->snapshotRawBytes += mqtt->snapshotLen;
+    mqtt->snapshotBytes += strlen(value);
+
+cleanup:
+    mqtt->snapshotLen = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send the rest of the full state snapshot
+ */
+//--------------------------------------------------------------------------------------------------
+void swi_mangoh_data_router_mqttSnapshotEnd(
+    swi_mangoh_data_router_mqtt_t* mqtt)
+{
+    LE_ASSERT(mqtt);
+
+    swi_mangoh_data_router_mqttSnapshotSend(mqtt);
+    if (mqtt->numSnapshotEntries)
+    {
+        LE_INFO(
+            "snapshot entries(%u) messages(%u) bytes(%zu) of JSON(%zu)",
+            mqtt->numSnapshotEntries,
+            mqtt->numSnapshotMsgs,
+            mqtt->snapshotBytes,
+            mqtt->snapshotRawBytes);
+    }
+
+    mqtt->numSnapshotEntries = 0;
+    mqtt->numSnapshotMsgs    = 0;
+    mqtt->snapshotRawBytes   = 0;
+    mqtt->snapshotBytes      = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send the statistics of an aggregated key as a JSON object, e.g.
+ * {"key":"temp","start":1700000000,"end":1700000059,"count":600,"min":21.5,"max":22.25,
+ * "mean":21.8,"last":22}, with the variance when enabled
+ */
+//--------------------------------------------------------------------------------------------------
+void swi_mangoh_data_router_mqttSendAggregate(
+    const char*                               key,
+    const swi_mangoh_data_router_aggregate_t* aggregate,
+    swi_mangoh_data_router_mqtt_t*            mqtt)
+{
+    char                          value[SWI_MANGOH_DATA_ROUTER_MQTT_AGGREGATE_MAX_LEN] = {0};
+    swi_mangoh_data_router_text_t text;
+
+    LE_ASSERT(key);
+    LE_ASSERT(aggregate);
+    LE_ASSERT(mqtt);
+
+    if (!mqtt->open)
+    {
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_text_init(&text, value, sizeof(value));
+    swi_mangoh_data_router_text_encodeRaw(&text, "{\"key\":");
+    swi_mangoh_data_router_text_encodeString(&text, key);
+    swi_mangoh_data_router_text_encodeRaw(&text, ",\"start\":");
+    swi_mangoh_data_router_text_encodeUint(&text, aggregate->start);
+    swi_mangoh_data_router_text_encodeRaw(&text, ",\"end\":");
+    swi_mangoh_data_router_text_encodeUint(&text, aggregate->end);
+    swi_mangoh_data_router_text_encodeRaw(&text, ",\"count\":");
+    swi_mangoh_data_router_text_encodeUint(&text, aggregate->count);
+    swi_mangoh_data_router_text_encodeRaw(&text, ",\"min\":");
+    swi_mangoh_data_router_text_encodeDouble(&text, aggregate->min);
+    swi_mangoh_data_router_text_encodeRaw(&text, ",\"max\":");
+    swi_mangoh_data_router_text_encodeDouble(&text, aggregate->max);
+    swi_mangoh_data_router_text_encodeRaw(&text, ",\"mean\":");
+    swi_mangoh_data_router_text_encodeDouble(&text, aggregate->mean);
+    swi_mangoh_data_router_text_encodeRaw(&text, ",\"last\":");
+    swi_mangoh_data_router_text_encodeDouble(&text, aggregate->last);
+    if (aggregate->variance)
+    {
+        swi_mangoh_data_router_text_encodeRaw(&text, ",\"variance\":");
+        swi_mangoh_data_router_text_encodeDouble(
+            &text, swi_mangoh_data_router_aggregate_getVariance(aggregate));
+    }
+
+    swi_mangoh_data_router_text_encodeChar(&text, '}');
+    if (!swi_mangoh_data_router_text_isValid(&text))
+    {
+        LE_ERROR("ERROR key('%s') aggregate too long", key);
+        goto cleanup;
+    }
+
+    // Spooled or, without a spool, queued in the class of the aggregated key while disconnected
+    const swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(mqtt->db, key);
+    dataRouter_Priority_t priority = dbItem ? dbItem->priority : DATAROUTER_PRIORITY_NORMAL;
+    if (!mqtt->spoolOpen && (!swi_mangoh_data_router_conn_isConnected(&mqtt->conn) ||
+                             mqtt->numQueuedAggregates[priority]))
+    {
+        swi_mangoh_data_router_mqttQueueAggregate(value, priority, mqtt);
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_mqttSend(SWI_MANGOH_DATA_ROUTER_MQTT_AGGREGATE_KEY, value, priority, mqtt);
+    mqtt->numAggregates++;
+
+cleanup:
+    return;
+}
+
+static void* swi_mangoh_data_router_mqttTransportStart(
+    void*                        context,
+    const char*                  appId,
+    const char*                  url,
+    const char*                  password,
+    swi_mangoh_data_router_db_t* db)
+{
+    return swi_mangoh_data_router_mqttSessionStart(
+        appId, url, password, (swi_mangoh_data_router_mqtt_t*)context, db);
+}
+
+static le_result_t swi_mangoh_data_router_mqttTransportWrite(
+    void*                                  client,
+    const char*                            key,
+    const swi_mangoh_data_router_dbItem_t* dbItem)
+{
+    return swi_mangoh_data_router_mqttWrite(
+        key, dbItem, (swi_mangoh_data_router_mqtt_client_t*)client);
+}
+
+static void swi_mangoh_data_router_mqttTransportWriteBatch(
+    void*                                  client,
+    const char*                            key,
+    const swi_mangoh_data_router_dbItem_t* dbItem,
+    const double*                          values,
+    const uint32_t*                        timestamps,
+    size_t                                 numSamples)
+{
+    swi_mangoh_data_router_mqttWriteSamples(
+        key,
+        dbItem,
+        values,
+        timestamps,
+        numSamples,
+        (swi_mangoh_data_router_mqtt_client_t*)client);
+}
+
+static void swi_mangoh_data_router_mqttTransportFlush(
+    void* context)
+{
+    swi_mangoh_data_router_mqttFlush((swi_mangoh_data_router_mqtt_t*)context);
+}
+
+static void swi_mangoh_data_router_mqttTransportSnapshot(
+    void*                                  context,
+    const char*                            key,
+    const swi_mangoh_data_router_dbItem_t* dbItem)
+{
+    swi_mangoh_data_router_mqttSnapshotAdd(key, dbItem, (swi_mangoh_data_router_mqtt_t*)context);
+}
+
+static void swi_mangoh_data_router_mqttTransportSnapshotEnd(
+    void* context)
+{
+    swi_mangoh_data_router_mqttSnapshotEnd((swi_mangoh_data_router_mqtt_t*)context);
+}
+
+static void swi_mangoh_data_router_mqttTransportAggregate(
+    void*                                     context,
+    const char*                               key,
+    const swi_mangoh_data_router_aggregate_t* aggregate)
+{
+    swi_mangoh_data_router_mqttSendAggregate(
+        key, aggregate, (swi_mangoh_data_router_mqtt_t*)context);
+}
+
+static uint32_t swi_mangoh_data_router_mqttTransportGetFill(
+    void* context)
+{
+    return swi_mangoh_data_router_mqttGetFill((swi_mangoh_data_router_mqtt_t*)context);
+}
+
+static void swi_mangoh_data_router_mqttTransportEnd(
+    void* client)
+{
+    swi_mangoh_data_router_mqttSessionEnd((swi_mangoh_data_router_mqtt_client_t*)client);
 }
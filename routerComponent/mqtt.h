@@ -13,63 +13,216 @@
 #include "interfaces.h"
 
 #include "db.h"
+#include "spool.h"
+#include "text.h"
+#include "alias.h"
+#include "conn.h"
+#include "queue.h"
+#include "priority.h"
+#include "transport.h"
 
 #ifndef SWI_MANGOH_DATA_ROUTER_MQTT_INCLUDE_GUARD
 #define SWI_MANGOH_DATA_ROUTER_MQTT_INCLUDE_GUARD
 
 #define SWI_MANGOH_DATA_ROUTER_MQTT_APP_NAME "MQTT"
 #define SWI_MANGOH_DATA_ROUTER_MQTT_QUEUED_REQUESTS_MAX_NUM 30
-#define SWI_MANGOH_DATA_ROUTER_MQTT_RECONNECT_INTERVAL_SECS 5
 
 #define SWI_MANGOH_DATA_ROUTER_MQTT_URL_LEN 128
 #define SWI_MANGOH_DATA_ROUTER_MQTT_PASSWORD_LEN 128
+#define SWI_MANGOH_DATA_ROUTER_MQTT_VALUE_MAX_LEN 256
+#define SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_MAX_LEN 1024
+#define SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_ENTRY_MAX_LEN 512
+#define SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_KEY "batch"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_SNAPSHOT_KEY "snapshot"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_AGGREGATE_KEY "aggregate"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_AGGREGATE_MAX_LEN 512
+#define SWI_MANGOH_DATA_ROUTER_MQTT_SNAPSHOT_MAX_LEN 2048
+#define SWI_MANGOH_DATA_ROUTER_MQTT_SNAPSHOT_DEFLATE_MAX_LEN (SWI_MANGOH_DATA_ROUTER_MQTT_SNAPSHOT_MAX_LEN + 64)
+#define SWI_MANGOH_DATA_ROUTER_MQTT_SNAPSHOT_WINDOW_BITS 11
+#define SWI_MANGOH_DATA_ROUTER_MQTT_SNAPSHOT_MEM_LEVEL 4
 
 #define SWI_MANGOH_DATA_ROUTER_MQTT_PORT_NUMBER 1883
 #define SWI_MANGOH_DATA_ROUTER_MQTT_KEEP_ALIVE 20
 
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_QUEUE_SIZE "/MQTT/queueSize"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_DROP_POLICY "/MQTT/dropPolicy"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_CRITICAL_QUEUE_SIZE "/MQTT/critical/queueSize"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_CRITICAL_DROP_POLICY "/MQTT/critical/dropPolicy"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_BULK_QUEUE_SIZE "/MQTT/bulk/queueSize"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_BULK_DROP_POLICY "/MQTT/bulk/dropPolicy"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_SPOOL_PATH "/MQTT/spoolPath"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_SPOOL_MAX_SEGMENTS "/MQTT/spoolMaxSegments"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_SPILL_INTERVAL "/MQTT/spillIntervalMs"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_DRAIN_RATE "/MQTT/drainRate"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_BATCH_WINDOW "/MQTT/batchWindowMs"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_BATCH_BYTES "/MQTT/batchBytes"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_MAX_KEY_ALIASES "/MQTT/maxKeyAliases"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_RECONNECT_MIN "/MQTT/reconnectMinMs"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_RECONNECT_MAX "/MQTT/reconnectMaxMs"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_CFG_NETWORK_RETRY "/MQTT/networkRetryMs"
+
+// Writable directory bundled in dataRouter.adef, kept in flash across reboots, the app file system
+// size covers the maximum number of segments
+#define SWI_MANGOH_DATA_ROUTER_MQTT_SPOOL_PATH "/spool"
+#define SWI_MANGOH_DATA_ROUTER_MQTT_SPOOL_MAX_SEGMENTS 48
+#define SWI_MANGOH_DATA_ROUTER_MQTT_SPILL_INTERVAL_MS 10000
+#define SWI_MANGOH_DATA_ROUTER_MQTT_DRAIN_RATE 200
+#define SWI_MANGOH_DATA_ROUTER_MQTT_DRAIN_INTERVAL_MS 100
+#define SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_WINDOW_MS 0
+#define SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_BYTES 256
+#define SWI_MANGOH_DATA_ROUTER_MQTT_MAX_KEY_ALIASES 0
+#define SWI_MANGOH_DATA_ROUTER_MQTT_RECONNECT_MIN_MS 5000
+#define SWI_MANGOH_DATA_ROUTER_MQTT_RECONNECT_MAX_MS 300000
+#define SWI_MANGOH_DATA_ROUTER_MQTT_NETWORK_RETRY_MS 2000
+
+//------------------------------------------------------------------------------------------------------------------
+/**
+ * Data Router MQTT statistics of a priority class
+ */
+//------------------------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_mqtt_classStats_t
+{
+    uint64_t numSent;                                    ///< Updates sent right away
+    uint64_t numQueued;                                  ///< Updates sent once dequeued
+    uint64_t numSpooled;                                 ///< Requests appended to the spool
+    uint64_t queuedMs;                                   ///< Total time the dequeued updates waited
+    uint32_t maxQueuedMs;                                ///< Longest time an update waited
+} swi_mangoh_data_router_mqtt_classStats_t;
+
+//------------------------------------------------------------------------------------------------------------------
+/**
+ * Data Router MQTT aggregate record produced while disconnected, queued by the connection when
+ * there is no spool to append it to
+ */
+//------------------------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_mqtt_queuedAggregate_t
+{
+    char value[SWI_MANGOH_DATA_ROUTER_MQTT_AGGREGATE_MAX_LEN]; ///< Encoded record
+    le_clk_Time_t queued;                                ///< Time the record was queued
+    le_sls_Link_t link;                                  ///< Link in the queued records of the
+                                                         ///  class
+} swi_mangoh_data_router_mqtt_queuedAggregate_t;
+
+struct _swi_mangoh_data_router_mqtt_t;
+
 //------------------------------------------------------------------------------------------------------------------
 /**
- * Data Router outstanding requests list element value
+ * Data Router MQTT client, a session pushing to Air Vantage through the shared connection
  */
 //------------------------------------------------------------------------------------------------------------------
-typedef struct _swi_mangoh_data_router_mqtt_dataLink_t
+typedef struct _swi_mangoh_data_router_mqtt_client_t
 {
-    char key[SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN];  ///< Key associated with the data
-    swi_mangoh_data_router_data_t data;            ///< Element data
-    le_sls_Link_t                 link;            ///< Linked list link to next element
-} swi_mangoh_data_router_mqtt_dataLink_t;
+    char appId[SWI_MANGOH_DATA_ROUTER_APP_NAME_LEN];     ///< Application of the session
+    struct _swi_mangoh_data_router_mqtt_t* mqtt;         ///< Shared connection
+    swi_mangoh_data_router_queue_t outstandingRequests[SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM];
+                                                         ///< Requests waiting to be forwarded,
+                                                         ///  per priority class
+    bool ended;                                          ///< Session ended, the client is freed
+                                                         ///  once its requests are forwarded
+    le_dls_Link_t link;                                  ///< Link in the connection clients
+} swi_mangoh_data_router_mqtt_client_t;
 
 //------------------------------------------------------------------------------------------------------------------
 /**
- * Data Router MQTT protocol
+ * Data Router MQTT protocol, the Air Vantage connection shared by all the pushing sessions.  It is
+ * opened with the first session and closed once the last session ended and the requests queued by
+ * the ended sessions are forwarded.
  */
 //------------------------------------------------------------------------------------------------------------------
 typedef struct _swi_mangoh_data_router_mqtt_t
 {
+    bool open;                                           ///< Connection open flag
+    uint32_t numSessions;                                ///< Sessions using the connection
+    le_dls_List_t clients;                               ///< Clients, including the ended clients
+                                                         ///  with queued requests ::
+                                                         ///  swi_mangoh_data_router_mqtt_client_t
     char url[SWI_MANGOH_DATA_ROUTER_MQTT_URL_LEN];       ///< Air Vantage URL
     char password[SWI_MANGOH_DATA_ROUTER_MQTT_PASSWORD_LEN]; ///< Air Vantage application model
                                                          ///  password
     mqtt_SessionStateHandlerRef_t sessionStateHdlrRef;   ///< MQTT session state callback function
     mqtt_IncomingMessageHandlerRef_t incomingMsgHdlrRef; ///< MQTT incoming data callback function
+    le_data_ConnectionStateHandlerRef_t dataConnHdlrRef; ///< Data connection state callback
+                                                         ///  function
     le_timer_Ref_t reconnectTimer;                       ///< Reconnect timer
-    le_sls_List_t outstandingRequests;                   ///< Requests waiting to be forwarded
+    swi_mangoh_data_router_conn_t conn;                  ///< Air Vantage connection
+    swi_mangoh_data_router_spool_t spool[SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM];
+                                                         ///< Requests waiting to be forwarded,
+                                                         ///  per priority class, the client
+                                                         ///  queues are spilled to them when open
+    bool spoolOpen;                                      ///< Spools open flag
+    le_timer_Ref_t spillTimer;                           ///< Client queues spill timer, spool
+                                                         ///  open only
+    bool replaying[SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM]; ///< Spooled requests of the class being
+                                                         ///  drained
+    le_timer_Ref_t drainTimer;                           ///< Queued requests drain timer
+    uint32_t drainRate;                                  ///< Drain rate (requests/s)
+    uint32_t numDrained;                                 ///< Requests drained since connected
+    le_clk_Time_t drainStart;                            ///< Drain start time
+    uint32_t drainMs;                                    ///< Duration of the last complete drain
+    uint8_t batch[SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_MAX_LEN]; ///< Batched requests
+    size_t batchLen;                                     ///< Batched requests length
+    dataRouter_Priority_t batchPriority;                 ///< Most urgent class of the batched
+                                                         ///  requests, the class it is spooled in
+    size_t batchBytes;                                   ///< Batched requests maximum length
+    uint32_t batchWindowMs;                              ///< Batching window, 0 when disabled
+    le_timer_Ref_t batchTimer;                           ///< Batching window timer
+    swi_mangoh_data_router_alias_t aliases;              ///< Key aliases, disabled when the
+                                                         ///  maximum number of aliases is 0
+    uint32_t numInboundBatches;                          ///< Inbound batches applied
+    uint64_t numInboundUpdates;                          ///< Inbound updates applied
+    uint32_t numInboundRejected;                         ///< Inbound updates and batches rejected
+    uint64_t inboundBatchUs;                             ///< Time spent applying inbound batches
+    char snapshot[SWI_MANGOH_DATA_ROUTER_MQTT_SNAPSHOT_MAX_LEN]; ///< Snapshot entries not sent
+                                                         ///  yet
+    size_t snapshotLen;                                  ///< Snapshot entries length
+    uint32_t numSnapshotEntries;                         ///< Entries of the current snapshot
+    uint32_t numSnapshotMsgs;                            ///< Messages of the current snapshot
+    size_t snapshotRawBytes;                             ///< JSON length of the current snapshot
+    size_t snapshotBytes;                                ///< Sent length of the current snapshot
+    uint32_t numAggregates;                              ///< Aggregate records sent
+    le_sls_List_t queuedAggregates[SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM];
+                                                         ///< Aggregate records waiting to be
+                                                         ///  forwarded, per priority class,
+                                                         ///  without a spool only ::
+                                                         ///  swi_mangoh_data_router_mqtt_queuedAggregate_t
+    uint32_t numQueuedAggregates[SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM];
+                                                         ///< Queued aggregate records per class
+    swi_mangoh_data_router_mqtt_classStats_t classStats[SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM];
+                                                         ///< Statistics per priority class
     swi_mangoh_data_router_db_t* db;                     ///< Database module
-    bool connected;                                      ///< Air Vantage connected flag
-    bool connecting;                                     ///< Air Vantage connecting flag
-    bool disconnect;                                     ///< Air Vantage disconnect flag
 } swi_mangoh_data_router_mqtt_t;
 
 void swi_mangoh_data_router_mqttReconnect(le_timer_Ref_t);
-void swi_mangoh_data_router_mqttSessionStart(
+swi_mangoh_data_router_mqtt_client_t* swi_mangoh_data_router_mqttSessionStart(
     const char*,
     const char*,
     const char*,
     swi_mangoh_data_router_mqtt_t*,
     swi_mangoh_data_router_db_t*);
-bool swi_mangoh_data_router_mqttSessionEnd(swi_mangoh_data_router_mqtt_t*);
-void swi_mangoh_data_router_mqttWrite(
-    const char* key,
+void swi_mangoh_data_router_mqttSessionEnd(swi_mangoh_data_router_mqtt_client_t*);
+void swi_mangoh_data_router_mqttSnapshotAdd(
+    const char*,
     const swi_mangoh_data_router_dbItem_t*,
     swi_mangoh_data_router_mqtt_t*);
+void swi_mangoh_data_router_mqttSnapshotEnd(swi_mangoh_data_router_mqtt_t*);
+void swi_mangoh_data_router_mqttSendAggregate(
+    const char*,
+    const swi_mangoh_data_router_aggregate_t*,
+    swi_mangoh_data_router_mqtt_t*);
+void swi_mangoh_data_router_mqttWriteSamples(
+    const char* key,
+    const swi_mangoh_data_router_dbItem_t*,
+    const double*,
+    const uint32_t*,
+    size_t,
+    swi_mangoh_data_router_mqtt_client_t*);
+le_result_t swi_mangoh_data_router_mqttWrite(
+    const char* key,
+    const swi_mangoh_data_router_dbItem_t*,
+    swi_mangoh_data_router_mqtt_client_t*);
+void swi_mangoh_data_router_mqttFlush(swi_mangoh_data_router_mqtt_t*);
+uint32_t swi_mangoh_data_router_mqttGetFill(swi_mangoh_data_router_mqtt_t*);
+
+extern const swi_mangoh_data_router_transportOps_t swi_mangoh_data_router_mqttTransportOps;
 
 #endif
@@ -0,0 +1,250 @@
+/**
+ * @file
+ *
+ * Data items written with a persisted storage type are marked dirty by the database module.  A
+ * periodic snapshot on the main data router thread copies the dirty items into one of two batches
+ * and hands the batch over to the writer thread, so config tree transactions and secure storage
+ * writes never block the data router API.  When both batches are still being written the
+ * snapshot is deferred and the dirty items keep coalescing in the database.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include "persist.h"
+
+static void swi_mangoh_data_router_persist_writeBatch(void*, void*);
+static void swi_mangoh_data_router_persist_postBarrier(void*, void*);
+static void swi_mangoh_data_router_persist_waitBarrier(swi_mangoh_data_router_persist_t*);
+static void swi_mangoh_data_router_persist_snapshot(swi_mangoh_data_router_persist_t*);
+static void swi_mangoh_data_router_persist_timerHandler(le_timer_Ref_t);
+static void* swi_mangoh_data_router_persist_threadMain(void*);
+
+static void swi_mangoh_data_router_persist_writeBatch
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    swi_mangoh_data_router_persistBatch_t* batch =
+        (swi_mangoh_data_router_persistBatch_t*)param2Ptr;
+
+    LE_DEBUG("write batch items(%zu)", batch->numItems);
+    for (size_t i = 0; i < batch->numItems; i++)
+    {
+        const swi_mangoh_data_router_persistItem_t* item = &batch->items[i];
+
+        if ((item->prevStorageType != DATAROUTER_CACHE) &&
+            (item->prevStorageType != item->storageType))
+        {
+            swi_mangoh_data_router_db_deleteData(item->key, item->prevStorageType);
+        }
+
+        if (item->storageType != DATAROUTER_CACHE)
+        {
+            swi_mangoh_data_router_db_storeData(item->key, item->storageType, &item->data);
+        }
+    }
+
+    if (batch->encryptedKeysLen)
+    {
+        swi_mangoh_data_router_db_storeEncryptedKeys(batch->encryptedKeys, batch->encryptedKeysLen);
+    }
+
+    batch->numItems = 0;
+    batch->encryptedKeysLen = 0;
+    __atomic_store_n(&batch->busy, false, __ATOMIC_RELEASE);
+}
+
+static void swi_mangoh_data_router_persist_postBarrier
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    swi_mangoh_data_router_persist_t* persist = (swi_mangoh_data_router_persist_t*)param1Ptr;
+    le_sem_Post(persist->barrier);
+}
+
+static void swi_mangoh_data_router_persist_waitBarrier
+(
+    swi_mangoh_data_router_persist_t* persist
+)
+{
+    le_clk_Time_t timeout = { .sec = SWI_MANGOH_DATA_ROUTER_PERSIST_FLUSH_TIMEOUT_SECS };
+
+    // Batches are written in order, so the barrier is reached once all queued batches are written
+    le_event_QueueFunctionToThread(
+        persist->thread, swi_mangoh_data_router_persist_postBarrier, persist, NULL);
+
+    le_result_t res = le_sem_WaitWithTimeOut(persist->barrier, timeout);
+    if (res != LE_OK)
+    {
+        LE_ERROR("ERROR le_sem_WaitWithTimeOut() failed(%d)", res);
+    }
+}
+
+static void swi_mangoh_data_router_persist_snapshot
+(
+    swi_mangoh_data_router_persist_t* persist
+)
+{
+    swi_mangoh_data_router_persistBatch_t* batch = NULL;
+    bool encryptedKeysChanged = false;
+
+    for (uint32_t i = 0; i < SWI_MANGOH_DATA_ROUTER_PERSIST_BATCHES_NUM; i++)
+    {
+        if (!__atomic_load_n(&persist->batches[i].busy, __ATOMIC_ACQUIRE))
+        {
+            batch = &persist->batches[i];
+            break;
+        }
+    }
+
+    if (!batch)
+    {
+        persist->numDeferred++;
+        LE_WARN("persistence writer busy, snapshot deferred(%u)", persist->numDeferred);
+        goto cleanup;
+    }
+
+    LE_ASSERT(!batch->numItems);
+    while (true)
+    {
+        if (batch->numItems == batch->maxItems)
+        {
+            size_t maxItems = batch->maxItems ?
+                2 * batch->maxItems : SWI_MANGOH_DATA_ROUTER_PERSIST_BATCH_INIT_SIZE;
+            swi_mangoh_data_router_persistItem_t* items =
+                realloc(batch->items, maxItems * sizeof(swi_mangoh_data_router_persistItem_t));
+            if (!items)
+            {
+                LE_ERROR("ERROR realloc() failed");
+                break;
+            }
+
+            batch->items = items;
+            batch->maxItems = maxItems;
+        }
+
+        swi_mangoh_data_router_dbItem_t* dbItem =
+            swi_mangoh_data_router_db_popDirtyItem(persist->db);
+        if (!dbItem)
+        {
+            break;
+        }
+
+        // The main thread is the only writer, the data can be copied without the sequence lock
+        swi_mangoh_data_router_persistItem_t* item = &batch->items[batch->numItems++];
+        strncpy(item->key, dbItem->key, sizeof(item->key) - 1);
+        item->key[sizeof(item->key) - 1] = '\0';
+        item->storageType = dbItem->storageType;
+        item->prevStorageType = dbItem->persistedStorageType;
+        memcpy(&item->data, &dbItem->data, sizeof(swi_mangoh_data_router_data_t));
+
+        if ((item->storageType != item->prevStorageType) &&
+            ((item->storageType == DATAROUTER_PERSIST_ENCRYPTED) ||
+             (item->prevStorageType == DATAROUTER_PERSIST_ENCRYPTED)))
+        {
+            encryptedKeysChanged = true;
+        }
+
+        dbItem->persistedStorageType = dbItem->storageType;
+    }
+
+    if (encryptedKeysChanged)
+    {
+        batch->encryptedKeysLen = swi_mangoh_data_router_db_getEncryptedKeys(
+            persist->db, batch->encryptedKeys, SWI_MANGOH_DATA_ROUTER_SEC_STORE_MAX_KEYS_LEN);
+    }
+
+    if (!batch->numItems && !batch->encryptedKeysLen)
+    {
+        goto cleanup;
+    }
+
+    LE_DEBUG("snapshot items(%zu)", batch->numItems);
+    __atomic_store_n(&batch->busy, true, __ATOMIC_RELEASE);
+    le_event_QueueFunctionToThread(
+        persist->thread, swi_mangoh_data_router_persist_writeBatch, persist, batch);
+
+cleanup:
+    return;
+}
+
+static void swi_mangoh_data_router_persist_timerHandler
+(
+    le_timer_Ref_t timer
+)
+{
+    swi_mangoh_data_router_persist_t* persist =
+        (swi_mangoh_data_router_persist_t*)le_timer_GetContextPtr(timer);
+    swi_mangoh_data_router_persist_snapshot(persist);
+}
+
+static void* swi_mangoh_data_router_persist_threadMain
+(
+    void* context
+)
+{
+    LE_INFO("Data router persistence writer started");
+    le_cfg_ConnectService();
+    le_secStore_ConnectService();
+    le_event_RunLoop();
+    return NULL;
+}
+
+void swi_mangoh_data_router_persist_start
+(
+    swi_mangoh_data_router_persist_t* persist,
+    swi_mangoh_data_router_db_t* db
+)
+{
+    le_clk_Time_t interval = { .sec = SWI_MANGOH_DATA_ROUTER_PERSIST_INTERVAL_SECS };
+
+    LE_ASSERT(persist);
+    LE_ASSERT(db);
+
+    memset(persist, 0, sizeof(swi_mangoh_data_router_persist_t));
+    persist->db = db;
+
+    for (uint32_t i = 0; i < SWI_MANGOH_DATA_ROUTER_PERSIST_BATCHES_NUM; i++)
+    {
+        persist->batches[i].encryptedKeys =
+            calloc(1, SWI_MANGOH_DATA_ROUTER_SEC_STORE_MAX_KEYS_LEN);
+        LE_ASSERT(persist->batches[i].encryptedKeys);
+    }
+
+    persist->barrier = le_sem_Create("DataRouterPersistBarrier", 0);
+
+    persist->thread = le_thread_Create(
+        SWI_MANGOH_DATA_ROUTER_PERSIST_THREAD_NAME,
+        swi_mangoh_data_router_persist_threadMain,
+        NULL);
+    le_thread_Start(persist->thread);
+
+    persist->timer = le_timer_Create("DataRouterPersistTimer");
+    le_timer_SetInterval(persist->timer, interval);
+    le_timer_SetRepeat(persist->timer, 0);
+    le_timer_SetContextPtr(persist->timer, persist);
+    le_timer_SetHandler(persist->timer, swi_mangoh_data_router_persist_timerHandler);
+    le_timer_Start(persist->timer);
+}
+
+// Called on SIGTERM, waits for the queued batches and writes the items that are still dirty.
+void swi_mangoh_data_router_persist_flush
+(
+    swi_mangoh_data_router_persist_t* persist
+)
+{
+    LE_ASSERT(persist);
+
+    le_timer_Stop(persist->timer);
+    swi_mangoh_data_router_persist_waitBarrier(persist);
+    swi_mangoh_data_router_persist_snapshot(persist);
+    swi_mangoh_data_router_persist_waitBarrier(persist);
+}
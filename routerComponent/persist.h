@@ -0,0 +1,75 @@
+/*
+ * @file persist.h
+ *
+ * Data router module.
+ *
+ * This module writes the persisted data of the mangOH data router from a background thread.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_PERSIST_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_PERSIST_INCLUDE_GUARD
+
+#define SWI_MANGOH_DATA_ROUTER_PERSIST_THREAD_NAME "DataRouterPersist"
+#define SWI_MANGOH_DATA_ROUTER_PERSIST_INTERVAL_SECS 30
+#define SWI_MANGOH_DATA_ROUTER_PERSIST_FLUSH_TIMEOUT_SECS 10
+#define SWI_MANGOH_DATA_ROUTER_PERSIST_BATCHES_NUM 2
+#define SWI_MANGOH_DATA_ROUTER_PERSIST_BATCH_INIT_SIZE 32
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router persisted data item snapshot
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_persistItem_t
+{
+    char key[SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN]; ///< Key associated with the data
+    dataRouter_Storage_t storageType;             ///< Storage to write the data to
+    dataRouter_Storage_t prevStorageType;         ///< Storage to remove the data from
+    swi_mangoh_data_router_data_t data;           ///< Data
+} swi_mangoh_data_router_persistItem_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router persistence batch, owned by the writer thread while busy
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_persistBatch_t
+{
+    swi_mangoh_data_router_persistItem_t* items; ///< Data item snapshots
+    size_t numItems;                             ///< Number of data item snapshots
+    size_t maxItems;                             ///< Data item snapshots capacity
+    char* encryptedKeys;                         ///< Encrypted keys list
+    size_t encryptedKeysLen;                     ///< Encrypted keys list length, 0 when unchanged
+    bool busy;                                   ///< Batch queued to the writer thread flag
+} swi_mangoh_data_router_persistBatch_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router persistence module
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_persist_t
+{
+    swi_mangoh_data_router_db_t* db;        ///< Database module
+    le_thread_Ref_t thread;                 ///< Writer thread
+    le_timer_Ref_t timer;                   ///< Snapshot timer
+    le_sem_Ref_t barrier;                   ///< Flush barrier semaphore
+    swi_mangoh_data_router_persistBatch_t batches[SWI_MANGOH_DATA_ROUTER_PERSIST_BATCHES_NUM];
+                                            ///< Snapshot batches
+    uint32_t numDeferred;                   ///< Snapshots deferred, writer thread busy
+} swi_mangoh_data_router_persist_t;
+
+void swi_mangoh_data_router_persist_start(
+    swi_mangoh_data_router_persist_t*,
+    swi_mangoh_data_router_db_t*);
+void swi_mangoh_data_router_persist_flush(swi_mangoh_data_router_persist_t*);
+
+#endif
@@ -0,0 +1,166 @@
+/**
+ * @file
+ *
+ * The rules are few and only change when an application sets them, while the class of a key is
+ * needed on every push.  So the rules are matched once per key and generation of the rules, and
+ * the resulting class is kept in the database item.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include "priority.h"
+
+void swi_mangoh_data_router_priority_init
+(
+    swi_mangoh_data_router_priority_t* priorities
+)
+{
+    LE_ASSERT(priorities);
+
+    memset(priorities, 0, sizeof(swi_mangoh_data_router_priority_t));
+
+    // Items start with generation 0 so that their class is matched on the first push
+    priorities->generation = 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the priority class of a key, or of the keys starting with a prefix when the pattern ends
+ * with the wildcard.  The rule of the same pattern is replaced.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t swi_mangoh_data_router_priority_set
+(
+    swi_mangoh_data_router_priority_t* priorities,
+    const char* pattern,
+    dataRouter_Priority_t priority
+)
+{
+    le_result_t res = LE_OK;
+
+    LE_ASSERT(priorities);
+    LE_ASSERT(pattern);
+
+    if (priority >= SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM)
+    {
+        LE_ERROR("ERROR invalid priority(%d)", priority);
+        res = LE_BAD_PARAMETER;
+        goto cleanup;
+    }
+
+    size_t len = strnlen(pattern, SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN);
+    bool prefix = len && (pattern[len - 1] == SWI_MANGOH_DATA_ROUTER_PRIORITY_WILDCARD);
+    if (prefix)
+    {
+        len--;
+    }
+
+    if (len >= SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN)
+    {
+        LE_ERROR("ERROR pattern too long");
+        res = LE_BAD_PARAMETER;
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_priorityRule_t* rule = NULL;
+    for (uint32_t i = 0; i < priorities->numRules; i++)
+    {
+        if ((priorities->rules[i].prefix == prefix) && (priorities->rules[i].len == len) &&
+            !memcmp(priorities->rules[i].pattern, pattern, len))
+        {
+            rule = &priorities->rules[i];
+            break;
+        }
+    }
+
+    if (!rule)
+    {
+        if (priorities->numRules == SWI_MANGOH_DATA_ROUTER_PRIORITY_RULES_MAX_NUM)
+        {
+            LE_ERROR("ERROR too many priority rules(%u)", priorities->numRules);
+            res = LE_NO_MEMORY;
+            goto cleanup;
+        }
+
+        rule = &priorities->rules[priorities->numRules++];
+        memcpy(rule->pattern, pattern, len);
+        rule->pattern[len] = '\0';
+        rule->len = len;
+        rule->prefix = prefix;
+    }
+
+    rule->priority = priority;
+    priorities->generation++;
+    LE_INFO(
+        "pattern('%s%s') priority(%s)",
+        rule->pattern,
+        prefix ? "*" : "",
+        swi_mangoh_data_router_priority_getName(priority));
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update the priority class of a database item if the rules changed since it was matched
+ */
+//--------------------------------------------------------------------------------------------------
+void swi_mangoh_data_router_priority_apply
+(
+    const swi_mangoh_data_router_priority_t* priorities,
+    swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    LE_ASSERT(priorities);
+    LE_ASSERT(dbItem);
+
+    if (dbItem->priorityGeneration == priorities->generation)
+    {
+        goto cleanup;
+    }
+
+    const swi_mangoh_data_router_priorityRule_t* match = NULL;
+    for (uint32_t i = 0; i < priorities->numRules; i++)
+    {
+        const swi_mangoh_data_router_priorityRule_t* rule = &priorities->rules[i];
+        if (rule->prefix)
+        {
+            if (!strncmp(dbItem->key, rule->pattern, rule->len) &&
+                (!match || (match->prefix && (rule->len > match->len))))
+            {
+                match = rule;
+            }
+        }
+        else if (!strcmp(dbItem->key, rule->pattern))
+        {
+            match = rule;
+            break;
+        }
+    }
+
+    dbItem->priority = match ? match->priority : DATAROUTER_PRIORITY_NORMAL;
+    dbItem->priorityGeneration = priorities->generation;
+
+cleanup:
+    return;
+}
+
+const char* swi_mangoh_data_router_priority_getName
+(
+    dataRouter_Priority_t priority
+)
+{
+    static const char* const names[SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM] = {
+        "critical",
+        "normal",
+        "bulk",
+    };
+
+    return (priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM) ? names[priority] : "unknown";
+}
@@ -0,0 +1,62 @@
+/*
+ * @file priority.h
+ *
+ * Data router module.
+ *
+ * This module assigns the upstream priority classes of the mangOH data router keys.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_PRIORITY_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_PRIORITY_INCLUDE_GUARD
+
+#define SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM (DATAROUTER_PRIORITY_BULK + 1)
+#define SWI_MANGOH_DATA_ROUTER_PRIORITY_RULES_MAX_NUM 32
+#define SWI_MANGOH_DATA_ROUTER_PRIORITY_WILDCARD '*'
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router priority rule, a key or a key prefix followed by the wildcard
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_priorityRule_t
+{
+    char pattern[SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN]; ///< Key or key prefix, without the wildcard
+    size_t len;                                      ///< Pattern length
+    bool prefix;                                     ///< Pattern is a key prefix
+    dataRouter_Priority_t priority;                  ///< Priority class of the matching keys
+} swi_mangoh_data_router_priorityRule_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router priority rules.  A key gets the priority class of the key rule, or else of the
+ * longest matching prefix rule, normal by default.  The class is cached in the database item until
+ * the rules change.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_priority_t
+{
+    swi_mangoh_data_router_priorityRule_t rules[SWI_MANGOH_DATA_ROUTER_PRIORITY_RULES_MAX_NUM];
+                                          ///< Priority rules
+    uint32_t numRules;                    ///< Number of rules
+    uint32_t generation;                  ///< Rules generation, incremented on each change
+} swi_mangoh_data_router_priority_t;
+
+void swi_mangoh_data_router_priority_init(swi_mangoh_data_router_priority_t*);
+le_result_t swi_mangoh_data_router_priority_set(
+    swi_mangoh_data_router_priority_t*,
+    const char*,
+    dataRouter_Priority_t);
+void swi_mangoh_data_router_priority_apply(
+    const swi_mangoh_data_router_priority_t*,
+    swi_mangoh_data_router_dbItem_t*);
+const char* swi_mangoh_data_router_priority_getName(dataRouter_Priority_t);
+
+#endif
@@ -0,0 +1,299 @@
+/**
+ * @file
+ *
+ * The queue keeps the updates that cannot be sent yet in a fixed capacity ring.  With the keep
+ * latest policy an open addressing table of the queued keys lets an update overwrite the queued
+ * update of its key, so the ring holds the latest value of up to size keys, in the order they
+ * were first updated.  Otherwise all the updates are queued and the oldest or the newest update
+ * is dropped when the ring is full.  Messages already formatted for the transport, the packed
+ * blocks of samples, are queued as they are and never coalesced.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include "queue.h"
+
+static uint32_t* swi_mangoh_data_router_queue_find(swi_mangoh_data_router_queue_t*, const char*);
+static void swi_mangoh_data_router_queue_indexRemove(swi_mangoh_data_router_queue_t*, uint32_t);
+static le_result_t swi_mangoh_data_router_queue_append(
+    swi_mangoh_data_router_queue_t*,
+    const char*,
+    const swi_mangoh_data_router_data_t*,
+    bool,
+    uint32_t*);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find the queued keys table slot of a key, the slot is 0 when the key is not queued
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t* swi_mangoh_data_router_queue_find(
+    swi_mangoh_data_router_queue_t* queue,
+    const char*                     key)
+{
+    uint32_t mask = queue->indexSize - 1;
+    uint32_t slot = le_hashmap_HashString(key) & mask;
+
+    while (queue->index[slot] && strcmp(queue->entries[queue->index[slot] - 1].key, key))
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return &queue->index[slot];
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a ring entry from the queued keys table, shifting back the entries probed past it
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_queue_indexRemove(
+    swi_mangoh_data_router_queue_t* queue,
+    uint32_t                        pos)
+{
+    uint32_t  mask = queue->indexSize - 1;
+    uint32_t* slotPtr = swi_mangoh_data_router_queue_find(queue, queue->entries[pos].key);
+    uint32_t  hole = slotPtr - queue->index;
+
+    LE_ASSERT(*slotPtr == pos + 1);
+    for (uint32_t slot = (hole + 1) & mask; queue->index[slot]; slot = (slot + 1) & mask)
+    {
+        uint32_t home =
+            le_hashmap_HashString(queue->entries[queue->index[slot] - 1].key) & mask;
+
+        // Entries whose home slot is cyclically in (hole, slot] stay where they are
+        if (((slot - home) & mask) >= ((slot - hole) & mask))
+        {
+            queue->index[hole] = queue->index[slot];
+            hole = slot;
+        }
+    }
+
+    queue->index[hole] = 0;
+}
+
+void swi_mangoh_data_router_queue_init(
+    swi_mangoh_data_router_queue_t* queue,
+    const char*                     sizeCfg,
+    const char*                     dropPolicyCfg,
+    uint32_t                        defaultSize)
+{
+    char dropPolicy[SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_POLICY_LEN] = {0};
+
+    memset(queue, 0, sizeof(swi_mangoh_data_router_queue_t));
+
+    int32_t size = le_cfg_QuickGetInt(sizeCfg, defaultSize);
+    if (size <= 0)
+    {
+        LE_WARN("invalid queue size(%d)", size);
+        size = defaultSize;
+    }
+
+    le_result_t res = le_cfg_QuickGetString(
+        dropPolicyCfg,
+        dropPolicy,
+        sizeof(dropPolicy),
+        SWI_MANGOH_DATA_ROUTER_QUEUE_KEEP_LATEST);
+    if ((res != LE_OK) || !strcmp(dropPolicy, SWI_MANGOH_DATA_ROUTER_QUEUE_KEEP_LATEST))
+    {
+        queue->dropPolicy = SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_POLICY_KEEP_LATEST;
+    }
+    else if (!strcmp(dropPolicy, SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_OLDEST))
+    {
+        queue->dropPolicy = SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_POLICY_DROP_OLDEST;
+    }
+    else if (!strcmp(dropPolicy, SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_NEWEST))
+    {
+        queue->dropPolicy = SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_POLICY_DROP_NEWEST;
+    }
+    else
+    {
+        LE_WARN("invalid drop policy('%s')", dropPolicy);
+        queue->dropPolicy = SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_POLICY_KEEP_LATEST;
+    }
+
+    queue->size    = size;
+    queue->entries = calloc(queue->size, sizeof(swi_mangoh_data_router_queueEntry_t));
+    LE_ASSERT(queue->entries);
+
+    if (queue->dropPolicy == SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_POLICY_KEEP_LATEST)
+    {
+        // At most half full so that probe sequences stay short
+        queue->indexSize = 1;
+        while (queue->indexSize < 2 * queue->size)
+        {
+            queue->indexSize <<= 1;
+        }
+
+        queue->index = calloc(queue->indexSize, sizeof(uint32_t));
+        LE_ASSERT(queue->index);
+    }
+
+    LE_DEBUG("queue size(%u), drop policy(%d)", queue->size, queue->dropPolicy);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append an entry to the ring, applying the drop policy when the ring is full.  The queued keys
+ * table slot of the key is given for the entries that can be coalesced, NULL otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t swi_mangoh_data_router_queue_append(
+    swi_mangoh_data_router_queue_t*      queue,
+    const char*                          key,
+    const swi_mangoh_data_router_data_t* data,
+    bool                                 message,
+    uint32_t*                            slotPtr)
+{
+    le_result_t res = LE_OK;
+
+    if (queue->numEntries == queue->size)
+    {
+        res = LE_OVERFLOW;
+        if (queue->dropPolicy == SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_POLICY_DROP_NEWEST)
+        {
+            queue->numDroppedNewest++;
+            LE_WARN("cannot queue('%s') data update, dropped(%u)", key, queue->numDroppedNewest);
+            goto cleanup;
+        }
+
+        const swi_mangoh_data_router_queueEntry_t* oldest =
+            swi_mangoh_data_router_queue_pop(queue);
+        queue->numDroppedOldest++;
+        LE_WARN("drop('%s') queued data update, dropped(%u)", oldest->key, queue->numDroppedOldest);
+
+        // The slot of the dropped key may have been shifted back
+        if (slotPtr)
+        {
+            slotPtr = swi_mangoh_data_router_queue_find(queue, key);
+        }
+    }
+
+    uint32_t pos = (queue->head + queue->numEntries) % queue->size;
+    LE_DEBUG("queue('%s')", key);
+    strncpy(queue->entries[pos].key, key, sizeof(queue->entries[pos].key) - 1);
+    queue->entries[pos].key[sizeof(queue->entries[pos].key) - 1] = '\0';
+    memcpy(&queue->entries[pos].data, data, sizeof(swi_mangoh_data_router_data_t));
+    queue->entries[pos].queued  = le_clk_GetRelativeTime();
+    queue->entries[pos].message = message;
+    queue->numEntries++;
+
+    if (slotPtr)
+    {
+        *slotPtr = pos + 1;
+    }
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue an update, returns LE_OVERFLOW when the ring was full and the update or the oldest queued
+ * update was dropped
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t swi_mangoh_data_router_queue_push(
+    swi_mangoh_data_router_queue_t*      queue,
+    const char*                          key,
+    const swi_mangoh_data_router_data_t* data)
+{
+    le_result_t res     = LE_OK;
+    uint32_t*   slotPtr = NULL;
+
+    if (queue->index)
+    {
+        slotPtr = swi_mangoh_data_router_queue_find(queue, key);
+        if (*slotPtr)
+        {
+            LE_DEBUG("coalesce('%s')", key);
+            memcpy(
+                &queue->entries[*slotPtr - 1].data, data, sizeof(swi_mangoh_data_router_data_t));
+            queue->numCoalesced++;
+            goto cleanup;
+        }
+    }
+
+    res = swi_mangoh_data_router_queue_append(queue, key, data, false, slotPtr);
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue a message already formatted for the transport, such as a packed block of samples.  The
+ * message is never coalesced, each message of a block takes a ring entry.  Returns LE_OVERFLOW
+ * when the ring was full and the message or the oldest queued update was dropped.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t swi_mangoh_data_router_queue_pushMessage(
+    swi_mangoh_data_router_queue_t* queue,
+    const char*                     key,
+    const char*                     message)
+{
+    swi_mangoh_data_router_data_t data = {.type = DATAROUTER_STRING};
+
+    LE_ASSERT(strlen(message) < sizeof(data.sValue));
+    strcpy(data.sValue, message);
+    data.timestamp = time(NULL);
+
+    return swi_mangoh_data_router_queue_append(queue, key, &data, true, NULL);
+}
+
+const swi_mangoh_data_router_queueEntry_t* swi_mangoh_data_router_queue_pop(
+    swi_mangoh_data_router_queue_t* queue)
+{
+    const swi_mangoh_data_router_queueEntry_t* entry = NULL;
+
+    if (!queue->numEntries)
+    {
+        goto cleanup;
+    }
+
+    if (queue->index && !queue->entries[queue->head].message)
+    {
+        swi_mangoh_data_router_queue_indexRemove(queue, queue->head);
+    }
+
+    // The entry stays valid until the next push
+    entry = &queue->entries[queue->head];
+    queue->head = (queue->head + 1) % queue->size;
+    queue->numEntries--;
+
+cleanup:
+    return entry;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Percentage of the ring in use
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t swi_mangoh_data_router_queue_getFill(
+    const swi_mangoh_data_router_queue_t* queue)
+{
+    return queue->size ? (uint64_t)queue->numEntries * 100 / queue->size : 0;
+}
+
+void swi_mangoh_data_router_queue_destroy(
+    swi_mangoh_data_router_queue_t* queue)
+{
+    if (queue->numCoalesced || queue->numDroppedOldest || queue->numDroppedNewest)
+    {
+        LE_INFO(
+            "queue coalesced(%u), dropped oldest(%u), dropped newest(%u)",
+            queue->numCoalesced,
+            queue->numDroppedOldest,
+            queue->numDroppedNewest);
+    }
+
+    free(queue->entries);
+    free(queue->index);
+    memset(queue, 0, sizeof(swi_mangoh_data_router_queue_t));
+}
@@ -0,0 +1,84 @@
+/*
+ * @file queue.h
+ *
+ * Data router module.
+ *
+ * This module is the offline queue of the data updates waiting for an upstream transport.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_QUEUE_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_QUEUE_INCLUDE_GUARD
+
+#define SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_POLICY_LEN 16
+#define SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_OLDEST "dropOldest"
+#define SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_NEWEST "dropNewest"
+#define SWI_MANGOH_DATA_ROUTER_QUEUE_KEEP_LATEST "keepLatest"
+
+typedef enum _swi_mangoh_data_router_queue_dropPolicy_e {
+    SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_POLICY_KEEP_LATEST = 0, ///< Coalesce per key, drop oldest
+    SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_POLICY_DROP_OLDEST,     ///< Queue all updates, drop oldest
+    SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_POLICY_DROP_NEWEST,     ///< Queue all updates, drop newest
+} swi_mangoh_data_router_queue_dropPolicy_e;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router outstanding requests queue element value
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_queueEntry_t
+{
+    char key[SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN];  ///< Key associated with the data
+    swi_mangoh_data_router_data_t data;            ///< Element data
+    le_clk_Time_t queued;                          ///< Time the key was queued, kept when the
+                                                   ///  update is coalesced
+    bool message;                                  ///< String value is a message formatted for
+                                                   ///  the transport, not in the keys table
+} swi_mangoh_data_router_queueEntry_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router outstanding requests queue, a fixed capacity ring of the updates made while offline
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_queue_t
+{
+    swi_mangoh_data_router_queueEntry_t* entries;  ///< Ring entries
+    uint32_t size;                                 ///< Ring capacity
+    uint32_t head;                                 ///< Oldest entry
+    uint32_t numEntries;                           ///< Number of queued entries
+    swi_mangoh_data_router_queue_dropPolicy_e dropPolicy; ///< Policy applied when the ring is full
+    uint32_t* index;                               ///< Queued keys, open addressing table of ring
+                                                   ///  entry + 1, keep latest policy only
+    uint32_t indexSize;                            ///< Queued keys table size, power of 2
+    uint32_t numCoalesced;                         ///< Updates that overwrote a queued update
+    uint32_t numDroppedOldest;                     ///< Queued updates dropped for newer updates
+    uint32_t numDroppedNewest;                     ///< Updates dropped, queue full
+} swi_mangoh_data_router_queue_t;
+
+void swi_mangoh_data_router_queue_init(
+    swi_mangoh_data_router_queue_t*,
+    const char*,
+    const char*,
+    uint32_t);
+le_result_t swi_mangoh_data_router_queue_push(
+    swi_mangoh_data_router_queue_t*,
+    const char*,
+    const swi_mangoh_data_router_data_t*);
+le_result_t swi_mangoh_data_router_queue_pushMessage(
+    swi_mangoh_data_router_queue_t*,
+    const char*,
+    const char*);
+const swi_mangoh_data_router_queueEntry_t* swi_mangoh_data_router_queue_pop(
+    swi_mangoh_data_router_queue_t*);
+uint32_t swi_mangoh_data_router_queue_getFill(const swi_mangoh_data_router_queue_t*);
+void swi_mangoh_data_router_queue_destroy(swi_mangoh_data_router_queue_t*);
+
+#endif
@@ -0,0 +1,224 @@
+/**
+ * @file
+ *
+ * The reader thread never modifies the database.  Data items are found through the key index and
+ * handle table published by the database module and their values are copied under the data item
+ * sequence lock, so reads never wait for the main data router thread.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include <math.h>
+
+#include "reader.h"
+
+static swi_mangoh_data_router_db_t* ReaderDb;
+
+static le_result_t swi_mangoh_data_router_reader_readData(
+    const char*,
+    dataRouter_DataType_t,
+    swi_mangoh_data_router_data_t*);
+static void* swi_mangoh_data_router_reader_threadMain(void*);
+
+static le_result_t swi_mangoh_data_router_reader_readData
+(
+    const char* key,
+    dataRouter_DataType_t type,
+    swi_mangoh_data_router_data_t* data
+)
+{
+    le_result_t res = LE_OK;
+
+    const swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_lookupDataItem(ReaderDb, key);
+    if (!dbItem)
+    {
+        LE_WARN("key('%s') not found", key);
+        res = LE_NOT_FOUND;
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_db_readData(dbItem, data);
+    if (data->type != type)
+    {
+        LE_WARN("key('%s') type(%d) not type(%d)", key, data->type, type);
+        res = LE_FORMAT_ERROR;
+        goto cleanup;
+    }
+
+cleanup:
+    return res;
+}
+
+static void* swi_mangoh_data_router_reader_threadMain
+(
+    void* context
+)
+{
+    LE_INFO("Data router reader started");
+    dataRouterReader_AdvertiseService();
+    le_event_RunLoop();
+    return NULL;
+}
+
+le_result_t dataRouterReader_ReadBoolean
+(
+    const char* key,
+    bool* valuePtr,
+    uint32_t* timestampPtr
+)
+{
+    swi_mangoh_data_router_data_t data;
+    le_result_t res = swi_mangoh_data_router_reader_readData(key, DATAROUTER_BOOLEAN, &data);
+    if (res == LE_OK)
+    {
+        *valuePtr     = data.bValue;
+        *timestampPtr = data.timestamp;
+        LE_DEBUG("key(%s) = value(%u), timestamp(%u)", key, *valuePtr, *timestampPtr);
+    }
+
+    return res;
+}
+
+le_result_t dataRouterReader_ReadInteger
+(
+    const char* key,
+    int32_t* valuePtr,
+    uint32_t* timestampPtr
+)
+{
+    swi_mangoh_data_router_data_t data;
+    le_result_t res = swi_mangoh_data_router_reader_readData(key, DATAROUTER_INTEGER, &data);
+    if (res == LE_OK)
+    {
+        *valuePtr     = data.iValue;
+        *timestampPtr = data.timestamp;
+        LE_DEBUG("key(%s) = value(%d), timestamp(%u)", key, *valuePtr, *timestampPtr);
+    }
+
+    return res;
+}
+
+le_result_t dataRouterReader_ReadFloat
+(
+    const char* key,
+    double* valuePtr,
+    uint32_t* timestampPtr
+)
+{
+    swi_mangoh_data_router_data_t data;
+    le_result_t res = swi_mangoh_data_router_reader_readData(key, DATAROUTER_FLOAT, &data);
+    if (res == LE_OK)
+    {
+        *valuePtr     = data.fValue;
+        *timestampPtr = data.timestamp;
+        LE_DEBUG("key(%s) = value(%f), timestamp(%u)", key, *valuePtr, *timestampPtr);
+    }
+
+    return res;
+}
+
+le_result_t dataRouterReader_ReadString
+(
+    const char* key,
+    char* valuePtr,
+    size_t numValues,
+    uint32_t* timestampPtr
+)
+{
+    swi_mangoh_data_router_data_t data;
+    le_result_t res = swi_mangoh_data_router_reader_readData(key, DATAROUTER_STRING, &data);
+    if (res == LE_OK)
+    {
+        memset(valuePtr, 0, numValues);
+        strncpy(valuePtr, data.sValue, numValues - 1);
+        *timestampPtr = data.timestamp;
+        LE_DEBUG("key(%s) = value('%s'), timestamp(%u)", key, valuePtr, *timestampPtr);
+    }
+
+    return res;
+}
+
+le_result_t dataRouterReader_MultiGet
+(
+    const uint32_t* handlePtr,
+    size_t handleSize,
+    double* valuePtr,
+    size_t* valueSizePtr,
+    uint32_t* timestampPtr,
+    size_t* timestampSizePtr
+)
+{
+    le_result_t res = LE_OK;
+    size_t numValues = handleSize;
+
+    if (numValues > *valueSizePtr)
+    {
+        numValues = *valueSizePtr;
+    }
+
+    if (numValues > *timestampSizePtr)
+    {
+        numValues = *timestampSizePtr;
+    }
+
+    for (size_t i = 0; i < numValues; i++)
+    {
+        swi_mangoh_data_router_data_t data;
+        const swi_mangoh_data_router_dbItem_t* dbItem =
+            swi_mangoh_data_router_db_lookupDataItemByHandle(ReaderDb, handlePtr[i]);
+
+        valuePtr[i]     = NAN;
+        timestampPtr[i] = 0;
+        if (!dbItem)
+        {
+            res = LE_NOT_FOUND;
+            continue;
+        }
+
+        swi_mangoh_data_router_db_readData(dbItem, &data);
+        switch (data.type)
+        {
+            case DATAROUTER_BOOLEAN:
+                valuePtr[i] = data.bValue;
+                break;
+
+            case DATAROUTER_INTEGER:
+                valuePtr[i] = data.iValue;
+                break;
+
+            case DATAROUTER_FLOAT:
+                valuePtr[i] = data.fValue;
+                break;
+
+            default:
+                res = LE_NOT_FOUND;
+                continue;
+        }
+
+        timestampPtr[i] = data.timestamp;
+    }
+
+    *valueSizePtr     = numValues;
+    *timestampSizePtr = numValues;
+    LE_DEBUG("handles(%zu) res(%d)", numValues, res);
+
+    return res;
+}
+
+void swi_mangoh_data_router_reader_start
+(
+    swi_mangoh_data_router_db_t* db
+)
+{
+    LE_ASSERT(db);
+
+    ReaderDb = db;
+    le_thread_Start(le_thread_Create(
+        SWI_MANGOH_DATA_ROUTER_READER_THREAD_NAME, swi_mangoh_data_router_reader_threadMain, NULL));
+}
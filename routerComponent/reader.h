@@ -0,0 +1,24 @@
+/*
+ * @file reader.h
+ *
+ * Data router module.
+ *
+ * This module serves the concurrent read API of the mangOH data router from a dedicated thread.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_READER_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_READER_INCLUDE_GUARD
+
+#define SWI_MANGOH_DATA_ROUTER_READER_THREAD_NAME "DataRouterReader"
+
+void swi_mangoh_data_router_reader_start(swi_mangoh_data_router_db_t*);
+
+#endif
@@ -14,17 +14,56 @@
 // Used to provide the session reference to match against when removing from the list of update
 // handlers.
 static le_msg_SessionRef_t ComparisonClientSessionRef;
+static swi_mangoh_data_router_flowControlHandler_t* ComparisonFlowHandler;
 static swi_mangoh_data_router_t dataRouter;
 
 static bool IsUpdateHandlerForSession(le_sls_Link_t* link);
 static void FreeDataUpdateHandlerListNode(le_sls_Link_t* link);
 static void swi_mangoh_data_router_SigTermEventHandler(int);
 static le_result_t swi_mangoh_data_router_getClientPidAndAppName(pid_t*, char[], size_t);
+static void swi_mangoh_data_router_addTransport(
+    const char*,
+    const swi_mangoh_data_router_transportOps_t*,
+    void*);
 static void swi_mangoh_data_router_selectAvProtocol(const char*);
-static void pushItemIfRequired(
+static le_result_t pushItemIfRequired(
     swi_mangoh_data_router_session_t* session,
     const char* key,
-    const swi_mangoh_data_router_dbItem_t* dbItem);
+    swi_mangoh_data_router_dbItem_t* dbItem);
+static void pushSamplesIfRequired(
+    swi_mangoh_data_router_session_t* session,
+    const char* key,
+    swi_mangoh_data_router_dbItem_t* dbItem,
+    const double* values,
+    const uint32_t* timestamps,
+    size_t numSamples);
+static swi_mangoh_data_router_session_t* swi_mangoh_data_router_getClientSession(void);
+static void swi_mangoh_data_router_syncItem(const swi_mangoh_data_router_dbItem_t*, void*);
+static void swi_mangoh_data_router_pushAggregate(
+    const swi_mangoh_data_router_dbItem_t*,
+    const swi_mangoh_data_router_aggregate_t*);
+static swi_mangoh_data_router_dbItem_t* swi_mangoh_data_router_getHandleItem(uint32_t);
+static swi_mangoh_data_router_dataUpdateHandler_t* swi_mangoh_data_router_addUpdateHandler(
+    swi_mangoh_data_router_dbItem_t*,
+    le_msg_SessionRef_t,
+    dataRouter_DataUpdateHandlerFunc_t,
+    dataRouter_HandleUpdateHandlerFunc_t,
+    const swi_mangoh_data_router_filter_t*,
+    void*);
+static void swi_mangoh_data_router_removeUpdateHandler(
+    swi_mangoh_data_router_dataUpdateHandler_t*,
+    le_msg_SessionRef_t);
+static le_result_t swi_mangoh_data_router_storeData(
+    swi_mangoh_data_router_session_t*,
+    const char*,
+    swi_mangoh_data_router_dbItem_t*,
+    const swi_mangoh_data_router_data_t*);
+static void swi_mangoh_data_router_runRuleAction(void*, const swi_mangoh_data_router_ruleAction_t*);
+static le_result_t swi_mangoh_data_router_tryWrite(
+    const char*,
+    const swi_mangoh_data_router_data_t*);
+static uint32_t swi_mangoh_data_router_getUpstreamFill(void);
+static void swi_mangoh_data_router_notifyFlowControl(bool);
 
 
 static bool IsUpdateHandlerForSession
@@ -47,14 +86,51 @@ static void FreeDataUpdateHandlerListNode
     free(node);
 }
 
+static bool IsFlowHandlerForSession
+(
+    le_sls_Link_t* link
+)
+{
+    swi_mangoh_data_router_flowControlHandler_t* node =
+        CONTAINER_OF(link, swi_mangoh_data_router_flowControlHandler_t, next);
+    return node->clientSessionRef == ComparisonClientSessionRef;
+}
+
+static bool IsFlowHandler
+(
+    le_sls_Link_t* link
+)
+{
+    swi_mangoh_data_router_flowControlHandler_t* node =
+        CONTAINER_OF(link, swi_mangoh_data_router_flowControlHandler_t, next);
+    return (node == ComparisonFlowHandler) &&
+           (node->clientSessionRef == ComparisonClientSessionRef);
+}
+
+static void FreeFlowHandlerListNode
+(
+    le_sls_Link_t* link
+)
+{
+    swi_mangoh_data_router_flowControlHandler_t* node =
+        CONTAINER_OF(link, swi_mangoh_data_router_flowControlHandler_t, next);
+    free(node);
+}
+
 static void swi_mangoh_data_router_SigTermEventHandler
 (
     int sigNum
 )
 {
+    for (uint32_t i = 0; i < dataRouter.numTransports; i++)
+    {
+        dataRouter.transports[i].ops->flush(dataRouter.transports[i].context);
+    }
+
     LE_INFO("Data router persistence started");
-    swi_mangoh_data_router_db_destroy(&dataRouter.db);
+    swi_mangoh_data_router_persist_flush(&dataRouter.persist);
     LE_INFO("Data router persistence completed");
+    exit(EXIT_SUCCESS);
 }
 
 static le_result_t swi_mangoh_data_router_getSessionPidAndAppName
@@ -100,6 +176,39 @@ static le_result_t swi_mangoh_data_router_getClientPidAndAppName
         dataRouter_GetClientSessionRef(), pid, appName, len);
 }
 
+static void swi_mangoh_data_router_addTransport
+(
+    const char* name,
+    const swi_mangoh_data_router_transportOps_t* ops,
+    void* context
+)
+{
+    for (uint32_t i = 0; i < dataRouter.numTransports; i++)
+    {
+        if (dataRouter.transports[i].context == context)
+        {
+            LE_WARN("AV protocol('%s') already selected", name);
+            goto cleanup;
+        }
+    }
+
+    if (dataRouter.numTransports == SWI_MANGOH_DATA_ROUTER_TRANSPORTS_MAX_NUM)
+    {
+        LE_ERROR("ERROR too many AV protocols, '%s' ignored", name);
+        goto cleanup;
+    }
+
+    LE_DEBUG("AV protocol %s", name);
+    dataRouter.transports[dataRouter.numTransports].name = name;
+    dataRouter.transports[dataRouter.numTransports].ops = ops;
+    dataRouter.transports[dataRouter.numTransports].context = context;
+    dataRouter.numTransports++;
+
+cleanup:
+    return;
+}
+
+// Called for each protocol argument, the updates are pushed to all the selected protocols
 static void swi_mangoh_data_router_selectAvProtocol
 (
     const char* value
@@ -108,10 +217,43 @@ static void swi_mangoh_data_router_selectAvProtocol
     LE_ASSERT(value);
     LE_DEBUG("AV protocol value('%s')", value);
 
+    if (!dataRouter.transportsSelected)
+    {
+        dataRouter.transportsSelected = true;
+        dataRouter.numTransports = 0;
+    }
+
     if (!strcmp(value, SWI_MANGOH_DATA_ROUTER_MQTT_APP_NAME))
     {
-        LE_DEBUG("AV protocol MQTT");
-        dataRouter.protocolType = SWI_MANGOH_DATA_ROUTER_AV_PROTOCOL_MQTT;
+        swi_mangoh_data_router_addTransport(
+            SWI_MANGOH_DATA_ROUTER_MQTT_APP_NAME,
+            &swi_mangoh_data_router_mqttTransportOps,
+            &dataRouter.mqtt);
+    }
+    else if (!strcmp(value, SWI_MANGOH_DATA_ROUTER_SINK_FILE_NAME))
+    {
+        swi_mangoh_data_router_addTransport(
+            SWI_MANGOH_DATA_ROUTER_SINK_FILE_NAME,
+            &swi_mangoh_data_router_sinkTransportOps,
+            &dataRouter.fileSink);
+    }
+    else if (!strcmp(value, SWI_MANGOH_DATA_ROUTER_SINK_SOCKET_NAME))
+    {
+        swi_mangoh_data_router_addTransport(
+            SWI_MANGOH_DATA_ROUTER_SINK_SOCKET_NAME,
+            &swi_mangoh_data_router_sinkTransportOps,
+            &dataRouter.socketSink);
+    }
+    else if (!strcmp(value, SWI_MANGOH_DATA_ROUTER_AVDATA_NAME))
+    {
+        swi_mangoh_data_router_addTransport(
+            SWI_MANGOH_DATA_ROUTER_AVDATA_NAME,
+            &swi_mangoh_data_router_avdataTransportOps,
+            &dataRouter.avdata);
+    }
+    else
+    {
+        LE_WARN("unsupported AV protocol('%s')", value);
     }
 }
 
@@ -124,6 +266,9 @@ void swi_mangoh_data_router_notifySubscribers
     LE_ASSERT(key);
     LE_ASSERT(dbItem);
 
+    swi_mangoh_data_router_derive_update(&dataRouter.derive, dbItem);
+    swi_mangoh_data_router_rules_update(&dataRouter.rules, dbItem);
+
     le_msg_SessionRef_t clientSession = dataRouter_GetClientSessionRef();
     for (le_sls_Link_t* nodePtr = le_sls_Peek(&dbItem->handlers);
          nodePtr;
@@ -132,12 +277,27 @@ void swi_mangoh_data_router_notifySubscribers
         swi_mangoh_data_router_dataUpdateHandler_t* handlerData =
             CONTAINER_OF(nodePtr, swi_mangoh_data_router_dataUpdateHandler_t, next);
 
+        // The filter tracks every update, including those of the subscriber session
+        if (handlerData->filter.enabled &&
+            !swi_mangoh_data_router_filter_match(&handlerData->filter, &dbItem->data))
+        {
+            continue;
+        }
+
         // notify all other clients
         if (handlerData->clientSessionRef != clientSession)
         {
             LE_DEBUG("Calling update handler for key (%s) on client (%p)", key, clientSession);
-            LE_ASSERT(handlerData->handler);
-            handlerData->handler(dbItem->data.type, key, handlerData->context);
+            if (handlerData->handleHandler)
+            {
+                handlerData->handleHandler(
+                    dbItem->data.type, dbItem->handle, handlerData->context);
+            }
+            else
+            {
+                LE_ASSERT(handlerData->handler);
+                handlerData->handler(dbItem->data.type, key, handlerData->context);
+            }
         }
     }
 }
@@ -179,22 +339,17 @@ void dataRouter_SessionStart
 
         session->pushAv = pushAv;
         session->storageType = storage;
+        swi_mangoh_data_router_limit_init(&session->limit, appName);
 
-        if (session->pushAv)
+        for (uint32_t i = 0; session->pushAv && (i < dataRouter.numTransports); i++)
         {
-            switch (dataRouter.protocolType)
-            {
-                case SWI_MANGOH_DATA_ROUTER_AV_PROTOCOL_MQTT:
-                    swi_mangoh_data_router_mqttSessionStart(
-                        appName, urlAsset, password, &session->mqtt, &dataRouter.db);
-                    break;
-
-                case SWI_MANGOH_DATA_ROUTER_AV_PROTOCOL_NONE:
-                    break;
+            const swi_mangoh_data_router_transport_t* transport = &dataRouter.transports[i];
 
-                default:
-                    LE_WARN("unsupported protocol(%u)", dataRouter.protocolType);
-                    break;
+            session->clients[i] = transport->ops->start(
+                transport->context, appName, urlAsset, password, &dataRouter.db);
+            if (!session->clients[i])
+            {
+                LE_ERROR("ERROR AV protocol('%s') start failed", transport->name);
             }
         }
 
@@ -250,47 +405,23 @@ static void swi_mangoh_data_router_cleanupSession
     swi_mangoh_data_router_session_t* session = le_hashmap_Get(dataRouter.sessions, clientSession);
     if (session)
     {
-        if (session->pushAv)
+        for (uint32_t i = 0; i < dataRouter.numTransports; i++)
         {
-            switch (dataRouter.protocolType)
+            if (session->clients[i])
             {
-                case SWI_MANGOH_DATA_ROUTER_AV_PROTOCOL_MQTT:
-                    if (swi_mangoh_data_router_mqttSessionEnd(&session->mqtt))
-                    {
-                        if (!le_hashmap_Remove(dataRouter.sessions, clientSession))
-                        {
-                            LE_ERROR("ERROR le_hashmap_Remove() failed");
-                            free(session);
-                            goto cleanup;
-                        }
-
-                        free(session);
-                    }
-                    else
-                    {
-                        // TODO: it seems like the session will never be removed from the hashmap
-                        // in this case.  This is a memory leak.
-                    }
-                    break;
-
-
-                case SWI_MANGOH_DATA_ROUTER_AV_PROTOCOL_NONE:
-                    break;
-
-                default:
-                    LE_WARN("unsupported protocol(%u)", dataRouter.protocolType);
-                    break;
+                dataRouter.transports[i].ops->end(session->clients[i]);
             }
         }
-        else
+
+        swi_mangoh_data_router_limit_log(&session->limit);
+        swi_mangoh_data_router_rules_removeOwner(&dataRouter.rules, clientSession);
+        swi_mangoh_data_router_derive_removeOwner(&dataRouter.derive, clientSession);
+        if (!le_hashmap_Remove(dataRouter.sessions, clientSession))
         {
-            if (!le_hashmap_Remove(dataRouter.sessions, clientSession))
-            {
-                LE_ERROR("ERROR le_hashmap_Remove() failed");
-                free(session);
-                goto cleanup;
-            }
+            LE_ERROR("ERROR le_hashmap_Remove() failed");
         }
+
+        free(session);
     }
     else
     {
@@ -300,9 +431,8 @@ static void swi_mangoh_data_router_cleanupSession
     // Make sure that all of the update handlers are removed
     swi_mangoh_data_router_removeAllUpdateHandlersForSession(&dataRouter.db, clientSession);
 
-cleanup:
-
-    return;
+    ComparisonClientSessionRef = clientSession;
+    ListFilter(&dataRouter.flowHandlers, &IsFlowHandlerForSession, &FreeFlowHandlerListNode);
 }
 
 static void swi_mangoh_data_router_onSessionClosed
@@ -331,27 +461,11 @@ void dataRouter_WriteBoolean
     uint32_t timestamp
 )
 {
-    le_msg_SessionRef_t clientSession = dataRouter_GetClientSessionRef();
-    pid_t pid;
-    char appName[SWI_MANGOH_DATA_ROUTER_APP_NAME_LEN];
-    if (swi_mangoh_data_router_getSessionPidAndAppName(
-            clientSession, &pid, appName, sizeof(appName)) != LE_OK)
-    {
-        LE_ERROR("Failed to get client information");
-        goto cleanup;
-    }
-    LE_DEBUG("lookup session('%p')", clientSession);
-    swi_mangoh_data_router_session_t* session = le_hashmap_Get(dataRouter.sessions, clientSession);
-    if (session)
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_WRITE))
     {
-        LE_DEBUG(
-            "app(%s)/pid(%u)/session(%p) --> key(%s) = value(%d), timestamp(%u)",
-            appName,
-            pid,
-            clientSession,
-            key,
-            value,
-            timestamp);
+        LE_DEBUG("--> key(%s) = value(%d), timestamp(%u)", key, value, timestamp);
 
         swi_mangoh_data_router_dbItem_t* dbItem =
             swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
@@ -365,24 +479,17 @@ void dataRouter_WriteBoolean
             }
         }
 
+        swi_mangoh_data_router_db_beginUpdate(dbItem);
         swi_mangoh_data_router_db_setStorageType(dbItem, session->storageType);
         swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_BOOLEAN);
         swi_mangoh_data_router_db_setBooleanValue(dbItem, value);
         swi_mangoh_data_router_db_setTimestamp(dbItem, timestamp);
+        swi_mangoh_data_router_db_endUpdate(&dataRouter.db, dbItem);
 
         pushItemIfRequired(session, key, dbItem);
 
         swi_mangoh_data_router_notifySubscribers(key, dbItem);
     }
-    else
-    {
-        LE_ERROR(
-            "Session not found for app(%s)/pid(%u)/session(%p).  Call SessionStart() to create a "
-            "session.",
-            appName,
-            pid,
-            clientSession);
-    }
 
 cleanup:
     return;
@@ -395,27 +502,11 @@ void dataRouter_WriteInteger
     uint32_t timestamp
 )
 {
-    le_msg_SessionRef_t clientSession = dataRouter_GetClientSessionRef();
-    pid_t pid;
-    char appName[SWI_MANGOH_DATA_ROUTER_APP_NAME_LEN];
-    if (swi_mangoh_data_router_getSessionPidAndAppName(
-            clientSession, &pid, appName, sizeof(appName)) != LE_OK)
-    {
-        LE_ERROR("Failed to get client information");
-        goto cleanup;
-    }
-    LE_DEBUG("lookup session('%p')", clientSession);
-    swi_mangoh_data_router_session_t* session = le_hashmap_Get(dataRouter.sessions, clientSession);
-    if (session)
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_WRITE))
     {
-        LE_DEBUG(
-            "app(%s)/pid(%u)/session(%p) --> key(%s) = value(%d), timestamp(%u)",
-            appName,
-            pid,
-            clientSession,
-            key,
-            value,
-            timestamp);
+        LE_DEBUG("--> key(%s) = value(%d), timestamp(%u)", key, value, timestamp);
 
         swi_mangoh_data_router_dbItem_t* dbItem =
             swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
@@ -429,24 +520,17 @@ void dataRouter_WriteInteger
             }
         }
 
+        swi_mangoh_data_router_db_beginUpdate(dbItem);
         swi_mangoh_data_router_db_setStorageType(dbItem, session->storageType);
         swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_INTEGER);
         swi_mangoh_data_router_db_setIntegerValue(dbItem, value);
         swi_mangoh_data_router_db_setTimestamp(dbItem, timestamp);
+        swi_mangoh_data_router_db_endUpdate(&dataRouter.db, dbItem);
 
         pushItemIfRequired(session, key, dbItem);
 
         swi_mangoh_data_router_notifySubscribers(key, dbItem);
     }
-    else
-    {
-        LE_ERROR(
-            "Session not found for app(%s)/pid(%u)/session(%p).  Call SessionStart() to create a "
-            "session.",
-            appName,
-            pid,
-            clientSession);
-    }
 
 cleanup:
     return;
@@ -459,27 +543,11 @@ void dataRouter_WriteFloat
     uint32_t timestamp
 )
 {
-    le_msg_SessionRef_t clientSession = dataRouter_GetClientSessionRef();
-    pid_t pid;
-    char appName[SWI_MANGOH_DATA_ROUTER_APP_NAME_LEN];
-    if (swi_mangoh_data_router_getSessionPidAndAppName(
-            clientSession, &pid, appName, sizeof(appName)) != LE_OK)
-    {
-        LE_ERROR("Failed to get client information");
-        goto cleanup;
-    }
-    LE_DEBUG("lookup session('%p')", clientSession);
-    swi_mangoh_data_router_session_t* session = le_hashmap_Get(dataRouter.sessions, clientSession);
-    if (session)
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_WRITE))
     {
-        LE_DEBUG(
-            "app(%s)/pid(%u)/session(%p) --> key(%s) = value(%f), timestamp(%u)",
-            appName,
-            pid,
-            clientSession,
-            key,
-            value,
-            timestamp);
+        LE_DEBUG("--> key(%s) = value(%f), timestamp(%u)", key, value, timestamp);
 
         swi_mangoh_data_router_dbItem_t* dbItem =
             swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
@@ -493,24 +561,18 @@ void dataRouter_WriteFloat
             }
         }
 
+        swi_mangoh_data_router_db_beginUpdate(dbItem);
         swi_mangoh_data_router_db_setStorageType(dbItem, session->storageType);
         swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_FLOAT);
         swi_mangoh_data_router_db_setFloatValue(dbItem, value);
         swi_mangoh_data_router_db_setTimestamp(dbItem, timestamp);
+        swi_mangoh_data_router_db_endUpdate(&dataRouter.db, dbItem);
+        swi_mangoh_data_router_db_appendHistory(dbItem, &value, &timestamp, 1);
 
         pushItemIfRequired(session, key, dbItem);
 
         swi_mangoh_data_router_notifySubscribers(key, dbItem);
     }
-    else
-    {
-        LE_ERROR(
-            "Session not found for app(%s)/pid(%u)/session(%p).  Call SessionStart() to create a "
-            "session.",
-            appName,
-            pid,
-            clientSession);
-    }
 
 cleanup:
     return;
@@ -523,27 +585,11 @@ void dataRouter_WriteString
     uint32_t timestamp
 )
 {
-    le_msg_SessionRef_t clientSession = dataRouter_GetClientSessionRef();
-    pid_t pid;
-    char appName[SWI_MANGOH_DATA_ROUTER_APP_NAME_LEN];
-    if (swi_mangoh_data_router_getSessionPidAndAppName(
-            clientSession, &pid, appName, sizeof(appName)) != LE_OK)
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_WRITE))
     {
-        LE_ERROR("Failed to get client information");
-        goto cleanup;
-    }
-    LE_DEBUG("lookup session('%p')", clientSession);
-    swi_mangoh_data_router_session_t* session = le_hashmap_Get(dataRouter.sessions, clientSession);
-    if (session)
-    {
-        LE_DEBUG(
-            "app(%s)/pid(%u)/session(%p) --> key(%s) = value('%s'), timestamp(%u)",
-            appName,
-            pid,
-            clientSession,
-            key,
-            value,
-            timestamp);
+        LE_DEBUG("--> key(%s) = value('%s'), timestamp(%u)", key, value, timestamp);
 
         swi_mangoh_data_router_dbItem_t* dbItem =
             swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
@@ -557,235 +603,1463 @@ void dataRouter_WriteString
             }
         }
 
+        swi_mangoh_data_router_db_beginUpdate(dbItem);
         swi_mangoh_data_router_db_setStorageType(dbItem, session->storageType);
         swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_STRING);
         swi_mangoh_data_router_db_setStringValue(dbItem, value);
         swi_mangoh_data_router_db_setTimestamp(dbItem, timestamp);
+        swi_mangoh_data_router_db_endUpdate(&dataRouter.db, dbItem);
 
         pushItemIfRequired(session, key, dbItem);
 
         swi_mangoh_data_router_notifySubscribers(key, dbItem);
     }
-    else
-    {
-        LE_ERROR(
-            "Session not found for app(%s)/pid(%u)/session(%p).  Call SessionStart() to create a "
-            "session.",
-            appName,
-            pid,
-            clientSession);
-    }
 
 cleanup:
     return;
 }
 
-void dataRouter_ReadBoolean
+void dataRouter_WriteFloatArray
 (
     const char* key,
-    bool* valuePtr,
-    uint32_t* timestampPtr
+    const double* valuePtr,
+    size_t valueSize,
+    uint32_t timestamp
 )
 {
-    le_msg_SessionRef_t clientSession = dataRouter_GetClientSessionRef();
-    pid_t pid;
-    char appName[SWI_MANGOH_DATA_ROUTER_APP_NAME_LEN];
-    if (swi_mangoh_data_router_getSessionPidAndAppName(
-            clientSession, &pid, appName, sizeof(appName)) != LE_OK)
-    {
-        LE_ERROR("Failed to get client information");
-        goto cleanup;
-    }
-    LE_DEBUG("lookup session('%p')", clientSession);
-    swi_mangoh_data_router_session_t* session = le_hashmap_Get(dataRouter.sessions, clientSession);
-    if (session)
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_WRITE))
     {
+        LE_DEBUG("--> key(%s) = count(%zu), timestamp(%u)", key, valueSize, timestamp);
+
         swi_mangoh_data_router_dbItem_t* dbItem =
             swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
-        if (dbItem)
+        if (!dbItem)
         {
-            if (dbItem->data.type == DATAROUTER_BOOLEAN)
-            {
-                *valuePtr     = dbItem->data.bValue;
-                *timestampPtr = dbItem->data.timestamp;
-                LE_DEBUG(
-                    "app(%s)/pid(%u)/session(%p) <-- key(%s) = value(%u), timestamp(%u)",
-                    appName,
-                    pid,
-                    clientSession,
-                    key,
-                    *valuePtr,
-                    *timestampPtr);
-            }
-            else
+            dbItem = swi_mangoh_data_router_db_createDataItem(&dataRouter.db, key);
+            if (!dbItem)
             {
-                LE_WARN("key('%s') not BOOLEAN type", key);
+                LE_ERROR("ERROR swi_mangoh_data_router_db_getDataItem() failed");
+                goto cleanup;
             }
         }
-        else
-        {
-            LE_WARN("key('%s') not found", key);
-        }
-    }
-    else
-    {
-        LE_ERROR(
-            "Session not found for app(%s)/pid(%u)/session(%p).  Call SessionStart() to create a "
-            "session.",
-            appName,
-            pid,
-            clientSession);
+
+        swi_mangoh_data_router_db_beginUpdate(dbItem);
+        swi_mangoh_data_router_db_setStorageType(dbItem, session->storageType);
+        swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_FLOAT_ARRAY);
+        swi_mangoh_data_router_db_setFloatArrayValue(dbItem, valuePtr, valueSize);
+        swi_mangoh_data_router_db_setTimestamp(dbItem, timestamp);
+        swi_mangoh_data_router_db_endUpdate(&dataRouter.db, dbItem);
+
+        pushItemIfRequired(session, key, dbItem);
+
+        swi_mangoh_data_router_notifySubscribers(key, dbItem);
     }
 
 cleanup:
     return;
 }
 
-void dataRouter_ReadInteger
+void dataRouter_WriteIntegerArray
 (
     const char* key,
-    int32_t* valuePtr,
-    uint32_t* timestampPtr
+    const int32_t* valuePtr,
+    size_t valueSize,
+    uint32_t timestamp
 )
 {
-    le_msg_SessionRef_t clientSession = dataRouter_GetClientSessionRef();
-    pid_t pid;
-    char appName[SWI_MANGOH_DATA_ROUTER_APP_NAME_LEN];
-    if (swi_mangoh_data_router_getSessionPidAndAppName(
-            clientSession, &pid, appName, sizeof(appName)) != LE_OK)
-    {
-        LE_ERROR("Failed to get client information");
-        goto cleanup;
-    }
-    LE_DEBUG("lookup session('%p')", clientSession);
-    swi_mangoh_data_router_session_t* session = le_hashmap_Get(dataRouter.sessions, clientSession);
-    if (session)
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_WRITE))
     {
+        LE_DEBUG("--> key(%s) = count(%zu), timestamp(%u)", key, valueSize, timestamp);
+
         swi_mangoh_data_router_dbItem_t* dbItem =
             swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
-        if (dbItem)
+        if (!dbItem)
         {
-            if (dbItem->data.type == DATAROUTER_INTEGER)
-            {
-                *valuePtr     = dbItem->data.iValue;
-                *timestampPtr = dbItem->data.timestamp;
-                LE_DEBUG(
-                    "app(%s)/pid(%u)/session(%p) <-- key(%s) = value(%d), timestamp(%u)",
-                    appName,
-                    pid,
-                    clientSession,
-                    key,
-                    *valuePtr,
-                    *timestampPtr);
-            }
-            else
+            dbItem = swi_mangoh_data_router_db_createDataItem(&dataRouter.db, key);
+            if (!dbItem)
             {
-                LE_WARN("key('%s') not INTEGER type", key);
+                LE_ERROR("ERROR swi_mangoh_data_router_db_getDataItem() failed");
+                goto cleanup;
             }
         }
-        else
-        {
-            LE_WARN("key('%s') not found", key);
-        }
-    }
-    else
-    {
-        LE_ERROR(
-            "Session not found for app(%s)/pid(%u)/session(%p).  Call SessionStart() to create a "
-            "session.",
-            appName,
-            pid,
-            clientSession);
-    }
 
-cleanup:
-    return;
+        swi_mangoh_data_router_db_beginUpdate(dbItem);
+        swi_mangoh_data_router_db_setStorageType(dbItem, session->storageType);
+        swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_INTEGER_ARRAY);
+        swi_mangoh_data_router_db_setIntegerArrayValue(dbItem, valuePtr, valueSize);
+        swi_mangoh_data_router_db_setTimestamp(dbItem, timestamp);
+        swi_mangoh_data_router_db_endUpdate(&dataRouter.db, dbItem);
+
+        pushItemIfRequired(session, key, dbItem);
+
+        swi_mangoh_data_router_notifySubscribers(key, dbItem);
+    }
+
+cleanup:
+    return;
+}
+
+void dataRouter_WriteFloatSamples
+(
+    const char* key,
+    const double* valuePtr,
+    size_t valueSize,
+    const uint32_t* timestampPtr,
+    size_t timestampSize
+)
+{
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_WRITE))
+    {
+        if (!valueSize || (valueSize != timestampSize))
+        {
+            LE_ERROR(
+                "ERROR key('%s') samples(%zu) timestamps(%zu) mismatch",
+                key,
+                valueSize,
+                timestampSize);
+            goto cleanup;
+        }
+
+        LE_DEBUG(
+            "--> key(%s) = samples(%zu), timestamps(%u..%u)",
+            key,
+            valueSize,
+            timestampPtr[0],
+            timestampPtr[valueSize - 1]);
+
+        swi_mangoh_data_router_dbItem_t* dbItem =
+            swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+        if (!dbItem)
+        {
+            dbItem = swi_mangoh_data_router_db_createDataItem(&dataRouter.db, key);
+            if (!dbItem)
+            {
+                LE_ERROR("ERROR swi_mangoh_data_router_db_getDataItem() failed");
+                goto cleanup;
+            }
+        }
+
+        // The last sample of the block becomes the current value
+        swi_mangoh_data_router_db_beginUpdate(dbItem);
+        swi_mangoh_data_router_db_setStorageType(dbItem, session->storageType);
+        swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_FLOAT);
+        swi_mangoh_data_router_db_setFloatValue(dbItem, valuePtr[valueSize - 1]);
+        swi_mangoh_data_router_db_setTimestamp(dbItem, timestampPtr[valueSize - 1]);
+        swi_mangoh_data_router_db_endUpdate(&dataRouter.db, dbItem);
+        swi_mangoh_data_router_db_appendHistory(dbItem, valuePtr, timestampPtr, valueSize);
+
+        pushSamplesIfRequired(session, key, dbItem, valuePtr, timestampPtr, valueSize);
+
+        swi_mangoh_data_router_notifySubscribers(key, dbItem);
+    }
+
+cleanup:
+    return;
+}
+
+le_result_t dataRouter_TryWriteBoolean
+(
+    const char* key,
+    bool value,
+    uint32_t timestamp
+)
+{
+    swi_mangoh_data_router_data_t data = {0};
+
+    data.type = DATAROUTER_BOOLEAN;
+    data.bValue = value;
+    data.timestamp = timestamp;
+    return swi_mangoh_data_router_tryWrite(key, &data);
+}
+
+le_result_t dataRouter_TryWriteInteger
+(
+    const char* key,
+    int32_t value,
+    uint32_t timestamp
+)
+{
+    swi_mangoh_data_router_data_t data = {0};
+
+    data.type = DATAROUTER_INTEGER;
+    data.iValue = value;
+    data.timestamp = timestamp;
+    return swi_mangoh_data_router_tryWrite(key, &data);
+}
+
+le_result_t dataRouter_TryWriteFloat
+(
+    const char* key,
+    double value,
+    uint32_t timestamp
+)
+{
+    swi_mangoh_data_router_data_t data = {0};
+
+    data.type = DATAROUTER_FLOAT;
+    data.fValue = value;
+    data.timestamp = timestamp;
+    return swi_mangoh_data_router_tryWrite(key, &data);
+}
+
+le_result_t dataRouter_TryWriteString
+(
+    const char* key,
+    const char* value,
+    uint32_t timestamp
+)
+{
+    swi_mangoh_data_router_data_t data = {0};
+
+    data.type = DATAROUTER_STRING;
+    strncpy(data.sValue, value, sizeof(data.sValue) - 1);
+    data.timestamp = timestamp;
+    return swi_mangoh_data_router_tryWrite(key, &data);
+}
+
+le_result_t dataRouter_EnableHistory
+(
+    const char* key,
+    uint32_t maxSamples
+)
+{
+    le_result_t res = LE_OK;
+
+    if (!swi_mangoh_data_router_getClientSession())
+    {
+        res = LE_NOT_PERMITTED;
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+    if (!dbItem)
+    {
+        dbItem = swi_mangoh_data_router_db_createDataItem(&dataRouter.db, key);
+        if (!dbItem)
+        {
+            LE_ERROR("ERROR swi_mangoh_data_router_db_createDataItem() failed");
+            res = LE_NO_MEMORY;
+            goto cleanup;
+        }
+    }
+
+    res = swi_mangoh_data_router_db_enableHistory(dbItem, maxSamples);
+
+cleanup:
+    return res;
+}
+
+le_result_t dataRouter_SetReportThreshold
+(
+    const char* key,
+    double threshold
+)
+{
+    le_result_t res = LE_OK;
+
+    if (!swi_mangoh_data_router_getClientSession())
+    {
+        res = LE_NOT_PERMITTED;
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+    if (!dbItem)
+    {
+        dbItem = swi_mangoh_data_router_db_createDataItem(&dataRouter.db, key);
+        if (!dbItem)
+        {
+            LE_ERROR("ERROR swi_mangoh_data_router_db_createDataItem() failed");
+            res = LE_NO_MEMORY;
+            goto cleanup;
+        }
+    }
+
+    res = swi_mangoh_data_router_db_setReportThreshold(dbItem, threshold);
+
+cleanup:
+    return res;
+}
+
+le_result_t dataRouter_SetAggregation
+(
+    const char* key,
+    uint32_t intervalSec,
+    bool variance
+)
+{
+    le_result_t res = LE_OK;
+
+    if (!swi_mangoh_data_router_getClientSession())
+    {
+        res = LE_NOT_PERMITTED;
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+    if (!dbItem)
+    {
+        dbItem = swi_mangoh_data_router_db_createDataItem(&dataRouter.db, key);
+        if (!dbItem)
+        {
+            LE_ERROR("ERROR swi_mangoh_data_router_db_createDataItem() failed");
+            res = LE_NO_MEMORY;
+            goto cleanup;
+        }
+    }
+
+    res = swi_mangoh_data_router_aggregate_set(
+        dbItem, intervalSec, variance, swi_mangoh_data_router_pushAggregate);
+
+cleanup:
+    return res;
+}
+
+le_result_t dataRouter_DefineDerivedKey
+(
+    const char* key,
+    const char* expression
+)
+{
+    le_result_t res = LE_OK;
+
+    if (!swi_mangoh_data_router_getClientSession())
+    {
+        res = LE_NOT_PERMITTED;
+        goto cleanup;
+    }
+
+    res = swi_mangoh_data_router_derive_define(
+        &dataRouter.derive, dataRouter_GetClientSessionRef(), key, expression);
+
+cleanup:
+    return res;
+}
+
+le_result_t dataRouter_RemoveDerivedKey
+(
+    const char* key
+)
+{
+    le_result_t res = LE_OK;
+
+    if (!swi_mangoh_data_router_getClientSession())
+    {
+        res = LE_NOT_PERMITTED;
+        goto cleanup;
+    }
+
+    res = swi_mangoh_data_router_derive_remove(
+        &dataRouter.derive, dataRouter_GetClientSessionRef(), key);
+
+cleanup:
+    return res;
+}
+
+le_result_t dataRouter_AddRule
+(
+    const char* name,
+    const char* condition,
+    const char* actions
+)
+{
+    le_result_t res = LE_OK;
+
+    if (!swi_mangoh_data_router_getClientSession())
+    {
+        res = LE_NOT_PERMITTED;
+        goto cleanup;
+    }
+
+    res = swi_mangoh_data_router_rules_add(
+        &dataRouter.rules, dataRouter_GetClientSessionRef(), name, condition, actions);
+
+cleanup:
+    return res;
+}
+
+le_result_t dataRouter_RemoveRule
+(
+    const char* name
+)
+{
+    le_result_t res = LE_OK;
+
+    if (!swi_mangoh_data_router_getClientSession())
+    {
+        res = LE_NOT_PERMITTED;
+        goto cleanup;
+    }
+
+    res = swi_mangoh_data_router_rules_remove(
+        &dataRouter.rules, dataRouter_GetClientSessionRef(), name);
+
+cleanup:
+    return res;
+}
+
+le_result_t dataRouter_SetPriority
+(
+    const char* pattern,
+    dataRouter_Priority_t priority
+)
+{
+    le_result_t res = LE_OK;
+
+    if (!swi_mangoh_data_router_getClientSession())
+    {
+        res = LE_NOT_PERMITTED;
+        goto cleanup;
+    }
+
+    res = swi_mangoh_data_router_priority_set(&dataRouter.priorities, pattern, priority);
+
+cleanup:
+    return res;
+}
+
+void dataRouter_ReadBoolean
+(
+    const char* key,
+    bool* valuePtr,
+    uint32_t* timestampPtr
+)
+{
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_READ))
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem =
+            swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+        if (dbItem)
+        {
+            if (dbItem->data.type == DATAROUTER_BOOLEAN)
+            {
+                *valuePtr     = dbItem->data.bValue;
+                *timestampPtr = dbItem->data.timestamp;
+                LE_DEBUG("<-- key(%s) = value(%u), timestamp(%u)", key, *valuePtr, *timestampPtr);
+            }
+            else
+            {
+                LE_WARN("key('%s') not BOOLEAN type", key);
+            }
+        }
+        else
+        {
+            LE_WARN("key('%s') not found", key);
+        }
+    }
+}
+
+void dataRouter_ReadInteger
+(
+    const char* key,
+    int32_t* valuePtr,
+    uint32_t* timestampPtr
+)
+{
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_READ))
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem =
+            swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+        if (dbItem)
+        {
+            if (dbItem->data.type == DATAROUTER_INTEGER)
+            {
+                *valuePtr     = dbItem->data.iValue;
+                *timestampPtr = dbItem->data.timestamp;
+                LE_DEBUG("<-- key(%s) = value(%d), timestamp(%u)", key, *valuePtr, *timestampPtr);
+            }
+            else
+            {
+                LE_WARN("key('%s') not INTEGER type", key);
+            }
+        }
+        else
+        {
+            LE_WARN("key('%s') not found", key);
+        }
+    }
+}
+
+void dataRouter_ReadFloat
+(
+    const char* key,
+    double* valuePtr,
+    uint32_t* timestampPtr
+)
+{
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_READ))
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem =
+            swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+        if (dbItem)
+        {
+            if (dbItem->data.type == DATAROUTER_FLOAT)
+            {
+                *valuePtr     = dbItem->data.fValue;
+                *timestampPtr = dbItem->data.timestamp;
+                LE_DEBUG("<-- key(%s) = value(%f), timestamp(%u)", key, *valuePtr, *timestampPtr);
+            }
+            else
+            {
+                LE_WARN("key('%s') not FLOAT type", key);
+            }
+        }
+        else
+        {
+            LE_WARN("key('%s') not found", key);
+        }
+    }
+}
+
+void dataRouter_ReadString
+(
+    const char* key,
+    char* valuePtr,
+    size_t numValues,
+    uint32_t* timestampPtr
+)
+{
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_READ))
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem =
+            swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+        if (dbItem)
+        {
+            if (dbItem->data.type == DATAROUTER_STRING)
+            {
+                memset(valuePtr, 0, numValues);
+                strncpy(valuePtr, dbItem->data.sValue, numValues - 1);
+                *timestampPtr = dbItem->data.timestamp;
+                LE_DEBUG("<-- key(%s) = value('%s'), timestamp(%u)", key, valuePtr, *timestampPtr);
+            }
+            else
+            {
+                LE_WARN("key('%s') not STRING type", key);
+            }
+        }
+        else
+        {
+            LE_WARN("key('%s') not found", key);
+        }
+    }
+}
+
+void dataRouter_ReadFloatArray
+(
+    const char* key,
+    double* valuePtr,
+    size_t* valueSizePtr,
+    uint32_t* timestampPtr
+)
+{
+    size_t maxValues = *valueSizePtr;
+
+    *valueSizePtr = 0;
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_READ))
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem =
+            swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+        if (dbItem)
+        {
+            if (dbItem->data.type == DATAROUTER_FLOAT_ARRAY)
+            {
+                *valueSizePtr = (dbItem->data.count < maxValues) ? dbItem->data.count : maxValues;
+                memcpy(valuePtr, dbItem->data.faValue, *valueSizePtr * sizeof(double));
+                *timestampPtr = dbItem->data.timestamp;
+                LE_DEBUG(
+                    "<-- key(%s) = count(%zu), timestamp(%u)", key, *valueSizePtr, *timestampPtr);
+            }
+            else
+            {
+                LE_WARN("key('%s') not FLOAT_ARRAY type", key);
+            }
+        }
+        else
+        {
+            LE_WARN("key('%s') not found", key);
+        }
+    }
+}
+
+void dataRouter_ReadIntegerArray
+(
+    const char* key,
+    int32_t* valuePtr,
+    size_t* valueSizePtr,
+    uint32_t* timestampPtr
+)
+{
+    size_t maxValues = *valueSizePtr;
+
+    *valueSizePtr = 0;
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_READ))
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem =
+            swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+        if (dbItem)
+        {
+            if (dbItem->data.type == DATAROUTER_INTEGER_ARRAY)
+            {
+                *valueSizePtr = (dbItem->data.count < maxValues) ? dbItem->data.count : maxValues;
+                memcpy(valuePtr, dbItem->data.iaValue, *valueSizePtr * sizeof(int32_t));
+                *timestampPtr = dbItem->data.timestamp;
+                LE_DEBUG(
+                    "<-- key(%s) = count(%zu), timestamp(%u)", key, *valueSizePtr, *timestampPtr);
+            }
+            else
+            {
+                LE_WARN("key('%s') not INTEGER_ARRAY type", key);
+            }
+        }
+        else
+        {
+            LE_WARN("key('%s') not found", key);
+        }
+    }
+}
+
+le_result_t dataRouter_ReadFloatHistory
+(
+    const char* key,
+    uint32_t since,
+    double* valuePtr,
+    size_t* valueSizePtr,
+    uint32_t* timestampPtr,
+    size_t* timestampSizePtr
+)
+{
+    le_result_t res = LE_OK;
+    size_t maxSamples = (*valueSizePtr < *timestampSizePtr) ? *valueSizePtr : *timestampSizePtr;
+
+    *valueSizePtr = 0;
+    *timestampSizePtr = 0;
+
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (!session)
+    {
+        res = LE_NOT_PERMITTED;
+        goto cleanup;
+    }
+
+    if (!swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_READ))
+    {
+        res = LE_WOULD_BLOCK;
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+    if (!dbItem || !dbItem->history)
+    {
+        LE_WARN("key('%s') has no history", key);
+        res = LE_NOT_FOUND;
+        goto cleanup;
+    }
+
+    *valueSizePtr = swi_mangoh_data_router_db_readHistory(
+        dbItem, since, valuePtr, timestampPtr, maxSamples);
+    *timestampSizePtr = *valueSizePtr;
+    LE_DEBUG("key(%s) <-- samples(%zu) since(%u)", key, *valueSizePtr, since);
+
+cleanup:
+    return res;
+}
+
+dataRouter_DataUpdateHandlerRef_t dataRouter_AddDataUpdateHandler
+(
+    const char* key,
+    dataRouter_DataUpdateHandlerFunc_t handlerPtr,
+    void* contextPtr
+)
+{
+    dataRouter_DataUpdateHandlerRef_t updateHandlerRef = NULL;
+    le_msg_SessionRef_t clientSession = dataRouter_GetClientSessionRef();
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_SUBSCRIBE))
+    {
+        LE_DEBUG("register handler on key(%s)", key);
+        swi_mangoh_data_router_dbItem_t* dbItem =
+            swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+        if (!dbItem)
+        {
+            dbItem = swi_mangoh_data_router_db_createDataItem(&dataRouter.db, key);
+            if (!dbItem)
+            {
+                LE_ERROR("ERROR swi_mangoh_data_router_db_getDataItem() failed");
+                goto cleanup;
+            }
+        }
+
+        updateHandlerRef =
+            (dataRouter_DataUpdateHandlerRef_t)swi_mangoh_data_router_addUpdateHandler(
+                dbItem, clientSession, handlerPtr, NULL, NULL, contextPtr);
+    }
+
+cleanup:
+    return updateHandlerRef;
+}
+
+void dataRouter_RemoveDataUpdateHandler
+(
+    dataRouter_DataUpdateHandlerRef_t updateHandlerRef
+)
+{
+    le_msg_SessionRef_t clientSession = dataRouter_GetClientSessionRef();
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session)
+    {
+        swi_mangoh_data_router_removeUpdateHandler(
+            (swi_mangoh_data_router_dataUpdateHandler_t*)updateHandlerRef, clientSession);
+    }
+}
+
+dataRouter_FilteredDataUpdateHandlerRef_t dataRouter_AddFilteredDataUpdateHandler
+(
+    const char* key,
+    dataRouter_Filter_t filter,
+    double low,
+    double high,
+    const char* match,
+    dataRouter_DataUpdateHandlerFunc_t handlerPtr,
+    void* contextPtr
+)
+{
+    swi_mangoh_data_router_dataUpdateHandler_t* newHandlerNode = NULL;
+    swi_mangoh_data_router_filter_t updateFilter;
+
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (!session ||
+        !swi_mangoh_data_router_limit_admit(
+            &session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_SUBSCRIBE))
+    {
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+    if (!dbItem)
+    {
+        dbItem = swi_mangoh_data_router_db_createDataItem(&dataRouter.db, key);
+        if (!dbItem)
+        {
+            LE_ERROR("ERROR swi_mangoh_data_router_db_createDataItem() failed");
+            goto cleanup;
+        }
+    }
+
+    if (swi_mangoh_data_router_filter_init(
+            &updateFilter, filter, low, high, match, dbItem->hasValue ? &dbItem->data : NULL) !=
+        LE_OK)
+    {
+        goto cleanup;
+    }
+
+    LE_DEBUG("register handler on key(%s) filter(%d)", key, filter);
+    newHandlerNode = swi_mangoh_data_router_addUpdateHandler(
+        dbItem, dataRouter_GetClientSessionRef(), handlerPtr, NULL, &updateFilter, contextPtr);
+
+cleanup:
+    return (dataRouter_FilteredDataUpdateHandlerRef_t)newHandlerNode;
+}
+
+void dataRouter_RemoveFilteredDataUpdateHandler
+(
+    dataRouter_FilteredDataUpdateHandlerRef_t updateHandlerRef
+)
+{
+    if (swi_mangoh_data_router_getClientSession())
+    {
+        swi_mangoh_data_router_removeUpdateHandler(
+            (swi_mangoh_data_router_dataUpdateHandler_t*)updateHandlerRef,
+            dataRouter_GetClientSessionRef());
+    }
+}
+
+dataRouter_FlowControlHandlerRef_t dataRouter_AddFlowControlHandler
+(
+    dataRouter_FlowControlHandlerFunc_t handlerPtr,
+    void* contextPtr
+)
+{
+    swi_mangoh_data_router_flowControlHandler_t* newHandlerNode = NULL;
+
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_SUBSCRIBE))
+    {
+        newHandlerNode = malloc(sizeof(swi_mangoh_data_router_flowControlHandler_t));
+        LE_ASSERT(newHandlerNode);
+        newHandlerNode->next             = LE_SLS_LINK_INIT;
+        newHandlerNode->clientSessionRef = dataRouter_GetClientSessionRef();
+        newHandlerNode->handler          = handlerPtr;
+        newHandlerNode->context          = contextPtr;
+        le_sls_Stack(&dataRouter.flowHandlers, &newHandlerNode->next);
+
+        // Producers registering during congestion must slow down too
+        if (dataRouter.flow.congested)
+        {
+            handlerPtr(true, contextPtr);
+        }
+    }
+
+    return (dataRouter_FlowControlHandlerRef_t)newHandlerNode;
+}
+
+void dataRouter_RemoveFlowControlHandler
+(
+    dataRouter_FlowControlHandlerRef_t flowHandlerRef
+)
+{
+    if (swi_mangoh_data_router_getClientSession())
+    {
+        ComparisonClientSessionRef = dataRouter_GetClientSessionRef();
+        ComparisonFlowHandler = (swi_mangoh_data_router_flowControlHandler_t*)flowHandlerRef;
+        if (!ListRemoveFirstMatch(
+                &dataRouter.flowHandlers, &IsFlowHandler, &FreeFlowHandlerListNode))
+        {
+            LE_WARN("flow control handler(%p) not found", flowHandlerRef);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Install an update handler for a client session on a data item.  Only one handler per client
+ * session is allowed on a data item, whether it was registered by key or by handle.
+ *
+ * @return
+ *      The new handler node or NULL if the client session already has a handler on the data item
+ */
+//--------------------------------------------------------------------------------------------------
+static swi_mangoh_data_router_dataUpdateHandler_t* swi_mangoh_data_router_addUpdateHandler
+(
+    swi_mangoh_data_router_dbItem_t* dbItem,
+    le_msg_SessionRef_t clientSession,
+    dataRouter_DataUpdateHandlerFunc_t handlerPtr,
+    dataRouter_HandleUpdateHandlerFunc_t handleHandlerPtr,
+    const swi_mangoh_data_router_filter_t* filter,
+    void* contextPtr
+)
+{
+    swi_mangoh_data_router_dataUpdateHandler_t* newHandlerNode = NULL;
+
+    le_sls_Link_t* linkPtr = le_sls_Peek(&dbItem->handlers);
+    while (linkPtr)
+    {
+        swi_mangoh_data_router_dataUpdateHandler_t* handlerElem =
+            CONTAINER_OF(linkPtr, swi_mangoh_data_router_dataUpdateHandler_t, next);
+
+        if (handlerElem->clientSessionRef == clientSession)
+        {
+            LE_WARN(
+                "session(%p) already has a handler for key(%s)", clientSession, dbItem->key);
+            goto cleanup;
+        }
+
+        linkPtr = le_sls_PeekNext(&dbItem->handlers, linkPtr);
+    }
+
+    // No handler exists for key
+    newHandlerNode = malloc(sizeof(swi_mangoh_data_router_dataUpdateHandler_t));
+    LE_ASSERT(newHandlerNode);
+    newHandlerNode->next              = LE_SLS_LINK_INIT;
+    newHandlerNode->dbItemInstalledOn = dbItem;
+    newHandlerNode->clientSessionRef  = clientSession;
+    newHandlerNode->handler           = handlerPtr;
+    newHandlerNode->handleHandler     = handleHandlerPtr;
+    newHandlerNode->context           = contextPtr;
+    if (filter)
+    {
+        newHandlerNode->filter = *filter;
+    }
+    else
+    {
+        memset(&newHandlerNode->filter, 0, sizeof(newHandlerNode->filter));
+    }
+    le_sls_Stack(&dbItem->handlers, &newHandlerNode->next);
+
+cleanup:
+    return newHandlerNode;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove the update handler of a client session from the data item it is installed on
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_removeUpdateHandler
+(
+    swi_mangoh_data_router_dataUpdateHandler_t* dataUpdateHandlerNode,
+    le_msg_SessionRef_t clientSession
+)
+{
+    // iterate over elements of dataUpdateHandlerNode->dbItemInstalledOn->handlers to identify and
+    // remove the node with the matching clientSession.  Unfortunately the C language doesn't
+    // support closures, so we have to set a global (ComparisonClientSessionRef) for use by
+    // IsUpdateHandlerForSession
+    ComparisonClientSessionRef = clientSession;
+    ListRemoveFirstMatch(
+        &dataUpdateHandlerNode->dbItemInstalledOn->handlers,
+        &IsUpdateHandlerForSession,
+        &FreeDataUpdateHandlerListNode);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Store a value written by the calling client, push it and notify the subscribers of the key
+ *
+ * @return
+ *      - LE_OK on success
+ *      - LE_NOT_PERMITTED if the client has not called SessionStart()
+ *      - LE_WOULD_BLOCK if the session is over its write rate limit
+ *      - LE_NO_MEMORY if the key could not be created
+ *      - LE_OVERFLOW or LE_BUSY if the value was stored but the transports are not keeping up
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t swi_mangoh_data_router_tryWrite
+(
+    const char* key,
+    const swi_mangoh_data_router_data_t* data
+)
+{
+    le_result_t res = LE_OK;
+
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (!session)
+    {
+        res = LE_NOT_PERMITTED;
+        goto cleanup;
+    }
+
+    if (!swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_WRITE))
+    {
+        res = LE_WOULD_BLOCK;
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+    if (!dbItem)
+    {
+        dbItem = swi_mangoh_data_router_db_createDataItem(&dataRouter.db, key);
+        if (!dbItem)
+        {
+            LE_ERROR("ERROR swi_mangoh_data_router_db_createDataItem() failed");
+            res = LE_NO_MEMORY;
+            goto cleanup;
+        }
+    }
+
+    res = swi_mangoh_data_router_storeData(session, key, dbItem, data);
+    LE_DEBUG("session(%p) --> key(%s) result(%d)", dataRouter_GetClientSessionRef(), key, res);
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Store a value of a session, push it to the transports and notify the subscribers
+ *
+ * @return
+ *      - LE_OK on success
+ *      - LE_OVERFLOW or LE_BUSY if the value was stored but the transports are not keeping up
+ *      - LE_BAD_PARAMETER if the value type is not supported
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t swi_mangoh_data_router_storeData
+(
+    swi_mangoh_data_router_session_t* session,
+    const char* key,
+    swi_mangoh_data_router_dbItem_t* dbItem,
+    const swi_mangoh_data_router_data_t* data
+)
+{
+    le_result_t res = LE_OK;
+
+    if ((data->type != DATAROUTER_BOOLEAN) && (data->type != DATAROUTER_INTEGER) &&
+        (data->type != DATAROUTER_FLOAT) && (data->type != DATAROUTER_STRING))
+    {
+        LE_ERROR("ERROR unsupported type(%d)", data->type);
+        res = LE_BAD_PARAMETER;
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_db_beginUpdate(dbItem);
+    swi_mangoh_data_router_db_setStorageType(dbItem, session->storageType);
+    swi_mangoh_data_router_db_setDataType(dbItem, data->type);
+    switch (data->type)
+    {
+        case DATAROUTER_BOOLEAN:
+            swi_mangoh_data_router_db_setBooleanValue(dbItem, data->bValue);
+            break;
+
+        case DATAROUTER_INTEGER:
+            swi_mangoh_data_router_db_setIntegerValue(dbItem, data->iValue);
+            break;
+
+        case DATAROUTER_FLOAT:
+            swi_mangoh_data_router_db_setFloatValue(dbItem, data->fValue);
+            break;
+
+        default:
+            swi_mangoh_data_router_db_setStringValue(dbItem, data->sValue);
+            break;
+    }
+    swi_mangoh_data_router_db_setTimestamp(dbItem, data->timestamp);
+    swi_mangoh_data_router_db_endUpdate(&dataRouter.db, dbItem);
+    if (data->type == DATAROUTER_FLOAT)
+    {
+        uint32_t timestamp = data->timestamp;
+        swi_mangoh_data_router_db_appendHistory(dbItem, &data->fValue, &timestamp, 1);
+    }
+
+    res = pushItemIfRequired(session, key, dbItem);
+    swi_mangoh_data_router_notifySubscribers(key, dbItem);
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run a rule action for the session that added the rule.  Written values are timestamped when
+ * the action runs.
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_runRuleAction
+(
+    void* owner,
+    const swi_mangoh_data_router_ruleAction_t* action
+)
+{
+    swi_mangoh_data_router_session_t* session = le_hashmap_Get(dataRouter.sessions, owner);
+    if (!session)
+    {
+        LE_WARN("session('%p') not found", owner);
+        goto cleanup;
+    }
+
+    if (action->push)
+    {
+        pushItemIfRequired(session, action->dbItem->key, action->dbItem);
+    }
+    else
+    {
+        swi_mangoh_data_router_data_t data = action->value;
+        data.timestamp = le_clk_GetAbsoluteTime().sec;
+        swi_mangoh_data_router_storeData(session, action->dbItem->key, action->dbItem, &data);
+    }
+
+cleanup:
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Look up the data router session of the calling client.  The client app name is only resolved
+ * when the session is missing, so that the handle based calls don't pay for it on every request.
+ *
+ * @return
+ *      The data router session or NULL if the client has not called SessionStart()
+ */
+//--------------------------------------------------------------------------------------------------
+static swi_mangoh_data_router_session_t* swi_mangoh_data_router_getClientSession
+(
+    void
+)
+{
+    le_msg_SessionRef_t clientSession = dataRouter_GetClientSessionRef();
+    swi_mangoh_data_router_session_t* session = le_hashmap_Get(dataRouter.sessions, clientSession);
+    if (!session)
+    {
+        pid_t pid = 0;
+        char appName[SWI_MANGOH_DATA_ROUTER_APP_NAME_LEN] = {0};
+        swi_mangoh_data_router_getSessionPidAndAppName(
+            clientSession, &pid, appName, sizeof(appName));
+        LE_ERROR(
+            "Session not found for app(%s)/pid(%u)/session(%p).  Call SessionStart() to create a "
+            "session.",
+            appName,
+            pid,
+            clientSession);
+    }
+
+    return session;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Look up the data item bound to a key handle
+ *
+ * @return
+ *      The data item or NULL if the handle is invalid
+ */
+//--------------------------------------------------------------------------------------------------
+static swi_mangoh_data_router_dbItem_t* swi_mangoh_data_router_getHandleItem
+(
+    uint32_t handle
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItemByHandle(&dataRouter.db, handle);
+    if (!dbItem)
+    {
+        LE_WARN("handle(%u) not found", handle);
+    }
+
+    return dbItem;
+}
+
+le_result_t dataRouter_RegisterKey
+(
+    const char* key,
+    uint32_t* handlePtr
+)
+{
+    le_result_t res = LE_OK;
+
+    *handlePtr = DATAROUTER_INVALID_HANDLE;
+
+    if (!swi_mangoh_data_router_getClientSession())
+    {
+        res = LE_NOT_PERMITTED;
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+    if (!dbItem)
+    {
+        dbItem = swi_mangoh_data_router_db_createDataItem(&dataRouter.db, key);
+        if (!dbItem)
+        {
+            LE_ERROR("ERROR swi_mangoh_data_router_db_createDataItem() failed");
+            res = LE_NO_MEMORY;
+            goto cleanup;
+        }
+    }
+
+    *handlePtr = swi_mangoh_data_router_db_registerHandle(&dataRouter.db, dbItem);
+    if (*handlePtr == DATAROUTER_INVALID_HANDLE)
+    {
+        res = LE_NO_MEMORY;
+    }
+
+cleanup:
+    return res;
+}
+
+le_result_t dataRouter_ResolveKey
+(
+    const char* key,
+    uint32_t* handlePtr
+)
+{
+    le_result_t res = LE_OK;
+
+    *handlePtr = DATAROUTER_INVALID_HANDLE;
+
+    if (!swi_mangoh_data_router_getClientSession())
+    {
+        res = LE_NOT_PERMITTED;
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+    if (!dbItem)
+    {
+        LE_WARN("key('%s') not found", key);
+        res = LE_NOT_FOUND;
+        goto cleanup;
+    }
+
+    *handlePtr = swi_mangoh_data_router_db_registerHandle(&dataRouter.db, dbItem);
+    if (*handlePtr == DATAROUTER_INVALID_HANDLE)
+    {
+        res = LE_NO_MEMORY;
+    }
+
+cleanup:
+    return res;
+}
+
+void dataRouter_WriteBooleanByHandle
+(
+    uint32_t handle,
+    bool value,
+    uint32_t timestamp
+)
+{
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_WRITE))
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_getHandleItem(handle);
+        if (dbItem)
+        {
+            LE_DEBUG(
+                "handle(%u) --> key(%s) = value(%d), timestamp(%u)",
+                handle,
+                dbItem->key,
+                value,
+                timestamp);
+
+            swi_mangoh_data_router_db_beginUpdate(dbItem);
+            swi_mangoh_data_router_db_setStorageType(dbItem, session->storageType);
+            swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_BOOLEAN);
+            swi_mangoh_data_router_db_setBooleanValue(dbItem, value);
+            swi_mangoh_data_router_db_setTimestamp(dbItem, timestamp);
+            swi_mangoh_data_router_db_endUpdate(&dataRouter.db, dbItem);
+
+            pushItemIfRequired(session, dbItem->key, dbItem);
+
+            swi_mangoh_data_router_notifySubscribers(dbItem->key, dbItem);
+        }
+    }
+}
+
+void dataRouter_WriteIntegerByHandle
+(
+    uint32_t handle,
+    int32_t value,
+    uint32_t timestamp
+)
+{
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_WRITE))
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_getHandleItem(handle);
+        if (dbItem)
+        {
+            LE_DEBUG(
+                "handle(%u) --> key(%s) = value(%d), timestamp(%u)",
+                handle,
+                dbItem->key,
+                value,
+                timestamp);
+
+            swi_mangoh_data_router_db_beginUpdate(dbItem);
+            swi_mangoh_data_router_db_setStorageType(dbItem, session->storageType);
+            swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_INTEGER);
+            swi_mangoh_data_router_db_setIntegerValue(dbItem, value);
+            swi_mangoh_data_router_db_setTimestamp(dbItem, timestamp);
+            swi_mangoh_data_router_db_endUpdate(&dataRouter.db, dbItem);
+
+            pushItemIfRequired(session, dbItem->key, dbItem);
+
+            swi_mangoh_data_router_notifySubscribers(dbItem->key, dbItem);
+        }
+    }
+}
+
+void dataRouter_WriteFloatByHandle
+(
+    uint32_t handle,
+    double value,
+    uint32_t timestamp
+)
+{
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_WRITE))
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_getHandleItem(handle);
+        if (dbItem)
+        {
+            LE_DEBUG(
+                "handle(%u) --> key(%s) = value(%f), timestamp(%u)",
+                handle,
+                dbItem->key,
+                value,
+                timestamp);
+
+            swi_mangoh_data_router_db_beginUpdate(dbItem);
+            swi_mangoh_data_router_db_setStorageType(dbItem, session->storageType);
+            swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_FLOAT);
+            swi_mangoh_data_router_db_setFloatValue(dbItem, value);
+            swi_mangoh_data_router_db_setTimestamp(dbItem, timestamp);
+            swi_mangoh_data_router_db_endUpdate(&dataRouter.db, dbItem);
+            swi_mangoh_data_router_db_appendHistory(dbItem, &value, &timestamp, 1);
+
+            pushItemIfRequired(session, dbItem->key, dbItem);
+
+            swi_mangoh_data_router_notifySubscribers(dbItem->key, dbItem);
+        }
+    }
 }
 
-void dataRouter_ReadFloat
+void dataRouter_WriteStringByHandle
 (
-    const char* key,
-    double* valuePtr,
-    uint32_t* timestampPtr
+    uint32_t handle,
+    const char* value,
+    uint32_t timestamp
 )
 {
-    le_msg_SessionRef_t clientSession = dataRouter_GetClientSessionRef();
-    pid_t pid;
-    char appName[SWI_MANGOH_DATA_ROUTER_APP_NAME_LEN];
-    if (swi_mangoh_data_router_getSessionPidAndAppName(
-            clientSession, &pid, appName, sizeof(appName)) != LE_OK)
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_WRITE))
     {
-        LE_ERROR("Failed to get client information");
-        goto cleanup;
+        swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_getHandleItem(handle);
+        if (dbItem)
+        {
+            LE_DEBUG(
+                "handle(%u) --> key(%s) = value('%s'), timestamp(%u)",
+                handle,
+                dbItem->key,
+                value,
+                timestamp);
+
+            swi_mangoh_data_router_db_beginUpdate(dbItem);
+            swi_mangoh_data_router_db_setStorageType(dbItem, session->storageType);
+            swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_STRING);
+            swi_mangoh_data_router_db_setStringValue(dbItem, value);
+            swi_mangoh_data_router_db_setTimestamp(dbItem, timestamp);
+            swi_mangoh_data_router_db_endUpdate(&dataRouter.db, dbItem);
+
+            pushItemIfRequired(session, dbItem->key, dbItem);
+
+            swi_mangoh_data_router_notifySubscribers(dbItem->key, dbItem);
+        }
     }
-    LE_DEBUG("lookup session('%p')", clientSession);
-    swi_mangoh_data_router_session_t* session = le_hashmap_Get(dataRouter.sessions, clientSession);
-    if (session)
+}
+
+void dataRouter_ReadBooleanByHandle
+(
+    uint32_t handle,
+    bool* valuePtr,
+    uint32_t* timestampPtr
+)
+{
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_READ))
     {
-        swi_mangoh_data_router_dbItem_t* dbItem =
-            swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+        swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_getHandleItem(handle);
         if (dbItem)
         {
-            if (dbItem->data.type == DATAROUTER_FLOAT)
+            if (dbItem->data.type == DATAROUTER_BOOLEAN)
             {
-                *valuePtr     = dbItem->data.fValue;
+                *valuePtr     = dbItem->data.bValue;
                 *timestampPtr = dbItem->data.timestamp;
                 LE_DEBUG(
-                    "app(%s)/pid(%u)/session(%p) <-- key(%s) = value(%f), timestamp(%u)",
-                    appName,
-                    pid,
-                    clientSession,
-                    key,
+                    "handle(%u) <-- key(%s) = value(%u), timestamp(%u)",
+                    handle,
+                    dbItem->key,
                     *valuePtr,
                     *timestampPtr);
             }
             else
             {
-                LE_WARN("key('%s') not FLOAT type", key);
+                LE_WARN("key('%s') not BOOLEAN type", dbItem->key);
             }
         }
-        else
+    }
+}
+
+void dataRouter_ReadIntegerByHandle
+(
+    uint32_t handle,
+    int32_t* valuePtr,
+    uint32_t* timestampPtr
+)
+{
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_READ))
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_getHandleItem(handle);
+        if (dbItem)
         {
-            LE_WARN("key('%s') not found", key);
+            if (dbItem->data.type == DATAROUTER_INTEGER)
+            {
+                *valuePtr     = dbItem->data.iValue;
+                *timestampPtr = dbItem->data.timestamp;
+                LE_DEBUG(
+                    "handle(%u) <-- key(%s) = value(%d), timestamp(%u)",
+                    handle,
+                    dbItem->key,
+                    *valuePtr,
+                    *timestampPtr);
+            }
+            else
+            {
+                LE_WARN("key('%s') not INTEGER type", dbItem->key);
+            }
         }
     }
-    else
+}
+
+void dataRouter_ReadFloatByHandle
+(
+    uint32_t handle,
+    double* valuePtr,
+    uint32_t* timestampPtr
+)
+{
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_READ))
     {
-        LE_ERROR(
-            "Session not found for app(%s)/pid(%u)/session(%p).  Call SessionStart() to create a "
-            "session.",
-            appName,
-            pid,
-            clientSession);
+        swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_getHandleItem(handle);
+        if (dbItem)
+        {
+            if (dbItem->data.type == DATAROUTER_FLOAT)
+            {
+                *valuePtr     = dbItem->data.fValue;
+                *timestampPtr = dbItem->data.timestamp;
+                LE_DEBUG(
+                    "handle(%u) <-- key(%s) = value(%f), timestamp(%u)",
+                    handle,
+                    dbItem->key,
+                    *valuePtr,
+                    *timestampPtr);
+            }
+            else
+            {
+                LE_WARN("key('%s') not FLOAT type", dbItem->key);
+            }
+        }
     }
-
-cleanup:
-    return;
 }
 
-void dataRouter_ReadString
+void dataRouter_ReadStringByHandle
 (
-    const char* key,
+    uint32_t handle,
     char* valuePtr,
     size_t numValues,
     uint32_t* timestampPtr
 )
 {
-    le_msg_SessionRef_t clientSession = dataRouter_GetClientSessionRef();
-    pid_t pid;
-    char appName[SWI_MANGOH_DATA_ROUTER_APP_NAME_LEN];
-    if (swi_mangoh_data_router_getSessionPidAndAppName(
-            clientSession, &pid, appName, sizeof(appName)) != LE_OK)
-    {
-        LE_ERROR("Failed to get client information");
-        goto cleanup;
-    }
-    LE_DEBUG("lookup session('%p')", clientSession);
-    swi_mangoh_data_router_session_t* session = le_hashmap_Get(dataRouter.sessions, clientSession);
-    if (session)
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_READ))
     {
-        swi_mangoh_data_router_dbItem_t* dbItem =
-            swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
+        swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_getHandleItem(handle);
         if (dbItem)
         {
             if (dbItem->data.type == DATAROUTER_STRING)
@@ -794,166 +2068,154 @@ void dataRouter_ReadString
                 strncpy(valuePtr, dbItem->data.sValue, numValues - 1);
                 *timestampPtr = dbItem->data.timestamp;
                 LE_DEBUG(
-                    "app(%s)/pid(%u)/session(%p) <-- key(%s) = value('%s'), timestamp(%u)",
-                    appName,
-                    pid,
-                    clientSession,
-                    key,
+                    "handle(%u) <-- key(%s) = value('%s'), timestamp(%u)",
+                    handle,
+                    dbItem->key,
                     valuePtr,
                     *timestampPtr);
             }
             else
             {
-                LE_WARN("key('%s') not STRING type", key);
+                LE_WARN("key('%s') not STRING type", dbItem->key);
             }
         }
-        else
+    }
+}
+
+dataRouter_HandleUpdateHandlerRef_t dataRouter_AddHandleUpdateHandler
+(
+    uint32_t handle,
+    dataRouter_HandleUpdateHandlerFunc_t handlerPtr,
+    void* contextPtr
+)
+{
+    dataRouter_HandleUpdateHandlerRef_t updateHandlerRef = NULL;
+
+    swi_mangoh_data_router_session_t* session = swi_mangoh_data_router_getClientSession();
+    if (session &&
+        swi_mangoh_data_router_limit_admit(&session->limit, SWI_MANGOH_DATA_ROUTER_LIMIT_SUBSCRIBE))
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_getHandleItem(handle);
+        if (dbItem)
         {
-            LE_WARN("key('%s') not found", key);
+            LE_DEBUG("register handler on handle(%u)/key(%s)", handle, dbItem->key);
+            updateHandlerRef =
+                (dataRouter_HandleUpdateHandlerRef_t)swi_mangoh_data_router_addUpdateHandler(
+                    dbItem, dataRouter_GetClientSessionRef(), NULL, handlerPtr, NULL, contextPtr);
         }
     }
-    else
+
+    return updateHandlerRef;
+}
+
+void dataRouter_RemoveHandleUpdateHandler
+(
+    dataRouter_HandleUpdateHandlerRef_t updateHandlerRef
+)
+{
+    if (swi_mangoh_data_router_getClientSession())
     {
-        LE_ERROR(
-            "Session not found for app(%s)/pid(%u)/session(%p).  Call SessionStart() to create a "
-            "session.",
-            appName,
-            pid,
-            clientSession);
+        swi_mangoh_data_router_removeUpdateHandler(
+            (swi_mangoh_data_router_dataUpdateHandler_t*)updateHandlerRef,
+            dataRouter_GetClientSessionRef());
     }
-
-cleanup:
-    return;
 }
 
-dataRouter_DataUpdateHandlerRef_t dataRouter_AddDataUpdateHandler
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push a key/dbItem pair to the selected transports if pushing to AirVantage is enabled and the
+ * update passes the report threshold of the key
+ *
+ * @return
+ *      - LE_OK if the update was pushed or did not need to be
+ *      - LE_OVERFLOW if a transport queue dropped an update
+ *      - LE_BUSY if the transport queues are congested
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t pushItemIfRequired
 (
+    swi_mangoh_data_router_session_t* session,
     const char* key,
-    dataRouter_DataUpdateHandlerFunc_t handlerPtr,
-    void* contextPtr
+    swi_mangoh_data_router_dbItem_t* dbItem
 )
 {
-    dataRouter_DataUpdateHandlerRef_t updateHandlerRef = NULL;
-    le_msg_SessionRef_t clientSession    = dataRouter_GetClientSessionRef();
-    pid_t pid;
-    char appName[SWI_MANGOH_DATA_ROUTER_APP_NAME_LEN];
-    if (swi_mangoh_data_router_getSessionPidAndAppName(
-            clientSession, &pid, appName, sizeof(appName)) != LE_OK)
+    le_result_t res = LE_OK;
+
+    if (!session->pushAv)
     {
-        LE_ERROR("Failed to get client information");
         goto cleanup;
     }
-    LE_DEBUG("lookup session('%p')", clientSession);
-    swi_mangoh_data_router_session_t* session = le_hashmap_Get(dataRouter.sessions, clientSession);
-    if (session)
-    {
-        LE_DEBUG(
-            "app(%s)/pid(%u)/session(%p): register handler on key(%s)",
-            appName,
-            pid,
-            clientSession,
-            key);
-        swi_mangoh_data_router_dbItem_t* dbItem =
-            swi_mangoh_data_router_db_getDataItem(&dataRouter.db, key);
-        if (!dbItem)
-        {
-            dbItem = swi_mangoh_data_router_db_createDataItem(&dataRouter.db, key);
-            if (!dbItem)
-            {
-                LE_ERROR("ERROR swi_mangoh_data_router_db_getDataItem() failed");
-                goto cleanup;
-            }
-        }
-
-        le_sls_Link_t* linkPtr = le_sls_Peek(&dbItem->handlers);
-        while (linkPtr)
-        {
-            swi_mangoh_data_router_dataUpdateHandler_t* handlerElem =
-                CONTAINER_OF(linkPtr, swi_mangoh_data_router_dataUpdateHandler_t, next);
 
-            if (handlerElem->clientSessionRef == clientSession)
-            {
-                LE_WARN(
-                    "app(%s)/pid(%u)/session(%p) already has a handler for key(%s)",
-                    appName,
-                    pid,
-                    clientSession,
-                    key);
-                break;
-            }
+    if (dbItem->aggregate &&
+        swi_mangoh_data_router_aggregate_addData(dbItem->aggregate, &dbItem->data))
+    {
+        goto cleanup;
+    }
 
-            linkPtr = le_sls_PeekNext(&dbItem->handlers, linkPtr);
-        }
+    if (!swi_mangoh_data_router_db_checkReport(dbItem))
+    {
+        LE_DEBUG("key('%s') update within the report threshold", key);
+        goto cleanup;
+    }
 
-        if (linkPtr == NULL)
+    swi_mangoh_data_router_priority_apply(&dataRouter.priorities, dbItem);
+    for (uint32_t i = 0; i < dataRouter.numTransports; i++)
+    {
+        if (session->clients[i] &&
+            (dataRouter.transports[i].ops->write(session->clients[i], key, dbItem) == LE_OVERFLOW))
         {
-            // No handler exists for key
-            swi_mangoh_data_router_dataUpdateHandler_t* newHandlerNode =
-                malloc(sizeof(swi_mangoh_data_router_dataUpdateHandler_t));
-            LE_ASSERT(newHandlerNode);
-            newHandlerNode->next              = LE_SLS_LINK_INIT;
-            newHandlerNode->dbItemInstalledOn = dbItem;
-            newHandlerNode->clientSessionRef  = clientSession;
-            newHandlerNode->handler           = handlerPtr;
-            newHandlerNode->context           = contextPtr;
-            le_sls_Stack(&dbItem->handlers, &newHandlerNode->next);
-
-            updateHandlerRef = (dataRouter_DataUpdateHandlerRef_t)newHandlerNode;
+            res = LE_OVERFLOW;
         }
     }
-    else
+
+    if (swi_mangoh_data_router_flow_check(&dataRouter.flow) && (res == LE_OK))
     {
-        LE_ERROR(
-            "Session not found for app(%s)/pid(%u)/session(%p).  Call SessionStart() to create a "
-            "session.",
-            appName,
-            pid,
-            clientSession);
+        res = LE_BUSY;
     }
 
 cleanup:
-    return updateHandlerRef;
+    return res;
 }
 
-void dataRouter_RemoveDataUpdateHandler
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push a block of samples of a key to the selected transports if pushing is enabled, or fold them
+ * into the statistics of the key when it is aggregated
+ */
+//--------------------------------------------------------------------------------------------------
+static void pushSamplesIfRequired
 (
-    dataRouter_DataUpdateHandlerRef_t updateHandlerRef
+    swi_mangoh_data_router_session_t* session,
+    const char* key,
+    swi_mangoh_data_router_dbItem_t* dbItem,
+    const double* values,
+    const uint32_t* timestamps,
+    size_t numSamples
 )
 {
-    le_msg_SessionRef_t clientSession = dataRouter_GetClientSessionRef();
-    pid_t pid;
-    char appName[SWI_MANGOH_DATA_ROUTER_APP_NAME_LEN];
-    if (swi_mangoh_data_router_getSessionPidAndAppName(
-            clientSession, &pid, appName, sizeof(appName)) != LE_OK)
+    if (!session->pushAv)
     {
-        LE_ERROR("Failed to get client information");
         goto cleanup;
     }
-    LE_DEBUG("lookup session('%p')", clientSession);
-    swi_mangoh_data_router_session_t* session = le_hashmap_Get(dataRouter.sessions, clientSession);
-    if (session)
+
+    if (dbItem->aggregate)
     {
-        swi_mangoh_data_router_dataUpdateHandler_t* dataUpdateHandlerNode =
-            (swi_mangoh_data_router_dataUpdateHandler_t*)updateHandlerRef;
-        // iterate over elements of dataUpdateHandlerNode->dbItemInstalledOn->handlers to identify
-        // and
-        // remove the node with the matching clientSession.  Unfortunately the C language doesn't
-        // support closures, so we have to set a global (ComparisonClientSessionRef) for use by
-        // IsUpdateHandlerForSession
-        ComparisonClientSessionRef = clientSession;
-        ListRemoveFirstMatch(
-            &dataUpdateHandlerNode->dbItemInstalledOn->handlers,
-            &IsUpdateHandlerForSession,
-            &FreeDataUpdateHandlerListNode);
+        for (size_t i = 0; i < numSamples; i++)
+        {
+            swi_mangoh_data_router_aggregate_add(dbItem->aggregate, values[i], timestamps[i]);
+        }
+
+        goto cleanup;
     }
-    else
+
+    swi_mangoh_data_router_priority_apply(&dataRouter.priorities, dbItem);
+    for (uint32_t i = 0; i < dataRouter.numTransports; i++)
     {
-        LE_ERROR(
-            "Session not found for app(%s)/pid(%u)/session(%p).  Call SessionStart() to create a "
-            "session.",
-            appName,
-            pid,
-            clientSession);
+        if (session->clients[i])
+        {
+            dataRouter.transports[i].ops->writeBatch(
+                session->clients[i], key, dbItem, values, timestamps, numSamples);
+        }
     }
 
 cleanup:
@@ -962,41 +2224,117 @@ cleanup:
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Push a key/dbItem pair to AirVantage if pushing to AirVantage is enabled
+ * Push the statistics of an aggregated key to the transports
  */
 //--------------------------------------------------------------------------------------------------
-static void pushItemIfRequired
+static void swi_mangoh_data_router_pushAggregate
 (
-    swi_mangoh_data_router_session_t* session,
-    const char* key,
-    const swi_mangoh_data_router_dbItem_t* dbItem
+    const swi_mangoh_data_router_dbItem_t* dbItem,
+    const swi_mangoh_data_router_aggregate_t* aggregate
+)
+{
+    LE_DEBUG("key('%s') aggregate count(%u)", dbItem->key, aggregate->count);
+    for (uint32_t i = 0; i < dataRouter.numTransports; i++)
+    {
+        const swi_mangoh_data_router_transport_t* transport = &dataRouter.transports[i];
+        if (transport->ops->aggregate)
+        {
+            transport->ops->aggregate(transport->context, dbItem->key, aggregate);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add an item to the full state snapshot of the transports, or end the snapshot when dbItem is
+ * NULL
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_syncItem
+(
+    const swi_mangoh_data_router_dbItem_t* dbItem,
+    void* context
 )
 {
-    if (session->pushAv)
+    for (uint32_t i = 0; i < dataRouter.numTransports; i++)
     {
-        switch (dataRouter.protocolType)
+        const swi_mangoh_data_router_transport_t* transport = &dataRouter.transports[i];
+        if (dbItem && transport->ops->snapshot)
+        {
+            transport->ops->snapshot(transport->context, dbItem->key, dbItem);
+        }
+        else if (!dbItem && transport->ops->snapshotEnd)
         {
-            case SWI_MANGOH_DATA_ROUTER_AV_PROTOCOL_MQTT:
-                swi_mangoh_data_router_mqttWrite(key, dbItem, &session->mqtt);
-                break;
+            transport->ops->snapshotEnd(transport->context);
+        }
+    }
+}
 
-            case SWI_MANGOH_DATA_ROUTER_AV_PROTOCOL_NONE:
-                break;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the percentage in use of the fullest transport queue or spool
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t swi_mangoh_data_router_getUpstreamFill
+(
+    void
+)
+{
+    uint32_t fill = 0;
 
-            default:
-                LE_ERROR("unsupported protocol(%u)", dataRouter.protocolType);
-                break;
+    for (uint32_t i = 0; i < dataRouter.numTransports; i++)
+    {
+        const swi_mangoh_data_router_transport_t* transport = &dataRouter.transports[i];
+        if (transport->ops->getFill)
+        {
+            uint32_t transportFill = transport->ops->getFill(transport->context);
+            if (transportFill > fill)
+            {
+                fill = transportFill;
+            }
         }
     }
+
+    return fill;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tell the producers that the transports became congested or drained
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_notifyFlowControl
+(
+    bool congested
+)
+{
+    for (le_sls_Link_t* nodePtr = le_sls_Peek(&dataRouter.flowHandlers);
+         nodePtr;
+         nodePtr = le_sls_PeekNext(&dataRouter.flowHandlers, nodePtr))
+    {
+        swi_mangoh_data_router_flowControlHandler_t* handlerData =
+            CONTAINER_OF(nodePtr, swi_mangoh_data_router_flowControlHandler_t, next);
 
+        LE_DEBUG(
+            "Calling flow control handler(congested %d) on client (%p)",
+            congested,
+            handlerData->clientSessionRef);
+        handlerData->handler(congested, handlerData->context);
+    }
+}
 
 COMPONENT_INIT
 {
     LE_INFO("mangOH Data Router Service Starting");
 
     swi_mangoh_data_router_db_init(&dataRouter.db);
+    swi_mangoh_data_router_priority_init(&dataRouter.priorities);
+    swi_mangoh_data_router_derive_init(
+        &dataRouter.derive, &dataRouter.db, swi_mangoh_data_router_notifySubscribers);
+    swi_mangoh_data_router_rules_init(
+        &dataRouter.rules, &dataRouter.db, swi_mangoh_data_router_runRuleAction);
+    swi_mangoh_data_router_reader_start(&dataRouter.db);
+    swi_mangoh_data_router_persist_start(&dataRouter.persist, &dataRouter.db);
 
     le_msg_AddServiceCloseHandler(
         dataRouter_GetServiceRef(), swi_mangoh_data_router_onSessionClosed, NULL);
@@ -1006,7 +2344,21 @@ COMPONENT_INIT
         SWI_MANGOH_DATA_ROUTER_SESSIONS_MAP_SIZE,
         le_hashmap_HashVoidPointer,
         le_hashmap_EqualsVoidPointer);
-    dataRouter.protocolType = SWI_MANGOH_DATA_ROUTER_AV_PROTOCOL_MQTT;
+    swi_mangoh_data_router_sink_init(&dataRouter.fileSink, SWI_MANGOH_DATA_ROUTER_SINK_TYPE_FILE);
+    swi_mangoh_data_router_sink_init(
+        &dataRouter.socketSink, SWI_MANGOH_DATA_ROUTER_SINK_TYPE_SOCKET);
+    swi_mangoh_data_router_avdata_init(&dataRouter.avdata);
+    swi_mangoh_data_router_addTransport(
+        SWI_MANGOH_DATA_ROUTER_MQTT_APP_NAME,
+        &swi_mangoh_data_router_mqttTransportOps,
+        &dataRouter.mqtt);
+    swi_mangoh_data_router_sync_init(
+        &dataRouter.sync, &dataRouter.db, swi_mangoh_data_router_syncItem, NULL);
+    dataRouter.flowHandlers = LE_SLS_LIST_INIT;
+    swi_mangoh_data_router_flow_init(
+        &dataRouter.flow,
+        swi_mangoh_data_router_getUpstreamFill,
+        swi_mangoh_data_router_notifyFlowControl);
 
     le_sig_Block(SIGTERM);
     le_sig_SetEventHandler(SIGTERM, swi_mangoh_data_router_SigTermEventHandler);
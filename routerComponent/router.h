@@ -13,6 +13,19 @@
 #include "interfaces.h"
 #include "db.h"
 #include "mqtt.h"
+#include "sink.h"
+#include "avdata.h"
+#include "transport.h"
+#include "persist.h"
+#include "reader.h"
+#include "sync.h"
+#include "aggregate.h"
+#include "priority.h"
+#include "flow.h"
+#include "limit.h"
+#include "filter.h"
+#include "derive.h"
+#include "rule.h"
 
 #ifndef SWI_MANGOH_DATA_ROUTER_INCLUDE_GUARD
 #define SWI_MANGOH_DATA_ROUTER_INCLUDE_GUARD
@@ -26,11 +39,6 @@
 #define SWI_MANGOH_DATA_ROUTER_DATA_HANDLERS_MAP_NAME "DataRouterDataHndlrs"
 #define SWI_MANGOH_DATA_ROUTER_DATA_HANDLERS_MAP_SIZE 7
 
-typedef enum _swi_mangoh_data_router_avProtocol_e {
-    SWI_MANGOH_DATA_ROUTER_AV_PROTOCOL_NONE = 0,
-    SWI_MANGOH_DATA_ROUTER_AV_PROTOCOL_MQTT,
-} swi_mangoh_data_router_avProtocol_e;
-
 //-------------------------------------------------------------------------------------------------
 /**
  * Data Router session
@@ -40,10 +48,9 @@ typedef struct _swi_mangoh_data_router_session_t
 {
     dataRouter_Storage_t storageType;          ///< Data storage
     bool                 pushAv;               ///< Push -> AV flag
-    union
-    {
-        swi_mangoh_data_router_mqtt_t  mqtt;   ///< MQTT protocol -> AV
-    };
+    void* clients[SWI_MANGOH_DATA_ROUTER_TRANSPORTS_MAX_NUM]; ///< Client of each transport, NULL
+                                               ///  when the transport failed to start
+    swi_mangoh_data_router_limit_t limit;      ///< Request rate limits of the session app
 } swi_mangoh_data_router_session_t;
 
 //-------------------------------------------------------------------------------------------------
@@ -54,7 +61,11 @@ typedef struct _swi_mangoh_data_router_session_t
 typedef struct
 {
     dataRouter_DataUpdateHandlerFunc_t handler;  ///< Application data update handler function
+    dataRouter_HandleUpdateHandlerFunc_t handleHandler; ///< Application key handle update handler
+                                                 ///  function, used instead of handler when set
     void* context;                               ///< Application context
+    swi_mangoh_data_router_filter_t filter;      ///< Updates dispatched to the handler, all when
+                                                 ///  not enabled
     le_msg_SessionRef_t clientSessionRef;        ///< Session that the handler is associated with
     swi_mangoh_data_router_dbItem_t* dbItemInstalledOn;  ///< A pointer to the db item that this
                                                  ///  handler is installed on.  This is required so
@@ -65,6 +76,19 @@ typedef struct
     le_sls_Link_t next;                          ///< Linked list link to next element
 } swi_mangoh_data_router_dataUpdateHandler_t;
 
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router flow control handler
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct
+{
+    dataRouter_FlowControlHandlerFunc_t handler; ///< Application flow control handler function
+    void* context;                               ///< Application context
+    le_msg_SessionRef_t clientSessionRef;        ///< Session that the handler is associated with
+    le_sls_Link_t next;                          ///< Linked list link to next element
+} swi_mangoh_data_router_flowControlHandler_t;
+
 //-------------------------------------------------------------------------------------------------
 /**
  * Data Router module
@@ -75,7 +99,22 @@ typedef struct _swi_mangoh_data_router_t
     le_hashmap_Ref_t sessions;      ///< Data sessions :: map<le_msg_SessionRef_t,
                                     ///  swi_mangoh_data_router_session_t>
     swi_mangoh_data_router_db_t db; ///< Database module
-    swi_mangoh_data_router_avProtocol_e protocolType; ///< AV push protocol
+    swi_mangoh_data_router_persist_t persist; ///< Persistence module
+    swi_mangoh_data_router_transport_t transports[SWI_MANGOH_DATA_ROUTER_TRANSPORTS_MAX_NUM];
+                                    ///< Transports the sessions push to
+    uint32_t numTransports;         ///< Number of transports
+    bool transportsSelected;        ///< Transports selected by the protocol argument, MQTT
+                                    ///  otherwise
+    swi_mangoh_data_router_mqtt_t mqtt; ///< MQTT connection -> AV, shared by the sessions
+    swi_mangoh_data_router_sink_t fileSink; ///< File sink, shared by the sessions
+    swi_mangoh_data_router_sink_t socketSink; ///< Unix socket sink, shared by the sessions
+    swi_mangoh_data_router_avdata_t avdata; ///< le_avdata timeseries -> AV, shared by the sessions
+    swi_mangoh_data_router_sync_t sync; ///< Periodic full state sync of the transports
+    swi_mangoh_data_router_priority_t priorities; ///< Upstream priority classes of the keys
+    swi_mangoh_data_router_flow_t flow; ///< Upstream congestion of the transports
+    le_sls_List_t flowHandlers;     ///< Flow control handlers of the sessions
+    swi_mangoh_data_router_derive_t derive; ///< Derived keys computed from the source keys
+    swi_mangoh_data_router_rules_t rules; ///< Local automation rules of the sessions
 } swi_mangoh_data_router_t;
 
 void swi_mangoh_data_router_notifySubscribers(const char*, const swi_mangoh_data_router_dbItem_t*);
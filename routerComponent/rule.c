@@ -0,0 +1,1052 @@
+/**
+ * @file
+ *
+ * A rule is a condition over keys and the actions run when it becomes true, e.g. the condition
+ * "{door/open} && {alarm/armed}" with the actions "{siren/on} = true; push {siren/on}".
+ *
+ * Conditions combine keys in braces, numbers, true, false, + - * /, comparisons, !, && and ||.  A
+ * key compared to a quoted string with == or != matches string values.  Actions, separated by ';',
+ * write a boolean, number or quoted string value to a key, or push the current value of a key.
+ *
+ * Rules are compiled once when they are added: the condition to a bytecode over the keys,
+ * constants and strings of the rule, and the actions to the items and values they write.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+#include <math.h>
+
+#include "rule.h"
+#include "text.h"
+
+#define SWI_MANGOH_DATA_ROUTER_RULE_PUSH "push"
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Rule compiler
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_ruleParser_t
+{
+    swi_mangoh_data_router_db_t* db;     ///< Database module
+    swi_mangoh_data_router_rule_t* rule; ///< Rule being compiled
+    const char* pos;                     ///< Condition or actions position
+    uint32_t depth;                      ///< Condition stack depth after the emitted code
+} swi_mangoh_data_router_ruleParser_t;
+
+static le_result_t swi_mangoh_data_router_rule_emit(
+    swi_mangoh_data_router_ruleParser_t*,
+    swi_mangoh_data_router_ruleOp_e,
+    int32_t);
+static le_result_t swi_mangoh_data_router_rule_parseKey(
+    swi_mangoh_data_router_ruleParser_t*,
+    swi_mangoh_data_router_dbItem_t**);
+static le_result_t swi_mangoh_data_router_rule_addKey(
+    swi_mangoh_data_router_ruleParser_t*,
+    swi_mangoh_data_router_dbItem_t*,
+    uint32_t*);
+static le_result_t swi_mangoh_data_router_rule_parsePrimary(swi_mangoh_data_router_ruleParser_t*);
+static le_result_t swi_mangoh_data_router_rule_parseTerm(swi_mangoh_data_router_ruleParser_t*);
+static le_result_t swi_mangoh_data_router_rule_parseSum(swi_mangoh_data_router_ruleParser_t*);
+static le_result_t swi_mangoh_data_router_rule_parseCompare(swi_mangoh_data_router_ruleParser_t*);
+static le_result_t swi_mangoh_data_router_rule_parseAnd(swi_mangoh_data_router_ruleParser_t*);
+static le_result_t swi_mangoh_data_router_rule_parseOr(swi_mangoh_data_router_ruleParser_t*);
+static le_result_t swi_mangoh_data_router_rule_parseActions(swi_mangoh_data_router_ruleParser_t*);
+static bool swi_mangoh_data_router_rule_run(const swi_mangoh_data_router_rule_t*);
+static void swi_mangoh_data_router_rule_free(
+    swi_mangoh_data_router_rules_t*,
+    swi_mangoh_data_router_rule_t*);
+static void swi_mangoh_data_router_rules_runActions(void*, void*);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append an instruction to the condition, tracking the stack depth it runs at so that the
+ * condition can not overflow the stack of swi_mangoh_data_router_rule_run()
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t swi_mangoh_data_router_rule_emit
+(
+    swi_mangoh_data_router_ruleParser_t* parser,
+    swi_mangoh_data_router_ruleOp_e op,
+    int32_t operand
+)
+{
+    swi_mangoh_data_router_rule_t* rule = parser->rule;
+    uint32_t len = (operand < 0) ? 1 : 2;
+    le_result_t res = LE_OK;
+
+    if (rule->codeLen + len > SWI_MANGOH_DATA_ROUTER_RULE_CODE_MAX_LEN)
+    {
+        LE_ERROR("ERROR condition too long");
+        res = LE_BAD_PARAMETER;
+        goto cleanup;
+    }
+
+    switch (op)
+    {
+        case SWI_MANGOH_DATA_ROUTER_RULE_OP_KEY:
+        case SWI_MANGOH_DATA_ROUTER_RULE_OP_CONST:
+        case SWI_MANGOH_DATA_ROUTER_RULE_OP_STREQ:
+            if (parser->depth >= SWI_MANGOH_DATA_ROUTER_RULE_STACK_MAX_NUM)
+            {
+                LE_ERROR("ERROR condition nested too deep");
+                res = LE_BAD_PARAMETER;
+                goto cleanup;
+            }
+            parser->depth++;
+            break;
+
+        case SWI_MANGOH_DATA_ROUTER_RULE_OP_NOT:
+        case SWI_MANGOH_DATA_ROUTER_RULE_OP_NEG:
+            break;
+
+        default:
+            parser->depth--;
+            break;
+    }
+
+    rule->code[rule->codeLen++] = op;
+    if (operand >= 0)
+    {
+        rule->code[rule->codeLen++] = operand;
+    }
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a key in braces, the key is created when it does not exist yet
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t swi_mangoh_data_router_rule_parseKey
+(
+    swi_mangoh_data_router_ruleParser_t* parser,
+    swi_mangoh_data_router_dbItem_t** dbItem
+)
+{
+    char key[SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN] = {0};
+    le_result_t res = LE_OK;
+
+    const char* end = (*parser->pos == '{') ? strchr(parser->pos, '}') : NULL;
+    size_t len = end ? (size_t)(end - parser->pos - 1) : 0;
+    if (!len || (len >= sizeof(key)))
+    {
+        LE_ERROR("ERROR invalid key at '%s'", parser->pos);
+        res = LE_BAD_PARAMETER;
+        goto cleanup;
+    }
+
+    memcpy(key, parser->pos + 1, len);
+    parser->pos = end + 1;
+
+    *dbItem = swi_mangoh_data_router_db_getDataItem(parser->db, key);
+    if (!*dbItem)
+    {
+        *dbItem = swi_mangoh_data_router_db_createDataItem(parser->db, key);
+        if (!*dbItem)
+        {
+            LE_ERROR("ERROR swi_mangoh_data_router_db_createDataItem() failed");
+            res = LE_NO_MEMORY;
+            goto cleanup;
+        }
+    }
+
+cleanup:
+    return res;
+}
+
+static le_result_t swi_mangoh_data_router_rule_addKey
+(
+    swi_mangoh_data_router_ruleParser_t* parser,
+    swi_mangoh_data_router_dbItem_t* dbItem,
+    uint32_t* index
+)
+{
+    swi_mangoh_data_router_rule_t* rule = parser->rule;
+    le_result_t res = LE_OK;
+
+    for (*index = 0; *index < rule->numKeys; (*index)++)
+    {
+        if (rule->keys[*index] == dbItem)
+        {
+            goto cleanup;
+        }
+    }
+
+    if (rule->numKeys >= SWI_MANGOH_DATA_ROUTER_RULE_KEYS_MAX_NUM)
+    {
+        LE_ERROR("ERROR too many keys in the condition");
+        res = LE_BAD_PARAMETER;
+        goto cleanup;
+    }
+
+    rule->keys[rule->numKeys++] = dbItem;
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a number, true, false, a key, a key compared to a string, a negation or a condition in
+ * parentheses
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t swi_mangoh_data_router_rule_parsePrimary
+(
+    swi_mangoh_data_router_ruleParser_t* parser
+)
+{
+    swi_mangoh_data_router_rule_t* rule = parser->rule;
+    swi_mangoh_data_router_dbItem_t* dbItem = NULL;
+    le_result_t res = LE_BAD_PARAMETER;
+    char op = 0;
+    uint32_t index = 0;
+    double value = 0;
+
+    parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+    op = *parser->pos;
+    if ((op == '!') || (op == '-'))
+    {
+        parser->pos++;
+        res = swi_mangoh_data_router_rule_parsePrimary(parser);
+        if (res == LE_OK)
+        {
+            res = swi_mangoh_data_router_rule_emit(
+                parser,
+                (op == '!') ? SWI_MANGOH_DATA_ROUTER_RULE_OP_NOT :
+                             SWI_MANGOH_DATA_ROUTER_RULE_OP_NEG,
+                -1);
+        }
+    }
+    else if (op == '(')
+    {
+        parser->pos++;
+        res = swi_mangoh_data_router_rule_parseOr(parser);
+        if (res != LE_OK)
+        {
+            goto cleanup;
+        }
+
+        // The ')' is only consumed when present, the position stays within the condition
+        parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+        if (*parser->pos != ')')
+        {
+            LE_ERROR("ERROR expected ')' at '%s'", parser->pos);
+            res = LE_BAD_PARAMETER;
+            goto cleanup;
+        }
+        parser->pos++;
+    }
+    else if (op == '{')
+    {
+        res = swi_mangoh_data_router_rule_parseKey(parser, &dbItem);
+        if (res == LE_OK)
+        {
+            res = swi_mangoh_data_router_rule_addKey(parser, dbItem, &index);
+        }
+
+        const char* pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+        bool equals = ((pos[0] == '=') || (pos[0] == '!')) && (pos[1] == '=');
+        const char* str = equals ? swi_mangoh_data_router_text_skipSpaces(pos + 2) : pos;
+        if ((res == LE_OK) && equals && (*str == '"'))
+        {
+            // String comparison, folded into a single instruction
+            char buf[SWI_MANGOH_DATA_ROUTER_DATA_MAX_LEN] = {0};
+
+            if ((rule->numStrings >= SWI_MANGOH_DATA_ROUTER_RULE_STRINGS_MAX_NUM) ||
+                (swi_mangoh_data_router_text_scanString(str, &parser->pos, buf, sizeof(buf)) !=
+                 LE_OK))
+            {
+                LE_ERROR("ERROR invalid string at '%s'", str);
+                res = LE_BAD_PARAMETER;
+                goto cleanup;
+            }
+
+            rule->strings[rule->numStrings] = strdup(buf);
+            LE_ASSERT(rule->strings[rule->numStrings]);
+            res = swi_mangoh_data_router_rule_emit(
+                parser, SWI_MANGOH_DATA_ROUTER_RULE_OP_STREQ, (index << 4) | rule->numStrings);
+            rule->numStrings++;
+
+            if ((res == LE_OK) && (pos[0] == '!'))
+            {
+                res = swi_mangoh_data_router_rule_emit(
+                    parser, SWI_MANGOH_DATA_ROUTER_RULE_OP_NOT, -1);
+            }
+        }
+        else if (res == LE_OK)
+        {
+            res = swi_mangoh_data_router_rule_emit(
+                parser, SWI_MANGOH_DATA_ROUTER_RULE_OP_KEY, index);
+        }
+    }
+    else
+    {
+        if (!strncmp(parser->pos, "true", 4))
+        {
+            value = 1;
+            parser->pos += 4;
+            res = LE_OK;
+        }
+        else if (!strncmp(parser->pos, "false", 5))
+        {
+            parser->pos += 5;
+            res = LE_OK;
+        }
+        else if ((op >= '0') && (op <= '9'))
+        {
+            res = swi_mangoh_data_router_text_scanDouble(parser->pos, &parser->pos, &value);
+        }
+
+        if (res != LE_OK)
+        {
+            LE_ERROR("ERROR unexpected '%s'", parser->pos);
+            res = LE_BAD_PARAMETER;
+            goto cleanup;
+        }
+
+        if (rule->numConsts >= SWI_MANGOH_DATA_ROUTER_RULE_CONSTS_MAX_NUM)
+        {
+            LE_ERROR("ERROR too many constants in the condition");
+            res = LE_BAD_PARAMETER;
+            goto cleanup;
+        }
+
+        rule->consts[rule->numConsts] = value;
+        res = swi_mangoh_data_router_rule_emit(
+            parser, SWI_MANGOH_DATA_ROUTER_RULE_OP_CONST, rule->numConsts++);
+    }
+
+cleanup:
+    return res;
+}
+
+static le_result_t swi_mangoh_data_router_rule_parseTerm
+(
+    swi_mangoh_data_router_ruleParser_t* parser
+)
+{
+    le_result_t res = swi_mangoh_data_router_rule_parsePrimary(parser);
+
+    while (res == LE_OK)
+    {
+        parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+        char op = *parser->pos;
+        if ((op != '*') && (op != '/'))
+        {
+            break;
+        }
+
+        parser->pos++;
+        res = swi_mangoh_data_router_rule_parsePrimary(parser);
+        if (res == LE_OK)
+        {
+            res = swi_mangoh_data_router_rule_emit(
+                parser,
+                (op == '*') ? SWI_MANGOH_DATA_ROUTER_RULE_OP_MUL :
+                             SWI_MANGOH_DATA_ROUTER_RULE_OP_DIV,
+                -1);
+        }
+    }
+
+    return res;
+}
+
+static le_result_t swi_mangoh_data_router_rule_parseSum
+(
+    swi_mangoh_data_router_ruleParser_t* parser
+)
+{
+    le_result_t res = swi_mangoh_data_router_rule_parseTerm(parser);
+
+    while (res == LE_OK)
+    {
+        parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+        char op = *parser->pos;
+        if ((op != '+') && (op != '-'))
+        {
+            break;
+        }
+
+        parser->pos++;
+        res = swi_mangoh_data_router_rule_parseTerm(parser);
+        if (res == LE_OK)
+        {
+            res = swi_mangoh_data_router_rule_emit(
+                parser,
+                (op == '+') ? SWI_MANGOH_DATA_ROUTER_RULE_OP_ADD :
+                             SWI_MANGOH_DATA_ROUTER_RULE_OP_SUB,
+                -1);
+        }
+    }
+
+    return res;
+}
+
+static le_result_t swi_mangoh_data_router_rule_parseCompare
+(
+    swi_mangoh_data_router_ruleParser_t* parser
+)
+{
+    static const struct
+    {
+        const char* token;
+        swi_mangoh_data_router_ruleOp_e op;
+    } compares[] =
+    {
+        // Two character tokens first
+        { "==", SWI_MANGOH_DATA_ROUTER_RULE_OP_EQ },
+        { "!=", SWI_MANGOH_DATA_ROUTER_RULE_OP_NE },
+        { "<=", SWI_MANGOH_DATA_ROUTER_RULE_OP_LE },
+        { ">=", SWI_MANGOH_DATA_ROUTER_RULE_OP_GE },
+        { "<", SWI_MANGOH_DATA_ROUTER_RULE_OP_LT },
+        { ">", SWI_MANGOH_DATA_ROUTER_RULE_OP_GT },
+    };
+
+    le_result_t res = swi_mangoh_data_router_rule_parseSum(parser);
+    if (res != LE_OK)
+    {
+        goto cleanup;
+    }
+
+    parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+    for (uint32_t i = 0; i < NUM_ARRAY_MEMBERS(compares); i++)
+    {
+        size_t len = strlen(compares[i].token);
+        if (!strncmp(parser->pos, compares[i].token, len))
+        {
+            parser->pos += len;
+            res = swi_mangoh_data_router_rule_parseSum(parser);
+            if (res == LE_OK)
+            {
+                res = swi_mangoh_data_router_rule_emit(parser, compares[i].op, -1);
+            }
+            break;
+        }
+    }
+
+cleanup:
+    return res;
+}
+
+static le_result_t swi_mangoh_data_router_rule_parseAnd
+(
+    swi_mangoh_data_router_ruleParser_t* parser
+)
+{
+    le_result_t res = swi_mangoh_data_router_rule_parseCompare(parser);
+
+    while (res == LE_OK)
+    {
+        parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+        if (strncmp(parser->pos, "&&", 2))
+        {
+            break;
+        }
+
+        parser->pos += 2;
+        res = swi_mangoh_data_router_rule_parseCompare(parser);
+        if (res == LE_OK)
+        {
+            res = swi_mangoh_data_router_rule_emit(parser, SWI_MANGOH_DATA_ROUTER_RULE_OP_AND, -1);
+        }
+    }
+
+    return res;
+}
+
+static le_result_t swi_mangoh_data_router_rule_parseOr
+(
+    swi_mangoh_data_router_ruleParser_t* parser
+)
+{
+    le_result_t res = swi_mangoh_data_router_rule_parseAnd(parser);
+
+    while (res == LE_OK)
+    {
+        parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+        if (strncmp(parser->pos, "||", 2))
+        {
+            break;
+        }
+
+        parser->pos += 2;
+        res = swi_mangoh_data_router_rule_parseAnd(parser);
+        if (res == LE_OK)
+        {
+            res = swi_mangoh_data_router_rule_emit(parser, SWI_MANGOH_DATA_ROUTER_RULE_OP_OR, -1);
+        }
+    }
+
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse the "{key} = value" and "push {key}" actions, separated by ';'
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t swi_mangoh_data_router_rule_parseActions
+(
+    swi_mangoh_data_router_ruleParser_t* parser
+)
+{
+    swi_mangoh_data_router_ruleAction_t actions[SWI_MANGOH_DATA_ROUTER_RULE_ACTIONS_MAX_NUM];
+    swi_mangoh_data_router_rule_t* rule = parser->rule;
+    uint32_t numActions = 0;
+    le_result_t res = LE_OK;
+
+    memset(actions, 0, sizeof(actions));
+    parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+    while (*parser->pos)
+    {
+        swi_mangoh_data_router_ruleAction_t* action = &actions[numActions];
+
+        if (numActions >= SWI_MANGOH_DATA_ROUTER_RULE_ACTIONS_MAX_NUM)
+        {
+            LE_ERROR("ERROR too many actions");
+            res = LE_BAD_PARAMETER;
+            goto cleanup;
+        }
+
+        action->push = !strncmp(parser->pos,
+                                SWI_MANGOH_DATA_ROUTER_RULE_PUSH,
+                                strlen(SWI_MANGOH_DATA_ROUTER_RULE_PUSH));
+        if (action->push)
+        {
+            parser->pos = swi_mangoh_data_router_text_skipSpaces(
+                parser->pos + strlen(SWI_MANGOH_DATA_ROUTER_RULE_PUSH));
+        }
+
+        res = swi_mangoh_data_router_rule_parseKey(parser, &action->dbItem);
+        if (res != LE_OK)
+        {
+            goto cleanup;
+        }
+
+        parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos);
+        if (!action->push)
+        {
+            const char* end = NULL;
+
+            if (*parser->pos != '=')
+            {
+                LE_ERROR("ERROR expected '=' at '%s'", parser->pos);
+                res = LE_BAD_PARAMETER;
+                goto cleanup;
+            }
+
+            // The value type follows from its text, numbers are integers unless they have a
+            // fraction or an exponent
+            parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos + 1);
+            switch (*parser->pos)
+            {
+                case 't':
+                case 'f':
+                    action->value.type = DATAROUTER_BOOLEAN;
+                    break;
+
+                case '"':
+                    action->value.type = DATAROUTER_STRING;
+                    break;
+
+                default:
+                    action->value.type = DATAROUTER_INTEGER;
+                    if ((swi_mangoh_data_router_text_scanValue(
+                             parser->pos, &end, &action->value) != LE_OK) ||
+                        (*end == '.') || (*end == 'e') || (*end == 'E'))
+                    {
+                        action->value.type = DATAROUTER_FLOAT;
+                    }
+                    break;
+            }
+
+            if (swi_mangoh_data_router_text_scanValue(parser->pos, &end, &action->value) != LE_OK)
+            {
+                LE_ERROR("ERROR invalid value at '%s'", parser->pos);
+                res = LE_BAD_PARAMETER;
+                goto cleanup;
+            }
+            parser->pos = swi_mangoh_data_router_text_skipSpaces(end);
+        }
+
+        numActions++;
+        if (*parser->pos == ';')
+        {
+            parser->pos = swi_mangoh_data_router_text_skipSpaces(parser->pos + 1);
+        }
+        else if (*parser->pos)
+        {
+            LE_ERROR("ERROR expected ';' at '%s'", parser->pos);
+            res = LE_BAD_PARAMETER;
+            goto cleanup;
+        }
+    }
+
+    if (!numActions)
+    {
+        LE_ERROR("ERROR no actions");
+        res = LE_BAD_PARAMETER;
+        goto cleanup;
+    }
+
+    rule->actions = malloc(numActions * sizeof(swi_mangoh_data_router_ruleAction_t));
+    LE_ASSERT(rule->actions);
+    memcpy(rule->actions, actions, numActions * sizeof(swi_mangoh_data_router_ruleAction_t));
+    rule->numActions = numActions;
+
+cleanup:
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run the condition of a rule on the current values of its keys.  Keys without a number value
+ * are 0, and the condition is true when its value is finite and not 0.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool swi_mangoh_data_router_rule_run
+(
+    const swi_mangoh_data_router_rule_t* rule
+)
+{
+    double stack[SWI_MANGOH_DATA_ROUTER_RULE_STACK_MAX_NUM];
+    uint32_t depth = 0;
+
+    for (uint32_t pc = 0; pc < rule->codeLen; pc++)
+    {
+        const swi_mangoh_data_router_data_t* data = NULL;
+        double a = 0;
+        double b = 0;
+
+        switch (rule->code[pc])
+        {
+            case SWI_MANGOH_DATA_ROUTER_RULE_OP_KEY:
+                data = &rule->keys[rule->code[++pc]]->data;
+                switch (data->type)
+                {
+                    case DATAROUTER_BOOLEAN:
+                        a = data->bValue;
+                        break;
+
+                    case DATAROUTER_INTEGER:
+                        a = data->iValue;
+                        break;
+
+                    case DATAROUTER_FLOAT:
+                        a = data->fValue;
+                        break;
+
+                    default:
+                        break;
+                }
+                stack[depth++] = a;
+                break;
+
+            case SWI_MANGOH_DATA_ROUTER_RULE_OP_CONST:
+                stack[depth++] = rule->consts[rule->code[++pc]];
+                break;
+
+            case SWI_MANGOH_DATA_ROUTER_RULE_OP_STREQ:
+                pc++;
+                data = &rule->keys[rule->code[pc] >> 4]->data;
+                stack[depth++] = (data->type == DATAROUTER_STRING) &&
+                                 !strcmp(data->sValue, rule->strings[rule->code[pc] & 0x0f]);
+                break;
+
+            case SWI_MANGOH_DATA_ROUTER_RULE_OP_NOT:
+                stack[depth - 1] = !stack[depth - 1];
+                break;
+
+            case SWI_MANGOH_DATA_ROUTER_RULE_OP_NEG:
+                stack[depth - 1] = -stack[depth - 1];
+                break;
+
+            default:
+                b = stack[--depth];
+                a = stack[depth - 1];
+                switch (rule->code[pc])
+                {
+                    case SWI_MANGOH_DATA_ROUTER_RULE_OP_AND:
+                        a = a && b;
+                        break;
+
+                    case SWI_MANGOH_DATA_ROUTER_RULE_OP_OR:
+                        a = a || b;
+                        break;
+
+                    case SWI_MANGOH_DATA_ROUTER_RULE_OP_EQ:
+                        a = (a == b);
+                        break;
+
+                    case SWI_MANGOH_DATA_ROUTER_RULE_OP_NE:
+                        a = (a != b);
+                        break;
+
+                    case SWI_MANGOH_DATA_ROUTER_RULE_OP_LT:
+                        a = (a < b);
+                        break;
+
+                    case SWI_MANGOH_DATA_ROUTER_RULE_OP_LE:
+                        a = (a <= b);
+                        break;
+
+                    case SWI_MANGOH_DATA_ROUTER_RULE_OP_GT:
+                        a = (a > b);
+                        break;
+
+                    case SWI_MANGOH_DATA_ROUTER_RULE_OP_GE:
+                        a = (a >= b);
+                        break;
+
+                    case SWI_MANGOH_DATA_ROUTER_RULE_OP_ADD:
+                        a += b;
+                        break;
+
+                    case SWI_MANGOH_DATA_ROUTER_RULE_OP_SUB:
+                        a -= b;
+                        break;
+
+                    case SWI_MANGOH_DATA_ROUTER_RULE_OP_MUL:
+                        a *= b;
+                        break;
+
+                    default:
+                        a /= b;
+                        break;
+                }
+                stack[depth - 1] = a;
+                break;
+        }
+    }
+
+    return (depth == 1) && isfinite(stack[0]) && (stack[0] != 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unlink a rule from the index, the rules and the pending lists and free it
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_rule_free
+(
+    swi_mangoh_data_router_rules_t* rules,
+    swi_mangoh_data_router_rule_t* rule
+)
+{
+    for (uint32_t i = 0; i < rule->numKeys; i++)
+    {
+        swi_mangoh_data_router_ruleRef_t** ref = &rule->keys[i]->rules;
+        while (*ref)
+        {
+            if ((*ref)->rule == rule)
+            {
+                swi_mangoh_data_router_ruleRef_t* next = (*ref)->next;
+                free(*ref);
+                *ref = next;
+                break;
+            }
+
+            ref = &(*ref)->next;
+        }
+    }
+
+    if (le_dls_IsInList(&rules->rules, &rule->link))
+    {
+        le_dls_Remove(&rules->rules, &rule->link);
+        rules->numRules--;
+    }
+
+    if (rule->pending)
+    {
+        le_dls_Remove(&rules->pending, &rule->pendingLink);
+    }
+
+    for (uint32_t i = 0; i < rule->numStrings; i++)
+    {
+        free(rule->strings[i]);
+    }
+
+    free(rule->actions);
+    free(rule);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run the actions of the rules fired since the last pass, queued to the event loop by the first
+ * rule fired
+ */
+//--------------------------------------------------------------------------------------------------
+static void swi_mangoh_data_router_rules_runActions
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    swi_mangoh_data_router_rules_t* rules = (swi_mangoh_data_router_rules_t*)param1Ptr;
+    LE_ASSERT(rules);
+
+    // Rules fired by the writes of these actions run in the next pass, one deeper in the chain
+    le_dls_List_t fired = rules->pending;
+    rules->pending = LE_DLS_LIST_INIT;
+    rules->scheduled = false;
+    rules->depth = rules->pendingDepth;
+    rules->pendingDepth = 0;
+
+    le_dls_Link_t* link = le_dls_Pop(&fired);
+    while (link)
+    {
+        swi_mangoh_data_router_rule_t* rule =
+            CONTAINER_OF(link, swi_mangoh_data_router_rule_t, pendingLink);
+
+        rule->pending = false;
+        rule->numFired++;
+        LE_DEBUG("rule('%s') fired(%u)", rule->name, rule->numFired);
+        for (uint32_t i = 0; i < rule->numActions; i++)
+        {
+            rules->handler(rule->owner, &rule->actions[i]);
+        }
+
+        link = le_dls_Pop(&fired);
+    }
+
+    rules->depth = 0;
+}
+
+void swi_mangoh_data_router_rules_init
+(
+    swi_mangoh_data_router_rules_t* rules,
+    swi_mangoh_data_router_db_t* db,
+    swi_mangoh_data_router_ruleHandler_t handler
+)
+{
+    LE_ASSERT(rules);
+    LE_ASSERT(db);
+    LE_ASSERT(handler);
+
+    memset(rules, 0, sizeof(swi_mangoh_data_router_rules_t));
+    rules->db = db;
+    rules->handler = handler;
+    rules->rules = LE_DLS_LIST_INIT;
+    rules->pending = LE_DLS_LIST_INIT;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compile a rule and index it by the keys of its condition.  The rule fires on the first update
+ * making its condition true, not when the condition is already true.
+ *
+ * @return
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the name, the condition or the actions are invalid
+ *      - LE_DUPLICATE if a rule has the name
+ *      - LE_NO_MEMORY if there are too many rules or a key could not be created
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t swi_mangoh_data_router_rules_add
+(
+    swi_mangoh_data_router_rules_t* rules,
+    void* owner,
+    const char* name,
+    const char* condition,
+    const char* actions
+)
+{
+    LE_ASSERT(rules);
+    LE_ASSERT(name);
+    LE_ASSERT(condition);
+    LE_ASSERT(actions);
+
+    swi_mangoh_data_router_rule_t* rule = NULL;
+    le_result_t res = LE_OK;
+
+    if (!*name || (strlen(name) >= SWI_MANGOH_DATA_ROUTER_RULE_NAME_MAX_LEN))
+    {
+        LE_ERROR("ERROR invalid rule name('%s')", name);
+        res = LE_BAD_PARAMETER;
+        goto cleanup;
+    }
+
+    if (rules->numRules >= SWI_MANGOH_DATA_ROUTER_RULES_MAX_NUM)
+    {
+        LE_ERROR("ERROR too many rules");
+        res = LE_NO_MEMORY;
+        goto cleanup;
+    }
+
+    for (le_dls_Link_t* link = le_dls_Peek(&rules->rules); link;
+         link = le_dls_PeekNext(&rules->rules, link))
+    {
+        if (!strcmp(CONTAINER_OF(link, swi_mangoh_data_router_rule_t, link)->name, name))
+        {
+            LE_ERROR("ERROR rule('%s') exists", name);
+            res = LE_DUPLICATE;
+            goto cleanup;
+        }
+    }
+
+    rule = calloc(1, sizeof(swi_mangoh_data_router_rule_t));
+    LE_ASSERT(rule);
+    strncpy(rule->name, name, sizeof(rule->name) - 1);
+    rule->owner = owner;
+    rule->link = LE_DLS_LINK_INIT;
+    rule->pendingLink = LE_DLS_LINK_INIT;
+
+    swi_mangoh_data_router_ruleParser_t parser = { rules->db, rule, condition, 0 };
+    res = swi_mangoh_data_router_rule_parseOr(&parser);
+    if ((res == LE_OK) && *swi_mangoh_data_router_text_skipSpaces(parser.pos))
+    {
+        LE_ERROR("ERROR unexpected '%s'", parser.pos);
+        res = LE_BAD_PARAMETER;
+    }
+
+    if (res == LE_OK)
+    {
+        parser.pos = actions;
+        res = swi_mangoh_data_router_rule_parseActions(&parser);
+    }
+
+    if (res != LE_OK)
+    {
+        goto cleanup;
+    }
+
+    for (uint32_t i = 0; i < rule->numKeys; i++)
+    {
+        swi_mangoh_data_router_ruleRef_t* ref = malloc(sizeof(swi_mangoh_data_router_ruleRef_t));
+        LE_ASSERT(ref);
+        ref->rule = rule;
+        ref->next = rule->keys[i]->rules;
+        rule->keys[i]->rules = ref;
+    }
+
+    rule->active = swi_mangoh_data_router_rule_run(rule);
+    le_dls_Queue(&rules->rules, &rule->link);
+    rules->numRules++;
+    LE_INFO(
+        "rule('%s') keys(%u) code(%u) actions(%u)",
+        name,
+        rule->numKeys,
+        rule->codeLen,
+        rule->numActions);
+    rule = NULL;
+
+cleanup:
+    if (rule)
+    {
+        swi_mangoh_data_router_rule_free(rules, rule);
+    }
+
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a rule of an owner
+ *
+ * @return
+ *      - LE_OK on success
+ *      - LE_NOT_FOUND if the owner has no rule with the name
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t swi_mangoh_data_router_rules_remove
+(
+    swi_mangoh_data_router_rules_t* rules,
+    void* owner,
+    const char* name
+)
+{
+    LE_ASSERT(rules);
+    LE_ASSERT(name);
+
+    le_result_t res = LE_NOT_FOUND;
+
+    for (le_dls_Link_t* link = le_dls_Peek(&rules->rules); link;
+         link = le_dls_PeekNext(&rules->rules, link))
+    {
+        swi_mangoh_data_router_rule_t* rule =
+            CONTAINER_OF(link, swi_mangoh_data_router_rule_t, link);
+        if ((rule->owner == owner) && !strcmp(rule->name, name))
+        {
+            swi_mangoh_data_router_rule_free(rules, rule);
+            res = LE_OK;
+            break;
+        }
+    }
+
+    return res;
+}
+
+void swi_mangoh_data_router_rules_removeOwner
+(
+    swi_mangoh_data_router_rules_t* rules,
+    void* owner
+)
+{
+    LE_ASSERT(rules);
+
+    le_dls_Link_t* link = le_dls_Peek(&rules->rules);
+    while (link)
+    {
+        swi_mangoh_data_router_rule_t* rule =
+            CONTAINER_OF(link, swi_mangoh_data_router_rule_t, link);
+
+        link = le_dls_PeekNext(&rules->rules, link);
+        if (rule->owner == owner)
+        {
+            swi_mangoh_data_router_rule_free(rules, rule);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Evaluate the rules of an updated item, and queue the actions of those becoming true.  A rule
+ * fired by an action too deep in a chain of rules is dropped.
+ */
+//--------------------------------------------------------------------------------------------------
+void swi_mangoh_data_router_rules_update
+(
+    swi_mangoh_data_router_rules_t* rules,
+    const swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    uint32_t depth = rules->depth + 1;
+
+    for (swi_mangoh_data_router_ruleRef_t* ref = dbItem->rules; ref; ref = ref->next)
+    {
+        swi_mangoh_data_router_rule_t* rule = ref->rule;
+        bool active = swi_mangoh_data_router_rule_run(rule);
+
+        if (active && !rule->active && !rule->pending)
+        {
+            if (depth > SWI_MANGOH_DATA_ROUTER_RULE_CHAIN_MAX_NUM)
+            {
+                LE_WARN("rule('%s') dropped, chained %u times", rule->name, rules->depth);
+            }
+            else
+            {
+                rule->pending = true;
+                if (depth > rules->pendingDepth)
+                {
+                    rules->pendingDepth = depth;
+                }
+                le_dls_Queue(&rules->pending, &rule->pendingLink);
+                if (!rules->scheduled)
+                {
+                    rules->scheduled = true;
+                    le_event_QueueFunction(swi_mangoh_data_router_rules_runActions, rules, NULL);
+                }
+            }
+        }
+
+        rule->active = active;
+    }
+}
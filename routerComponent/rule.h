@@ -0,0 +1,158 @@
+/*
+ * @file rule.h
+ *
+ * Data router module.
+ *
+ * This module runs the local automation rules of the mangOH data router.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_RULE_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_RULE_INCLUDE_GUARD
+
+#define SWI_MANGOH_DATA_ROUTER_RULES_MAX_NUM 4096
+#define SWI_MANGOH_DATA_ROUTER_RULE_NAME_MAX_LEN 64
+#define SWI_MANGOH_DATA_ROUTER_RULE_CODE_MAX_LEN 64
+#define SWI_MANGOH_DATA_ROUTER_RULE_KEYS_MAX_NUM 8
+#define SWI_MANGOH_DATA_ROUTER_RULE_CONSTS_MAX_NUM 8
+#define SWI_MANGOH_DATA_ROUTER_RULE_STRINGS_MAX_NUM 2
+#define SWI_MANGOH_DATA_ROUTER_RULE_ACTIONS_MAX_NUM 8
+#define SWI_MANGOH_DATA_ROUTER_RULE_STACK_MAX_NUM 16
+#define SWI_MANGOH_DATA_ROUTER_RULE_CHAIN_MAX_NUM 16
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router rule condition bytecode.  KEY, CONST and STREQ are followed by one operand byte, the
+ * index of a key, a constant or a key (high nibble) and a string (low nibble).
+ */
+//-------------------------------------------------------------------------------------------------
+typedef enum _swi_mangoh_data_router_ruleOp_e
+{
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_KEY = 0,   ///< Push the number value of a key
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_CONST,     ///< Push a constant
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_STREQ,     ///< Push whether a key holds a string
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_NOT,
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_NEG,
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_AND,
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_OR,
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_EQ,
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_NE,
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_LT,
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_LE,
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_GT,
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_GE,
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_ADD,
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_SUB,
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_MUL,
+    SWI_MANGOH_DATA_ROUTER_RULE_OP_DIV,
+} swi_mangoh_data_router_ruleOp_e;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router rule action, writing a value to a key or pushing the current value of a key
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_ruleAction_t
+{
+    bool push;                               ///< Push the key value, write otherwise
+    swi_mangoh_data_router_dbItem_t* dbItem; ///< Key written or pushed
+    swi_mangoh_data_router_data_t value;     ///< Value written
+} swi_mangoh_data_router_ruleAction_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router rule.  The actions run when the condition becomes true, not again until it has
+ * been false.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_rule_t
+{
+    char name[SWI_MANGOH_DATA_ROUTER_RULE_NAME_MAX_LEN]; ///< Rule name
+    void* owner;                                        ///< Session the rule acts for
+    uint8_t code[SWI_MANGOH_DATA_ROUTER_RULE_CODE_MAX_LEN]; ///< Condition bytecode
+    uint32_t codeLen;                                   ///< Condition bytecode length
+    swi_mangoh_data_router_dbItem_t* keys[SWI_MANGOH_DATA_ROUTER_RULE_KEYS_MAX_NUM];
+                                                        ///< Keys of the condition
+    uint32_t numKeys;                                   ///< Number of keys
+    double consts[SWI_MANGOH_DATA_ROUTER_RULE_CONSTS_MAX_NUM]; ///< Constants of the condition
+    uint32_t numConsts;                                 ///< Number of constants
+    char* strings[SWI_MANGOH_DATA_ROUTER_RULE_STRINGS_MAX_NUM]; ///< Strings of the condition
+    uint32_t numStrings;                                ///< Number of strings
+    swi_mangoh_data_router_ruleAction_t* actions;       ///< Actions
+    uint32_t numActions;                                ///< Number of actions
+    bool active;                                        ///< Condition true at the last update
+    bool pending;                                       ///< Actions waiting to run
+    uint32_t numFired;                                  ///< Times the actions ran
+    le_dls_Link_t link;                                 ///< Rules list link
+    le_dls_Link_t pendingLink;                          ///< Pending rules list link
+} swi_mangoh_data_router_rule_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router rule index entry, linking a key to a rule referencing it in its condition
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_ruleRef_t
+{
+    swi_mangoh_data_router_rule_t* rule;           ///< Rule
+    struct _swi_mangoh_data_router_ruleRef_t* next; ///< Next rule of the key
+} swi_mangoh_data_router_ruleRef_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router rule action handler, called with the owner of the rule
+ */
+//-------------------------------------------------------------------------------------------------
+typedef void (*swi_mangoh_data_router_ruleHandler_t)(
+    void*,
+    const swi_mangoh_data_router_ruleAction_t*);
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router rules.  The rules are indexed by the keys of their conditions, an update only
+ * evaluates the rules of its key.  The actions of the fired rules run from the event loop, after
+ * the current request or batch, so that rules writing keys of other rules do not recurse.  A
+ * chain of rules fired by the actions of other rules is cut after
+ * SWI_MANGOH_DATA_ROUTER_RULE_CHAIN_MAX_NUM passes, so that rules undoing each other's writes do
+ * not keep the event loop busy.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_rules_t
+{
+    swi_mangoh_data_router_db_t* db;              ///< Database module
+    swi_mangoh_data_router_ruleHandler_t handler; ///< Action handler
+    le_dls_List_t rules;                          ///< Rules :: swi_mangoh_data_router_rule_t
+    uint32_t numRules;                            ///< Number of rules
+    le_dls_List_t pending;                        ///< Fired rules :: swi_mangoh_data_router_rule_t
+    bool scheduled;                               ///< Actions pass queued
+    uint32_t depth;                               ///< Chain depth of the running pass, 0 if none
+    uint32_t pendingDepth;                        ///< Chain depth of the queued pass
+} swi_mangoh_data_router_rules_t;
+
+void swi_mangoh_data_router_rules_init(
+    swi_mangoh_data_router_rules_t*,
+    swi_mangoh_data_router_db_t*,
+    swi_mangoh_data_router_ruleHandler_t);
+le_result_t swi_mangoh_data_router_rules_add(
+    swi_mangoh_data_router_rules_t*,
+    void*,
+    const char*,
+    const char*,
+    const char*);
+le_result_t swi_mangoh_data_router_rules_remove(
+    swi_mangoh_data_router_rules_t*,
+    void*,
+    const char*);
+void swi_mangoh_data_router_rules_removeOwner(swi_mangoh_data_router_rules_t*, void*);
+void swi_mangoh_data_router_rules_update(
+    swi_mangoh_data_router_rules_t*,
+    const swi_mangoh_data_router_dbItem_t*);
+
+#endif
@@ -0,0 +1,423 @@
+/**
+ * @file
+ *
+ * The sink pushes the updates to a local file or to a Unix stream socket server instead of the
+ * MQTT broker, so the push path can be exercised and measured on a plain Linux host.  The socket
+ * is connected when the first session starts and reconnected on the flush timer when the server
+ * goes away.  Writes never block: what the file or the socket does not take stays queued.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "sink.h"
+
+static size_t swi_mangoh_data_router_sink_formatLine(
+    const char*,
+    const swi_mangoh_data_router_data_t*,
+    char*,
+    size_t);
+static le_result_t swi_mangoh_data_router_sink_queueLine(
+    swi_mangoh_data_router_sink_t*,
+    const char*,
+    size_t);
+static void swi_mangoh_data_router_sink_open(swi_mangoh_data_router_sink_t*);
+static void swi_mangoh_data_router_sink_close(swi_mangoh_data_router_sink_t*);
+static void swi_mangoh_data_router_sink_flush(void*);
+static void swi_mangoh_data_router_sink_flushTimerHandler(le_timer_Ref_t);
+static void* swi_mangoh_data_router_sink_start(
+    void*,
+    const char*,
+    const char*,
+    const char*,
+    swi_mangoh_data_router_db_t*);
+static le_result_t swi_mangoh_data_router_sink_write(
+    void*,
+    const char*,
+    const swi_mangoh_data_router_dbItem_t*);
+static void swi_mangoh_data_router_sink_writeBatch(
+    void*,
+    const char*,
+    const swi_mangoh_data_router_dbItem_t*,
+    const double*,
+    const uint32_t*,
+    size_t);
+static uint32_t swi_mangoh_data_router_sink_getFill(void*);
+static void swi_mangoh_data_router_sink_end(void*);
+
+const swi_mangoh_data_router_transportOps_t swi_mangoh_data_router_sinkTransportOps = {
+    .start      = swi_mangoh_data_router_sink_start,
+    .write      = swi_mangoh_data_router_sink_write,
+    .writeBatch = swi_mangoh_data_router_sink_writeBatch,
+    .flush      = swi_mangoh_data_router_sink_flush,
+    .getFill    = swi_mangoh_data_router_sink_getFill,
+    .end        = swi_mangoh_data_router_sink_end,
+};
+
+// Returns the line length including the '\n', or 0 when the line is too long
+static size_t swi_mangoh_data_router_sink_formatLine
+(
+    const char* key,
+    const swi_mangoh_data_router_data_t* data,
+    char* line,
+    size_t len
+)
+{
+    swi_mangoh_data_router_text_t text;
+
+    swi_mangoh_data_router_text_init(&text, line, len);
+    swi_mangoh_data_router_text_encodeRaw(&text, "{\"key\":");
+    swi_mangoh_data_router_text_encodeString(&text, key);
+    swi_mangoh_data_router_text_encodeRaw(&text, ",\"timestamp\":");
+    swi_mangoh_data_router_text_encodeUint(&text, data->timestamp);
+    swi_mangoh_data_router_text_encodeRaw(&text, ",\"value\":");
+    swi_mangoh_data_router_text_encodeValue(&text, data);
+    swi_mangoh_data_router_text_encodeRaw(&text, "}\n");
+
+    return swi_mangoh_data_router_text_isValid(&text) ? text.used : 0;
+}
+
+static le_result_t swi_mangoh_data_router_sink_queueLine
+(
+    swi_mangoh_data_router_sink_t* sink,
+    const char* line,
+    size_t len
+)
+{
+    le_result_t res = LE_OK;
+
+    if (sink->queueLen + len > sink->queueBytes)
+    {
+        res = LE_OVERFLOW;
+        // Logged on the first drop and then each time the number of drops doubles
+        sink->numDropped++;
+        if (!(sink->numDropped & (sink->numDropped - 1)))
+        {
+            LE_WARN("sink('%s') queue full, dropped(%u)", sink->path, sink->numDropped);
+        }
+        goto cleanup;
+    }
+
+    memcpy(&sink->queue[sink->queueLen], line, len);
+    sink->queueLen += len;
+    sink->numWritten++;
+
+    if (sink->queueLen > sink->flushBytes)
+    {
+        swi_mangoh_data_router_sink_flush(sink);
+    }
+
+cleanup:
+    return res;
+}
+
+static void swi_mangoh_data_router_sink_open
+(
+    swi_mangoh_data_router_sink_t* sink
+)
+{
+    if (sink->type == SWI_MANGOH_DATA_ROUTER_SINK_TYPE_FILE)
+    {
+        sink->fd = open(
+            sink->path,
+            O_WRONLY | O_CREAT | O_APPEND | O_NONBLOCK | O_CLOEXEC,
+            S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (sink->fd < 0)
+        {
+            LE_ERROR("ERROR open('%s') failed(%d)", sink->path, errno);
+        }
+        goto cleanup;
+    }
+
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    LE_ASSERT(strlen(sink->path) < sizeof(addr.sun_path));
+    strcpy(addr.sun_path, sink->path);
+
+    sink->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sink->fd < 0)
+    {
+        LE_ERROR("ERROR socket() failed(%d)", errno);
+        goto cleanup;
+    }
+
+    // Unix socket connects complete or fail right away
+    if (connect(sink->fd, (struct sockaddr*)&addr, sizeof(addr)))
+    {
+        LE_DEBUG("connect('%s') failed(%d)", sink->path, errno);
+        close(sink->fd);
+        sink->fd = -1;
+        goto cleanup;
+    }
+
+    LE_INFO("sink connected('%s')", sink->path);
+
+cleanup:
+    return;
+}
+
+static void swi_mangoh_data_router_sink_close
+(
+    swi_mangoh_data_router_sink_t* sink
+)
+{
+    if (sink->fd >= 0)
+    {
+        close(sink->fd);
+        sink->fd = -1;
+    }
+}
+
+static void swi_mangoh_data_router_sink_flush
+(
+    void* context
+)
+{
+    swi_mangoh_data_router_sink_t* sink = (swi_mangoh_data_router_sink_t*)context;
+    size_t written = 0;
+
+    LE_ASSERT(sink);
+
+    if (!sink->queueLen)
+    {
+        goto cleanup;
+    }
+
+    if (sink->fd < 0)
+    {
+        swi_mangoh_data_router_sink_open(sink);
+        if (sink->fd < 0)
+        {
+            goto cleanup;
+        }
+    }
+
+    while (written < sink->queueLen)
+    {
+        ssize_t len = (sink->type == SWI_MANGOH_DATA_ROUTER_SINK_TYPE_SOCKET) ?
+            send(sink->fd, &sink->queue[written], sink->queueLen - written, MSG_NOSIGNAL) :
+            write(sink->fd, &sink->queue[written], sink->queueLen - written);
+        if (len > 0)
+        {
+            written += len;
+        }
+        else if ((len < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+        else if ((len < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+        {
+            break;
+        }
+        else
+        {
+            // The queue is written again once reopened, a line may be written twice
+            LE_WARN("sink('%s') write failed(%d)", sink->path, errno);
+            swi_mangoh_data_router_sink_close(sink);
+            break;
+        }
+    }
+
+    // The unwritten lines are moved to the front of the queue
+    memmove(sink->queue, &sink->queue[written], sink->queueLen - written);
+    sink->queueLen -= written;
+
+cleanup:
+    return;
+}
+
+static void swi_mangoh_data_router_sink_flushTimerHandler
+(
+    le_timer_Ref_t timer
+)
+{
+    swi_mangoh_data_router_sink_flush(le_timer_GetContextPtr(timer));
+}
+
+void swi_mangoh_data_router_sink_init
+(
+    swi_mangoh_data_router_sink_t* sink,
+    swi_mangoh_data_router_sink_type_e type
+)
+{
+    LE_ASSERT(sink);
+
+    memset(sink, 0, sizeof(swi_mangoh_data_router_sink_t));
+    sink->type = type;
+    sink->fd = -1;
+}
+
+static void* swi_mangoh_data_router_sink_start
+(
+    void* context,
+    const char* appId,
+    const char* url,
+    const char* password,
+    swi_mangoh_data_router_db_t* db
+)
+{
+    swi_mangoh_data_router_sink_t* sink = (swi_mangoh_data_router_sink_t*)context;
+
+    LE_ASSERT(sink);
+
+    if (sink->numSessions++)
+    {
+        goto cleanup;
+    }
+
+    le_result_t res = le_cfg_QuickGetString(
+        (sink->type == SWI_MANGOH_DATA_ROUTER_SINK_TYPE_SOCKET) ?
+            SWI_MANGOH_DATA_ROUTER_SINK_CFG_SOCKET_PATH : SWI_MANGOH_DATA_ROUTER_SINK_CFG_FILE_PATH,
+        sink->path,
+        sizeof(sink->path),
+        (sink->type == SWI_MANGOH_DATA_ROUTER_SINK_TYPE_SOCKET) ?
+            SWI_MANGOH_DATA_ROUTER_SINK_SOCKET_PATH : SWI_MANGOH_DATA_ROUTER_SINK_FILE_PATH);
+    if (res != LE_OK)
+    {
+        LE_ERROR("ERROR le_cfg_QuickGetString() failed(%d)", res);
+        sink->numSessions--;
+        sink = NULL;
+        goto cleanup;
+    }
+
+    int32_t queueBytes = le_cfg_QuickGetInt(
+        SWI_MANGOH_DATA_ROUTER_SINK_CFG_QUEUE_BYTES, SWI_MANGOH_DATA_ROUTER_SINK_QUEUE_BYTES);
+    if (queueBytes < SWI_MANGOH_DATA_ROUTER_SINK_LINE_MAX_LEN)
+    {
+        LE_WARN("invalid sink queue bytes(%d)", queueBytes);
+        queueBytes = SWI_MANGOH_DATA_ROUTER_SINK_QUEUE_BYTES;
+    }
+
+    sink->queueBytes = queueBytes;
+    sink->queueLen = 0;
+    sink->queue = malloc(sink->queueBytes);
+    LE_ASSERT(sink->queue);
+
+    int32_t flushBytes = le_cfg_QuickGetInt(
+        SWI_MANGOH_DATA_ROUTER_SINK_CFG_FLUSH_BYTES, SWI_MANGOH_DATA_ROUTER_SINK_FLUSH_BYTES);
+    sink->flushBytes = (flushBytes > 0) ? (size_t)flushBytes : 0;
+    sink->numWritten = 0;
+    sink->numDropped = 0;
+
+    sink->flushTimer = le_timer_Create("DataRouterSinkFlush");
+    le_timer_SetMsInterval(sink->flushTimer, SWI_MANGOH_DATA_ROUTER_SINK_FLUSH_INTERVAL_MS);
+    le_timer_SetRepeat(sink->flushTimer, 0);
+    le_timer_SetContextPtr(sink->flushTimer, sink);
+    le_timer_SetHandler(sink->flushTimer, swi_mangoh_data_router_sink_flushTimerHandler);
+    le_timer_Start(sink->flushTimer);
+
+    LE_DEBUG(
+        "sink('%s') queue bytes(%zu), flush bytes(%zu)",
+        sink->path,
+        sink->queueBytes,
+        sink->flushBytes);
+    swi_mangoh_data_router_sink_open(sink);
+
+cleanup:
+    return sink;
+}
+
+static le_result_t swi_mangoh_data_router_sink_write
+(
+    void* client,
+    const char* key,
+    const swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    swi_mangoh_data_router_sink_t* sink = (swi_mangoh_data_router_sink_t*)client;
+    char line[SWI_MANGOH_DATA_ROUTER_SINK_LINE_MAX_LEN];
+    le_result_t res = LE_OK;
+
+    size_t len = swi_mangoh_data_router_sink_formatLine(key, &dbItem->data, line, sizeof(line));
+    if (!len)
+    {
+        LE_ERROR("ERROR key('%s') line too long", key);
+        res = LE_FAULT;
+        goto cleanup;
+    }
+
+    res = swi_mangoh_data_router_sink_queueLine(sink, line, len);
+
+cleanup:
+    return res;
+}
+
+static void swi_mangoh_data_router_sink_writeBatch
+(
+    void* client,
+    const char* key,
+    const swi_mangoh_data_router_dbItem_t* dbItem,
+    const double* values,
+    const uint32_t* timestamps,
+    size_t numSamples
+)
+{
+    swi_mangoh_data_router_sink_t* sink = (swi_mangoh_data_router_sink_t*)client;
+    char line[SWI_MANGOH_DATA_ROUTER_SINK_LINE_MAX_LEN];
+
+    // Each sample is a line with its own timestamp
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        swi_mangoh_data_router_data_t data = { .type = DATAROUTER_FLOAT };
+
+        data.fValue = values[i];
+        data.timestamp = timestamps[i];
+
+        size_t len = swi_mangoh_data_router_sink_formatLine(key, &data, line, sizeof(line));
+        if (len)
+        {
+            swi_mangoh_data_router_sink_queueLine(sink, line, len);
+        }
+    }
+}
+
+static uint32_t swi_mangoh_data_router_sink_getFill
+(
+    void* context
+)
+{
+    swi_mangoh_data_router_sink_t* sink = (swi_mangoh_data_router_sink_t*)context;
+
+    return sink->queueBytes ? (uint64_t)sink->queueLen * 100 / sink->queueBytes : 0;
+}
+
+static void swi_mangoh_data_router_sink_end
+(
+    void* client
+)
+{
+    swi_mangoh_data_router_sink_t* sink = (swi_mangoh_data_router_sink_t*)client;
+
+    LE_ASSERT(sink->numSessions);
+    if (--sink->numSessions)
+    {
+        goto cleanup;
+    }
+
+    swi_mangoh_data_router_sink_flush(sink);
+    LE_INFO(
+        "sink('%s') written(%llu), dropped(%u), not written(%zu bytes)",
+        sink->path,
+        (unsigned long long)sink->numWritten,
+        sink->numDropped,
+        sink->queueLen);
+
+    le_timer_Delete(sink->flushTimer);
+    sink->flushTimer = NULL;
+    swi_mangoh_data_router_sink_close(sink);
+    free(sink->queue);
+    sink->queue = NULL;
+    sink->queueLen = 0;
+
+cleanup:
+    return;
+}
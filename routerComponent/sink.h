@@ -0,0 +1,73 @@
+/*
+ * @file sink.h
+ *
+ * Data router module.
+ *
+ * This module is the local file and Unix socket sink transport of the mangOH data router pushes.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+#include "text.h"
+#include "transport.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_SINK_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_SINK_INCLUDE_GUARD
+
+#define SWI_MANGOH_DATA_ROUTER_SINK_FILE_NAME "file"
+#define SWI_MANGOH_DATA_ROUTER_SINK_SOCKET_NAME "socket"
+
+#define SWI_MANGOH_DATA_ROUTER_SINK_PATH_LEN 108
+#define SWI_MANGOH_DATA_ROUTER_SINK_LINE_MAX_LEN 512
+#define SWI_MANGOH_DATA_ROUTER_SINK_FLUSH_INTERVAL_MS 100
+
+#define SWI_MANGOH_DATA_ROUTER_SINK_CFG_FILE_PATH "/Sink/filePath"
+#define SWI_MANGOH_DATA_ROUTER_SINK_CFG_SOCKET_PATH "/Sink/socketPath"
+#define SWI_MANGOH_DATA_ROUTER_SINK_CFG_QUEUE_BYTES "/Sink/queueBytes"
+#define SWI_MANGOH_DATA_ROUTER_SINK_CFG_FLUSH_BYTES "/Sink/flushBytes"
+
+#define SWI_MANGOH_DATA_ROUTER_SINK_FILE_PATH "/tmp/dataRouter.sink"
+#define SWI_MANGOH_DATA_ROUTER_SINK_SOCKET_PATH "/tmp/dataRouter.sock"
+#define SWI_MANGOH_DATA_ROUTER_SINK_QUEUE_BYTES 65536
+#define SWI_MANGOH_DATA_ROUTER_SINK_FLUSH_BYTES 0
+
+typedef enum _swi_mangoh_data_router_sink_type_e {
+    SWI_MANGOH_DATA_ROUTER_SINK_TYPE_FILE = 0,   ///< Appended to a file
+    SWI_MANGOH_DATA_ROUTER_SINK_TYPE_SOCKET,     ///< Sent to a Unix stream socket server
+} swi_mangoh_data_router_sink_type_e;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router sink.  Updates are written as JSON lines {"key":..,"timestamp":..,"value":..}
+ * through a queue, which is written once it holds the flush bytes and periodically, and which
+ * drops the updates that do not fit while the file or the socket server cannot keep up.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_sink_t
+{
+    swi_mangoh_data_router_sink_type_e type; ///< Sink type
+    char path[SWI_MANGOH_DATA_ROUTER_SINK_PATH_LEN]; ///< File or socket path
+    int fd;                                  ///< File or socket, -1 when not open
+    uint32_t numSessions;                    ///< Sessions using the sink
+    char* queue;                             ///< Lines waiting to be written
+    size_t queueLen;                         ///< Queued bytes
+    size_t queueBytes;                       ///< Queue size
+    size_t flushBytes;                       ///< Queued bytes written right away, 0 to write
+                                             ///  each update
+    le_timer_Ref_t flushTimer;               ///< Queue flush timer
+    uint64_t numWritten;                     ///< Updates queued
+    uint32_t numDropped;                     ///< Updates dropped, queue full
+} swi_mangoh_data_router_sink_t;
+
+void swi_mangoh_data_router_sink_init(
+    swi_mangoh_data_router_sink_t*,
+    swi_mangoh_data_router_sink_type_e);
+
+extern const swi_mangoh_data_router_transportOps_t swi_mangoh_data_router_sinkTransportOps;
+
+#endif
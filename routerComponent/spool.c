@@ -0,0 +1,730 @@
+/**
+ * @file
+ *
+ * The spool is a directory of append-only segment files, named after their hexadecimal sequence
+ * number.  Records are appended through a block sized buffer, flushed when it is full and
+ * periodically, so the flash sees sequential block writes.  Records that fail to be written stay
+ * buffered until a later flush writes them, appends fail while the buffer is full.  A segment is
+ * closed and synced once it reaches the segment size, and the oldest segment is dropped when the
+ * spool already holds the maximum number of segments.
+ *
+ * Records are read from the cursor and acknowledged once they have been forwarded.  Segments are
+ * deleted when all their records are acknowledged and the cursor is saved when the buffer is
+ * flushed, so records acknowledged just before a restart can be forwarded again.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "spool.h"
+
+static void swi_mangoh_data_router_spool_segmentPath(
+    const swi_mangoh_data_router_spool_t*,
+    uint32_t,
+    char*,
+    size_t);
+static uint32_t swi_mangoh_data_router_spool_checksum(
+    const uint8_t*,
+    size_t,
+    const uint8_t*,
+    size_t);
+static void swi_mangoh_data_router_spool_saveCursor(swi_mangoh_data_router_spool_t*);
+static void swi_mangoh_data_router_spool_loadCursor(swi_mangoh_data_router_spool_t*);
+static le_result_t swi_mangoh_data_router_spool_writeBuffer(swi_mangoh_data_router_spool_t*);
+static le_result_t swi_mangoh_data_router_spool_openWriteSegment(swi_mangoh_data_router_spool_t*);
+static void swi_mangoh_data_router_spool_nextReadSegment(swi_mangoh_data_router_spool_t*);
+static void swi_mangoh_data_router_spool_dropFirstSegment(swi_mangoh_data_router_spool_t*);
+static uint32_t swi_mangoh_data_router_spool_fill(swi_mangoh_data_router_spool_t*, uint32_t);
+static void swi_mangoh_data_router_spool_flushTimerHandler(le_timer_Ref_t);
+
+static void swi_mangoh_data_router_spool_segmentPath
+(
+    const swi_mangoh_data_router_spool_t* spool,
+    uint32_t seq,
+    char* path,
+    size_t len
+)
+{
+    snprintf(path, len, "%s/%08x%s", spool->dir, seq, SWI_MANGOH_DATA_ROUTER_SPOOL_SEGMENT_EXT);
+}
+
+static uint32_t swi_mangoh_data_router_spool_checksum
+(
+    const uint8_t* key,
+    size_t keyLen,
+    const uint8_t* value,
+    size_t valueLen
+)
+{
+    uint32_t checksum = 2166136261u;
+
+    for (size_t i = 0; i < keyLen; i++)
+    {
+        checksum = (checksum ^ key[i]) * 16777619u;
+    }
+
+    for (size_t i = 0; i < valueLen; i++)
+    {
+        checksum = (checksum ^ value[i]) * 16777619u;
+    }
+
+    return checksum;
+}
+
+static void swi_mangoh_data_router_spool_saveCursor
+(
+    swi_mangoh_data_router_spool_t* spool
+)
+{
+    char path[SWI_MANGOH_DATA_ROUTER_SPOOL_PATH_LEN + 16] = {0};
+    char tmpPath[SWI_MANGOH_DATA_ROUTER_SPOOL_PATH_LEN + 16] = {0};
+
+    snprintf(path, sizeof(path), "%s/%s", spool->dir, SWI_MANGOH_DATA_ROUTER_SPOOL_CURSOR_NAME);
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+
+    // The cursor file is replaced, never partially written
+    int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd < 0)
+    {
+        LE_ERROR("ERROR open('%s') failed(%d)", tmpPath, errno);
+        goto cleanup;
+    }
+
+    if (write(fd, &spool->cursor, sizeof(spool->cursor)) != sizeof(spool->cursor))
+    {
+        LE_ERROR("ERROR write('%s') failed(%d)", tmpPath, errno);
+        close(fd);
+        goto cleanup;
+    }
+
+    close(fd);
+    if (rename(tmpPath, path))
+    {
+        LE_ERROR("ERROR rename('%s') failed(%d)", path, errno);
+        goto cleanup;
+    }
+
+    spool->cursorChanged = false;
+
+cleanup:
+    return;
+}
+
+static void swi_mangoh_data_router_spool_loadCursor
+(
+    swi_mangoh_data_router_spool_t* spool
+)
+{
+    char path[SWI_MANGOH_DATA_ROUTER_SPOOL_PATH_LEN + 16] = {0};
+    swi_mangoh_data_router_spoolCursor_t cursor = {0};
+
+    spool->cursor.seq = spool->firstSeq;
+    spool->cursor.offset = 0;
+
+    snprintf(path, sizeof(path), "%s/%s", spool->dir, SWI_MANGOH_DATA_ROUTER_SPOOL_CURSOR_NAME);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        LE_DEBUG("no cursor('%s')", path);
+        goto cleanup;
+    }
+
+    ssize_t len = read(fd, &cursor, sizeof(cursor));
+    close(fd);
+    if (len != sizeof(cursor))
+    {
+        LE_WARN("invalid cursor('%s')", path);
+        goto cleanup;
+    }
+
+    if ((cursor.seq >= spool->firstSeq) && (cursor.seq <= spool->lastSeq))
+    {
+        spool->cursor = cursor;
+    }
+
+cleanup:
+    return;
+}
+
+static le_result_t swi_mangoh_data_router_spool_writeBuffer
+(
+    swi_mangoh_data_router_spool_t* spool
+)
+{
+    le_result_t res = LE_OK;
+    uint32_t written = 0;
+
+    while (written < spool->writeBufLen)
+    {
+        ssize_t len =
+            write(spool->writeFd, &spool->writeBuf[written], spool->writeBufLen - written);
+        if (len < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            LE_ERROR("ERROR write() failed(%d)", errno);
+            res = LE_IO_ERROR;
+            goto cleanup;
+        }
+
+        written += len;
+    }
+
+cleanup:
+    // The records not written stay buffered for the next flush, the last segment length counts
+    // them already
+    spool->writeBufLen -= written;
+    memmove(spool->writeBuf, &spool->writeBuf[written], spool->writeBufLen);
+    return res;
+}
+
+static le_result_t swi_mangoh_data_router_spool_openWriteSegment
+(
+    swi_mangoh_data_router_spool_t* spool
+)
+{
+    char path[SWI_MANGOH_DATA_ROUTER_SPOOL_PATH_LEN + 16] = {0};
+    swi_mangoh_data_router_spoolRecord_t record;
+    uint8_t payload[SWI_MANGOH_DATA_ROUTER_SPOOL_BLOCK_SIZE];
+    le_result_t res = LE_OK;
+
+    swi_mangoh_data_router_spool_segmentPath(spool, spool->lastSeq, path, sizeof(path));
+    spool->writeFd = open(path, O_RDWR | O_CREAT | O_APPEND, S_IRUSR | S_IWUSR);
+    if (spool->writeFd < 0)
+    {
+        LE_ERROR("ERROR open('%s') failed(%d)", path, errno);
+        res = LE_IO_ERROR;
+        goto cleanup;
+    }
+
+    // Records torn by a power loss are cut off the end of the segment
+    spool->writeOffset = 0;
+    while (pread(spool->writeFd, &record, sizeof(record), spool->writeOffset) == sizeof(record))
+    {
+        size_t len = record.keyLen + record.valueLen;
+        if ((sizeof(record) + len > sizeof(payload)) ||
+            (pread(spool->writeFd, payload, len, spool->writeOffset + sizeof(record)) !=
+             (ssize_t)len) ||
+            (record.checksum != swi_mangoh_data_router_spool_checksum(
+                 payload, record.keyLen, &payload[record.keyLen], record.valueLen)))
+        {
+            break;
+        }
+
+        spool->writeOffset += sizeof(record) + len;
+    }
+
+    if (ftruncate(spool->writeFd, spool->writeOffset))
+    {
+        LE_ERROR("ERROR ftruncate('%s') failed(%d)", path, errno);
+    }
+
+    spool->writeBufLen = 0;
+
+cleanup:
+    return res;
+}
+
+static void swi_mangoh_data_router_spool_nextReadSegment
+(
+    swi_mangoh_data_router_spool_t* spool
+)
+{
+    char path[SWI_MANGOH_DATA_ROUTER_SPOOL_PATH_LEN + 16] = {0};
+
+    LE_ASSERT(spool->cursor.seq < spool->lastSeq);
+
+    if (spool->readFd >= 0)
+    {
+        close(spool->readFd);
+        spool->readFd = -1;
+    }
+
+    // All the records of the cursor segment, and of the segments before it, are acknowledged
+    swi_mangoh_data_router_spool_segmentPath(spool, spool->cursor.seq, path, sizeof(path));
+    LE_DEBUG("delete segment('%s')", path);
+    unlink(path);
+
+    spool->cursor.seq++;
+    spool->cursor.offset = 0;
+    spool->cursorChanged = true;
+    spool->firstSeq = spool->cursor.seq;
+    spool->readBufLen = 0;
+}
+
+static void swi_mangoh_data_router_spool_dropFirstSegment
+(
+    swi_mangoh_data_router_spool_t* spool
+)
+{
+    char path[SWI_MANGOH_DATA_ROUTER_SPOOL_PATH_LEN + 16] = {0};
+
+    spool->numDroppedSegments++;
+    if (spool->cursor.seq == spool->firstSeq)
+    {
+        LE_WARN("spool full, drop unsent segment(%u)", spool->numDroppedSegments);
+        swi_mangoh_data_router_spool_nextReadSegment(spool);
+        spool->peekLen = 0;
+    }
+    else
+    {
+        swi_mangoh_data_router_spool_segmentPath(spool, spool->firstSeq, path, sizeof(path));
+        unlink(path);
+        spool->firstSeq++;
+    }
+}
+
+// Returns the number of bytes available in the read buffer from the cursor, up to len.
+static uint32_t swi_mangoh_data_router_spool_fill
+(
+    swi_mangoh_data_router_spool_t* spool,
+    uint32_t len
+)
+{
+    uint32_t end = spool->readBufOffset + spool->readBufLen;
+
+    if ((spool->cursor.offset < spool->readBufOffset) || (spool->cursor.offset + len > end))
+    {
+        ssize_t readLen =
+            pread(spool->readFd, spool->readBuf, sizeof(spool->readBuf), spool->cursor.offset);
+        spool->readBufOffset = spool->cursor.offset;
+        spool->readBufLen = (readLen > 0) ? readLen : 0;
+        end = spool->readBufOffset + spool->readBufLen;
+    }
+
+    return (end - spool->cursor.offset < len) ? end - spool->cursor.offset : len;
+}
+
+static void swi_mangoh_data_router_spool_flushTimerHandler
+(
+    le_timer_Ref_t timer
+)
+{
+    swi_mangoh_data_router_spool_t* spool =
+        (swi_mangoh_data_router_spool_t*)le_timer_GetContextPtr(timer);
+    swi_mangoh_data_router_spool_flush(spool);
+}
+
+le_result_t swi_mangoh_data_router_spool_open
+(
+    swi_mangoh_data_router_spool_t* spool,
+    const char* dir,
+    uint32_t maxSegments
+)
+{
+    char path[SWI_MANGOH_DATA_ROUTER_SPOOL_PATH_LEN + 16] = {0};
+    le_clk_Time_t interval = { .sec = SWI_MANGOH_DATA_ROUTER_SPOOL_FLUSH_INTERVAL_SECS };
+    le_result_t res = LE_OK;
+    bool found = false;
+
+    LE_ASSERT(spool);
+    LE_ASSERT(dir);
+
+    memset(spool, 0, sizeof(swi_mangoh_data_router_spool_t));
+    spool->writeFd = -1;
+    spool->readFd = -1;
+    spool->maxSegments = maxSegments ? maxSegments : 1;
+    strncpy(spool->dir, dir, sizeof(spool->dir) - 1);
+
+    // Create the parent directories, and the segments directory itself
+    strncpy(path, spool->dir, sizeof(path) - 1);
+    for (char* pos = strchr(path + 1, '/'); ; pos = strchr(pos + 1, '/'))
+    {
+        if (pos)
+        {
+            *pos = '\0';
+        }
+
+        if (mkdir(path, S_IRWXU) && (errno != EEXIST))
+        {
+            LE_ERROR("ERROR mkdir('%s') failed(%d)", path, errno);
+            res = LE_IO_ERROR;
+            goto cleanup;
+        }
+
+        if (!pos)
+        {
+            break;
+        }
+
+        *pos = '/';
+    }
+
+    DIR* dirPtr = opendir(spool->dir);
+    if (!dirPtr)
+    {
+        LE_ERROR("ERROR opendir('%s') failed(%d)", spool->dir, errno);
+        res = LE_IO_ERROR;
+        goto cleanup;
+    }
+
+    struct dirent* entry = NULL;
+    while ((entry = readdir(dirPtr)))
+    {
+        uint32_t seq = 0;
+        char ext[sizeof(SWI_MANGOH_DATA_ROUTER_SPOOL_SEGMENT_EXT)] = {0};
+
+        if ((sscanf(entry->d_name, "%8x%4s", &seq, ext) != 2) ||
+            strcmp(ext, SWI_MANGOH_DATA_ROUTER_SPOOL_SEGMENT_EXT))
+        {
+            continue;
+        }
+
+        if (!found || (seq < spool->firstSeq))
+        {
+            spool->firstSeq = seq;
+        }
+
+        if (!found || (seq > spool->lastSeq))
+        {
+            spool->lastSeq = seq;
+        }
+
+        found = true;
+    }
+
+    closedir(dirPtr);
+
+    // Segments before the cursor were acknowledged before a restart
+    swi_mangoh_data_router_spool_loadCursor(spool);
+    while (spool->firstSeq < spool->cursor.seq)
+    {
+        swi_mangoh_data_router_spool_segmentPath(spool, spool->firstSeq, path, sizeof(path));
+        unlink(path);
+        spool->firstSeq++;
+    }
+
+    res = swi_mangoh_data_router_spool_openWriteSegment(spool);
+    if (res != LE_OK)
+    {
+        LE_ERROR("ERROR swi_mangoh_data_router_spool_openWriteSegment() failed(%d)", res);
+        goto cleanup;
+    }
+
+    if ((spool->cursor.seq == spool->lastSeq) && (spool->cursor.offset > spool->writeOffset))
+    {
+        spool->cursor.offset = spool->writeOffset;
+    }
+
+    LE_INFO(
+        "spool('%s') segments(%u - %u), cursor(%u/%u)",
+        spool->dir,
+        spool->firstSeq,
+        spool->lastSeq,
+        spool->cursor.seq,
+        spool->cursor.offset);
+
+    spool->flushTimer = le_timer_Create("DataRouterSpoolFlush");
+    le_timer_SetInterval(spool->flushTimer, interval);
+    le_timer_SetRepeat(spool->flushTimer, 0);
+    le_timer_SetContextPtr(spool->flushTimer, spool);
+    le_timer_SetHandler(spool->flushTimer, swi_mangoh_data_router_spool_flushTimerHandler);
+    le_timer_Start(spool->flushTimer);
+
+cleanup:
+    return res;
+}
+
+le_result_t swi_mangoh_data_router_spool_append
+(
+    swi_mangoh_data_router_spool_t* spool,
+    const char* key,
+    const char* value
+)
+{
+    swi_mangoh_data_router_spoolRecord_t record = {0};
+    le_result_t res = LE_OK;
+
+    LE_ASSERT(spool);
+    LE_ASSERT(key);
+    LE_ASSERT(value);
+
+    size_t keyLen = strlen(key);
+    size_t valueLen = strlen(value);
+    uint32_t len = sizeof(record) + keyLen + valueLen;
+    if (len > sizeof(spool->writeBuf))
+    {
+        LE_ERROR("ERROR record('%s') too long(%u)", key, len);
+        res = LE_OVERFLOW;
+        goto cleanup;
+    }
+
+    if (spool->writeOffset + len > SWI_MANGOH_DATA_ROUTER_SPOOL_SEGMENT_SIZE)
+    {
+        // The segment is only closed once all its buffered records are written
+        res = swi_mangoh_data_router_spool_writeBuffer(spool);
+        if (res != LE_OK)
+        {
+            LE_ERROR("ERROR swi_mangoh_data_router_spool_writeBuffer() failed(%d)", res);
+            goto cleanup;
+        }
+
+        fdatasync(spool->writeFd);
+        close(spool->writeFd);
+
+        spool->lastSeq++;
+        res = swi_mangoh_data_router_spool_openWriteSegment(spool);
+        if (res != LE_OK)
+        {
+            LE_ERROR("ERROR swi_mangoh_data_router_spool_openWriteSegment() failed(%d)", res);
+            goto cleanup;
+        }
+
+        if (spool->lastSeq - spool->firstSeq + 1 > spool->maxSegments)
+        {
+            swi_mangoh_data_router_spool_dropFirstSegment(spool);
+        }
+    }
+
+    if (spool->writeBufLen + len > sizeof(spool->writeBuf))
+    {
+        res = swi_mangoh_data_router_spool_writeBuffer(spool);
+        if (res != LE_OK)
+        {
+            LE_ERROR("ERROR swi_mangoh_data_router_spool_writeBuffer() failed(%d)", res);
+            goto cleanup;
+        }
+    }
+
+    record.keyLen = keyLen;
+    record.valueLen = valueLen;
+    record.checksum = swi_mangoh_data_router_spool_checksum(
+        (const uint8_t*)key, keyLen, (const uint8_t*)value, valueLen);
+
+    uint8_t* pos = &spool->writeBuf[spool->writeBufLen];
+    memcpy(pos, &record, sizeof(record));
+    memcpy(pos + sizeof(record), key, keyLen);
+    memcpy(pos + sizeof(record) + keyLen, value, valueLen);
+    spool->writeBufLen += len;
+    spool->writeOffset += len;
+
+cleanup:
+    return res;
+}
+
+bool swi_mangoh_data_router_spool_isEmpty
+(
+    const swi_mangoh_data_router_spool_t* spool
+)
+{
+    LE_ASSERT(spool);
+    return (spool->cursor.seq == spool->lastSeq) && (spool->cursor.offset == spool->writeOffset);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Percentage of the maximum number of segments holding unacknowledged records
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t swi_mangoh_data_router_spool_getFill
+(
+    const swi_mangoh_data_router_spool_t* spool
+)
+{
+    uint32_t fill = 0;
+
+    LE_ASSERT(spool);
+
+    if (!swi_mangoh_data_router_spool_isEmpty(spool) && spool->maxSegments)
+    {
+        fill = (uint64_t)(spool->lastSeq - spool->cursor.seq + 1) * 100 / spool->maxSegments;
+    }
+
+    return fill;
+}
+
+le_result_t swi_mangoh_data_router_spool_peek
+(
+    swi_mangoh_data_router_spool_t* spool,
+    char* key,
+    size_t keyLen,
+    char* value,
+    size_t valueLen
+)
+{
+    char path[SWI_MANGOH_DATA_ROUTER_SPOOL_PATH_LEN + 16] = {0};
+    swi_mangoh_data_router_spoolRecord_t record;
+    le_result_t res = LE_NOT_FOUND;
+
+    LE_ASSERT(spool);
+    LE_ASSERT(key);
+    LE_ASSERT(value);
+
+    while (!swi_mangoh_data_router_spool_isEmpty(spool))
+    {
+        // The buffered records are read back from the segment, a partly written record must
+        // not be taken for a corrupted one
+        if ((spool->cursor.seq == spool->lastSeq) && spool->writeBufLen &&
+            (swi_mangoh_data_router_spool_writeBuffer(spool) != LE_OK))
+        {
+            res = LE_IO_ERROR;
+            break;
+        }
+
+        if (spool->readFd < 0)
+        {
+            swi_mangoh_data_router_spool_segmentPath(spool, spool->cursor.seq, path, sizeof(path));
+            spool->readFd = open(path, O_RDONLY);
+            spool->readBufLen = 0;
+            if (spool->readFd < 0)
+            {
+                LE_ERROR("ERROR open('%s') failed(%d)", path, errno);
+                if (spool->cursor.seq == spool->lastSeq)
+                {
+                    res = LE_IO_ERROR;
+                    break;
+                }
+
+                swi_mangoh_data_router_spool_nextReadSegment(spool);
+                continue;
+            }
+        }
+
+        if (swi_mangoh_data_router_spool_fill(spool, sizeof(record)) < sizeof(record))
+        {
+            if (spool->cursor.seq == spool->lastSeq)
+            {
+                LE_ERROR("ERROR segment(%u) truncated", spool->cursor.seq);
+                res = LE_IO_ERROR;
+                break;
+            }
+
+            swi_mangoh_data_router_spool_nextReadSegment(spool);
+            continue;
+        }
+
+        const uint8_t* pos = &spool->readBuf[spool->cursor.offset - spool->readBufOffset];
+        memcpy(&record, pos, sizeof(record));
+
+        uint32_t len = sizeof(record) + record.keyLen + record.valueLen;
+        bool valid = (len <= sizeof(spool->readBuf)) &&
+                     (swi_mangoh_data_router_spool_fill(spool, len) == len);
+        if (valid)
+        {
+            pos = &spool->readBuf[spool->cursor.offset - spool->readBufOffset];
+            valid = record.checksum == swi_mangoh_data_router_spool_checksum(
+                pos + sizeof(record),
+                record.keyLen,
+                pos + sizeof(record) + record.keyLen,
+                record.valueLen);
+        }
+
+        if (!valid)
+        {
+            // Nothing after a corrupted record can be trusted in the segment
+            LE_ERROR("ERROR segment(%u) corrupted(%u)", spool->cursor.seq, spool->cursor.offset);
+            if (spool->cursor.seq == spool->lastSeq)
+            {
+                spool->cursor.offset = spool->writeOffset;
+                spool->cursorChanged = true;
+                res = LE_FAULT;
+                break;
+            }
+
+            swi_mangoh_data_router_spool_nextReadSegment(spool);
+            continue;
+        }
+
+        if ((record.keyLen >= keyLen) || (record.valueLen >= valueLen))
+        {
+            LE_WARN("skip record(%u/%u) too long", spool->cursor.seq, spool->cursor.offset);
+            spool->cursor.offset += len;
+            spool->cursorChanged = true;
+            continue;
+        }
+
+        memcpy(key, pos + sizeof(record), record.keyLen);
+        key[record.keyLen] = '\0';
+        memcpy(value, pos + sizeof(record) + record.keyLen, record.valueLen);
+        value[record.valueLen] = '\0';
+        spool->peekLen = len;
+        res = LE_OK;
+        break;
+    }
+
+    return res;
+}
+
+void swi_mangoh_data_router_spool_ack
+(
+    swi_mangoh_data_router_spool_t* spool
+)
+{
+    LE_ASSERT(spool);
+
+    if (spool->peekLen)
+    {
+        spool->cursor.offset += spool->peekLen;
+        spool->cursorChanged = true;
+        spool->peekLen = 0;
+    }
+}
+
+void swi_mangoh_data_router_spool_flush
+(
+    swi_mangoh_data_router_spool_t* spool
+)
+{
+    LE_ASSERT(spool);
+
+    if (spool->writeBufLen)
+    {
+        swi_mangoh_data_router_spool_writeBuffer(spool);
+    }
+
+    if (spool->cursorChanged)
+    {
+        swi_mangoh_data_router_spool_saveCursor(spool);
+    }
+}
+
+void swi_mangoh_data_router_spool_close
+(
+    swi_mangoh_data_router_spool_t* spool
+)
+{
+    LE_ASSERT(spool);
+
+    swi_mangoh_data_router_spool_flush(spool);
+    if (spool->writeBufLen)
+    {
+        LE_ERROR("ERROR spool('%s') buffered records lost(%u)", spool->dir, spool->writeBufLen);
+    }
+
+    if (spool->flushTimer)
+    {
+        le_timer_Delete(spool->flushTimer);
+        spool->flushTimer = NULL;
+    }
+
+    if (spool->writeFd >= 0)
+    {
+        fdatasync(spool->writeFd);
+        close(spool->writeFd);
+        spool->writeFd = -1;
+    }
+
+    if (spool->readFd >= 0)
+    {
+        close(spool->readFd);
+        spool->readFd = -1;
+    }
+
+    if (spool->numDroppedSegments)
+    {
+        LE_INFO("spool('%s') dropped segments(%u)", spool->dir, spool->numDroppedSegments);
+    }
+}
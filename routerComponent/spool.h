@@ -0,0 +1,95 @@
+/*
+ * @file spool.h
+ *
+ * Data router module.
+ *
+ * This module is the on-disk store-and-forward spool of the mangOH data router pushes.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_SPOOL_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_SPOOL_INCLUDE_GUARD
+
+#define SWI_MANGOH_DATA_ROUTER_SPOOL_PATH_LEN 128
+#define SWI_MANGOH_DATA_ROUTER_SPOOL_CURSOR_NAME "cursor"
+#define SWI_MANGOH_DATA_ROUTER_SPOOL_SEGMENT_EXT ".seg"
+#define SWI_MANGOH_DATA_ROUTER_SPOOL_SEGMENT_SIZE 65536
+#define SWI_MANGOH_DATA_ROUTER_SPOOL_BLOCK_SIZE 4096
+#define SWI_MANGOH_DATA_ROUTER_SPOOL_FLUSH_INTERVAL_SECS 1
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router spool record header, followed by the key and the value without terminating '\0'
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_spoolRecord_t
+{
+    uint16_t keyLen;    ///< Key length
+    uint16_t valueLen;  ///< Value length
+    uint32_t checksum;  ///< FNV-1a checksum of the key and the value
+} swi_mangoh_data_router_spoolRecord_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router spool read/acknowledge cursor, persisted in the cursor file
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_spoolCursor_t
+{
+    uint32_t seq;     ///< Segment
+    uint32_t offset;  ///< Offset of the first unacknowledged record in the segment
+} swi_mangoh_data_router_spoolCursor_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router spool.  Records are appended to the last segment through a block sized buffer and
+ * read from the cursor segment, segments are deleted once all their records are acknowledged.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_spool_t
+{
+    char dir[SWI_MANGOH_DATA_ROUTER_SPOOL_PATH_LEN]; ///< Segments directory
+    uint32_t maxSegments;                   ///< Maximum number of segments
+    uint32_t firstSeq;                      ///< Oldest segment
+    uint32_t lastSeq;                       ///< Segment records are appended to
+    int writeFd;                            ///< Last segment file
+    uint32_t writeOffset;                   ///< Last segment length, including the buffer
+    uint8_t writeBuf[SWI_MANGOH_DATA_ROUTER_SPOOL_BLOCK_SIZE]; ///< Write buffer
+    uint32_t writeBufLen;                   ///< Write buffer length
+    int readFd;                             ///< Cursor segment file
+    swi_mangoh_data_router_spoolCursor_t cursor; ///< Read/acknowledge cursor
+    bool cursorChanged;                     ///< Cursor not saved flag
+    uint8_t readBuf[SWI_MANGOH_DATA_ROUTER_SPOOL_BLOCK_SIZE]; ///< Read buffer
+    uint32_t readBufOffset;                 ///< Cursor segment offset of the read buffer
+    uint32_t readBufLen;                    ///< Read buffer length
+    uint32_t peekLen;                       ///< Length of the record returned by peek
+    uint32_t numDroppedSegments;            ///< Segments dropped, spool full
+    le_timer_Ref_t flushTimer;              ///< Write buffer flush timer
+} swi_mangoh_data_router_spool_t;
+
+le_result_t swi_mangoh_data_router_spool_open(
+    swi_mangoh_data_router_spool_t*,
+    const char*,
+    uint32_t);
+le_result_t swi_mangoh_data_router_spool_append(
+    swi_mangoh_data_router_spool_t*,
+    const char*,
+    const char*);
+bool swi_mangoh_data_router_spool_isEmpty(const swi_mangoh_data_router_spool_t*);
+uint32_t swi_mangoh_data_router_spool_getFill(const swi_mangoh_data_router_spool_t*);
+le_result_t swi_mangoh_data_router_spool_peek(
+    swi_mangoh_data_router_spool_t*,
+    char*,
+    size_t,
+    char*,
+    size_t);
+void swi_mangoh_data_router_spool_ack(swi_mangoh_data_router_spool_t*);
+void swi_mangoh_data_router_spool_flush(swi_mangoh_data_router_spool_t*);
+void swi_mangoh_data_router_spool_close(swi_mangoh_data_router_spool_t*);
+
+#endif
@@ -0,0 +1,189 @@
+/**
+ * @file
+ *
+ * The full state sync walks the slots of the database key index.  The writers only ever fill the
+ * empty slots of the index or publish a larger copy in its place, so the walk can be spread over
+ * several slices, and starts over when the index was replaced between two slices.  The sequence
+ * of an item, incremented on every update, tells which items were updated since the previous
+ * snapshot.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include "sync.h"
+
+static bool swi_mangoh_data_router_sync_slice(swi_mangoh_data_router_sync_t*);
+static void swi_mangoh_data_router_sync_sliceTimer(le_timer_Ref_t);
+static void swi_mangoh_data_router_sync_intervalTimer(le_timer_Ref_t);
+
+// Walks the next slots of the index, returns true once the snapshot is complete
+static bool swi_mangoh_data_router_sync_slice
+(
+    swi_mangoh_data_router_sync_t* sync
+)
+{
+    const swi_mangoh_data_router_dbIndex_t* index = sync->db->index;
+    bool done = false;
+
+    if (index != sync->index)
+    {
+        LE_DEBUG("index replaced, snapshot restarted");
+        sync->index = index;
+        sync->slot = 0;
+    }
+
+    uint32_t end = sync->slot + sync->sliceItems;
+    if (end > index->size)
+    {
+        end = index->size;
+    }
+
+    for (; sync->slot < end; sync->slot++)
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem = index->items[sync->slot];
+
+        // Items without a value were neither updated nor restored from persistent storage
+        if (!dbItem ||
+            (!dbItem->seq && (dbItem->persistedStorageType == DATAROUTER_CACHE)) ||
+            (sync->dirtyOnly && (dbItem->seq == dbItem->syncedSeq)))
+        {
+            continue;
+        }
+
+        dbItem->syncedSeq = dbItem->seq;
+        sync->handler(dbItem, sync->context);
+        sync->numItems++;
+    }
+
+    if (sync->slot < index->size)
+    {
+        goto cleanup;
+    }
+
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), sync->start);
+
+    sync->handler(NULL, sync->context);
+    sync->index = NULL;
+    sync->numSnapshots++;
+    done = true;
+    LE_INFO(
+        "snapshot(%u) items(%u) in %u ms",
+        sync->numSnapshots,
+        sync->numItems,
+        (uint32_t)(elapsed.sec * 1000 + elapsed.usec / 1000));
+
+cleanup:
+    return done;
+}
+
+static void swi_mangoh_data_router_sync_sliceTimer
+(
+    le_timer_Ref_t timerRef
+)
+{
+    swi_mangoh_data_router_sync_t* sync =
+        (swi_mangoh_data_router_sync_t*)le_timer_GetContextPtr(timerRef);
+
+    LE_ASSERT(sync);
+    if (swi_mangoh_data_router_sync_slice(sync))
+    {
+        le_timer_Stop(sync->sliceTimer);
+    }
+}
+
+static void swi_mangoh_data_router_sync_intervalTimer
+(
+    le_timer_Ref_t timerRef
+)
+{
+    swi_mangoh_data_router_sync_t* sync =
+        (swi_mangoh_data_router_sync_t*)le_timer_GetContextPtr(timerRef);
+
+    LE_ASSERT(sync);
+    if (sync->index)
+    {
+        LE_WARN("snapshot(%u) still running", sync->numSnapshots + 1);
+        goto cleanup;
+    }
+
+    if (!sync->db->index)
+    {
+        LE_DEBUG("empty database");
+        goto cleanup;
+    }
+
+    sync->index = sync->db->index;
+    sync->slot = 0;
+    sync->numItems = 0;
+    sync->start = le_clk_GetRelativeTime();
+    if (!swi_mangoh_data_router_sync_slice(sync))
+    {
+        le_timer_Start(sync->sliceTimer);
+    }
+
+cleanup:
+    return;
+}
+
+void swi_mangoh_data_router_sync_init
+(
+    swi_mangoh_data_router_sync_t* sync,
+    swi_mangoh_data_router_db_t* db,
+    swi_mangoh_data_router_syncHandler_t handler,
+    void* context
+)
+{
+    LE_ASSERT(sync);
+    LE_ASSERT(db);
+    LE_ASSERT(handler);
+
+    memset(sync, 0, sizeof(swi_mangoh_data_router_sync_t));
+    sync->db = db;
+    sync->handler = handler;
+    sync->context = context;
+
+    int32_t intervalMin = le_cfg_QuickGetInt(
+        SWI_MANGOH_DATA_ROUTER_SYNC_CFG_INTERVAL, SWI_MANGOH_DATA_ROUTER_SYNC_INTERVAL_MIN);
+    if (intervalMin <= 0)
+    {
+        LE_DEBUG("full state sync disabled");
+        goto cleanup;
+    }
+
+    sync->dirtyOnly = le_cfg_QuickGetBool(SWI_MANGOH_DATA_ROUTER_SYNC_CFG_DIRTY_ONLY, false);
+    int32_t sliceItems = le_cfg_QuickGetInt(
+        SWI_MANGOH_DATA_ROUTER_SYNC_CFG_SLICE_ITEMS, SWI_MANGOH_DATA_ROUTER_SYNC_SLICE_ITEMS);
+    if (sliceItems <= 0)
+    {
+        LE_WARN("invalid slice items(%d)", sliceItems);
+        sliceItems = SWI_MANGOH_DATA_ROUTER_SYNC_SLICE_ITEMS;
+    }
+
+    sync->sliceItems = sliceItems;
+    LE_INFO(
+        "full state sync every %d min, dirty only(%d), slice items(%u)",
+        intervalMin,
+        sync->dirtyOnly,
+        sync->sliceItems);
+
+    sync->sliceTimer = le_timer_Create("DataRouterSyncSlice");
+    le_timer_SetMsInterval(sync->sliceTimer, SWI_MANGOH_DATA_ROUTER_SYNC_SLICE_INTERVAL_MS);
+    le_timer_SetRepeat(sync->sliceTimer, 0);
+    le_timer_SetContextPtr(sync->sliceTimer, sync);
+    le_timer_SetHandler(sync->sliceTimer, swi_mangoh_data_router_sync_sliceTimer);
+
+    sync->intervalTimer = le_timer_Create("DataRouterSync");
+    le_timer_SetMsInterval(sync->intervalTimer, (uint32_t)intervalMin * 60 * 1000);
+    le_timer_SetRepeat(sync->intervalTimer, 0);
+    le_timer_SetContextPtr(sync->intervalTimer, sync);
+    le_timer_SetHandler(sync->intervalTimer, swi_mangoh_data_router_sync_intervalTimer);
+    le_timer_Start(sync->intervalTimer);
+
+cleanup:
+    return;
+}
@@ -0,0 +1,67 @@
+/*
+ * @file sync.h
+ *
+ * Data router module.
+ *
+ * This module periodically walks the database of the mangOH data router to push full state
+ * snapshots upstream.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_SYNC_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_SYNC_INCLUDE_GUARD
+
+#define SWI_MANGOH_DATA_ROUTER_SYNC_CFG_INTERVAL "/Sync/intervalMin"
+#define SWI_MANGOH_DATA_ROUTER_SYNC_CFG_DIRTY_ONLY "/Sync/dirtyOnly"
+#define SWI_MANGOH_DATA_ROUTER_SYNC_CFG_SLICE_ITEMS "/Sync/sliceItems"
+
+#define SWI_MANGOH_DATA_ROUTER_SYNC_INTERVAL_MIN 0
+#define SWI_MANGOH_DATA_ROUTER_SYNC_SLICE_ITEMS 32
+#define SWI_MANGOH_DATA_ROUTER_SYNC_SLICE_INTERVAL_MS 100
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router snapshot handler, called with each item of a snapshot and with NULL once the
+ * snapshot is complete
+ */
+//-------------------------------------------------------------------------------------------------
+typedef void (*swi_mangoh_data_router_syncHandler_t)(const swi_mangoh_data_router_dbItem_t*, void*);
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router full state sync.  Every interval the database key index is walked in slices of
+ * items on the slice timer, so that a large database does not hold up the writers, and the items
+ * with a value, or only those updated since the previous snapshot, are passed to the handler.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_sync_t
+{
+    swi_mangoh_data_router_db_t* db;             ///< Database module
+    swi_mangoh_data_router_syncHandler_t handler; ///< Snapshot handler
+    void* context;                               ///< Snapshot handler context
+    bool dirtyOnly;                              ///< Only the items updated since the previous
+                                                 ///  snapshot are passed
+    uint32_t sliceItems;                         ///< Index slots walked per slice
+    le_timer_Ref_t intervalTimer;                ///< Snapshot interval timer
+    le_timer_Ref_t sliceTimer;                   ///< Slice timer
+    const swi_mangoh_data_router_dbIndex_t* index; ///< Index being walked, NULL when idle
+    uint32_t slot;                               ///< Next slot to walk
+    uint32_t numItems;                           ///< Items passed in the current snapshot
+    le_clk_Time_t start;                         ///< Current snapshot start time
+    uint32_t numSnapshots;                       ///< Snapshots completed
+} swi_mangoh_data_router_sync_t;
+
+void swi_mangoh_data_router_sync_init(
+    swi_mangoh_data_router_sync_t*,
+    swi_mangoh_data_router_db_t*,
+    swi_mangoh_data_router_syncHandler_t,
+    void*);
+
+#endif
@@ -0,0 +1,1366 @@
+/**
+ * @file
+ *
+ * Values are serialized straight into the caller buffer without snprintf.  Doubles are written
+ * with the fewest significant digits that read back to the same double, e.g. 0.1 instead of
+ * 0.100000, which also keeps the precision that %f drops.  The shortest digits are searched with
+ * exact double arithmetic while the scaled value and the power of ten are exact, which covers
+ * the values of up to 15 significant digits between 1e-22 and 1e22, with 128 bit integers for 16
+ * and 17 digits between 1e-6 and 2^53, and with %e otherwise.  Parsers check the whole text and
+ * use exact double arithmetic when the digits and the exponent allow it, strtod otherwise.  The
+ * scanners read a JSON value and return where it ends, for the callers parsing JSON documents.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#include <errno.h>
+#include <math.h>
+
+#include "text.h"
+
+// Largest power of ten, and largest integer, exactly represented in a double
+#define SWI_MANGOH_DATA_ROUTER_TEXT_POW10_MAX 22
+#define SWI_MANGOH_DATA_ROUTER_TEXT_EXACT_MAX 9007199254740992ULL
+
+static const double swi_mangoh_data_router_text_pow10[SWI_MANGOH_DATA_ROUTER_TEXT_POW10_MAX + 1] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint64_t swi_mangoh_data_router_text_pow5[SWI_MANGOH_DATA_ROUTER_TEXT_POW10_MAX + 1] =
+{
+    1ULL, 5ULL, 25ULL, 125ULL, 625ULL, 3125ULL, 15625ULL, 78125ULL, 390625ULL, 1953125ULL,
+    9765625ULL, 48828125ULL, 244140625ULL, 1220703125ULL, 6103515625ULL, 30517578125ULL,
+    152587890625ULL, 762939453125ULL, 3814697265625ULL, 19073486328125ULL, 95367431640625ULL,
+    476837158203125ULL, 2384185791015625ULL
+};
+
+static const char swi_mangoh_data_router_text_digitPairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// 128 bit unsigned integer, for the exact checks of the 16 and 17 digit decimals
+typedef struct _swi_mangoh_data_router_text_u128_t
+{
+    uint64_t hi;
+    uint64_t lo;
+} swi_mangoh_data_router_text_u128_t;
+
+static void swi_mangoh_data_router_text_encodeBytes(
+    swi_mangoh_data_router_text_t*,
+    const char*,
+    size_t);
+static swi_mangoh_data_router_text_u128_t swi_mangoh_data_router_text_mul64(uint64_t, uint64_t);
+static swi_mangoh_data_router_text_u128_t swi_mangoh_data_router_text_shl(
+    swi_mangoh_data_router_text_u128_t,
+    int);
+static swi_mangoh_data_router_text_u128_t swi_mangoh_data_router_text_shr(
+    swi_mangoh_data_router_text_u128_t,
+    int);
+static swi_mangoh_data_router_text_u128_t swi_mangoh_data_router_text_sub(
+    swi_mangoh_data_router_text_u128_t,
+    swi_mangoh_data_router_text_u128_t);
+static int swi_mangoh_data_router_text_cmp(
+    swi_mangoh_data_router_text_u128_t,
+    swi_mangoh_data_router_text_u128_t);
+static bool swi_mangoh_data_router_text_nearestExact(double, int, uint64_t*);
+static char* swi_mangoh_data_router_text_formatUint(uint64_t, char*);
+static bool swi_mangoh_data_router_text_shortestFast(double, uint64_t*, int*, int*);
+static void swi_mangoh_data_router_text_shortestSlow(double, int, uint64_t*, int*);
+static le_result_t swi_mangoh_data_router_text_scanInt(const char*, const char**, int32_t*);
+static le_result_t swi_mangoh_data_router_text_scanArray(
+    const char*,
+    const char**,
+    swi_mangoh_data_router_data_t*);
+static le_result_t swi_mangoh_data_router_text_scanHex(const char*, uint32_t*);
+static size_t swi_mangoh_data_router_text_encodeUtf8(uint32_t, char*);
+
+static void swi_mangoh_data_router_text_encodeBytes
+(
+    swi_mangoh_data_router_text_t* text,
+    const char* bytes,
+    size_t len
+)
+{
+    if (text->used + len < text->len)
+    {
+        memcpy(&text->buf[text->used], bytes, len);
+        text->used += len;
+        text->buf[text->used] = '\0';
+    }
+    else
+    {
+        text->used = text->len;
+    }
+}
+
+static swi_mangoh_data_router_text_u128_t swi_mangoh_data_router_text_mul64
+(
+    uint64_t a,
+    uint64_t b
+)
+{
+    swi_mangoh_data_router_text_u128_t product;
+    uint64_t p00 = (a & UINT32_MAX) * (b & UINT32_MAX);
+    uint64_t p01 = (a & UINT32_MAX) * (b >> 32);
+    uint64_t p10 = (a >> 32) * (b & UINT32_MAX);
+    uint64_t p11 = (a >> 32) * (b >> 32);
+    uint64_t mid = (p00 >> 32) + (p01 & UINT32_MAX) + (p10 & UINT32_MAX);
+
+    product.lo = (mid << 32) | (p00 & UINT32_MAX);
+    product.hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+    return product;
+}
+
+static swi_mangoh_data_router_text_u128_t swi_mangoh_data_router_text_shl
+(
+    swi_mangoh_data_router_text_u128_t value,
+    int shift
+)
+{
+    if (shift >= 64)
+    {
+        value.hi = value.lo << (shift - 64);
+        value.lo = 0;
+    }
+    else if (shift)
+    {
+        value.hi = (value.hi << shift) | (value.lo >> (64 - shift));
+        value.lo <<= shift;
+    }
+
+    return value;
+}
+
+static swi_mangoh_data_router_text_u128_t swi_mangoh_data_router_text_shr
+(
+    swi_mangoh_data_router_text_u128_t value,
+    int shift
+)
+{
+    if (shift >= 64)
+    {
+        value.lo = value.hi >> (shift - 64);
+        value.hi = 0;
+    }
+    else if (shift)
+    {
+        value.lo = (value.lo >> shift) | (value.hi << (64 - shift));
+        value.hi >>= shift;
+    }
+
+    return value;
+}
+
+static swi_mangoh_data_router_text_u128_t swi_mangoh_data_router_text_sub
+(
+    swi_mangoh_data_router_text_u128_t a,
+    swi_mangoh_data_router_text_u128_t b
+)
+{
+    swi_mangoh_data_router_text_u128_t difference;
+
+    difference.lo = a.lo - b.lo;
+    difference.hi = a.hi - b.hi - (a.lo < b.lo);
+    return difference;
+}
+
+static int swi_mangoh_data_router_text_cmp
+(
+    swi_mangoh_data_router_text_u128_t a,
+    swi_mangoh_data_router_text_u128_t b
+)
+{
+    if (a.hi != b.hi)
+    {
+        return (a.hi < b.hi) ? -1 : 1;
+    }
+
+    return (a.lo < b.lo) ? -1 : (a.lo > b.lo);
+}
+
+// Finds the decimal mantissa * 10^-scale nearest to a value below 2^53 which reads back to it.
+// With value = m * 2^-k, a decimal c * 10^-scale reads back to the value when
+// |c * 2^(k+1) - 2 * m * 10^scale| <= 10^scale, or half that below the value when m is a power of
+// two, a tie reading back to an even m.  All the terms fit 128 bits for a scale up to 22.
+static bool swi_mangoh_data_router_text_nearestExact
+(
+    double value,
+    int scale,
+    uint64_t* mantissa
+)
+{
+    uint64_t bits = 0;
+    bool found = false;
+
+    memcpy(&bits, &value, sizeof(bits));
+    uint64_t m = (bits & ((1ULL << 52) - 1)) | (1ULL << 52);
+    int k = 1075 - (int)(bits >> 52);
+    bool even = !(m & 1);
+
+    // halfUlp is 10^scale, in the units of twiceValue
+    swi_mangoh_data_router_text_u128_t halfUlp =
+        swi_mangoh_data_router_text_shl(
+            swi_mangoh_data_router_text_mul64(swi_mangoh_data_router_text_pow5[scale], 1), scale);
+    swi_mangoh_data_router_text_u128_t twiceValue = swi_mangoh_data_router_text_shl(
+        swi_mangoh_data_router_text_mul64(m, swi_mangoh_data_router_text_pow5[scale]), scale + 1);
+
+    uint64_t below = swi_mangoh_data_router_text_shr(twiceValue, k + 1).lo;
+    swi_mangoh_data_router_text_u128_t belowDiff = swi_mangoh_data_router_text_sub(
+        twiceValue,
+        swi_mangoh_data_router_text_shl(swi_mangoh_data_router_text_mul64(below, 1), k + 1));
+    swi_mangoh_data_router_text_u128_t aboveDiff = swi_mangoh_data_router_text_sub(
+        swi_mangoh_data_router_text_shl(swi_mangoh_data_router_text_mul64(below + 1, 1), k + 1),
+        twiceValue);
+
+    int belowCmp = swi_mangoh_data_router_text_cmp(
+        (m == (1ULL << 52)) ? swi_mangoh_data_router_text_shl(belowDiff, 1) : belowDiff, halfUlp);
+    int aboveCmp = swi_mangoh_data_router_text_cmp(aboveDiff, halfUlp);
+    bool belowReads = (belowCmp < 0) || (!belowCmp && even);
+    bool aboveReads = (aboveCmp < 0) || (!aboveCmp && even);
+
+    if (belowReads &&
+        (!aboveReads || (swi_mangoh_data_router_text_cmp(belowDiff, aboveDiff) <= 0)))
+    {
+        *mantissa = below;
+        found = (below != 0);
+    }
+    else if (aboveReads)
+    {
+        *mantissa = below + 1;
+        found = true;
+    }
+
+    return found;
+}
+
+// Writes the digits backwards from end, returns the first digit
+static char* swi_mangoh_data_router_text_formatUint
+(
+    uint64_t value,
+    char* end
+)
+{
+    const char* pairs = swi_mangoh_data_router_text_digitPairs;
+    char* pos = end;
+
+    while (value >= 100)
+    {
+        uint32_t pair = (value % 100) * 2;
+
+        value /= 100;
+        *--pos = pairs[pair + 1];
+        *--pos = pairs[pair];
+    }
+
+    if (value >= 10)
+    {
+        *--pos = pairs[value * 2 + 1];
+        *--pos = pairs[value * 2];
+    }
+    else
+    {
+        *--pos = '0' + value;
+    }
+
+    return pos;
+}
+
+// Finds the shortest mantissa * 10^exp10 reading back to a positive value.  On failure, digits is
+// the number of significant digits to start the slow search from.
+static bool swi_mangoh_data_router_text_shortestFast
+(
+    double value,
+    uint64_t* mantissa,
+    int* exp10,
+    int* digits
+)
+{
+    const double* pow10 = swi_mangoh_data_router_text_pow10;
+    bool found = false;
+    int exp = 0;
+
+    *digits = 1;
+    if ((value < 1e-22) || (value >= 1e22))
+    {
+        goto cleanup;
+    }
+
+    // Decimal exponent of the first digit, a product rounded up to 1 only costs a longer search
+    if (value >= 1)
+    {
+        while (value >= pow10[exp + 1])
+        {
+            exp++;
+        }
+    }
+    else
+    {
+        exp = -1;
+        while (value * pow10[-exp] < 1)
+        {
+            exp--;
+        }
+    }
+
+    for (int scale = -exp; scale <= SWI_MANGOH_DATA_ROUTER_TEXT_POW10_MAX; scale++)
+    {
+        double scaled = (scale >= 0) ? value * pow10[scale] : value / pow10[-scale];
+        if (scaled >= SWI_MANGOH_DATA_ROUTER_TEXT_EXACT_MAX)
+        {
+            // 16 and 17 digit decimals of a value below 2^53
+            if ((scale < 0) || (value >= SWI_MANGOH_DATA_ROUTER_TEXT_EXACT_MAX))
+            {
+                break;
+            }
+
+            if (swi_mangoh_data_router_text_nearestExact(value, scale, mantissa))
+            {
+                *exp10 = -scale;
+                found = true;
+                goto cleanup;
+            }
+
+            *digits = scale + exp + 2;
+            continue;
+        }
+
+        // The scaled value is within a quarter of the candidate reading back to the value, if any
+        uint64_t nearest = (uint64_t)(scaled + 0.5);
+        for (uint64_t candidate = nearest - 1; candidate <= nearest + 1; candidate++)
+        {
+            // Both operands are exact so the result is the correctly rounded decimal
+            double readBack = (scale >= 0) ?
+                (double)candidate / pow10[scale] : (double)candidate * pow10[-scale];
+            if (readBack == value)
+            {
+                *mantissa = candidate;
+                *exp10 = -scale;
+                found = true;
+                goto cleanup;
+            }
+        }
+
+        *digits = scale + exp + 2;
+    }
+
+cleanup:
+    return found;
+}
+
+static void swi_mangoh_data_router_text_shortestSlow
+(
+    double value,
+    int digits,
+    uint64_t* mantissa,
+    int* exp10
+)
+{
+    char buf[SWI_MANGOH_DATA_ROUTER_TEXT_DOUBLE_MAX_LEN];
+    uint64_t m = 0;
+
+    // 17 significant digits always read back to the same double
+    for (; digits <= 17; digits++)
+    {
+        snprintf(buf, sizeof(buf), "%.*e", digits - 1, value);
+        if ((digits == 17) || (strtod(buf, NULL) == value))
+        {
+            break;
+        }
+    }
+
+    const char* pos = buf;
+    for (; *pos != 'e'; pos++)
+    {
+        if (*pos != '.')
+        {
+            m = m * 10 + (*pos - '0');
+        }
+    }
+
+    *mantissa = m;
+    *exp10 = atoi(pos + 1) - (digits - 1);
+}
+
+void swi_mangoh_data_router_text_init
+(
+    swi_mangoh_data_router_text_t* text,
+    char* buf,
+    size_t len
+)
+{
+    LE_ASSERT(text);
+    LE_ASSERT(buf);
+    LE_ASSERT(len);
+
+    text->buf = buf;
+    text->len = len;
+    text->used = 0;
+    text->buf[0] = '\0';
+}
+
+bool swi_mangoh_data_router_text_isValid
+(
+    const swi_mangoh_data_router_text_t* text
+)
+{
+    LE_ASSERT(text);
+    return text->used < text->len;
+}
+
+void swi_mangoh_data_router_text_encodeChar
+(
+    swi_mangoh_data_router_text_t* text,
+    char value
+)
+{
+    swi_mangoh_data_router_text_encodeBytes(text, &value, 1);
+}
+
+void swi_mangoh_data_router_text_encodeRaw
+(
+    swi_mangoh_data_router_text_t* text,
+    const char* value
+)
+{
+    swi_mangoh_data_router_text_encodeBytes(text, value, strlen(value));
+}
+
+// JSON string, with '"', '\' and the control characters escaped
+void swi_mangoh_data_router_text_encodeString
+(
+    swi_mangoh_data_router_text_t* text,
+    const char* value
+)
+{
+    static const char hex[] = "0123456789abcdef";
+    const char* run = value;
+
+    swi_mangoh_data_router_text_encodeChar(text, '"');
+    for (; *value; value++)
+    {
+        unsigned char c = *value;
+
+        if ((c != '"') && (c != '\\') && (c >= 0x20))
+        {
+            continue;
+        }
+
+        char escaped[] = { '\\', c, 0, 0, 0, 0 };
+        size_t len = 2;
+
+        if (c < 0x20)
+        {
+            memcpy(&escaped[1], "u00", 3);
+            escaped[4] = hex[c >> 4];
+            escaped[5] = hex[c & 0xf];
+            len = sizeof(escaped);
+        }
+
+        swi_mangoh_data_router_text_encodeBytes(text, run, value - run);
+        swi_mangoh_data_router_text_encodeBytes(text, escaped, len);
+        run = value + 1;
+    }
+
+    swi_mangoh_data_router_text_encodeBytes(text, run, value - run);
+    swi_mangoh_data_router_text_encodeChar(text, '"');
+}
+
+void swi_mangoh_data_router_text_encodeUint
+(
+    swi_mangoh_data_router_text_t* text,
+    uint64_t value
+)
+{
+    char digits[20];
+    char* end = &digits[sizeof(digits)];
+    char* pos = swi_mangoh_data_router_text_formatUint(value, end);
+
+    swi_mangoh_data_router_text_encodeBytes(text, pos, end - pos);
+}
+
+void swi_mangoh_data_router_text_encodeInt
+(
+    swi_mangoh_data_router_text_t* text,
+    int64_t value
+)
+{
+    char digits[21];
+    char* end = &digits[sizeof(digits)];
+    char* pos = swi_mangoh_data_router_text_formatUint(
+        (value < 0) ? (uint64_t)0 - (uint64_t)value : (uint64_t)value, end);
+
+    if (value < 0)
+    {
+        *--pos = '-';
+    }
+
+    swi_mangoh_data_router_text_encodeBytes(text, pos, end - pos);
+}
+
+// Fixed notation with at least one fractional digit from 1e-6 to below 1e21, e.g. 2.0 and 0.001,
+// and exponent notation otherwise, e.g. 1e-7 and 1.5e21, as JSON numbers.  JSON has no NaN and
+// infinities, they are encoded as null.
+void swi_mangoh_data_router_text_encodeDouble
+(
+    swi_mangoh_data_router_text_t* text,
+    double value
+)
+{
+    char out[SWI_MANGOH_DATA_ROUTER_TEXT_DOUBLE_MAX_LEN];
+    char digits[20];
+    size_t used = 0;
+    uint64_t mantissa = 0;
+    int exp10 = 0;
+    int numDigits = 1;
+
+    if (!isfinite(value))
+    {
+        swi_mangoh_data_router_text_encodeRaw(text, "null");
+        goto cleanup;
+    }
+
+    if (signbit(value))
+    {
+        out[used++] = '-';
+        value = -value;
+    }
+
+    if ((value != 0) &&
+        !swi_mangoh_data_router_text_shortestFast(value, &mantissa, &exp10, &numDigits))
+    {
+        swi_mangoh_data_router_text_shortestSlow(value, numDigits, &mantissa, &exp10);
+    }
+
+    while (mantissa && !(mantissa % 10))
+    {
+        mantissa /= 10;
+        exp10++;
+    }
+
+    char* end = &digits[sizeof(digits)];
+    char* first = swi_mangoh_data_router_text_formatUint(mantissa, end);
+    int len = end - first;
+    int point = len + exp10;  // Digits before the decimal point
+
+    if ((point > -6) && (point <= 21))
+    {
+        if (point <= 0)
+        {
+            memcpy(&out[used], "0.", 2);
+            used += 2;
+            memset(&out[used], '0', -point);
+            used += -point;
+            memcpy(&out[used], first, len);
+            used += len;
+        }
+        else if (point < len)
+        {
+            memcpy(&out[used], first, point);
+            used += point;
+            out[used++] = '.';
+            memcpy(&out[used], &first[point], len - point);
+            used += len - point;
+        }
+        else
+        {
+            memcpy(&out[used], first, len);
+            used += len;
+            memset(&out[used], '0', point - len);
+            used += point - len;
+            memcpy(&out[used], ".0", 2);
+            used += 2;
+        }
+    }
+    else
+    {
+        out[used++] = first[0];
+        if (len > 1)
+        {
+            out[used++] = '.';
+            memcpy(&out[used], &first[1], len - 1);
+            used += len - 1;
+        }
+
+        int exp = point - 1;
+        out[used++] = 'e';
+        if (exp < 0)
+        {
+            out[used++] = '-';
+            exp = -exp;
+        }
+
+        char* expEnd = &digits[sizeof(digits)];
+        char* expFirst = swi_mangoh_data_router_text_formatUint(exp, expEnd);
+        memcpy(&out[used], expFirst, expEnd - expFirst);
+        used += expEnd - expFirst;
+    }
+
+    swi_mangoh_data_router_text_encodeBytes(text, out, used);
+
+cleanup:
+    return;
+}
+
+void swi_mangoh_data_router_text_encodeBool
+(
+    swi_mangoh_data_router_text_t* text,
+    bool value
+)
+{
+    swi_mangoh_data_router_text_encodeRaw(text, value ? "true" : "false");
+}
+
+// JSON value, arrays as [1,2,3] and strings quoted
+void swi_mangoh_data_router_text_encodeValue
+(
+    swi_mangoh_data_router_text_t* text,
+    const swi_mangoh_data_router_data_t* data
+)
+{
+    LE_ASSERT(text);
+    LE_ASSERT(data);
+
+    switch (data->type)
+    {
+        case DATAROUTER_BOOLEAN:
+            swi_mangoh_data_router_text_encodeBool(text, data->bValue);
+            break;
+
+        case DATAROUTER_INTEGER:
+            swi_mangoh_data_router_text_encodeInt(text, data->iValue);
+            break;
+
+        case DATAROUTER_FLOAT:
+            swi_mangoh_data_router_text_encodeDouble(text, data->fValue);
+            break;
+
+        case DATAROUTER_STRING:
+            swi_mangoh_data_router_text_encodeString(text, data->sValue);
+            break;
+
+        case DATAROUTER_FLOAT_ARRAY:
+        case DATAROUTER_INTEGER_ARRAY:
+            swi_mangoh_data_router_text_encodeChar(text, '[');
+            for (uint32_t i = 0; i < data->count; i++)
+            {
+                if (i)
+                {
+                    swi_mangoh_data_router_text_encodeChar(text, ',');
+                }
+
+                if (data->type == DATAROUTER_FLOAT_ARRAY)
+                {
+                    swi_mangoh_data_router_text_encodeDouble(text, data->faValue[i]);
+                }
+                else
+                {
+                    swi_mangoh_data_router_text_encodeInt(text, data->iaValue[i]);
+                }
+            }
+            swi_mangoh_data_router_text_encodeChar(text, ']');
+            break;
+    }
+}
+
+// Base64 of binary data, e.g. a deflated payload, for the MQTT service which takes text values.
+// Returns the base64 length, excluding the terminating '\0', or 0 when the text is too short.
+size_t swi_mangoh_data_router_text_base64
+(
+    const uint8_t* bytes,
+    size_t len,
+    char* text,
+    size_t textLen
+)
+{
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t used = 0;
+
+    if (SWI_MANGOH_DATA_ROUTER_TEXT_BASE64_LEN(len) > textLen)
+    {
+        return 0;
+    }
+
+    for (size_t i = 0; i < len; i += 3)
+    {
+        uint32_t bits = bytes[i] << 16;
+
+        if (i + 1 < len)
+        {
+            bits |= bytes[i + 1] << 8;
+        }
+
+        if (i + 2 < len)
+        {
+            bits |= bytes[i + 2];
+        }
+
+        text[used++] = alphabet[(bits >> 18) & 0x3f];
+        text[used++] = alphabet[(bits >> 12) & 0x3f];
+        text[used++] = (i + 1 < len) ? alphabet[(bits >> 6) & 0x3f] : '=';
+        text[used++] = (i + 2 < len) ? alphabet[bits & 0x3f] : '=';
+    }
+
+    text[used] = '\0';
+    return used;
+}
+
+// Skips the JSON white space
+const char* swi_mangoh_data_router_text_skipSpaces
+(
+    const char* str
+)
+{
+    while ((*str == ' ') || (*str == '\t') || (*str == '\n') || (*str == '\r'))
+    {
+        str++;
+    }
+
+    return str;
+}
+
+le_result_t swi_mangoh_data_router_text_scanUint
+(
+    const char* str,
+    const char** end,
+    uint64_t* value
+)
+{
+    le_result_t res = LE_FORMAT_ERROR;
+    uint64_t v = 0;
+
+    if ((*str < '0') || (*str > '9'))
+    {
+        goto cleanup;
+    }
+
+    for (; (*str >= '0') && (*str <= '9'); str++)
+    {
+        uint32_t digit = *str - '0';
+
+        if (v > (UINT64_MAX - digit) / 10)
+        {
+            res = LE_OUT_OF_RANGE;
+            goto cleanup;
+        }
+
+        v = v * 10 + digit;
+    }
+
+    *end = str;
+    *value = v;
+    res = LE_OK;
+
+cleanup:
+    return res;
+}
+
+static le_result_t swi_mangoh_data_router_text_scanInt
+(
+    const char* str,
+    const char** end,
+    int32_t* value
+)
+{
+    bool negative = (*str == '-');
+    uint64_t magnitude = 0;
+
+    if ((*str == '-') || (*str == '+'))
+    {
+        str++;
+    }
+
+    le_result_t res = swi_mangoh_data_router_text_scanUint(str, end, &magnitude);
+    if (res != LE_OK)
+    {
+        goto cleanup;
+    }
+
+    if (magnitude > (negative ? (uint64_t)INT32_MAX + 1 : (uint64_t)INT32_MAX))
+    {
+        res = LE_OUT_OF_RANGE;
+        goto cleanup;
+    }
+
+    *value = negative ? (int32_t)(-(int64_t)magnitude) : (int32_t)magnitude;
+
+cleanup:
+    return res;
+}
+
+le_result_t swi_mangoh_data_router_text_scanDouble
+(
+    const char* str,
+    const char** end,
+    double* value
+)
+{
+    const char* pos = str;
+    le_result_t res = LE_OK;
+    uint64_t mantissa = 0;
+    int exp10 = 0;
+    bool exact = true;
+    bool hasDigits = false;
+    bool negative = (*pos == '-');
+
+    if ((*pos == '-') || (*pos == '+'))
+    {
+        pos++;
+    }
+
+    // Digits past the 17th are only counted in the exponent, the value is then left to strtod
+    for (; (*pos >= '0') && (*pos <= '9'); pos++)
+    {
+        hasDigits = true;
+        if (mantissa < 100000000000000000ULL)
+        {
+            mantissa = mantissa * 10 + (*pos - '0');
+        }
+        else
+        {
+            exp10++;
+            exact = exact && (*pos == '0');
+        }
+    }
+
+    if (*pos == '.')
+    {
+        for (pos++; (*pos >= '0') && (*pos <= '9'); pos++)
+        {
+            hasDigits = true;
+            if (mantissa < 100000000000000000ULL)
+            {
+                mantissa = mantissa * 10 + (*pos - '0');
+                exp10--;
+            }
+            else
+            {
+                exact = exact && (*pos == '0');
+            }
+        }
+    }
+
+    // Also rejects nan and inf, which strtod() would accept
+    if (!hasDigits)
+    {
+        res = LE_FORMAT_ERROR;
+        *end = str;
+        goto cleanup;
+    }
+
+    if ((*pos == 'e') || (*pos == 'E'))
+    {
+        const char* expPos = pos + 1;
+        bool expNegative = (*expPos == '-');
+        int exp = 0;
+
+        if ((*expPos == '-') || (*expPos == '+'))
+        {
+            expPos++;
+        }
+
+        // Without exponent digits the number ends before the 'e'
+        if ((*expPos >= '0') && (*expPos <= '9'))
+        {
+            for (; (*expPos >= '0') && (*expPos <= '9'); expPos++)
+            {
+                if (exp < 100000)
+                {
+                    exp = exp * 10 + (*expPos - '0');
+                }
+            }
+
+            exp10 += expNegative ? -exp : exp;
+            pos = expPos;
+        }
+    }
+
+    if (!exact || (mantissa > SWI_MANGOH_DATA_ROUTER_TEXT_EXACT_MAX) ||
+        (exp10 < -SWI_MANGOH_DATA_ROUTER_TEXT_POW10_MAX) ||
+        (exp10 > SWI_MANGOH_DATA_ROUTER_TEXT_POW10_MAX))
+    {
+        goto slow;
+    }
+
+    // Both operands are exact so the result is correctly rounded
+    double v = (exp10 >= 0) ? (double)mantissa * swi_mangoh_data_router_text_pow10[exp10] :
+                              (double)mantissa / swi_mangoh_data_router_text_pow10[-exp10];
+    *value = negative ? -v : v;
+    *end = pos;
+    goto cleanup;
+
+slow:
+    {
+        char* slowEnd = NULL;
+
+        errno = 0;
+        *value = strtod(str, &slowEnd);
+        if (slowEnd == str)
+        {
+            res = LE_FORMAT_ERROR;
+        }
+        else if ((errno == ERANGE) && isinf(*value))
+        {
+            res = LE_OUT_OF_RANGE;
+        }
+
+        *end = slowEnd;
+    }
+
+cleanup:
+    return res;
+}
+
+static le_result_t swi_mangoh_data_router_text_scanArray
+(
+    const char* str,
+    const char** end,
+    swi_mangoh_data_router_data_t* data
+)
+{
+    const char* pos = str;
+    le_result_t res = LE_FORMAT_ERROR;
+    uint32_t count = 0;
+
+    if (*pos != '[')
+    {
+        goto cleanup;
+    }
+
+    pos = swi_mangoh_data_router_text_skipSpaces(pos + 1);
+    while (*pos != ']')
+    {
+        if (count && (*pos++ != ','))
+        {
+            res = LE_FORMAT_ERROR;
+            goto cleanup;
+        }
+
+        if (count == DATAROUTER_ARRAY_MAX_LEN)
+        {
+            res = LE_OVERFLOW;
+            goto cleanup;
+        }
+
+        pos = swi_mangoh_data_router_text_skipSpaces(pos);
+        res = (data->type == DATAROUTER_FLOAT_ARRAY) ?
+            swi_mangoh_data_router_text_scanDouble(pos, &pos, &data->faValue[count]) :
+            swi_mangoh_data_router_text_scanInt(pos, &pos, &data->iaValue[count]);
+        if (res != LE_OK)
+        {
+            goto cleanup;
+        }
+
+        count++;
+        pos = swi_mangoh_data_router_text_skipSpaces(pos);
+    }
+
+    res = LE_OK;
+    *end = pos + 1;
+    data->count = count;
+
+cleanup:
+    return res;
+}
+
+static le_result_t swi_mangoh_data_router_text_scanHex
+(
+    const char* str,
+    uint32_t* value
+)
+{
+    le_result_t res = LE_OK;
+
+    *value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        char c = str[i];
+
+        if ((c >= '0') && (c <= '9'))
+        {
+            *value = (*value << 4) | (c - '0');
+        }
+        else if (((c | 0x20) >= 'a') && ((c | 0x20) <= 'f'))
+        {
+            *value = (*value << 4) | ((c | 0x20) - 'a' + 10);
+        }
+        else
+        {
+            res = LE_FORMAT_ERROR;
+            break;
+        }
+    }
+
+    return res;
+}
+
+static size_t swi_mangoh_data_router_text_encodeUtf8
+(
+    uint32_t codePoint,
+    char* buf
+)
+{
+    size_t len = 0;
+
+    if (codePoint < 0x80)
+    {
+        buf[len++] = codePoint;
+    }
+    else if (codePoint < 0x800)
+    {
+        buf[len++] = 0xc0 | (codePoint >> 6);
+        buf[len++] = 0x80 | (codePoint & 0x3f);
+    }
+    else if (codePoint < 0x10000)
+    {
+        buf[len++] = 0xe0 | (codePoint >> 12);
+        buf[len++] = 0x80 | ((codePoint >> 6) & 0x3f);
+        buf[len++] = 0x80 | (codePoint & 0x3f);
+    }
+    else
+    {
+        buf[len++] = 0xf0 | (codePoint >> 18);
+        buf[len++] = 0x80 | ((codePoint >> 12) & 0x3f);
+        buf[len++] = 0x80 | ((codePoint >> 6) & 0x3f);
+        buf[len++] = 0x80 | (codePoint & 0x3f);
+    }
+
+    return len;
+}
+
+// Scans a JSON string into a '\0' terminated buffer
+le_result_t swi_mangoh_data_router_text_scanString
+(
+    const char* str,
+    const char** end,
+    char* buf,
+    size_t len
+)
+{
+    static const char escapes[] = "\"\\/bfnrt";
+    static const char unescaped[] = "\"\\/\b\f\n\r\t";
+    const char* pos = str;
+    le_result_t res = LE_FORMAT_ERROR;
+    size_t used = 0;
+
+    LE_ASSERT(len);
+    if (*pos++ != '"')
+    {
+        goto cleanup;
+    }
+
+    while (*pos != '"')
+    {
+        char utf8[4];
+        size_t utf8Len = 1;
+
+        if ((unsigned char)*pos < 0x20)
+        {
+            goto cleanup;
+        }
+
+        const char* escape = (*pos == '\\') && pos[1] ? strchr(escapes, pos[1]) : NULL;
+        if (*pos != '\\')
+        {
+            utf8[0] = *pos++;
+        }
+        else if (escape)
+        {
+            utf8[0] = unescaped[escape - escapes];
+            pos += 2;
+        }
+        else if (pos[1] == 'u')
+        {
+            uint32_t codePoint = 0;
+            uint32_t low = 0;
+
+            if (swi_mangoh_data_router_text_scanHex(pos + 2, &codePoint) != LE_OK)
+            {
+                goto cleanup;
+            }
+
+            pos += 6;
+
+            // Characters past the basic plane are escaped as a surrogate pair
+            if ((codePoint >= 0xd800) && (codePoint < 0xdc00))
+            {
+                if ((pos[0] != '\\') || (pos[1] != 'u') ||
+                    (swi_mangoh_data_router_text_scanHex(pos + 2, &low) != LE_OK) ||
+                    (low < 0xdc00) || (low >= 0xe000))
+                {
+                    goto cleanup;
+                }
+
+                pos += 6;
+                codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+            }
+            else if (!codePoint || ((codePoint >= 0xdc00) && (codePoint < 0xe000)))
+            {
+                goto cleanup;
+            }
+
+            utf8Len = swi_mangoh_data_router_text_encodeUtf8(codePoint, utf8);
+        }
+        else
+        {
+            goto cleanup;
+        }
+
+        if (used + utf8Len >= len)
+        {
+            res = LE_OVERFLOW;
+            goto cleanup;
+        }
+
+        memcpy(&buf[used], utf8, utf8Len);
+        used += utf8Len;
+    }
+
+    buf[used] = '\0';
+    *end = pos + 1;
+    res = LE_OK;
+
+cleanup:
+    return res;
+}
+
+// Skips a JSON string, number, literal or array of numbers
+le_result_t swi_mangoh_data_router_text_skipValue
+(
+    const char* str,
+    const char** end
+)
+{
+    const char* pos = str;
+    le_result_t res = LE_FORMAT_ERROR;
+
+    if (*pos == '"')
+    {
+        for (pos++; *pos && (*pos != '"'); pos++)
+        {
+            if ((*pos == '\\') && pos[1])
+            {
+                pos++;
+            }
+        }
+    }
+    else if (*pos == '[')
+    {
+        pos = strchr(pos, ']');
+    }
+    else
+    {
+        pos += strcspn(pos, ",]} \t\n\r");
+        if (pos == str)
+        {
+            goto cleanup;
+        }
+
+        pos--;
+    }
+
+    if (!pos || !*pos)
+    {
+        goto cleanup;
+    }
+
+    *end = pos + 1;
+    res = LE_OK;
+
+cleanup:
+    return res;
+}
+
+// Scans a JSON value of the data type, strings are quoted
+le_result_t swi_mangoh_data_router_text_scanValue
+(
+    const char* str,
+    const char** end,
+    swi_mangoh_data_router_data_t* data
+)
+{
+    le_result_t res = LE_FORMAT_ERROR;
+
+    LE_ASSERT(str);
+    LE_ASSERT(end);
+    LE_ASSERT(data);
+
+    switch (data->type)
+    {
+        case DATAROUTER_BOOLEAN:
+            if (!strncmp(str, "true", 4))
+            {
+                data->bValue = true;
+                *end = str + 4;
+                res = LE_OK;
+            }
+            else if (!strncmp(str, "false", 5))
+            {
+                data->bValue = false;
+                *end = str + 5;
+                res = LE_OK;
+            }
+            break;
+
+        case DATAROUTER_INTEGER:
+            res = swi_mangoh_data_router_text_scanInt(str, end, &data->iValue);
+            break;
+
+        case DATAROUTER_FLOAT:
+            res = swi_mangoh_data_router_text_scanDouble(str, end, &data->fValue);
+            break;
+
+        case DATAROUTER_STRING:
+            res = swi_mangoh_data_router_text_scanString(
+                str, end, data->sValue, sizeof(data->sValue));
+            break;
+
+        case DATAROUTER_FLOAT_ARRAY:
+        case DATAROUTER_INTEGER_ARRAY:
+            res = swi_mangoh_data_router_text_scanArray(str, end, data);
+            break;
+    }
+
+    return res;
+}
+
+le_result_t swi_mangoh_data_router_text_parseBool
+(
+    const char* str,
+    bool* value
+)
+{
+    le_result_t res = LE_OK;
+
+    if (!strcmp(str, "true"))
+    {
+        *value = true;
+    }
+    else if (!strcmp(str, "false"))
+    {
+        *value = false;
+    }
+    else
+    {
+        res = LE_FORMAT_ERROR;
+    }
+
+    return res;
+}
+
+le_result_t swi_mangoh_data_router_text_parseInt
+(
+    const char* str,
+    int32_t* value
+)
+{
+    const char* end = NULL;
+
+    le_result_t res = swi_mangoh_data_router_text_scanInt(
+        swi_mangoh_data_router_text_skipSpaces(str), &end, value);
+    if ((res == LE_OK) && *swi_mangoh_data_router_text_skipSpaces(end))
+    {
+        res = LE_FORMAT_ERROR;
+    }
+
+    return res;
+}
+
+le_result_t swi_mangoh_data_router_text_parseUint
+(
+    const char* str,
+    uint64_t* value
+)
+{
+    const char* end = NULL;
+
+    le_result_t res = swi_mangoh_data_router_text_scanUint(
+        swi_mangoh_data_router_text_skipSpaces(str), &end, value);
+    if ((res == LE_OK) && *swi_mangoh_data_router_text_skipSpaces(end))
+    {
+        res = LE_FORMAT_ERROR;
+    }
+
+    return res;
+}
+
+le_result_t swi_mangoh_data_router_text_parseDouble
+(
+    const char* str,
+    double* value
+)
+{
+    const char* end = NULL;
+
+    le_result_t res = swi_mangoh_data_router_text_scanDouble(
+        swi_mangoh_data_router_text_skipSpaces(str), &end, value);
+    if ((res == LE_OK) && *swi_mangoh_data_router_text_skipSpaces(end))
+    {
+        res = LE_FORMAT_ERROR;
+    }
+
+    return res;
+}
+
+// Parses a value of the data type, strings are taken as is
+le_result_t swi_mangoh_data_router_text_parseValue
+(
+    const char* str,
+    swi_mangoh_data_router_data_t* data
+)
+{
+    le_result_t res = LE_FORMAT_ERROR;
+
+    LE_ASSERT(str);
+    LE_ASSERT(data);
+
+    switch (data->type)
+    {
+        case DATAROUTER_BOOLEAN:
+            res = swi_mangoh_data_router_text_parseBool(str, &data->bValue);
+            break;
+
+        case DATAROUTER_INTEGER:
+            res = swi_mangoh_data_router_text_parseInt(str, &data->iValue);
+            break;
+
+        case DATAROUTER_FLOAT:
+            res = swi_mangoh_data_router_text_parseDouble(str, &data->fValue);
+            break;
+
+        case DATAROUTER_STRING:
+            if (strlen(str) >= sizeof(data->sValue))
+            {
+                res = LE_OVERFLOW;
+                break;
+            }
+
+            strcpy(data->sValue, str);
+            res = LE_OK;
+            break;
+
+        case DATAROUTER_FLOAT_ARRAY:
+        case DATAROUTER_INTEGER_ARRAY:
+        {
+            const char* end = NULL;
+
+            res = swi_mangoh_data_router_text_scanArray(
+                swi_mangoh_data_router_text_skipSpaces(str), &end, data);
+            if ((res == LE_OK) && *swi_mangoh_data_router_text_skipSpaces(end))
+            {
+                res = LE_FORMAT_ERROR;
+            }
+            break;
+        }
+    }
+
+    return res;
+}
@@ -0,0 +1,69 @@
+/*
+ * @file text.h
+ *
+ * Data router module.
+ *
+ * This module is the text value serializer and parser of the mangOH data router MQTT messages.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_TEXT_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_TEXT_INCLUDE_GUARD
+
+// Longest double, e.g. "-0.0000012345678901234567"
+#define SWI_MANGOH_DATA_ROUTER_TEXT_DOUBLE_MAX_LEN 32
+
+// Base64 length of a binary length, including the terminating '\0'
+#define SWI_MANGOH_DATA_ROUTER_TEXT_BASE64_LEN(len) ((((len) + 2) / 3) * 4 + 1)
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router text serializer, writing into a caller buffer which is kept '\0' terminated.  used
+ * reaches len when the buffer is too short.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_text_t
+{
+    char* buf;     ///< Serialization buffer
+    size_t len;    ///< Serialization buffer length, including the terminating '\0'
+    size_t used;   ///< Serialized length, excluding the terminating '\0'
+} swi_mangoh_data_router_text_t;
+
+void swi_mangoh_data_router_text_init(swi_mangoh_data_router_text_t*, char*, size_t);
+bool swi_mangoh_data_router_text_isValid(const swi_mangoh_data_router_text_t*);
+void swi_mangoh_data_router_text_encodeChar(swi_mangoh_data_router_text_t*, char);
+void swi_mangoh_data_router_text_encodeRaw(swi_mangoh_data_router_text_t*, const char*);
+void swi_mangoh_data_router_text_encodeString(swi_mangoh_data_router_text_t*, const char*);
+void swi_mangoh_data_router_text_encodeInt(swi_mangoh_data_router_text_t*, int64_t);
+void swi_mangoh_data_router_text_encodeUint(swi_mangoh_data_router_text_t*, uint64_t);
+void swi_mangoh_data_router_text_encodeDouble(swi_mangoh_data_router_text_t*, double);
+void swi_mangoh_data_router_text_encodeBool(swi_mangoh_data_router_text_t*, bool);
+void swi_mangoh_data_router_text_encodeValue(
+    swi_mangoh_data_router_text_t*,
+    const swi_mangoh_data_router_data_t*);
+size_t swi_mangoh_data_router_text_base64(const uint8_t*, size_t, char*, size_t);
+
+le_result_t swi_mangoh_data_router_text_parseBool(const char*, bool*);
+le_result_t swi_mangoh_data_router_text_parseInt(const char*, int32_t*);
+le_result_t swi_mangoh_data_router_text_parseUint(const char*, uint64_t*);
+le_result_t swi_mangoh_data_router_text_parseDouble(const char*, double*);
+le_result_t swi_mangoh_data_router_text_parseValue(const char*, swi_mangoh_data_router_data_t*);
+
+const char* swi_mangoh_data_router_text_skipSpaces(const char*);
+le_result_t swi_mangoh_data_router_text_scanUint(const char*, const char**, uint64_t*);
+le_result_t swi_mangoh_data_router_text_scanDouble(const char*, const char**, double*);
+le_result_t swi_mangoh_data_router_text_scanString(const char*, const char**, char*, size_t);
+le_result_t swi_mangoh_data_router_text_skipValue(const char*, const char**);
+le_result_t swi_mangoh_data_router_text_scanValue(
+    const char*,
+    const char**,
+    swi_mangoh_data_router_data_t*);
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * @file transport.h
+ *
+ * Data router module.
+ *
+ * This module is the upstream transport interface of the mangOH data router pushes.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "db.h"
+#include "aggregate.h"
+
+#ifndef SWI_MANGOH_DATA_ROUTER_TRANSPORT_INCLUDE_GUARD
+#define SWI_MANGOH_DATA_ROUTER_TRANSPORT_INCLUDE_GUARD
+
+#define SWI_MANGOH_DATA_ROUTER_TRANSPORTS_MAX_NUM 4
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router upstream transport operations.  A transport is shared by the sessions pushing to
+ * it: start returns the client of a session, NULL on failure, which is passed to write, writeBatch
+ * and end.  Each transport queues the updates it cannot send right away, write returns LE_OVERFLOW
+ * when a queue dropped an update.  The full state snapshot, aggregate and fill operations are
+ * optional and, like flush, are passed the transport.
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_transportOps_t
+{
+    void* (*start)(                                  ///< Start pushing the updates of a session
+        void*,
+        const char*,
+        const char*,
+        const char*,
+        swi_mangoh_data_router_db_t*);
+    le_result_t (*write)(                            ///< Push an update
+        void*,
+        const char*,
+        const swi_mangoh_data_router_dbItem_t*);
+    void (*writeBatch)(                              ///< Push a block of float samples of a key
+        void*,
+        const char*,
+        const swi_mangoh_data_router_dbItem_t*,
+        const double*,
+        const uint32_t*,
+        size_t);
+    void (*flush)(void*);                            ///< Send the buffered updates now
+    void (*snapshot)(                                ///< Add an item to the full state
+        void*,                                       ///  snapshot
+        const char*,
+        const swi_mangoh_data_router_dbItem_t*);
+    void (*snapshotEnd)(void*);                      ///< Send the rest of the snapshot
+    void (*aggregate)(                               ///< Push the statistics of an
+        void*,                                       ///  aggregated key
+        const char*,
+        const swi_mangoh_data_router_aggregate_t*);
+    uint32_t (*getFill)(void*);                      ///< Percentage of the queues in use
+    void (*end)(void*);                              ///< Stop pushing the updates of a session
+} swi_mangoh_data_router_transportOps_t;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Data Router upstream transport
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct _swi_mangoh_data_router_transport_t
+{
+    const char* name;                                ///< Protocol name
+    const swi_mangoh_data_router_transportOps_t* ops; ///< Operations
+    void* context;                                   ///< Transport, passed to start and flush
+} swi_mangoh_data_router_transport_t;
+
+#endif
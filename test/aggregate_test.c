@@ -0,0 +1,181 @@
+/**
+ * @file
+ *
+ * Test of the aggregation of aggregate.c on the simulated clock: the values of an interval are
+ * folded into the statistics handed to the handler once per interval and reset, the intervals
+ * without values are not handled, NaN values and the types which are not numbers are left out,
+ * and the statistics pending are handled when the interval is changed.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include <math.h>
+#include "aggregate.h"
+#include "db.h"
+
+#define AGGREGATE_TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+#define AGGREGATE_TEST_INTERVAL_SEC 10
+
+static swi_mangoh_data_router_db_t Db;
+static swi_mangoh_data_router_aggregate_t Handled;
+static uint32_t NumHandled;
+static uint32_t NumChecks;
+
+static void aggregate_test_handler
+(
+    const swi_mangoh_data_router_dbItem_t* dbItem,
+    const swi_mangoh_data_router_aggregate_t* aggregate
+)
+{
+    Handled = *aggregate;
+    NumHandled++;
+}
+
+static void aggregate_test_advance
+(
+    uint32_t sec
+)
+{
+    le_test_AdvanceClock(sec * 1000);
+    le_test_RunEvents();
+}
+
+static void aggregate_test_interval
+(
+    void
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_createDataItem(&Db, "agg/temp");
+    static const double values[] = { 2, 4, 1, 5 };
+
+    printf("statistics handled once per interval and reset\n");
+    LE_ASSERT(dbItem);
+    AGGREGATE_TEST_CHECK(swi_mangoh_data_router_aggregate_set(
+        dbItem, AGGREGATE_TEST_INTERVAL_SEC, true, aggregate_test_handler) == LE_OK);
+    swi_mangoh_data_router_aggregate_t* aggregate = dbItem->aggregate;
+    AGGREGATE_TEST_CHECK(aggregate && aggregate->variance);
+
+    for (uint32_t i = 0; i < NUM_ARRAY_MEMBERS(values); i++)
+    {
+        swi_mangoh_data_router_aggregate_add(aggregate, values[i], 100 + i);
+    }
+
+    swi_mangoh_data_router_aggregate_add(aggregate, NAN, 110);
+    AGGREGATE_TEST_CHECK(aggregate->count == 4);
+    AGGREGATE_TEST_CHECK(swi_mangoh_data_router_aggregate_getVariance(aggregate) == 2.5);
+
+    aggregate_test_advance(AGGREGATE_TEST_INTERVAL_SEC - 1);
+    AGGREGATE_TEST_CHECK(!NumHandled);
+    aggregate_test_advance(1);
+    AGGREGATE_TEST_CHECK(NumHandled == 1);
+    AGGREGATE_TEST_CHECK((Handled.count == 4) && (Handled.min == 1) && (Handled.max == 5));
+    AGGREGATE_TEST_CHECK((Handled.mean == 3) && (Handled.last == 5));
+    AGGREGATE_TEST_CHECK((Handled.start == 100) && (Handled.end == 103));
+    AGGREGATE_TEST_CHECK(!aggregate->count && (aggregate->numIntervals == 1));
+
+    // An interval without values is not handled
+    aggregate_test_advance(AGGREGATE_TEST_INTERVAL_SEC);
+    AGGREGATE_TEST_CHECK((NumHandled == 1) && (aggregate->numIntervals == 1));
+
+    // The next interval starts over from its first value
+    swi_mangoh_data_router_aggregate_add(aggregate, 7, 120);
+    aggregate_test_advance(AGGREGATE_TEST_INTERVAL_SEC);
+    AGGREGATE_TEST_CHECK((NumHandled == 2) && (Handled.count == 1));
+    AGGREGATE_TEST_CHECK((Handled.min == 7) && (Handled.max == 7) && (Handled.mean == 7));
+    AGGREGATE_TEST_CHECK(swi_mangoh_data_router_aggregate_getVariance(&Handled) == 0);
+    AGGREGATE_TEST_CHECK(aggregate->numValues == 5);
+    NumChecks++;
+}
+
+static void aggregate_test_data
+(
+    void
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(&Db, "agg/temp");
+    swi_mangoh_data_router_data_t data = { .type = DATAROUTER_BOOLEAN, .bValue = true };
+
+    printf("booleans, integers and floats folded, the other types left out\n");
+    swi_mangoh_data_router_aggregate_t* aggregate = dbItem->aggregate;
+    data.timestamp = 130;
+    AGGREGATE_TEST_CHECK(swi_mangoh_data_router_aggregate_addData(aggregate, &data));
+    data.type = DATAROUTER_INTEGER;
+    data.iValue = -3;
+    AGGREGATE_TEST_CHECK(swi_mangoh_data_router_aggregate_addData(aggregate, &data));
+    data.type = DATAROUTER_FLOAT;
+    data.fValue = 0.5;
+    AGGREGATE_TEST_CHECK(swi_mangoh_data_router_aggregate_addData(aggregate, &data));
+    data.type = DATAROUTER_STRING;
+    strcpy(data.sValue, "9");
+    AGGREGATE_TEST_CHECK(!swi_mangoh_data_router_aggregate_addData(aggregate, &data));
+    AGGREGATE_TEST_CHECK((aggregate->count == 3) && (aggregate->min == -3));
+    AGGREGATE_TEST_CHECK(aggregate->max == 1);
+    NumChecks++;
+}
+
+static void aggregate_test_set
+(
+    void
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(&Db, "agg/temp");
+
+    printf("pending statistics handled when the interval changes\n");
+    AGGREGATE_TEST_CHECK(swi_mangoh_data_router_aggregate_set(
+                             dbItem, SWI_MANGOH_DATA_ROUTER_AGGREGATE_INTERVAL_MAX_SEC + 1, false,
+                             aggregate_test_handler) == LE_OUT_OF_RANGE);
+    AGGREGATE_TEST_CHECK((NumHandled == 2) && (dbItem->aggregate->count == 3));
+
+    AGGREGATE_TEST_CHECK(swi_mangoh_data_router_aggregate_set(
+        dbItem, 2 * AGGREGATE_TEST_INTERVAL_SEC, false, aggregate_test_handler) == LE_OK);
+    AGGREGATE_TEST_CHECK((NumHandled == 3) && (Handled.count == 3));
+    AGGREGATE_TEST_CHECK(!dbItem->aggregate->variance && !dbItem->aggregate->count);
+
+    // The interval timer restarts with the new interval
+    swi_mangoh_data_router_aggregate_add(dbItem->aggregate, 1, 140);
+    aggregate_test_advance(AGGREGATE_TEST_INTERVAL_SEC);
+    AGGREGATE_TEST_CHECK(NumHandled == 3);
+    aggregate_test_advance(AGGREGATE_TEST_INTERVAL_SEC);
+    AGGREGATE_TEST_CHECK(NumHandled == 4);
+
+    // An interval of 0 stops the aggregation
+    swi_mangoh_data_router_aggregate_add(dbItem->aggregate, 2, 150);
+    AGGREGATE_TEST_CHECK(swi_mangoh_data_router_aggregate_set(
+        dbItem, 0, false, aggregate_test_handler) == LE_OK);
+    AGGREGATE_TEST_CHECK((NumHandled == 5) && !dbItem->aggregate);
+    aggregate_test_advance(4 * AGGREGATE_TEST_INTERVAL_SEC);
+    AGGREGATE_TEST_CHECK(NumHandled == 5);
+    NumChecks++;
+}
+
+int main
+(
+    void
+)
+{
+    le_test_SimulateClock();
+    swi_mangoh_data_router_db_init(&Db);
+
+    aggregate_test_interval();
+    aggregate_test_data();
+    aggregate_test_set();
+
+    printf("aggregate_test: %u checks passed\n", NumChecks);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file
+ *
+ * Bytes sent for the keys and the values of a workload of float updates, with and without the key
+ * aliases of alias.c.  The keys are hierarchical, like the keys of a gateway relaying the sensors
+ * of its devices.  Each round updates every key once and the connection is lost once, halfway
+ * through the rounds, which resets the aliases.
+ *
+ *   alias_bench [<keys> [<rounds>]]
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "alias.h"
+
+#define ALIAS_BENCH_NUM_KEYS 200
+#define ALIAS_BENCH_NUM_ROUNDS 100
+#define ALIAS_BENCH_VALUE_MAX_LEN 32
+
+static void alias_bench_run
+(
+    uint32_t numKeys,
+    uint32_t rounds
+)
+{
+    static const char* sensors[] = { "temperature", "humidity", "pressure", "battery/voltage" };
+    swi_mangoh_data_router_alias_t aliases;
+    uint64_t fullBytes = 0;
+    uint64_t aliasedBytes = 0;
+
+    LE_ASSERT_OK(swi_mangoh_data_router_alias_init(&aliases, numKeys));
+    swi_mangoh_data_router_alias_reset(&aliases);
+
+    for (uint32_t i = 0; i < rounds; i++)
+    {
+        if (i && (i == rounds / 2))
+        {
+            swi_mangoh_data_router_alias_reset(&aliases);
+        }
+
+        for (uint32_t j = 0; j < numKeys; j++)
+        {
+            char key[SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN];
+            char aliasedKey[SWI_MANGOH_DATA_ROUTER_ALIAS_KEY_MAX_LEN];
+            char value[ALIAS_BENCH_VALUE_MAX_LEN];
+
+            snprintf(key, sizeof(key), "gateway/site-%02u/device-%04u/sensors/%s",
+                     j % 16, j / 4, sensors[j % NUM_ARRAY_MEMBERS(sensors)]);
+            size_t valueLen = snprintf(value, sizeof(value), "%f", 20.0 + (i + j) % 100 / 10.0);
+
+            swi_mangoh_data_router_aliasEntry_t* entry =
+                swi_mangoh_data_router_alias_encode(&aliases, key, aliasedKey, sizeof(aliasedKey));
+            LE_ASSERT(entry);
+            swi_mangoh_data_router_alias_sent(&aliases, entry, aliasedKey);
+
+            fullBytes += strlen(key) + valueLen;
+            aliasedBytes += strlen(aliasedKey) + valueLen;
+        }
+    }
+
+    printf("  %u keys, %u rounds: %llu bytes full keys, %llu bytes aliased, %.1f%% saved\n",
+           numKeys,
+           rounds,
+           (unsigned long long)fullBytes,
+           (unsigned long long)aliasedBytes,
+           100.0 * ((double)fullBytes - (double)aliasedBytes) / fullBytes);
+
+    swi_mangoh_data_router_alias_destroy(&aliases);
+}
+
+int main
+(
+    int argc,
+    char** argv
+)
+{
+    uint32_t numKeys = (argc > 1) ? atoi(argv[1]) : ALIAS_BENCH_NUM_KEYS;
+    uint32_t rounds = (argc > 2) ? atoi(argv[2]) : ALIAS_BENCH_NUM_ROUNDS;
+
+    LE_ASSERT(numKeys && rounds);
+
+    printf("key and value bytes of float updates, with and without key aliases\n");
+    alias_bench_run(numKeys, rounds);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+/**
+ * @file
+ *
+ * Test of the le_avdata transport: updates are queued until the AirVantage session starts, then
+ * recorded in order into timeseries records pushed on the push bytes, on a full record, on the
+ * push timer and on a flush.  Array elements are recorded as scalars under key/index.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "db.h"
+#include "avdata.h"
+#include "avserver.h"
+
+#define AVDATA_TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+#define AVDATA_TEST_KEY_MAX_LEN 32
+
+static swi_mangoh_data_router_db_t Db;
+static swi_mangoh_data_router_avdata_t AvData;
+static const swi_mangoh_data_router_transportOps_t* Ops =
+    &swi_mangoh_data_router_avdataTransportOps;
+static void* Client;
+static uint32_t NumChecks;
+
+static le_result_t avdata_test_writeFloat
+(
+    const char* key,
+    double value
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_db_getDataItem(&Db, key);
+
+    if (!dbItem)
+    {
+        dbItem = swi_mangoh_data_router_db_createDataItem(&Db, key);
+        LE_ASSERT(dbItem);
+    }
+
+    swi_mangoh_data_router_db_beginUpdate(dbItem);
+    swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_FLOAT);
+    swi_mangoh_data_router_db_setFloatValue(dbItem, value);
+    swi_mangoh_data_router_db_setTimestamp(dbItem, 1);
+    swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+    return Ops->write(Client, key, dbItem);
+}
+
+// Writes one value to each of the keys sensor/<first> to sensor/<first + num - 1>
+static void avdata_test_writeKeys
+(
+    uint32_t first,
+    uint32_t num
+)
+{
+    for (uint32_t i = first; i < first + num; i++)
+    {
+        char key[AVDATA_TEST_KEY_MAX_LEN];
+
+        snprintf(key, sizeof(key), "sensor/%u", i);
+        AVDATA_TEST_CHECK(avdata_test_writeFloat(key, i) == LE_OK);
+    }
+}
+
+static void avdata_test_queued
+(
+    void
+)
+{
+    const avserver_Stats_t* stats = avserver_GetStats();
+
+    printf("updates queued until the session starts\n");
+    avdata_test_writeKeys(0, 10);
+    avdata_test_writeKeys(0, 1);
+    le_test_RunEvents();
+    AVDATA_TEST_CHECK((stats->numRequests == 1) && !stats->started && !stats->numRecords);
+    AVDATA_TEST_CHECK(Ops->getFill(&AvData) ==
+                      10 * 100 / SWI_MANGOH_DATA_ROUTER_AVDATA_QUEUED_REQUESTS_MAX_NUM);
+
+    avserver_SetUp(true);
+    le_test_RunEvents();
+    AVDATA_TEST_CHECK((stats->numRecords == 1) && (stats->numValues == 10));
+    AVDATA_TEST_CHECK(!Ops->getFill(&AvData));
+    AVDATA_TEST_CHECK(AvData.numRecordsPushed == 1);
+    NumChecks++;
+}
+
+static void avdata_test_full
+(
+    void
+)
+{
+    const avserver_Stats_t* stats = avserver_GetStats();
+
+    printf("full record pushed, the value starts the next record\n");
+    avdata_test_writeKeys(0, AVSERVER_RECORD_MAX_NUM + 8);
+    AVDATA_TEST_CHECK(stats->numRecords == 2);
+    AVDATA_TEST_CHECK(stats->numValues == 10 + AVSERVER_RECORD_MAX_NUM);
+    AVDATA_TEST_CHECK(AvData.recordValues == 8);
+
+    Ops->flush(&AvData);
+    le_test_RunEvents();
+    AVDATA_TEST_CHECK(stats->numRecords == 3);
+    AVDATA_TEST_CHECK(stats->numValues == 18 + AVSERVER_RECORD_MAX_NUM);
+    AVDATA_TEST_CHECK((AvData.numRecordsPushed == 3) && !AvData.numRecordsFailed);
+    NumChecks++;
+}
+
+static void avdata_test_array
+(
+    void
+)
+{
+    const avserver_Stats_t* stats = avserver_GetStats();
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_createDataItem(&Db, "accel");
+    static const double values[] = { 0.01, -0.02, 9.81 };
+    uint64_t numValues = stats->numValues;
+
+    printf("array elements recorded as key/index, pushed on the timer\n");
+    LE_ASSERT(dbItem);
+    swi_mangoh_data_router_db_beginUpdate(dbItem);
+    swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_FLOAT_ARRAY);
+    swi_mangoh_data_router_db_setFloatArrayValue(dbItem, values, NUM_ARRAY_MEMBERS(values));
+    swi_mangoh_data_router_db_setTimestamp(dbItem, 1);
+    swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+    AVDATA_TEST_CHECK(Ops->write(Client, "accel", dbItem) == LE_OK);
+    AVDATA_TEST_CHECK(!strcmp(stats->lastPath, "accel/2"));
+    AVDATA_TEST_CHECK(stats->numValues == numValues);
+
+    le_test_AdvanceClock(SWI_MANGOH_DATA_ROUTER_AVDATA_PUSH_INTERVAL_MS);
+    le_test_RunEvents();
+    AVDATA_TEST_CHECK(stats->numValues == numValues + NUM_ARRAY_MEMBERS(values));
+    NumChecks++;
+}
+
+static void avdata_test_stopped
+(
+    void
+)
+{
+    const avserver_Stats_t* stats = avserver_GetStats();
+    uint32_t numRecords = stats->numRecords;
+
+    printf("session stopped, then started again\n");
+    avdata_test_writeKeys(0, 2);
+    avserver_Drop();
+    le_test_RunEvents();
+    avdata_test_writeKeys(2, 3);
+    le_test_AdvanceClock(SWI_MANGOH_DATA_ROUTER_AVDATA_PUSH_INTERVAL_MS);
+    le_test_RunEvents();
+    AVDATA_TEST_CHECK((stats->numRecords == numRecords) && !stats->numRejected);
+    AVDATA_TEST_CHECK(AvData.recordValues == 2);
+
+    // The values recorded before the stop go first, then the queued updates
+    avserver_SetUp(true);
+    le_test_RunEvents();
+    AVDATA_TEST_CHECK(stats->numRecords == numRecords + 2);
+    AVDATA_TEST_CHECK(!strcmp(stats->lastPath, "sensor/4"));
+
+    Ops->end(Client);
+    le_test_RunEvents();
+    AVDATA_TEST_CHECK(!stats->started && (AvData.numRecordsPushed == stats->numRecords));
+    NumChecks++;
+}
+
+int main
+(
+    void
+)
+{
+    le_test_SimulateClock();
+    swi_mangoh_data_router_db_init(&Db);
+    swi_mangoh_data_router_avdata_init(&AvData);
+    Client = Ops->start(&AvData, "avdata_test", "", "", &Db);
+    AVDATA_TEST_CHECK(Client);
+
+    avdata_test_queued();
+    avdata_test_full();
+    avdata_test_array();
+    avdata_test_stopped();
+
+    printf("avdata_test: %u checks passed\n", NumChecks);
+    return EXIT_SUCCESS;
+}
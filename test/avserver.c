@@ -0,0 +1,261 @@
+/**
+ * @file
+ *
+ * Stand-in for the le_avdata service, see avserver.h.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "avserver.h"
+
+struct le_avdata_Record
+{
+    uint32_t numValues; ///< Values recorded
+};
+
+struct le_avdata_RequestSessionObj
+{
+    int unused; ///< Only one session request is served
+};
+
+struct le_avdata_SessionStateHandler
+{
+    le_avdata_SessionStateHandlerFunc_t func; ///< Session state handler
+    void* context;                            ///< Handler context
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push result waiting to be reported
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_avdata_CallbackResultFunc_t func; ///< Push result handler
+    void* context;                       ///< Handler context
+    le_avdata_PushStatus_t status;       ///< Push result
+} avserver_PushResult_t;
+
+static bool ServerUp;
+static bool SessionRequested;
+static avserver_Stats_t Stats;
+static struct le_avdata_RequestSessionObj SessionRequest;
+static struct le_avdata_SessionStateHandler SessionStateHandler;
+
+static void avserver_Report
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    bool isStarted = (bool)(intptr_t)param1Ptr;
+
+    if (SessionStateHandler.func)
+    {
+        SessionStateHandler.func(isStarted ? LE_AVDATA_SESSION_STARTED : LE_AVDATA_SESSION_STOPPED,
+                                 SessionStateHandler.context);
+    }
+}
+
+static void avserver_ReportPush
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    avserver_PushResult_t* result = (avserver_PushResult_t*)param1Ptr;
+
+    if (result->func)
+    {
+        result->func(result->status, result->context);
+    }
+
+    free(result);
+}
+
+static le_result_t avserver_Record
+(
+    le_avdata_RecordRef_t record,
+    const char* path
+)
+{
+    LE_ASSERT(record && path);
+
+    if (record->numValues == AVSERVER_RECORD_MAX_NUM)
+    {
+        return LE_NO_MEMORY;
+    }
+
+    record->numValues++;
+    snprintf(Stats.lastPath, sizeof(Stats.lastPath), "%s", path);
+    return LE_OK;
+}
+
+void avserver_SetUp
+(
+    bool isUp
+)
+{
+    ServerUp = isUp;
+    if (ServerUp && SessionRequested && !Stats.started)
+    {
+        Stats.started = true;
+        le_event_QueueFunction(avserver_Report, (void*)(intptr_t)true, NULL);
+    }
+}
+
+void avserver_Drop
+(
+    void
+)
+{
+    ServerUp = false;
+    if (Stats.started)
+    {
+        Stats.started = false;
+        le_event_QueueFunction(avserver_Report, (void*)(intptr_t)false, NULL);
+    }
+}
+
+const avserver_Stats_t* avserver_GetStats
+(
+    void
+)
+{
+    return &Stats;
+}
+
+le_avdata_RecordRef_t le_avdata_CreateRecord
+(
+    void
+)
+{
+    le_avdata_RecordRef_t record = calloc(1, sizeof(struct le_avdata_Record));
+
+    LE_ASSERT(record);
+    return record;
+}
+
+void le_avdata_DeleteRecord
+(
+    le_avdata_RecordRef_t record
+)
+{
+    free(record);
+}
+
+le_result_t le_avdata_RecordInt
+(
+    le_avdata_RecordRef_t record,
+    const char* path,
+    int32_t value,
+    uint64_t timestamp
+)
+{
+    return avserver_Record(record, path);
+}
+
+le_result_t le_avdata_RecordFloat
+(
+    le_avdata_RecordRef_t record,
+    const char* path,
+    double value,
+    uint64_t timestamp
+)
+{
+    return avserver_Record(record, path);
+}
+
+le_result_t le_avdata_RecordBool
+(
+    le_avdata_RecordRef_t record,
+    const char* path,
+    bool value,
+    uint64_t timestamp
+)
+{
+    return avserver_Record(record, path);
+}
+
+le_result_t le_avdata_RecordString
+(
+    le_avdata_RecordRef_t record,
+    const char* path,
+    const char* value,
+    uint64_t timestamp
+)
+{
+    return avserver_Record(record, path);
+}
+
+le_result_t le_avdata_PushRecord
+(
+    le_avdata_RecordRef_t record,
+    le_avdata_CallbackResultFunc_t func,
+    void* context
+)
+{
+    avserver_PushResult_t* result = calloc(1, sizeof(avserver_PushResult_t));
+
+    LE_ASSERT(record && result);
+    result->func = func;
+    result->context = context;
+    result->status = LE_AVDATA_PUSH_SUCCESS;
+    if (Stats.started)
+    {
+        Stats.numRecords++;
+        Stats.numValues += record->numValues;
+    }
+    else
+    {
+        Stats.numRejected++;
+        result->status = LE_AVDATA_PUSH_FAILED;
+    }
+
+    le_event_QueueFunction(avserver_ReportPush, result, NULL);
+    return LE_OK;
+}
+
+le_avdata_SessionStateHandlerRef_t le_avdata_AddSessionStateHandler
+(
+    le_avdata_SessionStateHandlerFunc_t func,
+    void* context
+)
+{
+    LE_ASSERT(!SessionStateHandler.func);
+    SessionStateHandler.func = func;
+    SessionStateHandler.context = context;
+    return &SessionStateHandler;
+}
+
+void le_avdata_RemoveSessionStateHandler
+(
+    le_avdata_SessionStateHandlerRef_t handler
+)
+{
+    handler->func = NULL;
+}
+
+le_avdata_RequestSessionObjRef_t le_avdata_RequestSession
+(
+    void
+)
+{
+    Stats.numRequests++;
+    SessionRequested = true;
+    avserver_SetUp(ServerUp);
+    return &SessionRequest;
+}
+
+void le_avdata_ReleaseSession
+(
+    le_avdata_RequestSessionObjRef_t sessionRef
+)
+{
+    SessionRequested = false;
+    Stats.started = false;
+}
@@ -0,0 +1,43 @@
+/*
+ * @file avserver.h
+ *
+ * Data router host tests.
+ *
+ * Stand-in for the le_avdata service: a requested AirVantage session starts while the server is
+ * up, and the session state and the push results are reported from the event loop as the service
+ * reports them.  Records hold at most AVSERVER_RECORD_MAX_NUM values, as a full record is reported
+ * with LE_NO_MEMORY, and the records pushed while the session is started are counted.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#ifndef AVSERVER_INCLUDE_GUARD
+#define AVSERVER_INCLUDE_GUARD
+
+#include "legato.h"
+
+#define AVSERVER_RECORD_MAX_NUM 32
+#define AVSERVER_PATH_MAX_LEN 160
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * AirVantage server statistics
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool started;              ///< Session started
+    uint32_t numRequests;      ///< Session requests
+    uint32_t numRecords;       ///< Records pushed
+    uint64_t numValues;        ///< Values of the records pushed
+    uint32_t numRejected;      ///< Records pushed while the session was stopped
+    char lastPath[AVSERVER_PATH_MAX_LEN]; ///< Path of the last value recorded
+} avserver_Stats_t;
+
+void avserver_SetUp(bool);
+void avserver_Drop(void);
+const avserver_Stats_t* avserver_GetStats(void);
+
+#endif
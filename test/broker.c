@@ -0,0 +1,187 @@
+/**
+ * @file
+ *
+ * Stand-in for the MQTT service, see broker.h.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "broker.h"
+
+struct mqtt_SessionStateHandler
+{
+    mqtt_SessionStateHandlerFunc_t func; ///< Session state handler
+    void* context;                       ///< Handler context
+};
+
+struct mqtt_IncomingMessageHandler
+{
+    mqtt_IncomingMessageHandlerFunc_t func; ///< Incoming message handler
+    void* context;                          ///< Handler context
+};
+
+static bool BrokerUp;
+static broker_Stats_t Stats;
+static broker_MessageHandler_t MessageHandler;
+static struct mqtt_SessionStateHandler SessionStateHandler;
+static struct mqtt_IncomingMessageHandler IncomingMessageHandler;
+
+static void broker_Report
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    bool isConnected = (bool)(intptr_t)param1Ptr;
+
+    if (SessionStateHandler.func)
+    {
+        SessionStateHandler.func(isConnected, isConnected ? 0 : -1, 0, SessionStateHandler.context);
+    }
+}
+
+void broker_SetUp
+(
+    bool isUp
+)
+{
+    BrokerUp = isUp;
+}
+
+void broker_Drop
+(
+    void
+)
+{
+    if (Stats.connected)
+    {
+        Stats.connected = false;
+        le_event_QueueFunction(broker_Report, (void*)(intptr_t)false, NULL);
+    }
+}
+
+void broker_SetMessageHandler
+(
+    broker_MessageHandler_t handler
+)
+{
+    MessageHandler = handler;
+}
+
+void broker_Receive
+(
+    const char* key,
+    const char* value,
+    const char* timestamp
+)
+{
+    if (IncomingMessageHandler.func)
+    {
+        IncomingMessageHandler.func("", key, value, timestamp, IncomingMessageHandler.context);
+    }
+}
+
+const broker_Stats_t* broker_GetStats
+(
+    void
+)
+{
+    return &Stats;
+}
+
+void mqtt_Config
+(
+    const char* url,
+    int32_t port,
+    int32_t keepAlive,
+    int32_t qos
+)
+{
+}
+
+void mqtt_Connect
+(
+    const char* password
+)
+{
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+
+    Stats.numConnects++;
+    Stats.lastConnectMs = (uint64_t)now.sec * 1000 + now.usec / 1000;
+    Stats.connected = BrokerUp;
+    le_event_QueueFunction(broker_Report, (void*)(intptr_t)BrokerUp, NULL);
+}
+
+void mqtt_Disconnect
+(
+    void
+)
+{
+    Stats.numDisconnects++;
+    broker_Drop();
+}
+
+void mqtt_Send
+(
+    const char* topic,
+    const char* payload,
+    int32_t* error
+)
+{
+    if (!Stats.connected || !strlen(topic) || !strlen(payload))
+    {
+        *error = -1;
+        return;
+    }
+
+    *error = 0;
+    Stats.numMessages++;
+    Stats.numBytes += strlen(topic) + strlen(payload);
+    if (MessageHandler)
+    {
+        MessageHandler(topic, payload);
+    }
+}
+
+mqtt_SessionStateHandlerRef_t mqtt_AddSessionStateHandler
+(
+    mqtt_SessionStateHandlerFunc_t func,
+    void* context
+)
+{
+    LE_ASSERT(!SessionStateHandler.func);
+    SessionStateHandler.func = func;
+    SessionStateHandler.context = context;
+    return &SessionStateHandler;
+}
+
+void mqtt_RemoveSessionStateHandler
+(
+    mqtt_SessionStateHandlerRef_t handler
+)
+{
+    handler->func = NULL;
+}
+
+mqtt_IncomingMessageHandlerRef_t mqtt_AddIncomingMessageHandler
+(
+    mqtt_IncomingMessageHandlerFunc_t func,
+    void* context
+)
+{
+    IncomingMessageHandler.func = func;
+    IncomingMessageHandler.context = context;
+    return &IncomingMessageHandler;
+}
+
+void mqtt_RemoveIncomingMessageHandler
+(
+    mqtt_IncomingMessageHandlerRef_t handler
+)
+{
+    handler->func = NULL;
+}
@@ -0,0 +1,44 @@
+/*
+ * @file broker.h
+ *
+ * Data router host tests.
+ *
+ * Stand-in for the MQTT service: the connects succeed while the broker is up, and the session
+ * state is reported from the event loop as the service reports it.  The messages sent while
+ * connected are counted and passed to the message handler of the test, the messages received are
+ * passed to the incoming message handler of the MQTT transport.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#ifndef BROKER_INCLUDE_GUARD
+#define BROKER_INCLUDE_GUARD
+
+#include "legato.h"
+
+typedef void (*broker_MessageHandler_t)(const char*, const char*);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Broker statistics
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool connected;            ///< Session connected
+    uint32_t numConnects;      ///< Connect attempts
+    uint32_t numDisconnects;   ///< Disconnects requested
+    uint64_t lastConnectMs;    ///< Relative time of the last connect attempt
+    uint64_t numMessages;      ///< Messages received
+    uint64_t numBytes;         ///< Topic and payload bytes received
+} broker_Stats_t;
+
+void broker_SetUp(bool);
+void broker_Drop(void);
+void broker_SetMessageHandler(broker_MessageHandler_t);
+void broker_Receive(const char*, const char*, const char*);
+const broker_Stats_t* broker_GetStats(void);
+
+#endif
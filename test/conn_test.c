@@ -0,0 +1,347 @@
+/**
+ * @file
+ *
+ * Deterministic test of the MQTT reconnects on the simulated clock.  The MQTT connection of
+ * mqtt.c runs against the stand-in broker, which fails the connects while it is down, and the
+ * test checks the time of every connect attempt:
+ *
+ * - the delays double from the minimum up to the maximum interval, each delay within the equal
+ *   jitter range [interval / 2, interval],
+ * - a network up retries within the network retry delay and restarts the backoff,
+ * - a connection lost once connected retries from the minimum interval,
+ * - the sessions naming the URL and password of the connection share it, the others are refused,
+ * - a session ended with queued requests keeps reconnecting, also on a network up, forwards them
+ *   and the aggregate records produced while disconnected once connected and disconnects,
+ * - no connect is attempted once the connection is closed.
+ *
+ * The first retries of a fleet losing the broker together are also checked to spread over the
+ * jitter range.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "broker.h"
+#include "conn.h"
+#include "db.h"
+#include "mqtt.h"
+
+#define CONN_TEST_MIN_MS 1000
+#define CONN_TEST_MAX_MS 16000
+#define CONN_TEST_NETWORK_RETRY_MS 2000
+#define CONN_TEST_NUM_BACKOFFS 10
+#define CONN_TEST_FLEET_SIZE 1000
+#define CONN_TEST_FLEET_BUCKETS 10
+
+#define CONN_TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+static swi_mangoh_data_router_db_t Db;
+static swi_mangoh_data_router_mqtt_t Mqtt;
+static uint32_t NumChecks;
+
+// The inbound updates are not exercised by this test
+void swi_mangoh_data_router_notifySubscribers
+(
+    const char* key,
+    const swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+}
+
+static uint64_t conn_test_nowMs
+(
+    void
+)
+{
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+
+    return (uint64_t)now.sec * 1000 + now.usec / 1000;
+}
+
+// Runs the timers up to the next connect attempt and returns its delay
+static uint64_t conn_test_nextAttempt
+(
+    uint32_t maxMs
+)
+{
+    const broker_Stats_t* stats = broker_GetStats();
+    uint32_t numConnects = stats->numConnects;
+    uint64_t startMs = conn_test_nowMs();
+
+    while ((stats->numConnects == numConnects) && le_test_RunNextTimer(maxMs))
+    {
+    }
+
+    CONN_TEST_CHECK(stats->numConnects == numConnects + 1);
+    NumChecks++;
+    return stats->lastConnectMs - startMs;
+}
+
+static void conn_test_checkDelay
+(
+    uint64_t delayMs,
+    uint32_t minMs,
+    uint32_t maxMs
+)
+{
+    printf("    delay %6llu ms in [%u, %u] ms\n", (unsigned long long)delayMs, minMs, maxMs);
+    CONN_TEST_CHECK(delayMs >= minMs);
+    CONN_TEST_CHECK(delayMs <= maxMs);
+    NumChecks++;
+}
+
+// Checks a backoff delay, with equal jitter
+static void conn_test_checkBackoff
+(
+    uint64_t delayMs,
+    uint32_t intervalMs
+)
+{
+    conn_test_checkDelay(delayMs, intervalMs / 2, intervalMs);
+}
+
+// Checks a retry delay after a network up
+static void conn_test_checkNetworkRetry
+(
+    uint64_t delayMs
+)
+{
+    conn_test_checkDelay(delayMs, 0, CONN_TEST_NETWORK_RETRY_MS);
+}
+
+static void conn_test_backoff
+(
+    void
+)
+{
+    uint32_t intervalMs = CONN_TEST_MIN_MS;
+    uint32_t numJittered = 0;
+
+    printf("backoff while the broker is down\n");
+    for (uint32_t i = 0; i < CONN_TEST_NUM_BACKOFFS; i++)
+    {
+        uint64_t delayMs = conn_test_nextAttempt(CONN_TEST_MAX_MS);
+        conn_test_checkBackoff(delayMs, intervalMs);
+        numJittered += (delayMs != intervalMs);
+        intervalMs = (2 * intervalMs > CONN_TEST_MAX_MS) ? CONN_TEST_MAX_MS : 2 * intervalMs;
+    }
+
+    CONN_TEST_CHECK(numJittered);
+    CONN_TEST_CHECK(Mqtt.conn.state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_BACKOFF);
+}
+
+static void conn_test_networkUp
+(
+    void
+)
+{
+    printf("network up during the backoff\n");
+    le_test_AdvanceClock(CONN_TEST_MIN_MS);
+    le_test_SetDataConnection(true);
+    conn_test_checkNetworkRetry(conn_test_nextAttempt(CONN_TEST_MAX_MS));
+    conn_test_checkBackoff(conn_test_nextAttempt(CONN_TEST_MAX_MS), CONN_TEST_MIN_MS);
+}
+
+static void conn_test_connectionLost
+(
+    void
+)
+{
+    const broker_Stats_t* stats = broker_GetStats();
+
+    printf("broker up, then connection lost\n");
+    broker_SetUp(true);
+    conn_test_nextAttempt(2 * CONN_TEST_MIN_MS);
+    CONN_TEST_CHECK(stats->connected);
+    CONN_TEST_CHECK(swi_mangoh_data_router_conn_isConnected(&Mqtt.conn));
+
+    broker_Drop();
+    le_test_RunEvents();
+    CONN_TEST_CHECK(Mqtt.conn.state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_BACKOFF);
+    conn_test_checkBackoff(conn_test_nextAttempt(CONN_TEST_MAX_MS), CONN_TEST_MIN_MS);
+    CONN_TEST_CHECK(swi_mangoh_data_router_conn_isConnected(&Mqtt.conn));
+}
+
+static void conn_test_shared
+(
+    void
+)
+{
+    const broker_Stats_t* stats = broker_GetStats();
+    uint32_t numConnects = stats->numConnects;
+
+    printf("connection shared by the sessions of the same URL and password\n");
+    CONN_TEST_CHECK(!swi_mangoh_data_router_mqttSessionStart(
+        "conn_test2", "broker.local", "other", &Mqtt, &Db));
+    CONN_TEST_CHECK(!swi_mangoh_data_router_mqttSessionStart(
+        "conn_test2", "other.local", "password", &Mqtt, &Db));
+    CONN_TEST_CHECK(Mqtt.numSessions == 1);
+
+    swi_mangoh_data_router_mqtt_client_t* client = swi_mangoh_data_router_mqttSessionStart(
+        "conn_test2", "broker.local", "password", &Mqtt, &Db);
+    CONN_TEST_CHECK(client && (Mqtt.numSessions == 2));
+    swi_mangoh_data_router_mqttSessionEnd(client);
+    le_test_RunEvents();
+    CONN_TEST_CHECK((Mqtt.numSessions == 1) && stats->connected);
+    CONN_TEST_CHECK(stats->numConnects == numConnects);
+    NumChecks++;
+}
+
+static void conn_test_drain
+(
+    swi_mangoh_data_router_mqtt_client_t* client
+)
+{
+    const broker_Stats_t* stats = broker_GetStats();
+
+    printf("session ended with queued requests while the broker is down\n");
+    broker_SetUp(false);
+    broker_Drop();
+    le_test_RunEvents();
+
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_createDataItem(&Db, "sensor/temperature");
+    LE_ASSERT(dbItem);
+    dbItem->priority = DATAROUTER_PRIORITY_NORMAL;
+    swi_mangoh_data_router_db_beginUpdate(dbItem);
+    swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_FLOAT);
+    swi_mangoh_data_router_db_setFloatValue(dbItem, 21.5);
+    swi_mangoh_data_router_db_setTimestamp(dbItem, 1);
+    swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+    CONN_TEST_CHECK(swi_mangoh_data_router_mqttWrite(dbItem->key, dbItem, client) == LE_OK);
+
+    // Queued by the connection, there is no spool
+    swi_mangoh_data_router_aggregate_t aggregate = { .count = 1, .min = 21.5, .max = 21.5,
+                                                     .mean = 21.5, .last = 21.5, .start = 1,
+                                                     .end = 1 };
+    swi_mangoh_data_router_mqttSendAggregate(dbItem->key, &aggregate, &Mqtt);
+    CONN_TEST_CHECK(Mqtt.numQueuedAggregates[DATAROUTER_PRIORITY_NORMAL] == 1);
+
+    swi_mangoh_data_router_mqttSessionEnd(client);
+    CONN_TEST_CHECK(Mqtt.conn.state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_DISCONNECTING);
+    conn_test_checkBackoff(conn_test_nextAttempt(CONN_TEST_MAX_MS), CONN_TEST_MIN_MS);
+    CONN_TEST_CHECK(Mqtt.conn.state == SWI_MANGOH_DATA_ROUTER_CONN_STATE_DISCONNECTING);
+
+    le_test_AdvanceClock(CONN_TEST_MIN_MS / 4);
+    le_test_SetDataConnection(true);
+    conn_test_checkNetworkRetry(conn_test_nextAttempt(CONN_TEST_MAX_MS));
+    CONN_TEST_CHECK(!stats->numMessages);
+
+    broker_SetUp(true);
+    conn_test_nextAttempt(CONN_TEST_MAX_MS);
+    le_test_AdvanceClock(SWI_MANGOH_DATA_ROUTER_MQTT_DRAIN_INTERVAL_MS);
+    CONN_TEST_CHECK(stats->numMessages == 2);
+    CONN_TEST_CHECK(Mqtt.numAggregates == 1);
+    CONN_TEST_CHECK(stats->numDisconnects == 1);
+    CONN_TEST_CHECK(!stats->connected);
+    CONN_TEST_CHECK(!Mqtt.open);
+    NumChecks++;
+}
+
+static void conn_test_closed
+(
+    void
+)
+{
+    const broker_Stats_t* stats = broker_GetStats();
+    uint32_t numConnects = stats->numConnects;
+
+    printf("closed, no connect for an hour\n");
+    le_test_SetDataConnection(true);
+    le_test_AdvanceClock(3600 * 1000);
+    CONN_TEST_CHECK(stats->numConnects == numConnects);
+    NumChecks++;
+}
+
+// First retry delays of a fleet losing the broker at once, seeded as mqtt.c seeds them
+static void conn_test_fleet
+(
+    void
+)
+{
+    uint32_t buckets[CONN_TEST_FLEET_BUCKETS] = {0};
+    uint32_t minNum = UINT32_MAX;
+    uint32_t maxNum = 0;
+
+    for (uint32_t i = 0; i < CONN_TEST_FLEET_SIZE; i++)
+    {
+        swi_mangoh_data_router_conn_t conn;
+        uint32_t usec = (i * 7919) % 1000000;
+        uint32_t relativeUsec = (i * 104729) % 1000000;
+
+        swi_mangoh_data_router_conn_init(
+            &conn,
+            SWI_MANGOH_DATA_ROUTER_MQTT_RECONNECT_MIN_MS,
+            SWI_MANGOH_DATA_ROUTER_MQTT_RECONNECT_MAX_MS,
+            SWI_MANGOH_DATA_ROUTER_MQTT_NETWORK_RETRY_MS,
+            1500000000 ^ (usec << 12) ^ relativeUsec);
+        swi_mangoh_data_router_conn_handleEvent(&conn, SWI_MANGOH_DATA_ROUTER_CONN_EVENT_START);
+        swi_mangoh_data_router_conn_handleEvent(&conn, SWI_MANGOH_DATA_ROUTER_CONN_EVENT_CONNECTED);
+        CONN_TEST_CHECK(swi_mangoh_data_router_conn_handleEvent(
+                            &conn, SWI_MANGOH_DATA_ROUTER_CONN_EVENT_DISCONNECTED) ==
+                        SWI_MANGOH_DATA_ROUTER_CONN_ACTION_WAIT);
+
+        uint32_t halfMs = SWI_MANGOH_DATA_ROUTER_MQTT_RECONNECT_MIN_MS / 2;
+        CONN_TEST_CHECK(conn.delayMs >= halfMs);
+        CONN_TEST_CHECK(conn.delayMs <= 2 * halfMs);
+        uint32_t bucket = (conn.delayMs - halfMs) * CONN_TEST_FLEET_BUCKETS / (halfMs + 1);
+        buckets[bucket]++;
+    }
+
+    printf("fleet of %u, first retries per %u ms:", CONN_TEST_FLEET_SIZE,
+           SWI_MANGOH_DATA_ROUTER_MQTT_RECONNECT_MIN_MS / 2 / CONN_TEST_FLEET_BUCKETS);
+    for (uint32_t i = 0; i < CONN_TEST_FLEET_BUCKETS; i++)
+    {
+        printf(" %u", buckets[i]);
+        minNum = (buckets[i] < minNum) ? buckets[i] : minNum;
+        maxNum = (buckets[i] > maxNum) ? buckets[i] : maxNum;
+    }
+    printf("\n");
+
+    // Uniform would be 100 per bucket
+    CONN_TEST_CHECK(minNum >= 60);
+    CONN_TEST_CHECK(maxNum <= 140);
+    NumChecks++;
+}
+
+int main
+(
+    void
+)
+{
+    le_test_SimulateClock();
+    le_test_SetCfgString(SWI_MANGOH_DATA_ROUTER_MQTT_CFG_SPOOL_PATH, "");
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_MQTT_CFG_RECONNECT_MIN, CONN_TEST_MIN_MS);
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_MQTT_CFG_RECONNECT_MAX, CONN_TEST_MAX_MS);
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_MQTT_CFG_NETWORK_RETRY, CONN_TEST_NETWORK_RETRY_MS);
+    swi_mangoh_data_router_db_init(&Db);
+
+    swi_mangoh_data_router_mqtt_client_t* client = swi_mangoh_data_router_mqttSessionStart(
+        "conn_test", "broker.local", "password", &Mqtt, &Db);
+    LE_ASSERT(client);
+    CONN_TEST_CHECK(broker_GetStats()->numConnects == 1);
+    le_test_RunEvents();
+
+    conn_test_backoff();
+    conn_test_networkUp();
+    conn_test_connectionLost();
+    conn_test_shared();
+    conn_test_drain(client);
+    conn_test_closed();
+    conn_test_fleet();
+
+    printf("conn_test: %u checks passed, %u connect attempts\n", NumChecks,
+           broker_GetStats()->numConnects);
+    return EXIT_SUCCESS;
+}
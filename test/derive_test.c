@@ -0,0 +1,217 @@
+/**
+ * @file
+ *
+ * Test of the derived keys: malformed expressions are rejected without reading past their end,
+ * valid ones are evaluated once per batch of source updates, in level order, and the derived keys
+ * are removed by their owner, one at a time or all of them when its session ends.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "db.h"
+#include "derive.h"
+
+#define DERIVE_TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+static swi_mangoh_data_router_db_t Db;
+static swi_mangoh_data_router_derive_t Derive;
+// Stand-ins for the sessions owning the derived keys
+static int Owner;
+static int Other;
+
+static uint32_t NumUpdates;
+static uint32_t NumChecks;
+
+// Derived updates feed the keys derived from them, as the router does
+static void derive_test_handler
+(
+    const char* key,
+    const swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    NumUpdates++;
+    swi_mangoh_data_router_derive_update(&Derive, dbItem);
+}
+
+static void derive_test_writeFloat
+(
+    const char* key,
+    double value
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_db_getDataItem(&Db, key);
+
+    if (!dbItem)
+    {
+        dbItem = swi_mangoh_data_router_db_createDataItem(&Db, key);
+        LE_ASSERT(dbItem);
+    }
+
+    swi_mangoh_data_router_db_beginUpdate(dbItem);
+    swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_FLOAT);
+    swi_mangoh_data_router_db_setFloatValue(dbItem, value);
+    swi_mangoh_data_router_db_setTimestamp(dbItem, 1);
+    swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+    swi_mangoh_data_router_derive_update(&Derive, dbItem);
+}
+
+static double derive_test_read
+(
+    const char* key
+)
+{
+    const swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(&Db, key);
+
+    DERIVE_TEST_CHECK(dbItem && dbItem->hasValue);
+    DERIVE_TEST_CHECK(dbItem->data.type == DATAROUTER_FLOAT);
+    return dbItem->data.fValue;
+}
+
+// The expression is copied to a buffer of its exact size, so that ASan catches a read past its end
+static le_result_t derive_test_define
+(
+    const char* key,
+    const char* expression
+)
+{
+    char* copy = strdup(expression);
+
+    LE_ASSERT(copy);
+    le_result_t res = swi_mangoh_data_router_derive_define(&Derive, &Owner, key, copy);
+    free(copy);
+    return res;
+}
+
+static void derive_test_malformed
+(
+    void
+)
+{
+    static const char* expressions[] =
+    {
+        "", "(", "((1", "((1)", "(1))", "({a} + 1", "{a", "{}", "{a} +", "{a} * * 2", "-",
+        "1 2", ")", "avg", "avg(", "avg({a}", "avg({a},", "avg({a}, 0)", "avg({a}, 65)",
+        "avg({a}, 2", "avg(1, 2)", "median({a}, 2)", "{a} ^ 2", "1e",
+    };
+
+    printf("malformed expressions\n");
+    for (uint32_t i = 0; i < NUM_ARRAY_MEMBERS(expressions); i++)
+    {
+        printf("    '%s'\n", expressions[i]);
+        DERIVE_TEST_CHECK(derive_test_define("bad", expressions[i]) == LE_BAD_PARAMETER);
+        NumChecks++;
+    }
+
+    DERIVE_TEST_CHECK(derive_test_define("self", "{self} + 1") == LE_BAD_PARAMETER);
+    DERIVE_TEST_CHECK(!Derive.numDerived);
+    NumChecks++;
+}
+
+static void derive_test_evaluate
+(
+    void
+)
+{
+    printf("derived keys evaluated once per batch, in level order\n");
+    DERIVE_TEST_CHECK(derive_test_define("total", "{ch1} + {ch2}") == LE_OK);
+    DERIVE_TEST_CHECK(derive_test_define("fahrenheit", "({total} * 1.8) + 32") == LE_OK);
+    DERIVE_TEST_CHECK(derive_test_define("mean", "avg({ch1}, 2)") == LE_OK);
+    DERIVE_TEST_CHECK(derive_test_define("total", "{ch1}") == LE_DUPLICATE);
+
+    // Not published until every source holds a value
+    NumUpdates = 0;
+    derive_test_writeFloat("ch1", 10);
+    le_test_RunEvents();
+    DERIVE_TEST_CHECK(NumUpdates == 1);
+    DERIVE_TEST_CHECK(derive_test_read("mean") == 10);
+
+    NumUpdates = 0;
+    derive_test_writeFloat("ch1", 20);
+    derive_test_writeFloat("ch2", 5);
+    le_test_RunEvents();
+    DERIVE_TEST_CHECK(NumUpdates == 3);
+    DERIVE_TEST_CHECK(derive_test_read("total") == 25);
+    DERIVE_TEST_CHECK(derive_test_read("fahrenheit") == 25 * 1.8 + 32);
+    DERIVE_TEST_CHECK(derive_test_read("mean") == 15);
+    NumChecks++;
+}
+
+static void derive_test_remove
+(
+    void
+)
+{
+    printf("derived keys removed by their owner\n");
+    DERIVE_TEST_CHECK(swi_mangoh_data_router_derive_define(
+        &Derive, &Other, "double", "{ch2} * 2") == LE_OK);
+    DERIVE_TEST_CHECK(Derive.numDerived == 4);
+    DERIVE_TEST_CHECK(swi_mangoh_data_router_derive_remove(&Derive, &Other, "total") ==
+                      LE_NOT_FOUND);
+    DERIVE_TEST_CHECK(swi_mangoh_data_router_derive_remove(&Derive, &Owner, "ch1") ==
+                      LE_NOT_FOUND);
+
+    // The last derived key moves to the freed slot, the source masks follow it
+    DERIVE_TEST_CHECK(swi_mangoh_data_router_derive_remove(&Derive, &Owner, "total") == LE_OK);
+    DERIVE_TEST_CHECK(Derive.numDerived == 3);
+    NumUpdates = 0;
+    derive_test_writeFloat("ch1", 30);
+    derive_test_writeFloat("ch2", 7);
+    le_test_RunEvents();
+    DERIVE_TEST_CHECK(NumUpdates == 2);
+    DERIVE_TEST_CHECK(derive_test_read("total") == 25);
+    DERIVE_TEST_CHECK(derive_test_read("mean") == 25);
+    DERIVE_TEST_CHECK(derive_test_read("double") == 14);
+    DERIVE_TEST_CHECK(swi_mangoh_data_router_db_getDataItem(&Db, "ch1")->deriveMask == 0x4);
+    DERIVE_TEST_CHECK(swi_mangoh_data_router_db_getDataItem(&Db, "ch2")->deriveMask == 0x1);
+
+    // A removed key is a plain key, the keys derived from it follow its writes
+    derive_test_writeFloat("total", 100);
+    le_test_RunEvents();
+    DERIVE_TEST_CHECK(derive_test_read("fahrenheit") == 100 * 1.8 + 32);
+    DERIVE_TEST_CHECK(derive_test_define("total", "{ch1} - {ch2}") == LE_OK);
+    le_test_RunEvents();
+    DERIVE_TEST_CHECK(derive_test_read("total") == 23);
+
+    // The session ends, only its derived keys are removed
+    swi_mangoh_data_router_derive_removeOwner(&Derive, &Owner);
+    DERIVE_TEST_CHECK((Derive.numDerived == 1) && (Derive.derived[0]->owner == &Other));
+    DERIVE_TEST_CHECK(!swi_mangoh_data_router_db_getDataItem(&Db, "ch1")->deriveMask);
+    NumUpdates = 0;
+    derive_test_writeFloat("ch1", 1);
+    derive_test_writeFloat("ch2", 8);
+    le_test_RunEvents();
+    DERIVE_TEST_CHECK((NumUpdates == 1) && (derive_test_read("double") == 16));
+    DERIVE_TEST_CHECK(derive_test_read("total") == 23);
+    swi_mangoh_data_router_derive_removeOwner(&Derive, &Other);
+    DERIVE_TEST_CHECK(!Derive.numDerived);
+    NumChecks++;
+}
+
+int main
+(
+    void
+)
+{
+    swi_mangoh_data_router_db_init(&Db);
+    swi_mangoh_data_router_derive_init(&Derive, &Db, derive_test_handler);
+
+    derive_test_malformed();
+    derive_test_evaluate();
+    derive_test_remove();
+
+    printf("derive_test: %u checks passed\n", NumChecks);
+    return EXIT_SUCCESS;
+}
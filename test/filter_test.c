@@ -0,0 +1,202 @@
+/**
+ * @file
+ *
+ * Test of the subscriber update filters: invalid predicates are rejected, and the edge and range
+ * filters match on the transitions of their state, which is unknown until the key has a value.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "filter.h"
+
+#define FILTER_TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+static uint32_t NumChecks;
+
+static swi_mangoh_data_router_data_t filter_test_float
+(
+    double value
+)
+{
+    swi_mangoh_data_router_data_t data = { .type = DATAROUTER_FLOAT, .fValue = value };
+
+    return data;
+}
+
+static swi_mangoh_data_router_data_t filter_test_boolean
+(
+    bool value
+)
+{
+    swi_mangoh_data_router_data_t data = { .type = DATAROUTER_BOOLEAN, .bValue = value };
+
+    return data;
+}
+
+static bool filter_test_matchFloat
+(
+    swi_mangoh_data_router_filter_t* filter,
+    double value
+)
+{
+    swi_mangoh_data_router_data_t data = filter_test_float(value);
+
+    return swi_mangoh_data_router_filter_match(filter, &data);
+}
+
+static bool filter_test_matchBoolean
+(
+    swi_mangoh_data_router_filter_t* filter,
+    bool value
+)
+{
+    swi_mangoh_data_router_data_t data = filter_test_boolean(value);
+
+    return swi_mangoh_data_router_filter_match(filter, &data);
+}
+
+static void filter_test_invalid
+(
+    void
+)
+{
+    swi_mangoh_data_router_filter_t filter;
+
+    printf("invalid predicates\n");
+    FILTER_TEST_CHECK(swi_mangoh_data_router_filter_init(
+        &filter, (dataRouter_Filter_t)(DATAROUTER_FILTER_EQUALS + 1), 0, 0, "", NULL) ==
+        LE_BAD_PARAMETER);
+    FILTER_TEST_CHECK(swi_mangoh_data_router_filter_init(
+        &filter, DATAROUTER_FILTER_ENTER_RANGE, 2, 1, "", NULL) == LE_BAD_PARAMETER);
+    FILTER_TEST_CHECK(swi_mangoh_data_router_filter_init(
+        &filter, DATAROUTER_FILTER_EXIT_RANGE, NAN, 1, "", NULL) == LE_BAD_PARAMETER);
+    FILTER_TEST_CHECK(!filter.enabled);
+    NumChecks++;
+}
+
+static void filter_test_threshold
+(
+    void
+)
+{
+    swi_mangoh_data_router_filter_t filter;
+    swi_mangoh_data_router_data_t data = { .type = DATAROUTER_STRING };
+
+    printf("thresholds and strings\n");
+    FILTER_TEST_CHECK(swi_mangoh_data_router_filter_init(
+        &filter, DATAROUTER_FILTER_ABOVE, 10, 0, "", NULL) == LE_OK);
+    FILTER_TEST_CHECK(!filter_test_matchFloat(&filter, 10));
+    FILTER_TEST_CHECK(filter_test_matchFloat(&filter, 10.5));
+    strcpy(data.sValue, "11");
+    FILTER_TEST_CHECK(!swi_mangoh_data_router_filter_match(&filter, &data));
+    FILTER_TEST_CHECK((filter.numMatched == 1) && (filter.numFiltered == 2));
+
+    FILTER_TEST_CHECK(swi_mangoh_data_router_filter_init(
+        &filter, DATAROUTER_FILTER_EQUALS, 0, 0, "open", NULL) == LE_OK);
+    strcpy(data.sValue, "open");
+    FILTER_TEST_CHECK(swi_mangoh_data_router_filter_match(&filter, &data));
+    strcpy(data.sValue, "closed");
+    FILTER_TEST_CHECK(!swi_mangoh_data_router_filter_match(&filter, &data));
+    NumChecks++;
+}
+
+static void filter_test_range
+(
+    void
+)
+{
+    swi_mangoh_data_router_filter_t filter;
+    swi_mangoh_data_router_data_t current = filter_test_float(0);
+
+    printf("range filters\n");
+
+    // No value yet, the first value in the range enters it
+    FILTER_TEST_CHECK(swi_mangoh_data_router_filter_init(
+        &filter, DATAROUTER_FILTER_ENTER_RANGE, -1, 1, "", NULL) == LE_OK);
+    FILTER_TEST_CHECK(filter_test_matchFloat(&filter, 0));
+    FILTER_TEST_CHECK(!filter_test_matchFloat(&filter, 0.5));
+    FILTER_TEST_CHECK(!filter_test_matchFloat(&filter, 5));
+    FILTER_TEST_CHECK(filter_test_matchFloat(&filter, 1));
+
+    // No value yet, the first value out of the range does not enter it
+    FILTER_TEST_CHECK(swi_mangoh_data_router_filter_init(
+        &filter, DATAROUTER_FILTER_ENTER_RANGE, -1, 1, "", NULL) == LE_OK);
+    FILTER_TEST_CHECK(!filter_test_matchFloat(&filter, 5));
+    FILTER_TEST_CHECK(filter_test_matchFloat(&filter, -1));
+
+    // Already in the range when attached
+    FILTER_TEST_CHECK(swi_mangoh_data_router_filter_init(
+        &filter, DATAROUTER_FILTER_ENTER_RANGE, -1, 1, "", &current) == LE_OK);
+    FILTER_TEST_CHECK(!filter_test_matchFloat(&filter, 0.5));
+    FILTER_TEST_CHECK(!filter_test_matchFloat(&filter, 2));
+    FILTER_TEST_CHECK(filter_test_matchFloat(&filter, 0.5));
+
+    FILTER_TEST_CHECK(swi_mangoh_data_router_filter_init(
+        &filter, DATAROUTER_FILTER_EXIT_RANGE, -1, 1, "", NULL) == LE_OK);
+    FILTER_TEST_CHECK(filter_test_matchFloat(&filter, 3));
+    FILTER_TEST_CHECK(!filter_test_matchFloat(&filter, 4));
+    FILTER_TEST_CHECK(!filter_test_matchFloat(&filter, 0));
+    FILTER_TEST_CHECK(filter_test_matchFloat(&filter, -3));
+    NumChecks++;
+}
+
+static void filter_test_edge
+(
+    void
+)
+{
+    swi_mangoh_data_router_filter_t filter;
+    swi_mangoh_data_router_data_t current = filter_test_boolean(true);
+    swi_mangoh_data_router_data_t text = { .type = DATAROUTER_STRING };
+
+    printf("edge filters\n");
+
+    // No value yet, the first true is a rising edge
+    FILTER_TEST_CHECK(swi_mangoh_data_router_filter_init(
+        &filter, DATAROUTER_FILTER_RISING_EDGE, 0, 0, "", NULL) == LE_OK);
+    FILTER_TEST_CHECK(filter_test_matchBoolean(&filter, true));
+    FILTER_TEST_CHECK(!filter_test_matchBoolean(&filter, true));
+    FILTER_TEST_CHECK(!filter_test_matchBoolean(&filter, false));
+    FILTER_TEST_CHECK(filter_test_matchBoolean(&filter, true));
+
+    // A value of another type leaves the state unknown
+    FILTER_TEST_CHECK(swi_mangoh_data_router_filter_init(
+        &filter, DATAROUTER_FILTER_FALLING_EDGE, 0, 0, "", &text) == LE_OK);
+    FILTER_TEST_CHECK(!swi_mangoh_data_router_filter_match(&filter, &text));
+    FILTER_TEST_CHECK(filter_test_matchBoolean(&filter, false));
+    FILTER_TEST_CHECK(!filter_test_matchBoolean(&filter, false));
+
+    // True when attached
+    FILTER_TEST_CHECK(swi_mangoh_data_router_filter_init(
+        &filter, DATAROUTER_FILTER_EDGE, 0, 0, "", &current) == LE_OK);
+    FILTER_TEST_CHECK(!filter_test_matchBoolean(&filter, true));
+    FILTER_TEST_CHECK(filter_test_matchBoolean(&filter, false));
+    FILTER_TEST_CHECK(filter_test_matchBoolean(&filter, true));
+    NumChecks++;
+}
+
+int main
+(
+    void
+)
+{
+    filter_test_invalid();
+    filter_test_threshold();
+    filter_test_range();
+    filter_test_edge();
+
+    printf("filter_test: %u checks passed\n", NumChecks);
+    return EXIT_SUCCESS;
+}
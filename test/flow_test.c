@@ -0,0 +1,153 @@
+/**
+ * @file
+ *
+ * Test of the flow control of flow.c on the simulated clock: the producers are signalled once
+ * when the fill reaches the high watermark and once when it falls to the low watermark, not while
+ * the fill hovers between them, and the fill is checked on the check timer while congested, as
+ * the queues drain without pushes.  Invalid watermarks fall back to the defaults.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "flow.h"
+
+#define FLOW_TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+#define FLOW_TEST_HIGH_WATERMARK 60
+#define FLOW_TEST_LOW_WATERMARK 20
+#define FLOW_TEST_CHECK_INTERVAL_MS 500
+
+static uint32_t Fill;
+static uint32_t NumCongested;
+static uint32_t NumDrained;
+static uint32_t NumChecks;
+
+static uint32_t flow_test_fill
+(
+    void
+)
+{
+    return Fill;
+}
+
+static void flow_test_handler
+(
+    bool congested
+)
+{
+    if (congested)
+    {
+        NumCongested++;
+    }
+    else
+    {
+        NumDrained++;
+    }
+}
+
+static void flow_test_hysteresis
+(
+    void
+)
+{
+    swi_mangoh_data_router_flow_t flow;
+    static const uint32_t fills[] = { 0, 59, 60, 90, 40, 59, 61, 21, 20, 40, 59, 100, 0 };
+    static const bool congested[] = {
+        false, false, true, true, true, true, true, true, false, false, false, true, false };
+
+    printf("signalled on the watermarks only\n");
+    swi_mangoh_data_router_flow_init(&flow, flow_test_fill, flow_test_handler);
+    FLOW_TEST_CHECK((flow.highWatermark == FLOW_TEST_HIGH_WATERMARK) &&
+                    (flow.lowWatermark == FLOW_TEST_LOW_WATERMARK));
+
+    for (uint32_t i = 0; i < NUM_ARRAY_MEMBERS(fills); i++)
+    {
+        Fill = fills[i];
+        FLOW_TEST_CHECK(swi_mangoh_data_router_flow_check(&flow) == congested[i]);
+    }
+
+    FLOW_TEST_CHECK((NumCongested == 2) && (NumDrained == 2) && (flow.numCongestions == 2));
+    NumChecks++;
+}
+
+static void flow_test_timer
+(
+    void
+)
+{
+    swi_mangoh_data_router_flow_t flow;
+
+    printf("fill checked on the timer while congested\n");
+    NumCongested = 0;
+    NumDrained = 0;
+    swi_mangoh_data_router_flow_init(&flow, flow_test_fill, flow_test_handler);
+    Fill = 100;
+    FLOW_TEST_CHECK(swi_mangoh_data_router_flow_check(&flow));
+
+    // The queues drain without pushes, the producers are told on the next check
+    Fill = FLOW_TEST_LOW_WATERMARK;
+    le_test_AdvanceClock(FLOW_TEST_CHECK_INTERVAL_MS - 1);
+    le_test_RunEvents();
+    FLOW_TEST_CHECK(flow.congested && !NumDrained);
+    le_test_AdvanceClock(1);
+    le_test_RunEvents();
+    FLOW_TEST_CHECK(!flow.congested && (NumDrained == 1));
+
+    // The timer is stopped once drained
+    Fill = 100;
+    le_test_AdvanceClock(10 * FLOW_TEST_CHECK_INTERVAL_MS);
+    le_test_RunEvents();
+    FLOW_TEST_CHECK(!flow.congested && (NumCongested == 1));
+    NumChecks++;
+}
+
+static void flow_test_invalid
+(
+    void
+)
+{
+    swi_mangoh_data_router_flow_t flow;
+
+    printf("invalid watermarks fall back to the defaults\n");
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_FLOW_CFG_HIGH_WATERMARK, FLOW_TEST_LOW_WATERMARK);
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_FLOW_CFG_LOW_WATERMARK, FLOW_TEST_HIGH_WATERMARK);
+    swi_mangoh_data_router_flow_init(&flow, flow_test_fill, flow_test_handler);
+    FLOW_TEST_CHECK((flow.highWatermark == SWI_MANGOH_DATA_ROUTER_FLOW_HIGH_WATERMARK) &&
+                    (flow.lowWatermark == SWI_MANGOH_DATA_ROUTER_FLOW_LOW_WATERMARK));
+
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_FLOW_CFG_HIGH_WATERMARK, 101);
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_FLOW_CFG_LOW_WATERMARK, FLOW_TEST_LOW_WATERMARK);
+    swi_mangoh_data_router_flow_init(&flow, flow_test_fill, flow_test_handler);
+    FLOW_TEST_CHECK(flow.highWatermark == SWI_MANGOH_DATA_ROUTER_FLOW_HIGH_WATERMARK);
+    NumChecks++;
+}
+
+int main
+(
+    void
+)
+{
+    le_test_SimulateClock();
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_FLOW_CFG_HIGH_WATERMARK, FLOW_TEST_HIGH_WATERMARK);
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_FLOW_CFG_LOW_WATERMARK, FLOW_TEST_LOW_WATERMARK);
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_FLOW_CFG_CHECK_INTERVAL, FLOW_TEST_CHECK_INTERVAL_MS);
+
+    flow_test_hysteresis();
+    flow_test_timer();
+    flow_test_invalid();
+
+    printf("flow_test: %u checks passed\n", NumChecks);
+    return EXIT_SUCCESS;
+}
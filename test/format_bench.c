@@ -0,0 +1,183 @@
+/**
+ * @file
+ *
+ * Value formatting and parsing of the MQTT path: snprintf with %f and %d then atof and atoi as
+ * before, against the shortest round trip text serializer and checked parsers of text.c.  Each
+ * value of a trace of floats and integers is formatted then parsed back, and the time, the length
+ * and the values not read back the same are reported per method.
+ *
+ *   format_bench [<rounds>]
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "text.h"
+
+#define FORMAT_BENCH_TRACE_LEN 64
+#define FORMAT_BENCH_VALUE_MAX_LEN 64
+#define FORMAT_BENCH_NUM_ROUNDS 50000
+
+static double Floats[FORMAT_BENCH_TRACE_LEN];
+static int32_t Ints[FORMAT_BENCH_TRACE_LEN];
+
+// Half sensor readings with two decimals and half computed values which need all their digits
+static void format_bench_buildTrace
+(
+    void
+)
+{
+    for (uint32_t i = 0; i < FORMAT_BENCH_TRACE_LEN; i++)
+    {
+        Floats[i] = (i % 2) ? (double)((i * 3217) % 100000) / 100 : 9.81 * i / 7;
+        Ints[i] = (int32_t)(i * 7919) - 250000;
+    }
+}
+
+static void format_bench_print
+(
+    const char* method,
+    size_t bytes,
+    uint32_t errors,
+    uint64_t elapsedNs,
+    uint32_t rounds
+)
+{
+    printf("  %-14s %6.2f bytes/value  %2u round trip errors  %6.1f ns/value\n",
+           method,
+           (double)bytes / FORMAT_BENCH_TRACE_LEN,
+           errors,
+           (double)elapsedNs / ((uint64_t)rounds * FORMAT_BENCH_TRACE_LEN));
+}
+
+static void format_bench_floatSnprintf
+(
+    uint32_t rounds
+)
+{
+    char buf[FORMAT_BENCH_VALUE_MAX_LEN];
+    size_t bytes = 0;
+    uint32_t errors = 0;
+    uint64_t startNs = le_test_NowNs();
+
+    for (uint32_t i = 0; i < rounds; i++)
+    {
+        bytes = 0;
+        errors = 0;
+        for (uint32_t j = 0; j < FORMAT_BENCH_TRACE_LEN; j++)
+        {
+            bytes += snprintf(buf, sizeof(buf), "%f", Floats[j]);
+            errors += (atof(buf) != Floats[j]);
+        }
+    }
+
+    format_bench_print("float snprintf", bytes, errors, le_test_NowNs() - startNs, rounds);
+}
+
+static void format_bench_floatText
+(
+    uint32_t rounds
+)
+{
+    char buf[FORMAT_BENCH_VALUE_MAX_LEN];
+    swi_mangoh_data_router_text_t text;
+    size_t bytes = 0;
+    uint32_t errors = 0;
+    uint64_t startNs = le_test_NowNs();
+
+    for (uint32_t i = 0; i < rounds; i++)
+    {
+        bytes = 0;
+        errors = 0;
+        for (uint32_t j = 0; j < FORMAT_BENCH_TRACE_LEN; j++)
+        {
+            double value = 0;
+
+            swi_mangoh_data_router_text_init(&text, buf, sizeof(buf));
+            swi_mangoh_data_router_text_encodeDouble(&text, Floats[j]);
+            bytes += text.used;
+            errors += (swi_mangoh_data_router_text_parseDouble(buf, &value) != LE_OK) ||
+                      (value != Floats[j]);
+        }
+    }
+
+    format_bench_print("float text", bytes, errors, le_test_NowNs() - startNs, rounds);
+}
+
+static void format_bench_intSnprintf
+(
+    uint32_t rounds
+)
+{
+    char buf[FORMAT_BENCH_VALUE_MAX_LEN];
+    size_t bytes = 0;
+    uint32_t errors = 0;
+    uint64_t startNs = le_test_NowNs();
+
+    for (uint32_t i = 0; i < rounds; i++)
+    {
+        bytes = 0;
+        errors = 0;
+        for (uint32_t j = 0; j < FORMAT_BENCH_TRACE_LEN; j++)
+        {
+            bytes += snprintf(buf, sizeof(buf), "%d", Ints[j]);
+            errors += (atoi(buf) != Ints[j]);
+        }
+    }
+
+    format_bench_print("int snprintf", bytes, errors, le_test_NowNs() - startNs, rounds);
+}
+
+static void format_bench_intText
+(
+    uint32_t rounds
+)
+{
+    char buf[FORMAT_BENCH_VALUE_MAX_LEN];
+    swi_mangoh_data_router_text_t text;
+    size_t bytes = 0;
+    uint32_t errors = 0;
+    uint64_t startNs = le_test_NowNs();
+
+    for (uint32_t i = 0; i < rounds; i++)
+    {
+        bytes = 0;
+        errors = 0;
+        for (uint32_t j = 0; j < FORMAT_BENCH_TRACE_LEN; j++)
+        {
+            int32_t value = 0;
+
+            swi_mangoh_data_router_text_init(&text, buf, sizeof(buf));
+            swi_mangoh_data_router_text_encodeInt(&text, Ints[j]);
+            bytes += text.used;
+            errors += (swi_mangoh_data_router_text_parseInt(buf, &value) != LE_OK) ||
+                      (value != Ints[j]);
+        }
+    }
+
+    format_bench_print("int text", bytes, errors, le_test_NowNs() - startNs, rounds);
+}
+
+int main
+(
+    int argc,
+    char** argv
+)
+{
+    uint32_t rounds = (argc > 1) ? atoi(argv[1]) : FORMAT_BENCH_NUM_ROUNDS;
+
+    LE_ASSERT(rounds);
+    format_bench_buildTrace();
+
+    printf("value format and parse back, %u rounds of %u values\n",
+           rounds, FORMAT_BENCH_TRACE_LEN);
+    format_bench_floatSnprintf(rounds);
+    format_bench_floatText(rounds);
+    format_bench_intSnprintf(rounds);
+    format_bench_intText(rounds);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,181 @@
+/**
+ * @file
+ *
+ * Per operation latency of string keys against key handles: the router side of a float write and
+ * of a float read, over 1000 keys accessed in a pseudo random order.
+ *
+ * The string key operations copy the key in and out of a message buffer as the IPC does for the
+ * string key[128] parameters, and look the key up in the database map, or in the reader index for
+ * the reads.  The handle operations copy the handle and index the handle table.  The IPC round trip
+ * itself, the same for both, is not measured.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "db.h"
+
+#define HANDLE_BENCH_NUM_KEYS 1000
+#define HANDLE_BENCH_NUM_OPS 2000000
+#define HANDLE_BENCH_KEY_MAX_LEN 128
+
+static swi_mangoh_data_router_db_t Db;
+static char Keys[HANDLE_BENCH_NUM_KEYS][HANDLE_BENCH_KEY_MAX_LEN];
+static uint32_t Handles[HANDLE_BENCH_NUM_KEYS];
+static uint16_t Order[HANDLE_BENCH_NUM_OPS];
+static volatile double Sink;
+
+// Copy of a string key through a message buffer, as packed and unpacked by the IPC
+static const char* handle_bench_copyKey
+(
+    const char* key,
+    char* msg,
+    char* unpacked
+)
+{
+    size_t len = strnlen(key, HANDLE_BENCH_KEY_MAX_LEN - 1);
+
+    memcpy(msg, &len, sizeof(len));
+    memcpy(&msg[sizeof(len)], key, len);
+    memcpy(&len, msg, sizeof(len));
+    memcpy(unpacked, &msg[sizeof(len)], len);
+    unpacked[len] = '\0';
+    return unpacked;
+}
+
+static void handle_bench_store
+(
+    swi_mangoh_data_router_dbItem_t* dbItem,
+    double value
+)
+{
+    swi_mangoh_data_router_db_beginUpdate(dbItem);
+    swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_FLOAT);
+    swi_mangoh_data_router_db_setFloatValue(dbItem, value);
+    swi_mangoh_data_router_db_setTimestamp(dbItem, 1);
+    swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+}
+
+static double handle_bench_writeKeys
+(
+    void
+)
+{
+    char msg[sizeof(size_t) + HANDLE_BENCH_KEY_MAX_LEN];
+    char key[HANDLE_BENCH_KEY_MAX_LEN];
+    uint64_t start = le_test_NowNs();
+
+    for (uint32_t i = 0; i < HANDLE_BENCH_NUM_OPS; i++)
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_db_getDataItem(
+            &Db, handle_bench_copyKey(Keys[Order[i]], msg, key));
+        handle_bench_store(dbItem, i);
+    }
+
+    return (double)(le_test_NowNs() - start) / HANDLE_BENCH_NUM_OPS;
+}
+
+static double handle_bench_writeHandles
+(
+    void
+)
+{
+    uint32_t msg;
+    uint64_t start = le_test_NowNs();
+
+    for (uint32_t i = 0; i < HANDLE_BENCH_NUM_OPS; i++)
+    {
+        msg = Handles[Order[i]];
+        swi_mangoh_data_router_dbItem_t* dbItem =
+            swi_mangoh_data_router_db_getDataItemByHandle(&Db, msg);
+        handle_bench_store(dbItem, i);
+    }
+
+    return (double)(le_test_NowNs() - start) / HANDLE_BENCH_NUM_OPS;
+}
+
+static double handle_bench_readKeys
+(
+    void
+)
+{
+    char msg[sizeof(size_t) + HANDLE_BENCH_KEY_MAX_LEN];
+    char key[HANDLE_BENCH_KEY_MAX_LEN];
+    swi_mangoh_data_router_data_t data;
+    uint64_t start = le_test_NowNs();
+
+    for (uint32_t i = 0; i < HANDLE_BENCH_NUM_OPS; i++)
+    {
+        const swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_db_lookupDataItem(
+            &Db, handle_bench_copyKey(Keys[Order[i]], msg, key));
+        swi_mangoh_data_router_db_readData(dbItem, &data);
+        Sink = data.fValue;
+    }
+
+    return (double)(le_test_NowNs() - start) / HANDLE_BENCH_NUM_OPS;
+}
+
+static double handle_bench_readHandles
+(
+    void
+)
+{
+    uint32_t msg;
+    swi_mangoh_data_router_data_t data;
+    uint64_t start = le_test_NowNs();
+
+    for (uint32_t i = 0; i < HANDLE_BENCH_NUM_OPS; i++)
+    {
+        msg = Handles[Order[i]];
+        const swi_mangoh_data_router_dbItem_t* dbItem =
+            swi_mangoh_data_router_db_lookupDataItemByHandle(&Db, msg);
+        swi_mangoh_data_router_db_readData(dbItem, &data);
+        Sink = data.fValue;
+    }
+
+    return (double)(le_test_NowNs() - start) / HANDLE_BENCH_NUM_OPS;
+}
+
+int main
+(
+    void
+)
+{
+    uint32_t seed = 1;
+
+    swi_mangoh_data_router_db_init(&Db);
+    for (uint32_t i = 0; i < HANDLE_BENCH_NUM_KEYS; i++)
+    {
+        snprintf(Keys[i], sizeof(Keys[i]), "/app/sensors/environment/node%03u/temperature", i);
+        swi_mangoh_data_router_dbItem_t* dbItem =
+            swi_mangoh_data_router_db_createDataItem(&Db, Keys[i]);
+        LE_ASSERT(dbItem);
+        handle_bench_store(dbItem, 0);
+        Handles[i] = swi_mangoh_data_router_db_registerHandle(&Db, dbItem);
+        LE_ASSERT(Handles[i] != DATAROUTER_INVALID_HANDLE);
+    }
+
+    for (uint32_t i = 0; i < HANDLE_BENCH_NUM_OPS; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        Order[i] = (seed >> 16) % HANDLE_BENCH_NUM_KEYS;
+    }
+
+    printf("string keys against handles, %u keys of %zu chars, %u ops, mean ns/op\n",
+           HANDLE_BENCH_NUM_KEYS, strlen(Keys[0]), HANDLE_BENCH_NUM_OPS);
+
+    double writeKey = handle_bench_writeKeys();
+    double writeHandle = handle_bench_writeHandles();
+    printf("  write  key %6.1f  handle %6.1f  (%.1fx)\n",
+           writeKey, writeHandle, writeKey / writeHandle);
+
+    double readKey = handle_bench_readKeys();
+    double readHandle = handle_bench_readHandles();
+    printf("  read   key %6.1f  handle %6.1f  (%.1fx)\n",
+           readKey, readHandle, readKey / readHandle);
+
+    return 0;
+}
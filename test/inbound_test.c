@@ -0,0 +1,157 @@
+/**
+ * @file
+ *
+ * Test of the inbound updates of mqtt.c received from the stand-in broker:
+ *
+ * - a batch is applied in order, the last update of a key wins, the keys not in the database are
+ *   created with the type of their entry, and the subscribers of each key are notified once,
+ * - a batch with an entry that does not parse or names an unknown key without a type is rejected
+ *   as a whole,
+ * - a single update needs an existing key, a value and a timestamp that parse.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "broker.h"
+#include "db.h"
+#include "mqtt.h"
+
+#define INBOUND_TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+static swi_mangoh_data_router_db_t Db;
+static swi_mangoh_data_router_mqtt_t Mqtt;
+static uint32_t NumNotified;
+static uint32_t NumNotifiedA;
+static uint32_t NumChecks;
+
+void swi_mangoh_data_router_notifySubscribers
+(
+    const char* key,
+    const swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+    NumNotified++;
+    if (!strcmp(key, "cfg/a"))
+    {
+        NumNotifiedA++;
+    }
+}
+
+static swi_mangoh_data_router_dbItem_t* inbound_test_getItem
+(
+    const char* key
+)
+{
+    return swi_mangoh_data_router_db_getDataItem(&Db, key);
+}
+
+static void inbound_test_batch
+(
+    void
+)
+{
+    printf("batch applied in order, each key notified once\n");
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_createDataItem(&Db, "cfg/a");
+    LE_ASSERT(dbItem);
+    swi_mangoh_data_router_db_beginUpdate(dbItem);
+    swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_INTEGER);
+    swi_mangoh_data_router_db_setIntegerValue(dbItem, 1);
+    swi_mangoh_data_router_db_setTimestamp(dbItem, 1);
+    swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+
+    broker_Receive(SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_KEY,
+                   "[[\"cfg/a\",10,5], [\"cfg/b\",11,2.5,2], [\"cfg/a\",12,7]]", "0");
+    INBOUND_TEST_CHECK((dbItem->data.iValue == 7) && (dbItem->data.timestamp == 12));
+    swi_mangoh_data_router_dbItem_t* other = inbound_test_getItem("cfg/b");
+    INBOUND_TEST_CHECK(other && (other->data.type == DATAROUTER_FLOAT));
+    INBOUND_TEST_CHECK((other->data.fValue == 2.5) && (other->data.timestamp == 11));
+    INBOUND_TEST_CHECK((NumNotified == 2) && (NumNotifiedA == 1));
+    INBOUND_TEST_CHECK((Mqtt.numInboundBatches == 1) && (Mqtt.numInboundUpdates == 3));
+    INBOUND_TEST_CHECK(!Mqtt.numInboundRejected);
+    NumChecks++;
+}
+
+static void inbound_test_rejected
+(
+    void
+)
+{
+    static const char* const batches[] = {
+        "[[\"cfg/a\",13,8], [\"cfg/c\",14,1]]",
+        "[[\"cfg/a\",13,8], [\"cfg/b\",14]]",
+        "[[\"cfg/a\",13,8]",
+        "[[\"cfg/a\",13,8]] x",
+        "[[\"cfg/a\",13,8,99]]",
+    };
+
+    printf("batch with an invalid entry rejected as a whole\n");
+    NumNotified = 0;
+    for (uint32_t i = 0; i < NUM_ARRAY_MEMBERS(batches); i++)
+    {
+        broker_Receive(SWI_MANGOH_DATA_ROUTER_MQTT_BATCH_KEY, batches[i], "0");
+        INBOUND_TEST_CHECK(Mqtt.numInboundRejected == i + 1);
+    }
+
+    INBOUND_TEST_CHECK(inbound_test_getItem("cfg/a")->data.iValue == 7);
+    INBOUND_TEST_CHECK(!inbound_test_getItem("cfg/c") && !NumNotified);
+    INBOUND_TEST_CHECK((Mqtt.numInboundBatches == 1) && (Mqtt.numInboundUpdates == 3));
+    NumChecks++;
+}
+
+static void inbound_test_single
+(
+    void
+)
+{
+    uint32_t numRejected = Mqtt.numInboundRejected;
+
+    printf("single update needs an existing key\n");
+    NumNotified = 0;
+    broker_Receive("cfg/a", "9", "15");
+    swi_mangoh_data_router_dbItem_t* dbItem = inbound_test_getItem("cfg/a");
+    INBOUND_TEST_CHECK((dbItem->data.iValue == 9) && (dbItem->data.timestamp == 15));
+    INBOUND_TEST_CHECK((NumNotified == 1) && (Mqtt.numInboundUpdates == 4));
+
+    broker_Receive("cfg/d", "1", "16");
+    broker_Receive("cfg/a", "x", "16");
+    broker_Receive("cfg/a", "10", "y");
+    INBOUND_TEST_CHECK(!inbound_test_getItem("cfg/d") && (dbItem->data.iValue == 9));
+    INBOUND_TEST_CHECK((Mqtt.numInboundRejected == numRejected + 3) && (NumNotified == 1));
+    NumChecks++;
+}
+
+int main
+(
+    void
+)
+{
+    le_test_SimulateClock();
+    le_test_SetCfgString(SWI_MANGOH_DATA_ROUTER_MQTT_CFG_SPOOL_PATH, "");
+    swi_mangoh_data_router_db_init(&Db);
+    broker_SetUp(true);
+
+    swi_mangoh_data_router_mqtt_client_t* client = swi_mangoh_data_router_mqttSessionStart(
+        "inbound_test", "broker.local", "password", &Mqtt, &Db);
+    LE_ASSERT(client);
+    le_test_RunEvents();
+
+    inbound_test_batch();
+    inbound_test_rejected();
+    inbound_test_single();
+
+    printf("inbound_test: %u checks passed\n", NumChecks);
+    return EXIT_SUCCESS;
+}
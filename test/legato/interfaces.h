@@ -0,0 +1,288 @@
+/*
+ * @file interfaces.h
+ *
+ * Data router host tests.
+ *
+ * Host declarations of the APIs the data router modules use, in place of the files generated from
+ * the .api definitions.  Only the types and the functions the modules reference are declared.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#ifndef INTERFACES_HOST_SHIM_INCLUDE_GUARD
+#define INTERFACES_HOST_SHIM_INCLUDE_GUARD
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * dataRouter.api, served by router.c
+ */
+//--------------------------------------------------------------------------------------------------
+#define DATAROUTER_ARRAY_MAX_LEN 15
+#define DATAROUTER_SAMPLES_MAX_NUM 256
+#define DATAROUTER_INVALID_HANDLE 0
+
+typedef enum
+{
+    DATAROUTER_BOOLEAN = 0,
+    DATAROUTER_INTEGER = 1,
+    DATAROUTER_FLOAT = 2,
+    DATAROUTER_STRING = 3,
+    DATAROUTER_FLOAT_ARRAY = 4,
+    DATAROUTER_INTEGER_ARRAY = 5,
+} dataRouter_DataType_t;
+
+typedef enum
+{
+    DATAROUTER_CACHE = 0,
+    DATAROUTER_PERSIST = 1,
+    DATAROUTER_PERSIST_ENCRYPTED = 2,
+} dataRouter_Storage_t;
+
+typedef enum
+{
+    DATAROUTER_PRIORITY_CRITICAL = 0,
+    DATAROUTER_PRIORITY_NORMAL = 1,
+    DATAROUTER_PRIORITY_BULK = 2,
+} dataRouter_Priority_t;
+
+typedef enum
+{
+    DATAROUTER_FILTER_ABOVE = 0,
+    DATAROUTER_FILTER_BELOW = 1,
+    DATAROUTER_FILTER_ENTER_RANGE = 2,
+    DATAROUTER_FILTER_EXIT_RANGE = 3,
+    DATAROUTER_FILTER_RISING_EDGE = 4,
+    DATAROUTER_FILTER_FALLING_EDGE = 5,
+    DATAROUTER_FILTER_EDGE = 6,
+    DATAROUTER_FILTER_EQUALS = 7,
+} dataRouter_Filter_t;
+
+typedef void (*dataRouter_DataUpdateHandlerFunc_t)(dataRouter_DataType_t, const char*, void*);
+typedef void (*dataRouter_FlowControlHandlerFunc_t)(bool, void*);
+typedef void (*dataRouter_HandleUpdateHandlerFunc_t)(dataRouter_DataType_t, uint32_t, void*);
+
+typedef struct dataRouter_DataUpdateHandler* dataRouter_DataUpdateHandlerRef_t;
+typedef struct dataRouter_FilteredDataUpdateHandler* dataRouter_FilteredDataUpdateHandlerRef_t;
+typedef struct dataRouter_FlowControlHandler* dataRouter_FlowControlHandlerRef_t;
+typedef struct dataRouter_HandleUpdateHandler* dataRouter_HandleUpdateHandlerRef_t;
+
+// The client session of the calls is set with le_test_SetClientSession()
+le_msg_SessionRef_t dataRouter_GetClientSessionRef(void);
+le_msg_ServiceRef_t dataRouter_GetServiceRef(void);
+void le_test_SetClientSession(le_msg_SessionRef_t);
+
+void dataRouter_SessionStart(const char*, const char*, bool, dataRouter_Storage_t);
+void dataRouter_SessionEnd(void);
+void dataRouter_WriteBoolean(const char*, bool, uint32_t);
+void dataRouter_WriteInteger(const char*, int32_t, uint32_t);
+void dataRouter_WriteFloat(const char*, double, uint32_t);
+void dataRouter_WriteString(const char*, const char*, uint32_t);
+void dataRouter_WriteFloatArray(const char*, const double*, size_t, uint32_t);
+void dataRouter_WriteIntegerArray(const char*, const int32_t*, size_t, uint32_t);
+void dataRouter_WriteFloatSamples(const char*, const double*, size_t, const uint32_t*, size_t);
+le_result_t dataRouter_TryWriteBoolean(const char*, bool, uint32_t);
+le_result_t dataRouter_TryWriteInteger(const char*, int32_t, uint32_t);
+le_result_t dataRouter_TryWriteFloat(const char*, double, uint32_t);
+le_result_t dataRouter_TryWriteString(const char*, const char*, uint32_t);
+le_result_t dataRouter_EnableHistory(const char*, uint32_t);
+le_result_t dataRouter_SetReportThreshold(const char*, double);
+le_result_t dataRouter_SetAggregation(const char*, uint32_t, bool);
+le_result_t dataRouter_DefineDerivedKey(const char*, const char*);
+le_result_t dataRouter_RemoveDerivedKey(const char*);
+le_result_t dataRouter_AddRule(const char*, const char*, const char*);
+le_result_t dataRouter_RemoveRule(const char*);
+le_result_t dataRouter_SetPriority(const char*, dataRouter_Priority_t);
+void dataRouter_ReadBoolean(const char*, bool*, uint32_t*);
+void dataRouter_ReadInteger(const char*, int32_t*, uint32_t*);
+void dataRouter_ReadFloat(const char*, double*, uint32_t*);
+void dataRouter_ReadString(const char*, char*, size_t, uint32_t*);
+void dataRouter_ReadFloatArray(const char*, double*, size_t*, uint32_t*);
+void dataRouter_ReadIntegerArray(const char*, int32_t*, size_t*, uint32_t*);
+le_result_t dataRouter_ReadFloatHistory(
+    const char*,
+    uint32_t,
+    double*,
+    size_t*,
+    uint32_t*,
+    size_t*);
+dataRouter_DataUpdateHandlerRef_t dataRouter_AddDataUpdateHandler(
+    const char*,
+    dataRouter_DataUpdateHandlerFunc_t,
+    void*);
+void dataRouter_RemoveDataUpdateHandler(dataRouter_DataUpdateHandlerRef_t);
+dataRouter_FilteredDataUpdateHandlerRef_t dataRouter_AddFilteredDataUpdateHandler(
+    const char*,
+    dataRouter_Filter_t,
+    double,
+    double,
+    const char*,
+    dataRouter_DataUpdateHandlerFunc_t,
+    void*);
+void dataRouter_RemoveFilteredDataUpdateHandler(dataRouter_FilteredDataUpdateHandlerRef_t);
+dataRouter_FlowControlHandlerRef_t dataRouter_AddFlowControlHandler(
+    dataRouter_FlowControlHandlerFunc_t,
+    void*);
+void dataRouter_RemoveFlowControlHandler(dataRouter_FlowControlHandlerRef_t);
+le_result_t dataRouter_RegisterKey(const char*, uint32_t*);
+le_result_t dataRouter_ResolveKey(const char*, uint32_t*);
+void dataRouter_WriteBooleanByHandle(uint32_t, bool, uint32_t);
+void dataRouter_WriteIntegerByHandle(uint32_t, int32_t, uint32_t);
+void dataRouter_WriteFloatByHandle(uint32_t, double, uint32_t);
+void dataRouter_WriteStringByHandle(uint32_t, const char*, uint32_t);
+void dataRouter_ReadBooleanByHandle(uint32_t, bool*, uint32_t*);
+void dataRouter_ReadIntegerByHandle(uint32_t, int32_t*, uint32_t*);
+void dataRouter_ReadFloatByHandle(uint32_t, double*, uint32_t*);
+void dataRouter_ReadStringByHandle(uint32_t, char*, size_t, uint32_t*);
+dataRouter_HandleUpdateHandlerRef_t dataRouter_AddHandleUpdateHandler(
+    uint32_t,
+    dataRouter_HandleUpdateHandlerFunc_t,
+    void*);
+void dataRouter_RemoveHandleUpdateHandler(dataRouter_HandleUpdateHandlerRef_t);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * dataRouterReader.api, served by reader.c
+ */
+//--------------------------------------------------------------------------------------------------
+#define DATAROUTERREADER_MULTI_GET_MAX_NUM 64
+
+void dataRouterReader_AdvertiseService(void);
+le_result_t dataRouterReader_ReadBoolean(const char*, bool*, uint32_t*);
+le_result_t dataRouterReader_ReadInteger(const char*, int32_t*, uint32_t*);
+le_result_t dataRouterReader_ReadFloat(const char*, double*, uint32_t*);
+le_result_t dataRouterReader_ReadString(const char*, char*, size_t, uint32_t*);
+le_result_t dataRouterReader_MultiGet(
+    const uint32_t*,
+    size_t,
+    double*,
+    size_t*,
+    uint32_t*,
+    size_t*);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * mqtt.api, implemented by the tests that stand in for the MQTT service
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct mqtt_SessionStateHandler* mqtt_SessionStateHandlerRef_t;
+typedef struct mqtt_IncomingMessageHandler* mqtt_IncomingMessageHandlerRef_t;
+typedef void (*mqtt_SessionStateHandlerFunc_t)(bool, int32_t, int32_t, void*);
+typedef void (*mqtt_IncomingMessageHandlerFunc_t)(
+    const char*,
+    const char*,
+    const char*,
+    const char*,
+    void*);
+
+void mqtt_Config(const char*, int32_t, int32_t, int32_t);
+void mqtt_Connect(const char*);
+void mqtt_Disconnect(void);
+void mqtt_Send(const char*, const char*, int32_t*);
+mqtt_SessionStateHandlerRef_t mqtt_AddSessionStateHandler(mqtt_SessionStateHandlerFunc_t, void*);
+void mqtt_RemoveSessionStateHandler(mqtt_SessionStateHandlerRef_t);
+mqtt_IncomingMessageHandlerRef_t mqtt_AddIncomingMessageHandler(
+    mqtt_IncomingMessageHandlerFunc_t,
+    void*);
+void mqtt_RemoveIncomingMessageHandler(mqtt_IncomingMessageHandlerRef_t);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_data.api, the connection state is set with le_test_SetDataConnection()
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct le_data_ConnectionStateHandler* le_data_ConnectionStateHandlerRef_t;
+typedef void (*le_data_ConnectionStateHandlerFunc_t)(const char*, bool, void*);
+
+le_data_ConnectionStateHandlerRef_t le_data_AddConnectionStateHandler(
+    le_data_ConnectionStateHandlerFunc_t,
+    void*);
+void le_data_RemoveConnectionStateHandler(le_data_ConnectionStateHandlerRef_t);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_appInfo.api, the test process is not an app
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_appInfo_GetName(pid_t, char*, size_t);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_secStore.api, an empty store
+ */
+//--------------------------------------------------------------------------------------------------
+void le_secStore_ConnectService(void);
+le_result_t le_secStore_Write(const char*, const uint8_t*, size_t);
+le_result_t le_secStore_Read(const char*, uint8_t*, size_t*);
+le_result_t le_secStore_Delete(const char*);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg.api, an empty tree under the read transactions.  The values set with le_test_SetCfg*()
+ * and by the write transactions are read by the quick reads
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct le_cfg_Iterator* le_cfg_IteratorRef_t;
+
+void le_cfg_ConnectService(void);
+le_cfg_IteratorRef_t le_cfg_CreateReadTxn(const char*);
+le_cfg_IteratorRef_t le_cfg_CreateWriteTxn(const char*);
+void le_cfg_CommitTxn(le_cfg_IteratorRef_t);
+void le_cfg_CancelTxn(le_cfg_IteratorRef_t);
+le_result_t le_cfg_GoToFirstChild(le_cfg_IteratorRef_t);
+le_result_t le_cfg_GoToNextSibling(le_cfg_IteratorRef_t);
+le_result_t le_cfg_GetString(le_cfg_IteratorRef_t, const char*, char*, size_t, const char*);
+int32_t le_cfg_GetInt(le_cfg_IteratorRef_t, const char*, int32_t);
+double le_cfg_GetFloat(le_cfg_IteratorRef_t, const char*, double);
+bool le_cfg_GetBool(le_cfg_IteratorRef_t, const char*, bool);
+void le_cfg_SetString(le_cfg_IteratorRef_t, const char*, const char*);
+void le_cfg_SetInt(le_cfg_IteratorRef_t, const char*, int32_t);
+void le_cfg_SetFloat(le_cfg_IteratorRef_t, const char*, double);
+void le_cfg_SetBool(le_cfg_IteratorRef_t, const char*, bool);
+le_result_t le_cfg_QuickGetString(const char*, char*, size_t, const char*);
+int32_t le_cfg_QuickGetInt(const char*, int32_t);
+bool le_cfg_QuickGetBool(const char*, bool);
+void le_cfg_QuickDeleteNode(const char*);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_avdata.api, implemented by the tests that stand in for the AirVantage service
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct le_avdata_Record* le_avdata_RecordRef_t;
+typedef struct le_avdata_RequestSessionObj* le_avdata_RequestSessionObjRef_t;
+typedef struct le_avdata_SessionStateHandler* le_avdata_SessionStateHandlerRef_t;
+
+typedef enum
+{
+    LE_AVDATA_PUSH_SUCCESS = 0,
+    LE_AVDATA_PUSH_FAILED = 1,
+} le_avdata_PushStatus_t;
+
+typedef enum
+{
+    LE_AVDATA_SESSION_STARTED = 0,
+    LE_AVDATA_SESSION_STOPPED = 1,
+} le_avdata_SessionState_t;
+
+typedef void (*le_avdata_CallbackResultFunc_t)(le_avdata_PushStatus_t, void*);
+typedef void (*le_avdata_SessionStateHandlerFunc_t)(le_avdata_SessionState_t, void*);
+
+le_avdata_RecordRef_t le_avdata_CreateRecord(void);
+void le_avdata_DeleteRecord(le_avdata_RecordRef_t);
+le_result_t le_avdata_RecordInt(le_avdata_RecordRef_t, const char*, int32_t, uint64_t);
+le_result_t le_avdata_RecordFloat(le_avdata_RecordRef_t, const char*, double, uint64_t);
+le_result_t le_avdata_RecordBool(le_avdata_RecordRef_t, const char*, bool, uint64_t);
+le_result_t le_avdata_RecordString(le_avdata_RecordRef_t, const char*, const char*, uint64_t);
+le_result_t le_avdata_PushRecord(le_avdata_RecordRef_t, le_avdata_CallbackResultFunc_t, void*);
+le_avdata_SessionStateHandlerRef_t le_avdata_AddSessionStateHandler(
+    le_avdata_SessionStateHandlerFunc_t,
+    void*);
+void le_avdata_RemoveSessionStateHandler(le_avdata_SessionStateHandlerRef_t);
+le_avdata_RequestSessionObjRef_t le_avdata_RequestSession(void);
+void le_avdata_ReleaseSession(le_avdata_RequestSessionObjRef_t);
+
+#endif
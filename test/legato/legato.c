@@ -0,0 +1,1654 @@
+/**
+ * @file
+ *
+ * Host implementation of the Legato functions declared in legato.h and interfaces.h.  Each thread
+ * has its own event queue, run by le_event_RunLoop() or by le_test_RunEvents().  With the
+ * simulated clock, time only moves when a test advances it and the timers expire in order of
+ * their expiry time, in the thread advancing the clock.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#include "interfaces.h"
+#include "legato.h"
+
+#define LE_TEST_CFG_MAX_NUM 128
+#define LE_TEST_CFG_PATH_LEN 128
+#define LE_TEST_CFG_VALUE_LEN 128
+#define LE_TEST_DATA_HANDLERS_MAX_NUM 4
+#define LE_TEST_SIMULATED_EPOCH_SECS 1500000000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hash map entry
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct le_hashmap_Entry
+{
+    const void* key;               ///< Entry key
+    void* value;                   ///< Entry value
+    struct le_hashmap_Entry* next; ///< Next entry of the bucket
+} le_hashmap_Entry_t;
+
+struct le_hashmap
+{
+    le_hashmap_HashFunc_t hash;     ///< Key hash function
+    le_hashmap_EqualsFunc_t equals; ///< Key comparison function
+    size_t numBuckets;              ///< Number of buckets, a power of 2
+    size_t size;                    ///< Number of entries
+    le_hashmap_Entry_t** buckets;   ///< Bucket chains
+};
+
+struct le_hashmap_It
+{
+    le_hashmap_Ref_t map;      ///< Map iterated
+    size_t bucket;             ///< Bucket of the current entry
+    le_hashmap_Entry_t* entry; ///< Current entry, NULL before the first one
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Deferred function queued to a thread event loop
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_event_DeferredFunc_t func; ///< Function
+    void* param1;                 ///< First parameter
+    void* param2;                 ///< Second parameter
+    le_dls_Link_t link;           ///< Event queue link
+} le_event_Deferred_t;
+
+struct le_thread
+{
+    char name[32];             ///< Thread name
+    pthread_t thread;          ///< Thread
+    le_thread_MainFunc_t main; ///< Thread main function
+    void* context;             ///< Thread main function parameter
+    pthread_mutex_t mutex;     ///< Event queue mutex
+    pthread_cond_t cond;       ///< Event queue signaled when a function is queued
+    le_dls_List_t events;      ///< Event queue :: le_event_Deferred_t
+};
+
+struct le_timer
+{
+    char name[32];                    ///< Timer name
+    le_timer_ExpiryHandler_t handler; ///< Expiry handler
+    uint64_t intervalNs;              ///< Interval
+    uint32_t repeat;                  ///< Expiries left, 0 to repeat forever
+    uint32_t repeatCount;             ///< Repeat count set
+    void* context;                    ///< Context pointer
+    bool running;                     ///< Started
+    uint64_t expiryNs;                ///< Next expiry, simulated clock
+    le_dls_Link_t link;               ///< Timers list link
+};
+
+struct le_mutex
+{
+    pthread_mutex_t mutex; ///< Mutex
+};
+
+struct le_sem
+{
+    pthread_mutex_t mutex; ///< Count mutex
+    pthread_cond_t cond;   ///< Signaled when the count is incremented
+    int32_t count;         ///< Semaphore count
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Configuration value set by a test
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char path[LE_TEST_CFG_PATH_LEN];   ///< Node path
+    char value[LE_TEST_CFG_VALUE_LEN]; ///< Node value
+} le_test_Cfg_t;
+
+struct le_cfg_Iterator
+{
+    char path[LE_TEST_CFG_PATH_LEN]; ///< Write transaction path, the read iterators never find
+                                     ///  a node
+};
+
+struct le_data_ConnectionStateHandler
+{
+    le_data_ConnectionStateHandlerFunc_t func; ///< Handler
+    void* context;                             ///< Handler context
+};
+
+struct le_msg_SessionEventHandler
+{
+    le_msg_SessionEventHandler_t func; ///< Handler
+    void* context;                     ///< Handler context
+};
+
+static volatile le_log_Level_t LogLevel = LE_LOG_ERR;
+
+static bool ClockSimulated;
+static uint64_t ClockNs;
+static le_dls_List_t Timers = LE_DLS_LIST_INIT;
+
+static struct le_thread MainThread =
+{
+    .name = "main",
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+static __thread struct le_thread* CurrentThread;
+
+static le_test_Cfg_t Cfg[LE_TEST_CFG_MAX_NUM];
+static pthread_mutex_t CfgMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t NumCfg;
+static struct le_cfg_Iterator CfgIterator;
+
+static struct le_data_ConnectionStateHandler DataHandlers[LE_TEST_DATA_HANDLERS_MAX_NUM];
+
+static struct le_msg_SessionEventHandler CloseHandler;
+static le_msg_SessionRef_t ClientSession;
+
+//--------------------------------------------------------------------------------------------------
+// Logging
+//--------------------------------------------------------------------------------------------------
+void le_log_SetFilterLevel
+(
+    le_log_Level_t level
+)
+{
+    LogLevel = level;
+}
+
+void _le_log_Send
+(
+    le_log_Level_t level,
+    const char* file,
+    unsigned int line,
+    const char* format,
+    ...
+)
+{
+    static const char* const names[] = { "DBUG", "INFO", "WARN", "ERR", "CRT", "EMR" };
+    va_list args;
+
+    if (level < LogLevel)
+    {
+        return;
+    }
+
+    const char* base = strrchr(file, '/');
+    fprintf(stderr, "%s | %s %u | ", names[level], base ? base + 1 : file, line);
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Singly linked lists, circular with the tail linked to the head
+//--------------------------------------------------------------------------------------------------
+void le_sls_Stack
+(
+    le_sls_List_t* list,
+    le_sls_Link_t* link
+)
+{
+    if (!list->tailLinkPtr)
+    {
+        link->nextPtr = link;
+        list->tailLinkPtr = link;
+    }
+    else
+    {
+        link->nextPtr = list->tailLinkPtr->nextPtr;
+        list->tailLinkPtr->nextPtr = link;
+    }
+}
+
+void le_sls_Queue
+(
+    le_sls_List_t* list,
+    le_sls_Link_t* link
+)
+{
+    le_sls_Stack(list, link);
+    list->tailLinkPtr = link;
+}
+
+le_sls_Link_t* le_sls_RemoveAfter
+(
+    le_sls_List_t* list,
+    le_sls_Link_t* link
+)
+{
+    if (!link)
+    {
+        return le_sls_Pop(list);
+    }
+
+    if (link == list->tailLinkPtr)
+    {
+        return NULL;
+    }
+
+    le_sls_Link_t* removed = link->nextPtr;
+    link->nextPtr = removed->nextPtr;
+    if (removed == list->tailLinkPtr)
+    {
+        list->tailLinkPtr = link;
+    }
+
+    removed->nextPtr = NULL;
+    return removed;
+}
+
+le_sls_Link_t* le_sls_Pop
+(
+    le_sls_List_t* list
+)
+{
+    le_sls_Link_t* head = le_sls_Peek(list);
+
+    if (!head)
+    {
+        return NULL;
+    }
+
+    if (head == list->tailLinkPtr)
+    {
+        list->tailLinkPtr = NULL;
+    }
+    else
+    {
+        list->tailLinkPtr->nextPtr = head->nextPtr;
+    }
+
+    head->nextPtr = NULL;
+    return head;
+}
+
+le_sls_Link_t* le_sls_Peek
+(
+    const le_sls_List_t* list
+)
+{
+    return list->tailLinkPtr ? list->tailLinkPtr->nextPtr : NULL;
+}
+
+le_sls_Link_t* le_sls_PeekNext
+(
+    const le_sls_List_t* list,
+    const le_sls_Link_t* link
+)
+{
+    return (link == list->tailLinkPtr) ? NULL : link->nextPtr;
+}
+
+bool le_sls_IsEmpty
+(
+    const le_sls_List_t* list
+)
+{
+    return !list->tailLinkPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Doubly linked lists, circular with the head linked back to the tail
+//--------------------------------------------------------------------------------------------------
+void le_dls_Queue
+(
+    le_dls_List_t* list,
+    le_dls_Link_t* link
+)
+{
+    le_dls_Link_t* head = list->headLinkPtr;
+
+    if (!head)
+    {
+        link->nextPtr = link;
+        link->prevPtr = link;
+        list->headLinkPtr = link;
+    }
+    else
+    {
+        link->nextPtr = head;
+        link->prevPtr = head->prevPtr;
+        head->prevPtr->nextPtr = link;
+        head->prevPtr = link;
+    }
+}
+
+void le_dls_Stack
+(
+    le_dls_List_t* list,
+    le_dls_Link_t* link
+)
+{
+    le_dls_Queue(list, link);
+    list->headLinkPtr = link;
+}
+
+le_dls_Link_t* le_dls_Pop
+(
+    le_dls_List_t* list
+)
+{
+    le_dls_Link_t* head = list->headLinkPtr;
+
+    if (head)
+    {
+        le_dls_Remove(list, head);
+    }
+
+    return head;
+}
+
+le_dls_Link_t* le_dls_Peek
+(
+    const le_dls_List_t* list
+)
+{
+    return list->headLinkPtr;
+}
+
+le_dls_Link_t* le_dls_PeekNext
+(
+    const le_dls_List_t* list,
+    const le_dls_Link_t* link
+)
+{
+    return (link->nextPtr == list->headLinkPtr) ? NULL : link->nextPtr;
+}
+
+void le_dls_Remove
+(
+    le_dls_List_t* list,
+    le_dls_Link_t* link
+)
+{
+    if (link->nextPtr == link)
+    {
+        list->headLinkPtr = NULL;
+    }
+    else
+    {
+        link->prevPtr->nextPtr = link->nextPtr;
+        link->nextPtr->prevPtr = link->prevPtr;
+        if (list->headLinkPtr == link)
+        {
+            list->headLinkPtr = link->nextPtr;
+        }
+    }
+
+    link->nextPtr = NULL;
+    link->prevPtr = NULL;
+}
+
+bool le_dls_IsEmpty
+(
+    const le_dls_List_t* list
+)
+{
+    return !list->headLinkPtr;
+}
+
+size_t le_dls_NumLinks
+(
+    const le_dls_List_t* list
+)
+{
+    size_t num = 0;
+
+    for (le_dls_Link_t* link = le_dls_Peek(list); link; link = le_dls_PeekNext(list, link))
+    {
+        num++;
+    }
+
+    return num;
+}
+
+bool le_dls_IsInList
+(
+    const le_dls_List_t* list,
+    const le_dls_Link_t* link
+)
+{
+    for (le_dls_Link_t* pos = le_dls_Peek(list); pos; pos = le_dls_PeekNext(list, pos))
+    {
+        if (pos == link)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Hash maps
+//--------------------------------------------------------------------------------------------------
+le_hashmap_Ref_t le_hashmap_Create
+(
+    const char* name,
+    size_t capacity,
+    le_hashmap_HashFunc_t hash,
+    le_hashmap_EqualsFunc_t equals
+)
+{
+    le_hashmap_Ref_t map = calloc(1, sizeof(struct le_hashmap));
+    LE_ASSERT(map);
+
+    // Sized for a load factor of at most 0.75 at the capacity
+    map->numBuckets = 1;
+    while (map->numBuckets * 3 < capacity * 4)
+    {
+        map->numBuckets <<= 1;
+    }
+
+    map->hash = hash;
+    map->equals = equals;
+    map->buckets = calloc(map->numBuckets, sizeof(le_hashmap_Entry_t*));
+    LE_ASSERT(map->buckets);
+
+    return map;
+}
+
+static le_hashmap_Entry_t** le_hashmap_Find
+(
+    le_hashmap_Ref_t map,
+    const void* key
+)
+{
+    le_hashmap_Entry_t** entryPtr = &map->buckets[map->hash(key) & (map->numBuckets - 1)];
+
+    while (*entryPtr && !map->equals((*entryPtr)->key, key))
+    {
+        entryPtr = &(*entryPtr)->next;
+    }
+
+    return entryPtr;
+}
+
+void* le_hashmap_Put
+(
+    le_hashmap_Ref_t map,
+    const void* key,
+    const void* value
+)
+{
+    le_hashmap_Entry_t** entryPtr = le_hashmap_Find(map, key);
+    void* old = NULL;
+
+    if (*entryPtr)
+    {
+        old = (*entryPtr)->value;
+    }
+    else
+    {
+        *entryPtr = calloc(1, sizeof(le_hashmap_Entry_t));
+        LE_ASSERT(*entryPtr);
+        map->size++;
+    }
+
+    (*entryPtr)->key = key;
+    (*entryPtr)->value = (void*)value;
+    return old;
+}
+
+void* le_hashmap_Get
+(
+    le_hashmap_Ref_t map,
+    const void* key
+)
+{
+    le_hashmap_Entry_t* entry = *le_hashmap_Find(map, key);
+
+    return entry ? entry->value : NULL;
+}
+
+void* le_hashmap_Remove
+(
+    le_hashmap_Ref_t map,
+    const void* key
+)
+{
+    le_hashmap_Entry_t** entryPtr = le_hashmap_Find(map, key);
+    le_hashmap_Entry_t* entry = *entryPtr;
+    void* value = NULL;
+
+    if (entry)
+    {
+        value = entry->value;
+        *entryPtr = entry->next;
+        free(entry);
+        map->size--;
+    }
+
+    return value;
+}
+
+size_t le_hashmap_Size
+(
+    le_hashmap_Ref_t map
+)
+{
+    return map->size;
+}
+
+le_hashmap_It_Ref_t le_hashmap_GetIterator
+(
+    le_hashmap_Ref_t map
+)
+{
+    le_hashmap_It_Ref_t it = calloc(1, sizeof(struct le_hashmap_It));
+    LE_ASSERT(it);
+
+    it->map = map;
+    return it;
+}
+
+le_result_t le_hashmap_NextNode
+(
+    le_hashmap_It_Ref_t it
+)
+{
+    if (it->entry && it->entry->next)
+    {
+        it->entry = it->entry->next;
+        return LE_OK;
+    }
+
+    for (size_t bucket = it->entry ? it->bucket + 1 : 0; bucket < it->map->numBuckets; bucket++)
+    {
+        if (it->map->buckets[bucket])
+        {
+            it->bucket = bucket;
+            it->entry = it->map->buckets[bucket];
+            return LE_OK;
+        }
+    }
+
+    it->bucket = it->map->numBuckets;
+    return LE_NOT_FOUND;
+}
+
+const void* le_hashmap_GetKey
+(
+    le_hashmap_It_Ref_t it
+)
+{
+    return it->entry ? it->entry->key : NULL;
+}
+
+void* le_hashmap_GetValue
+(
+    le_hashmap_It_Ref_t it
+)
+{
+    return it->entry ? it->entry->value : NULL;
+}
+
+size_t le_hashmap_HashString
+(
+    const void* key
+)
+{
+    const unsigned char* pos = key;
+    size_t hash = 5381;
+
+    while (*pos)
+    {
+        hash = hash * 33 + *pos++;
+    }
+
+    return hash;
+}
+
+bool le_hashmap_EqualsString
+(
+    const void* first,
+    const void* second
+)
+{
+    return !strcmp(first, second);
+}
+
+size_t le_hashmap_HashVoidPointer
+(
+    const void* key
+)
+{
+    return (size_t)key >> 3;
+}
+
+bool le_hashmap_EqualsVoidPointer
+(
+    const void* first,
+    const void* second
+)
+{
+    return first == second;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Clock
+//--------------------------------------------------------------------------------------------------
+static le_clk_Time_t le_clk_FromNs
+(
+    uint64_t ns
+)
+{
+    le_clk_Time_t time = { .sec = ns / 1000000000, .usec = (ns % 1000000000) / 1000 };
+
+    return time;
+}
+
+uint64_t le_test_NowNs
+(
+    void
+)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+le_clk_Time_t le_clk_GetRelativeTime
+(
+    void
+)
+{
+    return le_clk_FromNs(ClockSimulated ? ClockNs : le_test_NowNs());
+}
+
+le_clk_Time_t le_clk_GetAbsoluteTime
+(
+    void
+)
+{
+    struct timespec now;
+
+    if (ClockSimulated)
+    {
+        return le_clk_FromNs(LE_TEST_SIMULATED_EPOCH_SECS * 1000000000ULL + ClockNs);
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return le_clk_FromNs((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec);
+}
+
+le_clk_Time_t le_clk_Add
+(
+    le_clk_Time_t first,
+    le_clk_Time_t second
+)
+{
+    le_clk_Time_t sum = { .sec = first.sec + second.sec, .usec = first.usec + second.usec };
+
+    if (sum.usec >= 1000000)
+    {
+        sum.sec++;
+        sum.usec -= 1000000;
+    }
+
+    return sum;
+}
+
+le_clk_Time_t le_clk_Sub
+(
+    le_clk_Time_t first,
+    le_clk_Time_t second
+)
+{
+    le_clk_Time_t diff = { .sec = first.sec - second.sec, .usec = first.usec - second.usec };
+
+    if (diff.usec < 0)
+    {
+        diff.sec--;
+        diff.usec += 1000000;
+    }
+
+    return diff;
+}
+
+bool le_clk_GreaterThan
+(
+    le_clk_Time_t first,
+    le_clk_Time_t second
+)
+{
+    return (first.sec > second.sec) || ((first.sec == second.sec) && (first.usec > second.usec));
+}
+
+//--------------------------------------------------------------------------------------------------
+// Timers
+//--------------------------------------------------------------------------------------------------
+le_timer_Ref_t le_timer_Create
+(
+    const char* name
+)
+{
+    le_timer_Ref_t timer = calloc(1, sizeof(struct le_timer));
+    LE_ASSERT(timer);
+
+    strncpy(timer->name, name, sizeof(timer->name) - 1);
+    timer->intervalNs = 1000000000;
+    timer->repeatCount = 1;
+    le_dls_Queue(&Timers, &timer->link);
+    return timer;
+}
+
+void le_timer_Delete
+(
+    le_timer_Ref_t timer
+)
+{
+    le_dls_Remove(&Timers, &timer->link);
+    free(timer);
+}
+
+le_result_t le_timer_SetHandler
+(
+    le_timer_Ref_t timer,
+    le_timer_ExpiryHandler_t handler
+)
+{
+    timer->handler = handler;
+    return LE_OK;
+}
+
+le_result_t le_timer_SetInterval
+(
+    le_timer_Ref_t timer,
+    le_clk_Time_t interval
+)
+{
+    timer->intervalNs = (uint64_t)interval.sec * 1000000000 + (uint64_t)interval.usec * 1000;
+    return LE_OK;
+}
+
+le_result_t le_timer_SetMsInterval
+(
+    le_timer_Ref_t timer,
+    uint32_t intervalMs
+)
+{
+    timer->intervalNs = (uint64_t)intervalMs * 1000000;
+    return LE_OK;
+}
+
+le_result_t le_timer_SetRepeat
+(
+    le_timer_Ref_t timer,
+    uint32_t repeatCount
+)
+{
+    timer->repeatCount = repeatCount;
+    return LE_OK;
+}
+
+le_result_t le_timer_SetContextPtr
+(
+    le_timer_Ref_t timer,
+    void* context
+)
+{
+    timer->context = context;
+    return LE_OK;
+}
+
+void* le_timer_GetContextPtr
+(
+    le_timer_Ref_t timer
+)
+{
+    return timer->context;
+}
+
+le_result_t le_timer_Start
+(
+    le_timer_Ref_t timer
+)
+{
+    if (timer->running)
+    {
+        return LE_BUSY;
+    }
+
+    timer->running = true;
+    timer->repeat = timer->repeatCount;
+    timer->expiryNs = ClockNs + timer->intervalNs;
+    return LE_OK;
+}
+
+le_result_t le_timer_Stop
+(
+    le_timer_Ref_t timer
+)
+{
+    if (!timer->running)
+    {
+        return LE_FAULT;
+    }
+
+    timer->running = false;
+    return LE_OK;
+}
+
+bool le_timer_IsRunning
+(
+    le_timer_Ref_t timer
+)
+{
+    return timer->running;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Threads
+//--------------------------------------------------------------------------------------------------
+static struct le_thread* le_thread_Current
+(
+    void
+)
+{
+    return CurrentThread ? CurrentThread : &MainThread;
+}
+
+static void* le_thread_Main
+(
+    void* context
+)
+{
+    CurrentThread = (struct le_thread*)context;
+    return CurrentThread->main(CurrentThread->context);
+}
+
+le_thread_Ref_t le_thread_Create
+(
+    const char* name,
+    le_thread_MainFunc_t main,
+    void* context
+)
+{
+    le_thread_Ref_t thread = calloc(1, sizeof(struct le_thread));
+    LE_ASSERT(thread);
+
+    strncpy(thread->name, name, sizeof(thread->name) - 1);
+    thread->main = main;
+    thread->context = context;
+    pthread_mutex_init(&thread->mutex, NULL);
+    pthread_cond_init(&thread->cond, NULL);
+    return thread;
+}
+
+void le_thread_Start
+(
+    le_thread_Ref_t thread
+)
+{
+    LE_ASSERT(!pthread_create(&thread->thread, NULL, le_thread_Main, thread));
+    pthread_detach(thread->thread);
+}
+
+le_thread_Ref_t le_thread_GetCurrent
+(
+    void
+)
+{
+    return le_thread_Current();
+}
+
+le_mutex_Ref_t le_mutex_CreateNonRecursive
+(
+    const char* name
+)
+{
+    le_mutex_Ref_t mutex = calloc(1, sizeof(struct le_mutex));
+    LE_ASSERT(mutex);
+
+    pthread_mutex_init(&mutex->mutex, NULL);
+    return mutex;
+}
+
+void le_mutex_Lock
+(
+    le_mutex_Ref_t mutex
+)
+{
+    pthread_mutex_lock(&mutex->mutex);
+}
+
+void le_mutex_Unlock
+(
+    le_mutex_Ref_t mutex
+)
+{
+    pthread_mutex_unlock(&mutex->mutex);
+}
+
+le_sem_Ref_t le_sem_Create
+(
+    const char* name,
+    int32_t count
+)
+{
+    le_sem_Ref_t sem = calloc(1, sizeof(struct le_sem));
+    LE_ASSERT(sem);
+
+    pthread_mutex_init(&sem->mutex, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->count = count;
+    return sem;
+}
+
+void le_sem_Wait
+(
+    le_sem_Ref_t sem
+)
+{
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->count <= 0)
+    {
+        pthread_cond_wait(&sem->cond, &sem->mutex);
+    }
+
+    sem->count--;
+    pthread_mutex_unlock(&sem->mutex);
+}
+
+le_result_t le_sem_WaitWithTimeOut
+(
+    le_sem_Ref_t sem,
+    le_clk_Time_t timeout
+)
+{
+    struct timespec deadline;
+    le_result_t res = LE_OK;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout.sec;
+    deadline.tv_nsec += timeout.usec * 1000;
+    if (deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&sem->mutex);
+    while ((sem->count <= 0) && (res == LE_OK))
+    {
+        if (pthread_cond_timedwait(&sem->cond, &sem->mutex, &deadline) == ETIMEDOUT)
+        {
+            res = LE_TIMEOUT;
+        }
+    }
+
+    if (res == LE_OK)
+    {
+        sem->count--;
+    }
+
+    pthread_mutex_unlock(&sem->mutex);
+    return res;
+}
+
+void le_sem_Post
+(
+    le_sem_Ref_t sem
+)
+{
+    pthread_mutex_lock(&sem->mutex);
+    sem->count++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->mutex);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Event loops
+//--------------------------------------------------------------------------------------------------
+void le_event_QueueFunctionToThread
+(
+    le_thread_Ref_t thread,
+    le_event_DeferredFunc_t func,
+    void* param1,
+    void* param2
+)
+{
+    le_event_Deferred_t* deferred = calloc(1, sizeof(le_event_Deferred_t));
+    LE_ASSERT(deferred);
+
+    deferred->func = func;
+    deferred->param1 = param1;
+    deferred->param2 = param2;
+
+    pthread_mutex_lock(&thread->mutex);
+    le_dls_Queue(&thread->events, &deferred->link);
+    pthread_cond_signal(&thread->cond);
+    pthread_mutex_unlock(&thread->mutex);
+}
+
+void le_event_QueueFunction
+(
+    le_event_DeferredFunc_t func,
+    void* param1,
+    void* param2
+)
+{
+    le_event_QueueFunctionToThread(le_thread_Current(), func, param1, param2);
+}
+
+// Runs the next queued function of the current thread, waiting for one when asked to
+static bool le_event_RunNext
+(
+    bool wait
+)
+{
+    struct le_thread* thread = le_thread_Current();
+    le_dls_Link_t* link = NULL;
+
+    pthread_mutex_lock(&thread->mutex);
+    while (!(link = le_dls_Pop(&thread->events)) && wait)
+    {
+        pthread_cond_wait(&thread->cond, &thread->mutex);
+    }
+    pthread_mutex_unlock(&thread->mutex);
+
+    if (!link)
+    {
+        return false;
+    }
+
+    le_event_Deferred_t* deferred = CONTAINER_OF(link, le_event_Deferred_t, link);
+    deferred->func(deferred->param1, deferred->param2);
+    free(deferred);
+    return true;
+}
+
+void le_event_RunLoop
+(
+    void
+)
+{
+    for (;;)
+    {
+        le_event_RunNext(true);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Host test control
+//--------------------------------------------------------------------------------------------------
+void le_test_SimulateClock
+(
+    void
+)
+{
+    ClockSimulated = true;
+    ClockNs = 0;
+}
+
+size_t le_test_RunEvents
+(
+    void
+)
+{
+    size_t num = 0;
+
+    while (le_event_RunNext(false))
+    {
+        num++;
+    }
+
+    return num;
+}
+
+// Fires the first timer expiring by the end time, after running the queued functions
+static bool le_test_RunTimerUntil
+(
+    uint64_t endNs
+)
+{
+    le_timer_Ref_t next = NULL;
+
+    le_test_RunEvents();
+    for (le_dls_Link_t* link = le_dls_Peek(&Timers); link; link = le_dls_PeekNext(&Timers, link))
+    {
+        le_timer_Ref_t timer = CONTAINER_OF(link, struct le_timer, link);
+        if (timer->running && (timer->expiryNs <= endNs) &&
+            (!next || (timer->expiryNs < next->expiryNs)))
+        {
+            next = timer;
+        }
+    }
+
+    if (!next)
+    {
+        ClockNs = endNs;
+        return false;
+    }
+
+    ClockNs = next->expiryNs;
+    if (next->repeat != 1)
+    {
+        next->repeat -= next->repeat ? 1 : 0;
+        next->expiryNs += next->intervalNs;
+    }
+    else
+    {
+        next->running = false;
+    }
+
+    if (next->handler)
+    {
+        next->handler(next);
+    }
+
+    le_test_RunEvents();
+    return true;
+}
+
+void le_test_AdvanceClockNs
+(
+    uint64_t ns
+)
+{
+    uint64_t endNs = ClockNs + ns;
+
+    while (le_test_RunTimerUntil(endNs))
+    {
+    }
+}
+
+void le_test_AdvanceClock
+(
+    uint32_t ms
+)
+{
+    le_test_AdvanceClockNs((uint64_t)ms * 1000000);
+}
+
+bool le_test_RunNextTimer
+(
+    uint32_t maxMs
+)
+{
+    return le_test_RunTimerUntil(ClockNs + (uint64_t)maxMs * 1000000);
+}
+
+void le_test_SetCfgString
+(
+    const char* path,
+    const char* value
+)
+{
+    uint32_t i = 0;
+
+    pthread_mutex_lock(&CfgMutex);
+    while ((i < NumCfg) && strcmp(Cfg[i].path, path))
+    {
+        i++;
+    }
+
+    if (i == NumCfg)
+    {
+        LE_ASSERT(NumCfg < LE_TEST_CFG_MAX_NUM);
+        NumCfg++;
+    }
+
+    snprintf(Cfg[i].path, sizeof(Cfg[i].path), "%s", path);
+    snprintf(Cfg[i].value, sizeof(Cfg[i].value), "%s", value);
+    pthread_mutex_unlock(&CfgMutex);
+}
+
+void le_test_SetCfgInt
+(
+    const char* path,
+    int32_t value
+)
+{
+    char text[16];
+
+    snprintf(text, sizeof(text), "%d", value);
+    le_test_SetCfgString(path, text);
+}
+
+void le_test_SetDataConnection
+(
+    bool isConnected
+)
+{
+    for (uint32_t i = 0; i < LE_TEST_DATA_HANDLERS_MAX_NUM; i++)
+    {
+        if (DataHandlers[i].func)
+        {
+            DataHandlers[i].func("rmnet0", isConnected, DataHandlers[i].context);
+        }
+    }
+}
+
+void le_test_CloseSession
+(
+    le_msg_SessionRef_t sessionRef
+)
+{
+    if (CloseHandler.func)
+    {
+        CloseHandler.func(sessionRef, CloseHandler.context);
+    }
+}
+
+void le_test_SetClientSession
+(
+    le_msg_SessionRef_t sessionRef
+)
+{
+    ClientSession = sessionRef;
+}
+
+//--------------------------------------------------------------------------------------------------
+// IPC sessions, signals and arguments
+//--------------------------------------------------------------------------------------------------
+le_msg_SessionEventHandlerRef_t le_msg_AddServiceCloseHandler
+(
+    le_msg_ServiceRef_t serviceRef,
+    le_msg_SessionEventHandler_t func,
+    void* context
+)
+{
+    CloseHandler.func = func;
+    CloseHandler.context = context;
+    return &CloseHandler;
+}
+
+le_result_t le_msg_GetClientProcessId
+(
+    le_msg_SessionRef_t sessionRef,
+    pid_t* pid
+)
+{
+    *pid = getpid();
+    return LE_OK;
+}
+
+void le_sig_Block
+(
+    int sigNum
+)
+{
+}
+
+void le_sig_SetEventHandler
+(
+    int sigNum,
+    le_sig_EventHandlerFunc_t func
+)
+{
+}
+
+void le_arg_SetStringCallback
+(
+    le_arg_StringCallbackFunc_t func,
+    const char* shortName,
+    const char* longName
+)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+// dataRouter service and le_appInfo
+//--------------------------------------------------------------------------------------------------
+le_msg_SessionRef_t dataRouter_GetClientSessionRef
+(
+    void
+)
+{
+    return ClientSession;
+}
+
+le_msg_ServiceRef_t dataRouter_GetServiceRef
+(
+    void
+)
+{
+    return NULL;
+}
+
+le_result_t le_appInfo_GetName
+(
+    pid_t pid,
+    char* name,
+    size_t len
+)
+{
+    return LE_NOT_FOUND;
+}
+
+//--------------------------------------------------------------------------------------------------
+// le_cfg
+//--------------------------------------------------------------------------------------------------
+void le_cfg_ConnectService
+(
+    void
+)
+{
+}
+
+// Copies the value of a node, returns false when the node is not set
+static bool le_cfg_Find
+(
+    const char* path,
+    char value[LE_TEST_CFG_VALUE_LEN]
+)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&CfgMutex);
+    for (uint32_t i = 0; i < NumCfg; i++)
+    {
+        if (!strcmp(Cfg[i].path, path))
+        {
+            memcpy(value, Cfg[i].value, LE_TEST_CFG_VALUE_LEN);
+            found = true;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&CfgMutex);
+    return found;
+}
+
+// Sets a node under the path of a write transaction
+static void le_cfg_SetNode
+(
+    le_cfg_IteratorRef_t iterator,
+    const char* path,
+    const char* value
+)
+{
+    char nodePath[LE_TEST_CFG_PATH_LEN];
+
+    LE_ASSERT(iterator != &CfgIterator);
+    LE_ASSERT(snprintf(nodePath, sizeof(nodePath), "%s/%s", iterator->path, path) <
+              (int)sizeof(nodePath));
+    le_test_SetCfgString(nodePath, value);
+}
+
+le_cfg_IteratorRef_t le_cfg_CreateReadTxn
+(
+    const char* path
+)
+{
+    return &CfgIterator;
+}
+
+le_cfg_IteratorRef_t le_cfg_CreateWriteTxn
+(
+    const char* path
+)
+{
+    le_cfg_IteratorRef_t iterator = calloc(1, sizeof(struct le_cfg_Iterator));
+
+    LE_ASSERT(iterator && (strlen(path) < sizeof(iterator->path)));
+    strcpy(iterator->path, path);
+    return iterator;
+}
+
+// The nodes of a write transaction are set right away
+void le_cfg_CommitTxn
+(
+    le_cfg_IteratorRef_t iterator
+)
+{
+    if (iterator != &CfgIterator)
+    {
+        free(iterator);
+    }
+}
+
+void le_cfg_CancelTxn
+(
+    le_cfg_IteratorRef_t iterator
+)
+{
+    if (iterator != &CfgIterator)
+    {
+        free(iterator);
+    }
+}
+
+le_result_t le_cfg_GoToFirstChild
+(
+    le_cfg_IteratorRef_t iterator
+)
+{
+    return LE_NOT_FOUND;
+}
+
+le_result_t le_cfg_GoToNextSibling
+(
+    le_cfg_IteratorRef_t iterator
+)
+{
+    return LE_NOT_FOUND;
+}
+
+le_result_t le_cfg_GetString
+(
+    le_cfg_IteratorRef_t iterator,
+    const char* path,
+    char* value,
+    size_t len,
+    const char* defaultValue
+)
+{
+    snprintf(value, len, "%s", defaultValue);
+    return LE_OK;
+}
+
+int32_t le_cfg_GetInt
+(
+    le_cfg_IteratorRef_t iterator,
+    const char* path,
+    int32_t defaultValue
+)
+{
+    return defaultValue;
+}
+
+double le_cfg_GetFloat
+(
+    le_cfg_IteratorRef_t iterator,
+    const char* path,
+    double defaultValue
+)
+{
+    return defaultValue;
+}
+
+bool le_cfg_GetBool
+(
+    le_cfg_IteratorRef_t iterator,
+    const char* path,
+    bool defaultValue
+)
+{
+    return defaultValue;
+}
+
+void le_cfg_SetString
+(
+    le_cfg_IteratorRef_t iterator,
+    const char* path,
+    const char* value
+)
+{
+    le_cfg_SetNode(iterator, path, value);
+}
+
+void le_cfg_SetInt
+(
+    le_cfg_IteratorRef_t iterator,
+    const char* path,
+    int32_t value
+)
+{
+    char text[LE_TEST_CFG_VALUE_LEN];
+
+    snprintf(text, sizeof(text), "%d", value);
+    le_cfg_SetNode(iterator, path, text);
+}
+
+void le_cfg_SetFloat
+(
+    le_cfg_IteratorRef_t iterator,
+    const char* path,
+    double value
+)
+{
+    char text[LE_TEST_CFG_VALUE_LEN];
+
+    snprintf(text, sizeof(text), "%.17g", value);
+    le_cfg_SetNode(iterator, path, text);
+}
+
+void le_cfg_SetBool
+(
+    le_cfg_IteratorRef_t iterator,
+    const char* path,
+    bool value
+)
+{
+    le_cfg_SetNode(iterator, path, value ? "true" : "false");
+}
+
+le_result_t le_cfg_QuickGetString
+(
+    const char* path,
+    char* value,
+    size_t len,
+    const char* defaultValue
+)
+{
+    char found[LE_TEST_CFG_VALUE_LEN];
+
+    return (snprintf(value, len, "%s", le_cfg_Find(path, found) ? found : defaultValue) <
+            (int)len) ? LE_OK : LE_OVERFLOW;
+}
+
+int32_t le_cfg_QuickGetInt
+(
+    const char* path,
+    int32_t defaultValue
+)
+{
+    char found[LE_TEST_CFG_VALUE_LEN];
+
+    return le_cfg_Find(path, found) ? (int32_t)strtol(found, NULL, 0) : defaultValue;
+}
+
+bool le_cfg_QuickGetBool
+(
+    const char* path,
+    bool defaultValue
+)
+{
+    char found[LE_TEST_CFG_VALUE_LEN];
+
+    return le_cfg_Find(path, found) ? !strcmp(found, "true") : defaultValue;
+}
+
+void le_cfg_QuickDeleteNode
+(
+    const char* path
+)
+{
+    size_t len = strlen(path);
+
+    pthread_mutex_lock(&CfgMutex);
+    for (uint32_t i = 0; i < NumCfg;)
+    {
+        if (!strncmp(Cfg[i].path, path, len) && ((Cfg[i].path[len] == '\0') ||
+                                                 (Cfg[i].path[len] == '/')))
+        {
+            Cfg[i] = Cfg[--NumCfg];
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    pthread_mutex_unlock(&CfgMutex);
+}
+
+//--------------------------------------------------------------------------------------------------
+// le_secStore
+//--------------------------------------------------------------------------------------------------
+void le_secStore_ConnectService
+(
+    void
+)
+{
+}
+
+le_result_t le_secStore_Write
+(
+    const char* name,
+    const uint8_t* buf,
+    size_t len
+)
+{
+    return LE_OK;
+}
+
+le_result_t le_secStore_Read
+(
+    const char* name,
+    uint8_t* buf,
+    size_t* len
+)
+{
+    *len = 0;
+    return LE_OK;
+}
+
+le_result_t le_secStore_Delete
+(
+    const char* name
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+// le_data
+//--------------------------------------------------------------------------------------------------
+le_data_ConnectionStateHandlerRef_t le_data_AddConnectionStateHandler
+(
+    le_data_ConnectionStateHandlerFunc_t func,
+    void* context
+)
+{
+    for (uint32_t i = 0; i < LE_TEST_DATA_HANDLERS_MAX_NUM; i++)
+    {
+        if (!DataHandlers[i].func)
+        {
+            DataHandlers[i].func = func;
+            DataHandlers[i].context = context;
+            return &DataHandlers[i];
+        }
+    }
+
+    return NULL;
+}
+
+void le_data_RemoveConnectionStateHandler
+(
+    le_data_ConnectionStateHandlerRef_t handler
+)
+{
+    handler->func = NULL;
+}
@@ -0,0 +1,315 @@
+/*
+ * @file legato.h
+ *
+ * Data router host tests.
+ *
+ * Minimal host implementation of the Legato framework functions the data router modules use, so
+ * that the modules can be built and measured on a development host.  The clock can be simulated:
+ * timers then only expire when a test advances the clock, which makes runs deterministic.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#ifndef LEGATO_HOST_SHIM_INCLUDE_GUARD
+#define LEGATO_HOST_SHIM_INCLUDE_GUARD
+
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef enum
+{
+    LE_OK = 0,
+    LE_NOT_FOUND = -1,
+    LE_NOT_POSSIBLE = -2,
+    LE_OUT_OF_RANGE = -3,
+    LE_NO_MEMORY = -4,
+    LE_NOT_PERMITTED = -5,
+    LE_FAULT = -6,
+    LE_COMM_ERROR = -7,
+    LE_TIMEOUT = -8,
+    LE_OVERFLOW = -9,
+    LE_UNDERFLOW = -10,
+    LE_WOULD_BLOCK = -11,
+    LE_DEADLOCK = -12,
+    LE_FORMAT_ERROR = -13,
+    LE_DUPLICATE = -14,
+    LE_BAD_PARAMETER = -15,
+    LE_CLOSED = -16,
+    LE_BUSY = -17,
+    LE_UNSUPPORTED = -18,
+    LE_IO_ERROR = -19,
+    LE_NOT_IMPLEMENTED = -20,
+    LE_UNAVAILABLE = -21,
+    LE_TERMINATED = -22,
+} le_result_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Logging, messages below the filter level (LE_LOG_ERR by default) are discarded
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    LE_LOG_DEBUG = 0,
+    LE_LOG_INFO,
+    LE_LOG_WARN,
+    LE_LOG_ERR,
+    LE_LOG_CRIT,
+    LE_LOG_EMERG,
+} le_log_Level_t;
+
+void le_log_SetFilterLevel(le_log_Level_t);
+void _le_log_Send(le_log_Level_t, const char*, unsigned int, const char*, ...)
+    __attribute__((format(printf, 4, 5)));
+
+#define LE_DEBUG(...) _le_log_Send(LE_LOG_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
+#define LE_INFO(...) _le_log_Send(LE_LOG_INFO, __FILE__, __LINE__, __VA_ARGS__)
+#define LE_WARN(...) _le_log_Send(LE_LOG_WARN, __FILE__, __LINE__, __VA_ARGS__)
+#define LE_ERROR(...) _le_log_Send(LE_LOG_ERR, __FILE__, __LINE__, __VA_ARGS__)
+#define LE_CRIT(...) _le_log_Send(LE_LOG_CRIT, __FILE__, __LINE__, __VA_ARGS__)
+#define LE_FATAL(...) \
+    do \
+    { \
+        _le_log_Send(LE_LOG_EMERG, __FILE__, __LINE__, __VA_ARGS__); \
+        abort(); \
+    } while (0)
+#define LE_ASSERT(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            LE_FATAL("Assert Failed: '%s'", #condition); \
+        } \
+    } while (0)
+#define LE_ASSERT_OK(condition) LE_ASSERT((condition) == LE_OK)
+
+#define NUM_ARRAY_MEMBERS(array) (sizeof(array) / sizeof((array)[0]))
+#define CONTAINER_OF(ptr, type, member) ((type*)(((uint8_t*)(ptr)) - offsetof(type, member)))
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Singly linked lists
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct le_sls_Link
+{
+    struct le_sls_Link* nextPtr;
+} le_sls_Link_t;
+
+typedef struct
+{
+    le_sls_Link_t* tailLinkPtr;
+} le_sls_List_t;
+
+#define LE_SLS_LIST_INIT (le_sls_List_t){ NULL }
+#define LE_SLS_LINK_INIT (le_sls_Link_t){ NULL }
+
+void le_sls_Stack(le_sls_List_t*, le_sls_Link_t*);
+void le_sls_Queue(le_sls_List_t*, le_sls_Link_t*);
+le_sls_Link_t* le_sls_RemoveAfter(le_sls_List_t*, le_sls_Link_t*);
+le_sls_Link_t* le_sls_Pop(le_sls_List_t*);
+le_sls_Link_t* le_sls_Peek(const le_sls_List_t*);
+le_sls_Link_t* le_sls_PeekNext(const le_sls_List_t*, const le_sls_Link_t*);
+bool le_sls_IsEmpty(const le_sls_List_t*);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Doubly linked lists
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct le_dls_Link
+{
+    struct le_dls_Link* nextPtr;
+    struct le_dls_Link* prevPtr;
+} le_dls_Link_t;
+
+typedef struct
+{
+    le_dls_Link_t* headLinkPtr;
+} le_dls_List_t;
+
+#define LE_DLS_LIST_INIT (le_dls_List_t){ NULL }
+#define LE_DLS_LINK_INIT (le_dls_Link_t){ NULL, NULL }
+
+void le_dls_Queue(le_dls_List_t*, le_dls_Link_t*);
+void le_dls_Stack(le_dls_List_t*, le_dls_Link_t*);
+le_dls_Link_t* le_dls_Pop(le_dls_List_t*);
+le_dls_Link_t* le_dls_Peek(const le_dls_List_t*);
+le_dls_Link_t* le_dls_PeekNext(const le_dls_List_t*, const le_dls_Link_t*);
+void le_dls_Remove(le_dls_List_t*, le_dls_Link_t*);
+bool le_dls_IsEmpty(const le_dls_List_t*);
+size_t le_dls_NumLinks(const le_dls_List_t*);
+bool le_dls_IsInList(const le_dls_List_t*, const le_dls_Link_t*);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hash maps, chained with a fixed number of buckets sized from the capacity
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct le_hashmap* le_hashmap_Ref_t;
+typedef struct le_hashmap_It* le_hashmap_It_Ref_t;
+typedef size_t (*le_hashmap_HashFunc_t)(const void*);
+typedef bool (*le_hashmap_EqualsFunc_t)(const void*, const void*);
+
+le_hashmap_Ref_t le_hashmap_Create(
+    const char*,
+    size_t,
+    le_hashmap_HashFunc_t,
+    le_hashmap_EqualsFunc_t);
+void* le_hashmap_Put(le_hashmap_Ref_t, const void*, const void*);
+void* le_hashmap_Get(le_hashmap_Ref_t, const void*);
+void* le_hashmap_Remove(le_hashmap_Ref_t, const void*);
+size_t le_hashmap_Size(le_hashmap_Ref_t);
+le_hashmap_It_Ref_t le_hashmap_GetIterator(le_hashmap_Ref_t);
+le_result_t le_hashmap_NextNode(le_hashmap_It_Ref_t);
+const void* le_hashmap_GetKey(le_hashmap_It_Ref_t);
+void* le_hashmap_GetValue(le_hashmap_It_Ref_t);
+size_t le_hashmap_HashString(const void*);
+bool le_hashmap_EqualsString(const void*, const void*);
+size_t le_hashmap_HashVoidPointer(const void*);
+bool le_hashmap_EqualsVoidPointer(const void*, const void*);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Clock, real or simulated
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    time_t sec;
+    long usec;
+} le_clk_Time_t;
+
+le_clk_Time_t le_clk_GetRelativeTime(void);
+le_clk_Time_t le_clk_GetAbsoluteTime(void);
+le_clk_Time_t le_clk_Add(le_clk_Time_t, le_clk_Time_t);
+le_clk_Time_t le_clk_Sub(le_clk_Time_t, le_clk_Time_t);
+bool le_clk_GreaterThan(le_clk_Time_t, le_clk_Time_t);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timers, only expiring when a test advances the simulated clock
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct le_timer* le_timer_Ref_t;
+typedef void (*le_timer_ExpiryHandler_t)(le_timer_Ref_t);
+
+le_timer_Ref_t le_timer_Create(const char*);
+void le_timer_Delete(le_timer_Ref_t);
+le_result_t le_timer_SetHandler(le_timer_Ref_t, le_timer_ExpiryHandler_t);
+le_result_t le_timer_SetInterval(le_timer_Ref_t, le_clk_Time_t);
+le_result_t le_timer_SetMsInterval(le_timer_Ref_t, uint32_t);
+le_result_t le_timer_SetRepeat(le_timer_Ref_t, uint32_t);
+le_result_t le_timer_SetContextPtr(le_timer_Ref_t, void*);
+void* le_timer_GetContextPtr(le_timer_Ref_t);
+le_result_t le_timer_Start(le_timer_Ref_t);
+le_result_t le_timer_Stop(le_timer_Ref_t);
+bool le_timer_IsRunning(le_timer_Ref_t);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Threads, mutexes and semaphores
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct le_thread* le_thread_Ref_t;
+typedef void* (*le_thread_MainFunc_t)(void*);
+
+le_thread_Ref_t le_thread_Create(const char*, le_thread_MainFunc_t, void*);
+void le_thread_Start(le_thread_Ref_t);
+le_thread_Ref_t le_thread_GetCurrent(void);
+
+typedef struct le_mutex* le_mutex_Ref_t;
+
+le_mutex_Ref_t le_mutex_CreateNonRecursive(const char*);
+void le_mutex_Lock(le_mutex_Ref_t);
+void le_mutex_Unlock(le_mutex_Ref_t);
+
+typedef struct le_sem* le_sem_Ref_t;
+
+le_sem_Ref_t le_sem_Create(const char*, int32_t);
+void le_sem_Wait(le_sem_Ref_t);
+le_result_t le_sem_WaitWithTimeOut(le_sem_Ref_t, le_clk_Time_t);
+void le_sem_Post(le_sem_Ref_t);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event loops, one per thread
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*le_event_DeferredFunc_t)(void*, void*);
+
+void le_event_QueueFunction(le_event_DeferredFunc_t, void*, void*);
+void le_event_QueueFunctionToThread(le_thread_Ref_t, le_event_DeferredFunc_t, void*, void*);
+void le_event_RunLoop(void);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * IPC sessions, all served in the test process.  The service close handlers are called by
+ * le_test_CloseSession().
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct le_msg_Session* le_msg_SessionRef_t;
+typedef struct le_msg_Service* le_msg_ServiceRef_t;
+typedef struct le_msg_SessionEventHandler* le_msg_SessionEventHandlerRef_t;
+typedef void (*le_msg_SessionEventHandler_t)(le_msg_SessionRef_t, void*);
+
+le_msg_SessionEventHandlerRef_t le_msg_AddServiceCloseHandler(
+    le_msg_ServiceRef_t,
+    le_msg_SessionEventHandler_t,
+    void*);
+le_result_t le_msg_GetClientProcessId(le_msg_SessionRef_t, pid_t*);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Signal events and command line arguments, accepted and never delivered
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*le_sig_EventHandlerFunc_t)(int);
+typedef void (*le_arg_StringCallbackFunc_t)(const char*);
+
+void le_sig_Block(int);
+void le_sig_SetEventHandler(int, le_sig_EventHandlerFunc_t);
+void le_arg_SetStringCallback(le_arg_StringCallbackFunc_t, const char*, const char*);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Component initialization, called by the tests
+ */
+//--------------------------------------------------------------------------------------------------
+#define COMPONENT_INIT void le_test_InitComponent(void)
+
+void le_test_InitComponent(void);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Host test control, not part of Legato
+ */
+//--------------------------------------------------------------------------------------------------
+void le_test_SimulateClock(void);
+void le_test_AdvanceClock(uint32_t);
+void le_test_AdvanceClockNs(uint64_t);
+bool le_test_RunNextTimer(uint32_t);
+size_t le_test_RunEvents(void);
+void le_test_SetCfgString(const char*, const char*);
+void le_test_SetCfgInt(const char*, int32_t);
+void le_test_SetDataConnection(bool);
+void le_test_CloseSession(le_msg_SessionRef_t);
+uint64_t le_test_NowNs(void);
+
+#endif
@@ -0,0 +1,255 @@
+/**
+ * @file
+ *
+ * Fairness of the router under an adversarial client, with and without rate limits.
+ *
+ * The router serves the requests of all the sessions in arrival order from a single thread.  The
+ * test simulates it on the simulated clock with limit.c admitting the requests: an admitted write
+ * costs the router ROUTER_WRITE_US (hashing, notification fan-out and MQTT push) and a rejected
+ * one ROUTER_REJECT_US.  The adversary writes in a tight loop from ADVERSARY_THREADS threads, each
+ * waiting for its previous write, while well-behaved clients write every WELL_BEHAVED_PERIOD_MS.
+ *
+ * With limits, the well-behaved clients are never rejected and their p99 latency stays within a
+ * few admitted writes, and the adversary is admitted no more than its rate allows.  Its excess
+ * writes still reach the router, but rejecting them costs far less than serving them.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "limit.h"
+
+#define LIMIT_TEST_ROUTER_WRITE_US 200
+#define LIMIT_TEST_ROUTER_REJECT_US 5
+#define LIMIT_TEST_ADVERSARY_THREADS 16
+#define LIMIT_TEST_WELL_BEHAVED_NUM 4
+#define LIMIT_TEST_WELL_BEHAVED_PERIOD_MS 100
+#define LIMIT_TEST_WRITE_RATE 100
+#define LIMIT_TEST_WRITE_BURST 50
+#define LIMIT_TEST_DURATION_SECS 60
+
+#define LIMIT_TEST_NUM_CLIENTS (LIMIT_TEST_WELL_BEHAVED_NUM + 1)
+#define LIMIT_TEST_ADVERSARY LIMIT_TEST_WELL_BEHAVED_NUM
+#define LIMIT_TEST_QUEUE_LEN 64
+#define LIMIT_TEST_NUM_SAMPLES \
+    (LIMIT_TEST_WELL_BEHAVED_NUM * LIMIT_TEST_DURATION_SECS * 1000 / \
+     LIMIT_TEST_WELL_BEHAVED_PERIOD_MS)
+
+#define LIMIT_TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Request waiting for the router
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t client;   ///< Client index, LIMIT_TEST_ADVERSARY for the adversary
+    uint64_t issuedUs; ///< Time the request was sent
+} limit_test_request_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Results of a run
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t p50Us;                       ///< Well-behaved write latency median
+    uint32_t p99Us;                       ///< Well-behaved write latency 99th percentile
+    uint32_t maxUs;                       ///< Well-behaved write latency maximum
+    uint32_t numWellBehavedRejected;      ///< Well-behaved writes rejected
+    uint32_t numAdversaryAdmitted;        ///< Adversary writes admitted
+    uint32_t numAdversaryRejected;        ///< Adversary writes rejected
+    double adversaryWriteShare;           ///< Share of the time spent on admitted adversary writes
+    double adversaryRejectShare;          ///< Share of the time spent rejecting adversary writes
+} limit_test_result_t;
+
+static limit_test_request_t Queue[LIMIT_TEST_QUEUE_LEN];
+static uint32_t QueueHead;
+static uint32_t QueueLen;
+static uint32_t Latencies[LIMIT_TEST_NUM_SAMPLES];
+
+static void limit_test_push
+(
+    uint32_t client,
+    uint64_t issuedUs
+)
+{
+    LE_ASSERT(QueueLen < LIMIT_TEST_QUEUE_LEN);
+    Queue[(QueueHead + QueueLen++) % LIMIT_TEST_QUEUE_LEN] =
+        (limit_test_request_t){ .client = client, .issuedUs = issuedUs };
+}
+
+static limit_test_request_t limit_test_pop
+(
+    void
+)
+{
+    limit_test_request_t request = Queue[QueueHead];
+
+    QueueHead = (QueueHead + 1) % LIMIT_TEST_QUEUE_LEN;
+    QueueLen--;
+    return request;
+}
+
+static int limit_test_compare
+(
+    const void* first,
+    const void* second
+)
+{
+    uint32_t a = *(const uint32_t*)first;
+    uint32_t b = *(const uint32_t*)second;
+
+    return (a > b) - (a < b);
+}
+
+static void limit_test_run
+(
+    bool limited,
+    limit_test_result_t* result
+)
+{
+    swi_mangoh_data_router_limit_t limits[LIMIT_TEST_NUM_CLIENTS];
+    uint64_t nextUs[LIMIT_TEST_WELL_BEHAVED_NUM];
+    uint64_t endUs = (uint64_t)LIMIT_TEST_DURATION_SECS * 1000000;
+    uint64_t periodUs = LIMIT_TEST_WELL_BEHAVED_PERIOD_MS * 1000;
+    uint64_t adversaryWriteUs = 0;
+    uint64_t adversaryRejectUs = 0;
+    uint64_t nowUs = 0;
+    uint64_t clockUs = 0;
+    uint32_t numSamples = 0;
+    char appName[32];
+
+    memset(result, 0, sizeof(limit_test_result_t));
+    le_test_SetCfgInt("/RateLimit/writeRate", limited ? LIMIT_TEST_WRITE_RATE : 0);
+    le_test_SetCfgInt("/RateLimit/writeBurst", LIMIT_TEST_WRITE_BURST);
+    le_test_SimulateClock();
+    for (uint32_t i = 0; i < LIMIT_TEST_NUM_CLIENTS; i++)
+    {
+        snprintf(appName, sizeof(appName), (i == LIMIT_TEST_ADVERSARY) ? "adversary" : "app%u", i);
+        swi_mangoh_data_router_limit_init(&limits[i], appName);
+    }
+
+    // The well-behaved clients are out of phase
+    for (uint32_t i = 0; i < LIMIT_TEST_WELL_BEHAVED_NUM; i++)
+    {
+        nextUs[i] = i * periodUs / LIMIT_TEST_WELL_BEHAVED_NUM;
+    }
+
+    QueueHead = 0;
+    QueueLen = 0;
+    for (uint32_t i = 0; i < LIMIT_TEST_ADVERSARY_THREADS; i++)
+    {
+        limit_test_push(LIMIT_TEST_ADVERSARY, 0);
+    }
+
+    while (nowUs < endUs)
+    {
+        // The requests sent up to now are queued in order
+        for (;;)
+        {
+            uint32_t next = 0;
+            for (uint32_t i = 1; i < LIMIT_TEST_WELL_BEHAVED_NUM; i++)
+            {
+                next = (nextUs[i] < nextUs[next]) ? i : next;
+            }
+
+            if ((nextUs[next] > nowUs) && QueueLen)
+            {
+                break;
+            }
+
+            nowUs = (nextUs[next] > nowUs) ? nextUs[next] : nowUs;
+            limit_test_push(next, nextUs[next]);
+            nextUs[next] += periodUs;
+        }
+
+        limit_test_request_t request = limit_test_pop();
+        le_test_AdvanceClockNs((nowUs - clockUs) * 1000);
+        clockUs = nowUs;
+        bool admitted =
+            swi_mangoh_data_router_limit_admit(&limits[request.client],
+                                               SWI_MANGOH_DATA_ROUTER_LIMIT_WRITE);
+        uint32_t costUs = admitted ? LIMIT_TEST_ROUTER_WRITE_US : LIMIT_TEST_ROUTER_REJECT_US;
+        nowUs += costUs;
+
+        if (request.client == LIMIT_TEST_ADVERSARY)
+        {
+            adversaryWriteUs += admitted ? costUs : 0;
+            adversaryRejectUs += admitted ? 0 : costUs;
+            result->numAdversaryAdmitted += admitted;
+            result->numAdversaryRejected += !admitted;
+
+            // The thread writes again as soon as its write returns
+            limit_test_push(LIMIT_TEST_ADVERSARY, nowUs);
+        }
+        else
+        {
+            result->numWellBehavedRejected += !admitted;
+            if (numSamples < LIMIT_TEST_NUM_SAMPLES)
+            {
+                Latencies[numSamples++] = nowUs - request.issuedUs;
+            }
+        }
+    }
+
+    qsort(Latencies, numSamples, sizeof(uint32_t), limit_test_compare);
+    result->p50Us = Latencies[numSamples / 2];
+    result->p99Us = Latencies[numSamples * 99 / 100];
+    result->maxUs = Latencies[numSamples - 1];
+    result->adversaryWriteShare = (double)adversaryWriteUs / nowUs;
+    result->adversaryRejectShare = (double)adversaryRejectUs / nowUs;
+
+    printf("  %-10s well-behaved p50 %5u us  p99 %5u us  max %5u us  rejected %u\n",
+           limited ? "limited" : "unlimited", result->p50Us, result->p99Us, result->maxUs,
+           result->numWellBehavedRejected);
+    printf("  %-10s adversary admitted %u/s (%.1f%% of the time)  rejected %u/s (%.1f%%)\n", "",
+           result->numAdversaryAdmitted / LIMIT_TEST_DURATION_SECS,
+           100 * result->adversaryWriteShare,
+           result->numAdversaryRejected / LIMIT_TEST_DURATION_SECS,
+           100 * result->adversaryRejectShare);
+}
+
+int main
+(
+    void
+)
+{
+    limit_test_result_t unlimited;
+    limit_test_result_t limited;
+
+    printf("%u well-behaved clients writing every %u ms, adversary writing from %u threads, "
+           "%u s\n", LIMIT_TEST_WELL_BEHAVED_NUM, LIMIT_TEST_WELL_BEHAVED_PERIOD_MS,
+           LIMIT_TEST_ADVERSARY_THREADS, LIMIT_TEST_DURATION_SECS);
+    limit_test_run(false, &unlimited);
+    limit_test_run(true, &limited);
+
+    // Without limits the adversary takes the router, each well-behaved write waits for a write of
+    // every adversary thread
+    LIMIT_TEST_CHECK(unlimited.adversaryWriteShare > 0.95);
+    LIMIT_TEST_CHECK(unlimited.p99Us >=
+                     LIMIT_TEST_ADVERSARY_THREADS * LIMIT_TEST_ROUTER_WRITE_US / 2);
+
+    LIMIT_TEST_CHECK(!limited.numWellBehavedRejected);
+    LIMIT_TEST_CHECK(limited.numAdversaryAdmitted <=
+                     LIMIT_TEST_WRITE_RATE * LIMIT_TEST_DURATION_SECS + LIMIT_TEST_WRITE_BURST);
+    LIMIT_TEST_CHECK(limited.adversaryWriteShare < 0.05);
+    LIMIT_TEST_CHECK(limited.p99Us <= 4 * LIMIT_TEST_ROUTER_WRITE_US);
+    LIMIT_TEST_CHECK(limited.p99Us * 4 <= unlimited.p99Us);
+
+    printf("limit_test: passed\n");
+    return EXIT_SUCCESS;
+}
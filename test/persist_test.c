@@ -0,0 +1,201 @@
+/**
+ * @file
+ *
+ * Test of the persistence of persist.c: the items updated with a persisted storage type are
+ * written to the config tree by the writer thread on the snapshot timer, coalesced while dirty,
+ * removed from it once their storage type is cache, and the items still dirty are written by a
+ * flush.  The simulated clock runs the snapshot timer, the batches are written by the writer
+ * thread as on the target.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "db.h"
+#include "persist.h"
+
+#define PERSIST_TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+#define PERSIST_TEST_INTERVAL_MS (SWI_MANGOH_DATA_ROUTER_PERSIST_INTERVAL_SECS * 1000)
+#define PERSIST_TEST_WAIT_US 1000
+#define PERSIST_TEST_WAIT_MAX_NUM 10000
+#define PERSIST_TEST_VALUE_MAX_LEN 64
+
+static swi_mangoh_data_router_db_t Db;
+static swi_mangoh_data_router_persist_t Persist;
+static uint32_t NumChecks;
+
+static void persist_test_write
+(
+    const char* key,
+    dataRouter_Storage_t storageType,
+    dataRouter_DataType_t type,
+    int32_t iValue,
+    const char* sValue
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_db_getDataItem(&Db, key);
+
+    if (!dbItem)
+    {
+        dbItem = swi_mangoh_data_router_db_createDataItem(&Db, key);
+        LE_ASSERT(dbItem);
+    }
+
+    swi_mangoh_data_router_db_beginUpdate(dbItem);
+    swi_mangoh_data_router_db_setStorageType(dbItem, storageType);
+    swi_mangoh_data_router_db_setDataType(dbItem, type);
+    if (type == DATAROUTER_STRING)
+    {
+        swi_mangoh_data_router_db_setStringValue(dbItem, sValue);
+    }
+    else
+    {
+        swi_mangoh_data_router_db_setIntegerValue(dbItem, iValue);
+    }
+    swi_mangoh_data_router_db_setTimestamp(dbItem, 1);
+    swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+}
+
+// Runs the snapshot timer and waits for the writer thread to write the batch
+static void persist_test_snapshot
+(
+    void
+)
+{
+    le_test_AdvanceClock(PERSIST_TEST_INTERVAL_MS);
+    le_test_RunEvents();
+
+    for (uint32_t i = 0; i < SWI_MANGOH_DATA_ROUTER_PERSIST_BATCHES_NUM; i++)
+    {
+        uint32_t numWaits = 0;
+
+        while (__atomic_load_n(&Persist.batches[i].busy, __ATOMIC_ACQUIRE))
+        {
+            LE_ASSERT(++numWaits < PERSIST_TEST_WAIT_MAX_NUM);
+            usleep(PERSIST_TEST_WAIT_US);
+        }
+    }
+}
+
+static bool persist_test_isStored
+(
+    const char* key
+)
+{
+    char path[SWI_MANGOH_DATA_ROUTER_CFG_MAX_PATH_LEN];
+    char value[PERSIST_TEST_VALUE_MAX_LEN];
+
+    snprintf(path, sizeof(path), "%s/%s/%s", SWI_MANGOH_DATA_ROUTER_CFG_BASE_NAME, key,
+             SWI_MANGOH_DATA_ROUTER_CFG_KEY);
+    le_cfg_QuickGetString(path, value, sizeof(value), "");
+    return !strcmp(value, key);
+}
+
+static int32_t persist_test_getInt
+(
+    const char* key
+)
+{
+    char path[SWI_MANGOH_DATA_ROUTER_CFG_MAX_PATH_LEN];
+
+    snprintf(path, sizeof(path), "%s/%s/%s", SWI_MANGOH_DATA_ROUTER_CFG_BASE_NAME, key,
+             SWI_MANGOH_DATA_ROUTER_CFG_VALUE);
+    return le_cfg_QuickGetInt(path, -1);
+}
+
+static void persist_test_timer
+(
+    void
+)
+{
+    char path[SWI_MANGOH_DATA_ROUTER_CFG_MAX_PATH_LEN];
+    char value[PERSIST_TEST_VALUE_MAX_LEN];
+
+    printf("persisted items written on the snapshot timer\n");
+    persist_test_write("p/count", DATAROUTER_PERSIST, DATAROUTER_INTEGER, 42, NULL);
+    persist_test_write("p/name", DATAROUTER_PERSIST, DATAROUTER_STRING, 0, "pump");
+    persist_test_write("c/level", DATAROUTER_CACHE, DATAROUTER_INTEGER, 7, NULL);
+    PERSIST_TEST_CHECK(!persist_test_isStored("p/count") && !persist_test_isStored("p/name"));
+
+    persist_test_snapshot();
+    PERSIST_TEST_CHECK(persist_test_isStored("p/count") && (persist_test_getInt("p/count") == 42));
+    snprintf(path, sizeof(path), "%s/p/name/%s", SWI_MANGOH_DATA_ROUTER_CFG_BASE_NAME,
+             SWI_MANGOH_DATA_ROUTER_CFG_VALUE);
+    le_cfg_QuickGetString(path, value, sizeof(value), "");
+    PERSIST_TEST_CHECK(!strcmp(value, "pump"));
+    PERSIST_TEST_CHECK(!persist_test_isStored("c/level"));
+    PERSIST_TEST_CHECK(!swi_mangoh_data_router_db_popDirtyItem(&Db));
+    NumChecks++;
+}
+
+static void persist_test_coalesce
+(
+    void
+)
+{
+    printf("updates coalesced, items moved to the cache removed\n");
+    for (int32_t i = 43; i <= 45; i++)
+    {
+        persist_test_write("p/count", DATAROUTER_PERSIST, DATAROUTER_INTEGER, i, NULL);
+    }
+
+    persist_test_write("p/name", DATAROUTER_CACHE, DATAROUTER_STRING, 0, "valve");
+    PERSIST_TEST_CHECK(persist_test_getInt("p/count") == 42);
+
+    persist_test_snapshot();
+    PERSIST_TEST_CHECK(persist_test_getInt("p/count") == 45);
+    PERSIST_TEST_CHECK(!persist_test_isStored("p/name"));
+
+    // Nothing dirty, no batch is handed to the writer thread
+    persist_test_snapshot();
+    for (uint32_t i = 0; i < SWI_MANGOH_DATA_ROUTER_PERSIST_BATCHES_NUM; i++)
+    {
+        PERSIST_TEST_CHECK(!Persist.batches[i].numItems);
+    }
+
+    PERSIST_TEST_CHECK(!Persist.numDeferred);
+    NumChecks++;
+}
+
+static void persist_test_flush
+(
+    void
+)
+{
+    printf("items still dirty written by a flush\n");
+    persist_test_write("p/count", DATAROUTER_PERSIST, DATAROUTER_INTEGER, 46, NULL);
+    persist_test_write("p/other", DATAROUTER_PERSIST, DATAROUTER_INTEGER, 3, NULL);
+    swi_mangoh_data_router_persist_flush(&Persist);
+    PERSIST_TEST_CHECK(persist_test_getInt("p/count") == 46);
+    PERSIST_TEST_CHECK(persist_test_getInt("p/other") == 3);
+    NumChecks++;
+}
+
+int main
+(
+    void
+)
+{
+    le_test_SimulateClock();
+    swi_mangoh_data_router_db_init(&Db);
+    swi_mangoh_data_router_persist_start(&Persist, &Db);
+
+    persist_test_timer();
+    persist_test_coalesce();
+    persist_test_flush();
+
+    printf("persist_test: %u checks passed\n", NumChecks);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file
+ *
+ * Test of the priority classes of priority.c: a key gets the class of its key rule, or else of
+ * its longest matching prefix rule, normal by default, and the class cached in the database item
+ * is matched again once the rules change.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "db.h"
+#include "priority.h"
+
+#define PRIORITY_TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+#define PRIORITY_TEST_PATTERN_MAX_LEN 16
+
+static swi_mangoh_data_router_db_t Db;
+static swi_mangoh_data_router_priority_t Priorities;
+static uint32_t NumChecks;
+
+static dataRouter_Priority_t priority_test_get
+(
+    const char* key
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_db_getDataItem(&Db, key);
+
+    if (!dbItem)
+    {
+        dbItem = swi_mangoh_data_router_db_createDataItem(&Db, key);
+        LE_ASSERT(dbItem);
+    }
+
+    swi_mangoh_data_router_priority_apply(&Priorities, dbItem);
+    return dbItem->priority;
+}
+
+static void priority_test_match
+(
+    void
+)
+{
+    printf("key rule first, then the longest prefix rule, normal by default\n");
+    PRIORITY_TEST_CHECK(priority_test_get("alarm/door") == DATAROUTER_PRIORITY_NORMAL);
+
+    PRIORITY_TEST_CHECK(swi_mangoh_data_router_priority_set(
+        &Priorities, "alarm/*", DATAROUTER_PRIORITY_CRITICAL) == LE_OK);
+    PRIORITY_TEST_CHECK(swi_mangoh_data_router_priority_set(
+        &Priorities, "alarm/log/*", DATAROUTER_PRIORITY_BULK) == LE_OK);
+    PRIORITY_TEST_CHECK(swi_mangoh_data_router_priority_set(
+        &Priorities, "alarm/log/fire", DATAROUTER_PRIORITY_NORMAL) == LE_OK);
+    PRIORITY_TEST_CHECK(swi_mangoh_data_router_priority_set(
+        &Priorities, "*", DATAROUTER_PRIORITY_BULK) == LE_OK);
+
+    PRIORITY_TEST_CHECK(priority_test_get("alarm/door") == DATAROUTER_PRIORITY_CRITICAL);
+    PRIORITY_TEST_CHECK(priority_test_get("alarm/log/door") == DATAROUTER_PRIORITY_BULK);
+    PRIORITY_TEST_CHECK(priority_test_get("alarm/log/fire") == DATAROUTER_PRIORITY_NORMAL);
+    PRIORITY_TEST_CHECK(priority_test_get("alarm") == DATAROUTER_PRIORITY_BULK);
+    PRIORITY_TEST_CHECK(priority_test_get("sensor/temp") == DATAROUTER_PRIORITY_BULK);
+    PRIORITY_TEST_CHECK(Priorities.numRules == 4);
+    NumChecks++;
+}
+
+static void priority_test_change
+(
+    void
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(&Db, "alarm/door");
+    uint32_t generation = Priorities.generation;
+
+    printf("rule of the same pattern replaced, classes matched again\n");
+    PRIORITY_TEST_CHECK(dbItem->priorityGeneration == generation);
+    PRIORITY_TEST_CHECK(swi_mangoh_data_router_priority_set(
+        &Priorities, "alarm/*", DATAROUTER_PRIORITY_NORMAL) == LE_OK);
+    PRIORITY_TEST_CHECK((Priorities.numRules == 4) && (Priorities.generation == generation + 1));
+    PRIORITY_TEST_CHECK(dbItem->priority == DATAROUTER_PRIORITY_CRITICAL);
+    PRIORITY_TEST_CHECK(priority_test_get("alarm/door") == DATAROUTER_PRIORITY_NORMAL);
+
+    // A failed change keeps the rules and the cached classes
+    PRIORITY_TEST_CHECK(swi_mangoh_data_router_priority_set(
+        &Priorities, "alarm/*", SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM) == LE_BAD_PARAMETER);
+    PRIORITY_TEST_CHECK(Priorities.generation == generation + 1);
+    NumChecks++;
+}
+
+static void priority_test_limits
+(
+    void
+)
+{
+    char pattern[PRIORITY_TEST_PATTERN_MAX_LEN];
+    char longPattern[SWI_MANGOH_DATA_ROUTER_KEY_MAX_LEN + 1];
+
+    printf("rules table and pattern length limited\n");
+    memset(longPattern, 'k', sizeof(longPattern) - 1);
+    longPattern[sizeof(longPattern) - 1] = '\0';
+    PRIORITY_TEST_CHECK(swi_mangoh_data_router_priority_set(
+        &Priorities, longPattern, DATAROUTER_PRIORITY_BULK) == LE_BAD_PARAMETER);
+
+    while (Priorities.numRules < SWI_MANGOH_DATA_ROUTER_PRIORITY_RULES_MAX_NUM)
+    {
+        snprintf(pattern, sizeof(pattern), "fill/%u", Priorities.numRules);
+        PRIORITY_TEST_CHECK(swi_mangoh_data_router_priority_set(
+            &Priorities, pattern, DATAROUTER_PRIORITY_BULK) == LE_OK);
+    }
+
+    PRIORITY_TEST_CHECK(swi_mangoh_data_router_priority_set(
+        &Priorities, "extra", DATAROUTER_PRIORITY_BULK) == LE_NO_MEMORY);
+
+    // The rule of an existing pattern can still be changed
+    PRIORITY_TEST_CHECK(swi_mangoh_data_router_priority_set(
+        &Priorities, "alarm/*", DATAROUTER_PRIORITY_CRITICAL) == LE_OK);
+    PRIORITY_TEST_CHECK(!strcmp(
+        swi_mangoh_data_router_priority_getName(DATAROUTER_PRIORITY_CRITICAL), "critical"));
+    PRIORITY_TEST_CHECK(!strcmp(
+        swi_mangoh_data_router_priority_getName(SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM), "unknown"));
+    NumChecks++;
+}
+
+int main
+(
+    void
+)
+{
+    swi_mangoh_data_router_db_init(&Db);
+    swi_mangoh_data_router_priority_init(&Priorities);
+
+    priority_test_match();
+    priority_test_change();
+    priority_test_limits();
+
+    printf("priority_test: %u checks passed\n", NumChecks);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,238 @@
+/**
+ * @file
+ *
+ * Latency of float reads under a concurrent write storm, served by the main router thread and by
+ * the reader thread of reader.c.
+ *
+ * The router thread serves the storm writes and the main path reads from its event queue in
+ * arrival order, each client waiting for its request as over a synchronous IPC call.  The reader
+ * path reads run on the reader thread started by swi_mangoh_data_router_reader_start() and take
+ * no lock.  The storm writes from STORM_THREADS threads by handle, each write optionally spinning
+ * for the given microseconds to stand for the notification fan-out and the MQTT push.
+ *
+ *   reader_bench [<storm threads> [<write work us>]]
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "db.h"
+#include "reader.h"
+
+#define READER_BENCH_KEY "bench/storm"
+#define READER_BENCH_NUM_READS 20000
+#define READER_BENCH_STORM_THREADS 4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Synchronous request to a serving thread
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_sem_Ref_t done;   ///< Posted once the request is served
+    uint32_t handle;     ///< Key handle of a write
+    double value;        ///< Value written or read
+    le_result_t result;  ///< Result of a read
+} reader_bench_request_t;
+
+static swi_mangoh_data_router_db_t Db;
+static le_thread_Ref_t RouterThread;
+static le_thread_Ref_t ReaderThread;
+static le_sem_Ref_t ReaderStarted;
+static uint32_t WriteWorkUs;
+static volatile uint64_t NumWrites;
+static uint64_t Latencies[READER_BENCH_NUM_READS];
+
+// The reader thread is captured when it advertises its service
+void dataRouterReader_AdvertiseService
+(
+    void
+)
+{
+    ReaderThread = le_thread_GetCurrent();
+    le_sem_Post(ReaderStarted);
+}
+
+static void reader_bench_call
+(
+    le_thread_Ref_t thread,
+    le_event_DeferredFunc_t func,
+    reader_bench_request_t* request
+)
+{
+    le_event_QueueFunctionToThread(thread, func, request, NULL);
+    le_sem_Wait(request->done);
+}
+
+static void reader_bench_write
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    reader_bench_request_t* request = (reader_bench_request_t*)param1Ptr;
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItemByHandle(&Db, request->handle);
+
+    swi_mangoh_data_router_db_beginUpdate(dbItem);
+    swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_FLOAT);
+    swi_mangoh_data_router_db_setFloatValue(dbItem, request->value);
+    swi_mangoh_data_router_db_setTimestamp(dbItem, (uint32_t)request->value);
+    swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+
+    uint64_t endNs = le_test_NowNs() + (uint64_t)WriteWorkUs * 1000;
+    while (le_test_NowNs() < endNs)
+    {
+    }
+
+    NumWrites++;
+    le_sem_Post(request->done);
+}
+
+// Read served by the router thread, as dataRouter_ReadFloat()
+static void reader_bench_mainRead
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    reader_bench_request_t* request = (reader_bench_request_t*)param1Ptr;
+    swi_mangoh_data_router_data_t data;
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_getDataItem(&Db, READER_BENCH_KEY);
+
+    request->result = dbItem ? LE_OK : LE_NOT_FOUND;
+    if (dbItem)
+    {
+        swi_mangoh_data_router_db_readData(dbItem, &data);
+        request->value = data.fValue;
+    }
+
+    le_sem_Post(request->done);
+}
+
+// Read served by the reader thread
+static void reader_bench_readerRead
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    reader_bench_request_t* request = (reader_bench_request_t*)param1Ptr;
+    uint32_t timestamp;
+
+    request->result = dataRouterReader_ReadFloat(READER_BENCH_KEY, &request->value, &timestamp);
+    le_sem_Post(request->done);
+}
+
+static void* reader_bench_routerMain
+(
+    void* context
+)
+{
+    le_event_RunLoop();
+    return NULL;
+}
+
+static void* reader_bench_stormMain
+(
+    void* context
+)
+{
+    reader_bench_request_t request = { .done = le_sem_Create("storm", 0) };
+
+    request.handle = (uint32_t)(uintptr_t)context;
+    for (uint32_t i = 0; ; i++)
+    {
+        request.value = i;
+        reader_bench_call(RouterThread, reader_bench_write, &request);
+    }
+
+    return NULL;
+}
+
+static int reader_bench_compare
+(
+    const void* first,
+    const void* second
+)
+{
+    uint64_t a = *(const uint64_t*)first;
+    uint64_t b = *(const uint64_t*)second;
+
+    return (a > b) - (a < b);
+}
+
+static void reader_bench_measure
+(
+    const char* name,
+    le_thread_Ref_t thread,
+    le_event_DeferredFunc_t func
+)
+{
+    reader_bench_request_t request = { .done = le_sem_Create(name, 0) };
+    uint64_t numWrites = NumWrites;
+    uint64_t startNs = le_test_NowNs();
+
+    for (uint32_t i = 0; i < READER_BENCH_NUM_READS; i++)
+    {
+        uint64_t readNs = le_test_NowNs();
+        reader_bench_call(thread, func, &request);
+        LE_ASSERT_OK(request.result);
+        Latencies[i] = (le_test_NowNs() - readNs) / 1000;
+    }
+
+    double elapsedSecs = (le_test_NowNs() - startNs) / 1e9;
+    qsort(Latencies, READER_BENCH_NUM_READS, sizeof(uint64_t), reader_bench_compare);
+    printf("  %-28s p50 %5llu us  p99 %5llu us  max %6llu us  storm %.0f writes/s\n",
+           name,
+           (unsigned long long)Latencies[READER_BENCH_NUM_READS / 2],
+           (unsigned long long)Latencies[READER_BENCH_NUM_READS * 99 / 100],
+           (unsigned long long)Latencies[READER_BENCH_NUM_READS - 1],
+           (NumWrites - numWrites) / elapsedSecs);
+}
+
+int main
+(
+    int argc,
+    char** argv
+)
+{
+    uint32_t numStormThreads = (argc > 1) ? atoi(argv[1]) : READER_BENCH_STORM_THREADS;
+
+    WriteWorkUs = (argc > 2) ? atoi(argv[2]) : 0;
+    swi_mangoh_data_router_db_init(&Db);
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        swi_mangoh_data_router_db_createDataItem(&Db, READER_BENCH_KEY);
+    LE_ASSERT(dbItem);
+    uint32_t handle = swi_mangoh_data_router_db_registerHandle(&Db, dbItem);
+    reader_bench_request_t request = { .done = le_sem_Create("init", 0), .handle = handle };
+
+    RouterThread = le_thread_Create("router", reader_bench_routerMain, NULL);
+    le_thread_Start(RouterThread);
+    reader_bench_call(RouterThread, reader_bench_write, &request);
+
+    ReaderStarted = le_sem_Create("reader", 0);
+    swi_mangoh_data_router_reader_start(&Db);
+    le_sem_Wait(ReaderStarted);
+
+    printf("float reads, %u reads, %ld cpus, storm of %u threads, %u us of work per write\n",
+           READER_BENCH_NUM_READS, sysconf(_SC_NPROCESSORS_ONLN), numStormThreads, WriteWorkUs);
+    reader_bench_measure("idle main thread", RouterThread, reader_bench_mainRead);
+    reader_bench_measure("idle reader thread", ReaderThread, reader_bench_readerRead);
+
+    for (uint32_t i = 0; i < numStormThreads; i++)
+    {
+        le_thread_Start(le_thread_Create("storm", reader_bench_stormMain,
+                                         (void*)(uintptr_t)handle));
+    }
+
+    reader_bench_measure("storm main thread", RouterThread, reader_bench_mainRead);
+    reader_bench_measure("storm reader thread", ReaderThread, reader_bench_readerRead);
+
+    return EXIT_SUCCESS;
+}
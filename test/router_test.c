@@ -0,0 +1,242 @@
+/**
+ * @file
+ *
+ * Test of the write path of router.c through the dataRouter API, on the simulated clock with the
+ * MQTT transport running against the stand-in broker.  The client sessions of the API are set by
+ * the test before each call:
+ *
+ * - the TryWrite functions store the values and record the float history,
+ * - a filtered handler registered on a key without a value fires when the first value enters the
+ *   range, and is removed with the session of its subscriber, as are its derived keys,
+ * - the TryWrite functions report LE_BUSY once the MQTT queue reaches the high watermark while
+ *   disconnected and LE_OVERFLOW once it drops updates, the flow control handlers are told of the
+ *   congestion and of the drain once connected.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "broker.h"
+#include "flow.h"
+#include "mqtt.h"
+
+#define ROUTER_TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+#define ROUTER_TEST_HISTORY_NUM 8
+#define ROUTER_TEST_KEY_MAX_LEN 32
+#define ROUTER_TEST_MAX_TIMERS 1000
+#define ROUTER_TEST_TIMER_MAX_MS 60000
+
+// Stand-ins for the IPC sessions of the client apps
+static int Producer;
+static int Consumer;
+static int Pusher;
+
+static uint32_t NumUpdates;
+static uint32_t NumCongested;
+static uint32_t NumDrained;
+static uint32_t NumChecks;
+
+// The reader thread is started by the router, its service is not exercised by this test
+void dataRouterReader_AdvertiseService
+(
+    void
+)
+{
+}
+
+static void router_test_setSession
+(
+    int* session
+)
+{
+    le_test_SetClientSession((le_msg_SessionRef_t)session);
+}
+
+static void router_test_updateHandler
+(
+    dataRouter_DataType_t type,
+    const char* key,
+    void* contextPtr
+)
+{
+    LE_ASSERT(type == DATAROUTER_FLOAT);
+    NumUpdates++;
+}
+
+static void router_test_flowHandler
+(
+    bool congested,
+    void* contextPtr
+)
+{
+    if (congested)
+    {
+        NumCongested++;
+    }
+    else
+    {
+        NumDrained++;
+    }
+}
+
+static void router_test_history
+(
+    void
+)
+{
+    double values[ROUTER_TEST_HISTORY_NUM];
+    uint32_t timestamps[ROUTER_TEST_HISTORY_NUM];
+    size_t numValues = NUM_ARRAY_MEMBERS(values);
+    size_t numTimestamps = NUM_ARRAY_MEMBERS(timestamps);
+    int32_t iValue = 0;
+    double fValue = 0;
+    uint32_t timestamp = 0;
+
+    printf("TryWrite stores the values and records the history\n");
+    router_test_setSession(&Producer);
+    dataRouter_SessionStart("", "", false, DATAROUTER_CACHE);
+    ROUTER_TEST_CHECK(dataRouter_EnableHistory("sensor/temp", ROUTER_TEST_HISTORY_NUM) == LE_OK);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        ROUTER_TEST_CHECK(dataRouter_TryWriteFloat("sensor/temp", 20.5 + i, 100 + i) == LE_OK);
+    }
+
+    ROUTER_TEST_CHECK(dataRouter_ReadFloatHistory(
+                          "sensor/temp", 0, values, &numValues, timestamps, &numTimestamps) ==
+                      LE_OK);
+    ROUTER_TEST_CHECK((numValues == 3) && (numTimestamps == 3));
+    ROUTER_TEST_CHECK((values[0] == 20.5) && (values[2] == 22.5));
+    ROUTER_TEST_CHECK((timestamps[0] == 100) && (timestamps[2] == 102));
+
+    dataRouter_ReadFloat("sensor/temp", &fValue, &timestamp);
+    ROUTER_TEST_CHECK((fValue == 22.5) && (timestamp == 102));
+
+    ROUTER_TEST_CHECK(dataRouter_TryWriteInteger("sensor/count", 7, 103) == LE_OK);
+    dataRouter_ReadInteger("sensor/count", &iValue, &timestamp);
+    ROUTER_TEST_CHECK((iValue == 7) && (timestamp == 103));
+
+    // Without a session the write is refused
+    router_test_setSession(&Consumer);
+    ROUTER_TEST_CHECK(dataRouter_TryWriteFloat("sensor/temp", 0, 104) == LE_NOT_PERMITTED);
+    NumChecks++;
+}
+
+static void router_test_filter
+(
+    void
+)
+{
+    static const double levels[] = { 15, 16, 25, 12, 30 };
+    double fValue = 0;
+    uint32_t timestamp = 0;
+
+    printf("filtered handler fires on entering the range from an empty key\n");
+    router_test_setSession(&Consumer);
+    dataRouter_SessionStart("", "", false, DATAROUTER_CACHE);
+    ROUTER_TEST_CHECK(dataRouter_AddFilteredDataUpdateHandler(
+        "tank/level", DATAROUTER_FILTER_ENTER_RANGE, 10, 20, "", router_test_updateHandler, NULL));
+    ROUTER_TEST_CHECK(dataRouter_DefineDerivedKey("tank/double", "{tank/level} * 2") == LE_OK);
+    ROUTER_TEST_CHECK(dataRouter_DefineDerivedKey("tank/half", "{tank/level} / 2") == LE_OK);
+    ROUTER_TEST_CHECK(dataRouter_RemoveDerivedKey("tank/half") == LE_OK);
+    ROUTER_TEST_CHECK(dataRouter_RemoveDerivedKey("tank/half") == LE_NOT_FOUND);
+
+    router_test_setSession(&Producer);
+    for (uint32_t i = 0; i < NUM_ARRAY_MEMBERS(levels); i++)
+    {
+        ROUTER_TEST_CHECK(dataRouter_TryWriteFloat("tank/level", levels[i], 200 + i) == LE_OK);
+    }
+
+    ROUTER_TEST_CHECK(NumUpdates == 2);
+    le_test_RunEvents();
+    dataRouter_ReadFloat("tank/double", &fValue, &timestamp);
+    ROUTER_TEST_CHECK(fValue == 60);
+
+    // The handler and the derived keys go with the session of the subscriber
+    le_test_CloseSession((le_msg_SessionRef_t)&Consumer);
+    ROUTER_TEST_CHECK(dataRouter_TryWriteFloat("tank/level", 15, 210) == LE_OK);
+    le_test_RunEvents();
+    ROUTER_TEST_CHECK(NumUpdates == 2);
+    dataRouter_ReadFloat("tank/double", &fValue, &timestamp);
+    ROUTER_TEST_CHECK(fValue == 60);
+    NumChecks++;
+}
+
+static void router_test_flow
+(
+    void
+)
+{
+    const broker_Stats_t* stats = broker_GetStats();
+    uint32_t numQueued = SWI_MANGOH_DATA_ROUTER_MQTT_QUEUED_REQUESTS_MAX_NUM;
+    uint32_t numHigh = (numQueued * SWI_MANGOH_DATA_ROUTER_FLOW_HIGH_WATERMARK + 99) / 100;
+    char key[ROUTER_TEST_KEY_MAX_LEN];
+
+    printf("TryWrite reports the congestion of the MQTT queue\n");
+    router_test_setSession(&Consumer);
+    dataRouter_SessionStart("", "", false, DATAROUTER_CACHE);
+    ROUTER_TEST_CHECK(dataRouter_AddFlowControlHandler(router_test_flowHandler, NULL));
+
+    router_test_setSession(&Pusher);
+    dataRouter_SessionStart("tcp://broker", "", true, DATAROUTER_CACHE);
+    for (uint32_t i = 0; i < numQueued + 1; i++)
+    {
+        le_result_t expected = LE_OK;
+
+        if (i == numQueued)
+        {
+            expected = LE_OVERFLOW;
+        }
+        else if (i + 1 >= numHigh)
+        {
+            expected = LE_BUSY;
+        }
+
+        snprintf(key, sizeof(key), "queue/%u", i);
+        ROUTER_TEST_CHECK(dataRouter_TryWriteFloat(key, i, 300 + i) == expected);
+    }
+
+    ROUTER_TEST_CHECK((NumCongested == 1) && !NumDrained && !stats->numMessages);
+
+    // The queue drains once connected, the producers are told on the next fill check
+    broker_SetUp(true);
+    for (uint32_t i = 0; (i < ROUTER_TEST_MAX_TIMERS) && !NumDrained; i++)
+    {
+        le_test_RunEvents();
+        le_test_RunNextTimer(ROUTER_TEST_TIMER_MAX_MS);
+    }
+
+    ROUTER_TEST_CHECK(stats->connected && (stats->numMessages >= numQueued));
+    ROUTER_TEST_CHECK((NumCongested == 1) && (NumDrained == 1));
+    ROUTER_TEST_CHECK(dataRouter_TryWriteFloat("queue/0", 0, 400) == LE_OK);
+    NumChecks++;
+}
+
+int main
+(
+    void
+)
+{
+    // The updates are queued in memory while disconnected
+    le_test_SimulateClock();
+    le_test_SetCfgString(SWI_MANGOH_DATA_ROUTER_MQTT_CFG_SPOOL_PATH, "");
+    le_test_InitComponent();
+
+    router_test_history();
+    router_test_filter();
+    router_test_flow();
+
+    printf("router_test: %u checks passed\n", NumChecks);
+    return EXIT_SUCCESS;
+}
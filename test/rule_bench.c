@@ -0,0 +1,136 @@
+/**
+ * @file
+ *
+ * Rule overhead per write: the time of a float write to the database with no rule on its key,
+ * with one rule on its key and with 1000 rules on its key, the 1000 rules either staying false or
+ * firing on every other write.
+ *
+ * A write is the lookup of the key, the update of its item and the evaluation of its rules, as in
+ * the router.  The fired actions run from the event loop after each write and write another key.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "db.h"
+#include "rule.h"
+
+#define RULE_BENCH_NUM_RULES 1000
+#define RULE_BENCH_NUM_WRITES 200000
+
+static swi_mangoh_data_router_db_t Db;
+static swi_mangoh_data_router_rules_t Rules;
+static uint32_t NumActions;
+
+static swi_mangoh_data_router_dbItem_t* rule_bench_getItem
+(
+    const char* key
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_db_getDataItem(&Db, key);
+
+    return dbItem ? dbItem : swi_mangoh_data_router_db_createDataItem(&Db, key);
+}
+
+static void rule_bench_write
+(
+    const char* key,
+    double value
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem = rule_bench_getItem(key);
+
+    swi_mangoh_data_router_db_beginUpdate(dbItem);
+    swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_FLOAT);
+    swi_mangoh_data_router_db_setFloatValue(dbItem, value);
+    swi_mangoh_data_router_db_setTimestamp(dbItem, le_clk_GetAbsoluteTime().sec);
+    swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+    swi_mangoh_data_router_rules_update(&Rules, dbItem);
+}
+
+static void rule_bench_runAction
+(
+    void* owner,
+    const swi_mangoh_data_router_ruleAction_t* action
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem = action->dbItem;
+
+    NumActions++;
+    if (!action->push)
+    {
+        swi_mangoh_data_router_db_beginUpdate(dbItem);
+        swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_BOOLEAN);
+        swi_mangoh_data_router_db_setBooleanValue(dbItem, action->value.bValue);
+        swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+    }
+}
+
+// Mean time of a write to the key, alternating the values given, in ns
+static double rule_bench_measure
+(
+    const char* key,
+    double first,
+    double second,
+    uint32_t numWrites
+)
+{
+    uint64_t start = le_test_NowNs();
+
+    for (uint32_t i = 0; i < numWrites; i++)
+    {
+        rule_bench_write(key, (i & 1) ? second : first);
+        le_test_RunEvents();
+    }
+
+    return (double)(le_test_NowNs() - start) / numWrites;
+}
+
+int main
+(
+    void
+)
+{
+    char name[32];
+    char key[32];
+    char condition[64];
+
+    swi_mangoh_data_router_db_init(&Db);
+    swi_mangoh_data_router_rules_init(&Rules, &Db, rule_bench_runAction);
+
+    rule_bench_write("free", 0);
+    rule_bench_write("armed", 0);
+    LE_ASSERT_OK(swi_mangoh_data_router_rules_add(&Rules, &Db, "one", "{single} > 50",
+                                                  "{out} = true"));
+    for (uint32_t i = 0; i < RULE_BENCH_NUM_RULES; i++)
+    {
+        snprintf(name, sizeof(name), "r%u", i);
+        snprintf(key, sizeof(key), "k%u", i);
+        snprintf(condition, sizeof(condition), "{%s} > 50 && {armed} > 0", key);
+        rule_bench_write(key, 100);
+        LE_ASSERT_OK(swi_mangoh_data_router_rules_add(&Rules, &Db, name, condition,
+                                                      "{out} = true"));
+    }
+
+    printf("rule overhead per write, %u writes, mean ns/write\n", RULE_BENCH_NUM_WRITES);
+    double none = rule_bench_measure("free", 1, 2, RULE_BENCH_NUM_WRITES);
+    printf("  no rule on the key               %8.1f\n", none);
+    double one = rule_bench_measure("single", 1, 2, RULE_BENCH_NUM_WRITES);
+    printf("  1 rule on the key                %8.1f\n", one);
+
+    // The 1000 rules stay false on negative values and all fire going from 0 to 1
+    double evaluated = rule_bench_measure("armed", -1, -2, RULE_BENCH_NUM_WRITES / 10);
+    printf("  1000 rules on the key, false     %8.1f  (%.2f ns/rule)\n",
+           evaluated, (evaluated - none) / RULE_BENCH_NUM_RULES);
+
+    NumActions = 0;
+    double fired = rule_bench_measure("armed", 0, 1, RULE_BENCH_NUM_WRITES / 10);
+    printf("  1000 rules on the key, firing    %8.1f  (%.2f ns/rule, %u actions)\n",
+           fired, (fired - none) / RULE_BENCH_NUM_RULES, NumActions);
+
+    LE_ASSERT(NumActions == RULE_BENCH_NUM_RULES * (RULE_BENCH_NUM_WRITES / 20));
+    return 0;
+}
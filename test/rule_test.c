@@ -0,0 +1,220 @@
+/**
+ * @file
+ *
+ * Test of the rules engine: malformed conditions and actions are rejected without reading past
+ * their end, valid rules fire their actions once per false to true transition, and rules undoing
+ * each other's writes stop after a bounded chain.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "db.h"
+#include "rule.h"
+
+#define RULE_TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+static swi_mangoh_data_router_db_t Db;
+static swi_mangoh_data_router_rules_t Rules;
+static uint32_t NumActions;
+static uint32_t NumChecks;
+
+static swi_mangoh_data_router_dbItem_t* rule_test_getItem
+(
+    const char* key
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_db_getDataItem(&Db, key);
+
+    return dbItem ? dbItem : swi_mangoh_data_router_db_createDataItem(&Db, key);
+}
+
+static void rule_test_writeFloat
+(
+    const char* key,
+    double value
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem = rule_test_getItem(key);
+
+    swi_mangoh_data_router_db_beginUpdate(dbItem);
+    swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_FLOAT);
+    swi_mangoh_data_router_db_setFloatValue(dbItem, value);
+    swi_mangoh_data_router_db_setTimestamp(dbItem, 1);
+    swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+    swi_mangoh_data_router_rules_update(&Rules, dbItem);
+}
+
+static void rule_test_runAction
+(
+    void* owner,
+    const swi_mangoh_data_router_ruleAction_t* action
+)
+{
+    NumActions++;
+    if (!action->push)
+    {
+        swi_mangoh_data_router_dbItem_t* dbItem = action->dbItem;
+
+        swi_mangoh_data_router_db_beginUpdate(dbItem);
+        swi_mangoh_data_router_db_setDataType(dbItem, action->value.type);
+        switch (action->value.type)
+        {
+            case DATAROUTER_BOOLEAN:
+                swi_mangoh_data_router_db_setBooleanValue(dbItem, action->value.bValue);
+                break;
+
+            case DATAROUTER_INTEGER:
+                swi_mangoh_data_router_db_setIntegerValue(dbItem, action->value.iValue);
+                break;
+
+            default:
+                swi_mangoh_data_router_db_setFloatValue(dbItem, action->value.fValue);
+                break;
+        }
+        swi_mangoh_data_router_db_setTimestamp(dbItem, 1);
+        swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+        swi_mangoh_data_router_rules_update(&Rules, dbItem);
+    }
+}
+
+// The condition is copied to a buffer of its exact size, so that ASan catches a read past its end
+static le_result_t rule_test_add
+(
+    const char* name,
+    const char* condition,
+    const char* actions
+)
+{
+    char* conditionCopy = strdup(condition);
+    char* actionsCopy = strdup(actions);
+
+    LE_ASSERT(conditionCopy && actionsCopy);
+    le_result_t res =
+        swi_mangoh_data_router_rules_add(&Rules, NULL, name, conditionCopy, actionsCopy);
+    free(conditionCopy);
+    free(actionsCopy);
+    return res;
+}
+
+static void rule_test_malformed
+(
+    void
+)
+{
+    static const char* conditions[] =
+    {
+        "", "(", "((1", "((1)", "(1))", "({a} > 1", "{a", "{}", "{a} >", "{a} > > 1", "!",
+        "-", "1 +", "{a} == \"x", "{a} && ", "{a} || (", "1 2", ")",
+    };
+    static const char* actions[] =
+    {
+        "", "{out}", "{out} =", "{out} = ", "{out} = \"x", "{out} = 1 {b} = 2", "push",
+        "push {", "{out} = 1;;",
+    };
+
+    printf("malformed rules\n");
+    for (uint32_t i = 0; i < NUM_ARRAY_MEMBERS(conditions); i++)
+    {
+        printf("    condition '%s'\n", conditions[i]);
+        RULE_TEST_CHECK(rule_test_add("bad", conditions[i], "{out} = true") == LE_BAD_PARAMETER);
+        NumChecks++;
+    }
+
+    for (uint32_t i = 0; i < NUM_ARRAY_MEMBERS(actions); i++)
+    {
+        printf("    actions '%s'\n", actions[i]);
+        RULE_TEST_CHECK(rule_test_add("bad", "{a} > 1", actions[i]) == LE_BAD_PARAMETER);
+        NumChecks++;
+    }
+
+    RULE_TEST_CHECK(!Rules.numRules);
+}
+
+static void rule_test_fire
+(
+    void
+)
+{
+    printf("rule fires on each false to true transition\n");
+    RULE_TEST_CHECK(rule_test_add("hot", "(({temp} - 2) * 2) > 50 && !({mode} == \"off\")",
+                                  "{fan} = true; push {temp}") == LE_OK);
+    RULE_TEST_CHECK(rule_test_add("hot", "{temp} > 1", "{fan} = true") == LE_DUPLICATE);
+
+    NumActions = 0;
+    rule_test_writeFloat("temp", 20);
+    le_test_RunEvents();
+    RULE_TEST_CHECK(!NumActions);
+
+    rule_test_writeFloat("temp", 30);
+    le_test_RunEvents();
+    RULE_TEST_CHECK(NumActions == 2);
+    RULE_TEST_CHECK(swi_mangoh_data_router_db_getDataItem(&Db, "fan")->data.bValue);
+
+    // Still true, no new action until the condition has been false
+    rule_test_writeFloat("temp", 31);
+    le_test_RunEvents();
+    RULE_TEST_CHECK(NumActions == 2);
+
+    rule_test_writeFloat("temp", 10);
+    rule_test_writeFloat("temp", 40);
+    le_test_RunEvents();
+    RULE_TEST_CHECK(NumActions == 4);
+
+    RULE_TEST_CHECK(swi_mangoh_data_router_rules_remove(&Rules, NULL, "hot") == LE_OK);
+    RULE_TEST_CHECK(swi_mangoh_data_router_rules_remove(&Rules, NULL, "hot") == LE_NOT_FOUND);
+    NumChecks++;
+}
+
+static void rule_test_cycle
+(
+    void
+)
+{
+    printf("rules undoing each other's writes stop after %u passes\n",
+           SWI_MANGOH_DATA_ROUTER_RULE_CHAIN_MAX_NUM);
+    rule_test_writeFloat("x", 2);
+    RULE_TEST_CHECK(rule_test_add("ping", "{x} == 0", "{x} = 1") == LE_OK);
+    RULE_TEST_CHECK(rule_test_add("pong", "{x} == 1", "{x} = 0") == LE_OK);
+
+    NumActions = 0;
+    rule_test_writeFloat("x", 0);
+    le_test_RunEvents();
+    RULE_TEST_CHECK(NumActions == SWI_MANGOH_DATA_ROUTER_RULE_CHAIN_MAX_NUM);
+
+    // The next outside write starts a new chain
+    rule_test_writeFloat("x", 1);
+    le_test_RunEvents();
+    RULE_TEST_CHECK(NumActions == 2 * SWI_MANGOH_DATA_ROUTER_RULE_CHAIN_MAX_NUM);
+
+    RULE_TEST_CHECK(swi_mangoh_data_router_rules_remove(&Rules, NULL, "ping") == LE_OK);
+    RULE_TEST_CHECK(swi_mangoh_data_router_rules_remove(&Rules, NULL, "pong") == LE_OK);
+    NumChecks++;
+}
+
+int main
+(
+    void
+)
+{
+    swi_mangoh_data_router_db_init(&Db);
+    swi_mangoh_data_router_rules_init(&Rules, &Db, rule_test_runAction);
+
+    rule_test_malformed();
+    rule_test_fire();
+    rule_test_cycle();
+
+    printf("rule_test: %u checks passed\n", NumChecks);
+    return EXIT_SUCCESS;
+}
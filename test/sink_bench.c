@@ -0,0 +1,194 @@
+/**
+ * @file
+ *
+ * Push latency and throughput through the socket sink transport of sink.c, without a broker.  The
+ * bench listens on a Unix socket, as a local consumer configured in /Sink/socketPath would, starts
+ * a pushing session and writes float updates through the transport, reading the JSON lines back
+ * after each write.  The latency of an update is from its write to the reception of its line, it
+ * is measured with each update written right away and with the lines queued up to flush bytes.
+ *
+ *   sink_bench [<updates>]
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "db.h"
+#include "sink.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define SINK_BENCH_KEY "bench/sink"
+#define SINK_BENCH_NUM_UPDATES 100000
+#define SINK_BENCH_TIMEOUT_MS 5000
+
+static swi_mangoh_data_router_db_t Db;
+static char SocketPath[SWI_MANGOH_DATA_ROUTER_SINK_PATH_LEN];
+static uint64_t* SentNs;
+static uint64_t* Latencies;
+
+static int sink_bench_compare
+(
+    const void* first,
+    const void* second
+)
+{
+    uint64_t a = *(const uint64_t*)first;
+    uint64_t b = *(const uint64_t*)second;
+
+    return (a > b) - (a < b);
+}
+
+// Reads the lines available on the socket, the value of each line is the index of its update
+static void sink_bench_readLines
+(
+    int fd,
+    int timeoutMs,
+    char* buf,
+    size_t* bufLen,
+    uint32_t* numReceived,
+    uint32_t numUpdates
+)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+    if (poll(&pfd, 1, timeoutMs) <= 0)
+    {
+        return;
+    }
+
+    ssize_t len = recv(fd, &buf[*bufLen], SWI_MANGOH_DATA_ROUTER_SINK_LINE_MAX_LEN - *bufLen,
+                       MSG_DONTWAIT);
+    if (len <= 0)
+    {
+        LE_ASSERT((len < 0) && ((errno == EAGAIN) || (errno == EINTR)));
+        return;
+    }
+
+    uint64_t nowNs = le_test_NowNs();
+    size_t used = *bufLen + len;
+    size_t start = 0;
+    for (size_t i = *bufLen; i < used; i++)
+    {
+        if (buf[i] != '\n')
+        {
+            continue;
+        }
+
+        buf[i] = '\0';
+        const char* value = strstr(&buf[start], "\"value\":");
+        LE_ASSERT(value);
+        uint32_t index = strtoul(value + strlen("\"value\":"), NULL, 10);
+        LE_ASSERT((index < numUpdates) && (*numReceived < numUpdates));
+        Latencies[(*numReceived)++] = (nowNs - SentNs[index]) / 1000;
+        start = i + 1;
+    }
+
+    *bufLen = used - start;
+    LE_ASSERT(*bufLen < SWI_MANGOH_DATA_ROUTER_SINK_LINE_MAX_LEN);
+    memmove(buf, &buf[start], *bufLen);
+}
+
+static void sink_bench_run
+(
+    int listenFd,
+    int32_t flushBytes,
+    uint32_t numUpdates
+)
+{
+    swi_mangoh_data_router_sink_t sink;
+    const swi_mangoh_data_router_transportOps_t* ops = &swi_mangoh_data_router_sinkTransportOps;
+    swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_db_getDataItem(&Db,
+                                                                                    SINK_BENCH_KEY);
+    char buf[SWI_MANGOH_DATA_ROUTER_SINK_LINE_MAX_LEN];
+    size_t bufLen = 0;
+    uint32_t numReceived = 0;
+
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_SINK_CFG_FLUSH_BYTES, flushBytes);
+    swi_mangoh_data_router_sink_init(&sink, SWI_MANGOH_DATA_ROUTER_SINK_TYPE_SOCKET);
+    void* client = ops->start(&sink, "sink_bench", "", "", &Db);
+    LE_ASSERT(client && (sink.fd >= 0));
+    int fd = accept(listenFd, NULL, NULL);
+    LE_ASSERT(fd >= 0);
+
+    uint64_t startNs = le_test_NowNs();
+    for (uint32_t i = 0; i < numUpdates; i++)
+    {
+        swi_mangoh_data_router_db_beginUpdate(dbItem);
+        swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_FLOAT);
+        swi_mangoh_data_router_db_setFloatValue(dbItem, i);
+        swi_mangoh_data_router_db_setTimestamp(dbItem, i);
+        swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+
+        SentNs[i] = le_test_NowNs();
+        LE_ASSERT_OK(ops->write(client, SINK_BENCH_KEY, dbItem));
+        sink_bench_readLines(fd, 0, buf, &bufLen, &numReceived, numUpdates);
+    }
+
+    ops->flush(&sink);
+    while (numReceived < numUpdates)
+    {
+        uint32_t prevReceived = numReceived;
+
+        sink_bench_readLines(fd, SINK_BENCH_TIMEOUT_MS, buf, &bufLen, &numReceived, numUpdates);
+        if (numReceived == prevReceived)
+        {
+            break;
+        }
+    }
+
+    double elapsedSecs = (le_test_NowNs() - startNs) / 1e9;
+    LE_ASSERT(numReceived == numUpdates);
+    qsort(Latencies, numReceived, sizeof(uint64_t), sink_bench_compare);
+    printf("  flush bytes %-6d  %8.0f updates/s  p50 %5llu us  p99 %5llu us  max %6llu us\n",
+           flushBytes,
+           numReceived / elapsedSecs,
+           (unsigned long long)Latencies[numReceived / 2],
+           (unsigned long long)Latencies[numReceived * 99 / 100],
+           (unsigned long long)Latencies[numReceived - 1]);
+
+    ops->end(client);
+    close(fd);
+}
+
+int main
+(
+    int argc,
+    char** argv
+)
+{
+    uint32_t numUpdates = (argc > 1) ? atoi(argv[1]) : SINK_BENCH_NUM_UPDATES;
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+    LE_ASSERT(numUpdates);
+    SentNs = calloc(numUpdates, sizeof(uint64_t));
+    Latencies = calloc(numUpdates, sizeof(uint64_t));
+    LE_ASSERT(SentNs && Latencies);
+
+    swi_mangoh_data_router_db_init(&Db);
+    LE_ASSERT(swi_mangoh_data_router_db_createDataItem(&Db, SINK_BENCH_KEY));
+
+    snprintf(SocketPath, sizeof(SocketPath), "/tmp/sink_bench.%d.sock", (int)getpid());
+    LE_ASSERT(strlen(SocketPath) < sizeof(addr.sun_path));
+    strcpy(addr.sun_path, SocketPath);
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    LE_ASSERT(listenFd >= 0);
+    unlink(SocketPath);
+    LE_ASSERT(!bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) && !listen(listenFd, 1));
+    le_test_SetCfgString(SWI_MANGOH_DATA_ROUTER_SINK_CFG_SOCKET_PATH, SocketPath);
+
+    printf("socket sink push of %u float updates, read back by a local consumer\n", numUpdates);
+    sink_bench_run(listenFd, 0, numUpdates);
+    sink_bench_run(listenFd, 4096, numUpdates);
+
+    close(listenFd);
+    unlink(SocketPath);
+    free(SentNs);
+    free(Latencies);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,250 @@
+/**
+ * @file
+ *
+ * Test of the file and socket sink transports of sink.c on the simulated clock:
+ *
+ * - the updates are appended to the file as JSON lines once the queue holds the flush bytes or on
+ *   the flush timer, each sample of a block on its own line,
+ * - the lines queued while the socket server is not listening are dropped once the queue is full,
+ *   and the queue is written once the server listens,
+ * - the sink is shared by the sessions and closed with the last one.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "db.h"
+#include "sink.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define SINK_TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+#define SINK_TEST_FLUSH_BYTES 256
+#define SINK_TEST_QUEUE_BYTES SWI_MANGOH_DATA_ROUTER_SINK_LINE_MAX_LEN
+#define SINK_TEST_BUF_LEN 4096
+
+static swi_mangoh_data_router_db_t Db;
+static const swi_mangoh_data_router_transportOps_t* Ops = &swi_mangoh_data_router_sinkTransportOps;
+static char FilePath[SWI_MANGOH_DATA_ROUTER_SINK_PATH_LEN];
+static char SocketPath[SWI_MANGOH_DATA_ROUTER_SINK_PATH_LEN];
+static uint32_t NumChecks;
+
+static swi_mangoh_data_router_dbItem_t* sink_test_update
+(
+    const char* key,
+    dataRouter_DataType_t type,
+    double value,
+    const char* sValue,
+    uint32_t timestamp
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_db_getDataItem(&Db, key);
+
+    if (!dbItem)
+    {
+        dbItem = swi_mangoh_data_router_db_createDataItem(&Db, key);
+        LE_ASSERT(dbItem);
+    }
+
+    swi_mangoh_data_router_db_beginUpdate(dbItem);
+    swi_mangoh_data_router_db_setDataType(dbItem, type);
+    switch (type)
+    {
+        case DATAROUTER_INTEGER:
+            swi_mangoh_data_router_db_setIntegerValue(dbItem, value);
+            break;
+
+        case DATAROUTER_STRING:
+            swi_mangoh_data_router_db_setStringValue(dbItem, sValue);
+            break;
+
+        default:
+            swi_mangoh_data_router_db_setFloatValue(dbItem, value);
+            break;
+    }
+    swi_mangoh_data_router_db_setTimestamp(dbItem, timestamp);
+    swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+    return dbItem;
+}
+
+// Reads the whole file, returns its length
+static size_t sink_test_readFile
+(
+    char* buf,
+    size_t len
+)
+{
+    FILE* file = fopen(FilePath, "r");
+
+    if (!file)
+    {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    size_t used = fread(buf, 1, len - 1, file);
+    buf[used] = '\0';
+    fclose(file);
+    return used;
+}
+
+static void sink_test_file
+(
+    void
+)
+{
+    swi_mangoh_data_router_sink_t sink;
+    char buf[SINK_TEST_BUF_LEN];
+    static const double samples[] = { 1.5, 2.5 };
+    static const uint32_t timestamps[] = { 10, 11 };
+
+    printf("file sink lines written on the flush bytes and on the flush timer\n");
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_SINK_CFG_FLUSH_BYTES, SINK_TEST_FLUSH_BYTES);
+    swi_mangoh_data_router_sink_init(&sink, SWI_MANGOH_DATA_ROUTER_SINK_TYPE_FILE);
+    void* client = Ops->start(&sink, "sink_test", "", "", &Db);
+    SINK_TEST_CHECK(client && (sink.fd >= 0));
+
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        sink_test_update("a/temp", DATAROUTER_FLOAT, 21.5, NULL, 1);
+    SINK_TEST_CHECK(Ops->write(client, "a/temp", dbItem) == LE_OK);
+    dbItem = sink_test_update("a/count", DATAROUTER_INTEGER, -3, NULL, 2);
+    SINK_TEST_CHECK(Ops->write(client, "a/count", dbItem) == LE_OK);
+    dbItem = sink_test_update("a/name", DATAROUTER_STRING, 0, "say \"hi\"", 3);
+    SINK_TEST_CHECK(Ops->write(client, "a/name", dbItem) == LE_OK);
+    SINK_TEST_CHECK(!sink_test_readFile(buf, sizeof(buf)) && sink.queueLen);
+
+    le_test_AdvanceClock(SWI_MANGOH_DATA_ROUTER_SINK_FLUSH_INTERVAL_MS);
+    le_test_RunEvents();
+    sink_test_readFile(buf, sizeof(buf));
+    SINK_TEST_CHECK(!strcmp(buf,
+                            "{\"key\":\"a/temp\",\"timestamp\":1,\"value\":21.5}\n"
+                            "{\"key\":\"a/count\",\"timestamp\":2,\"value\":-3}\n"
+                            "{\"key\":\"a/name\",\"timestamp\":3,\"value\":\"say \\\"hi\\\"\"}\n"));
+    SINK_TEST_CHECK(!sink.queueLen);
+
+    // The lines are written once the queue holds more than the flush bytes
+    dbItem = sink_test_update("b/level", DATAROUTER_FLOAT, 0, NULL, 4);
+    size_t fileLen = strlen(buf);
+    uint32_t numLines = 0;
+    do
+    {
+        SINK_TEST_CHECK(sink_test_readFile(buf, sizeof(buf)) == fileLen);
+        SINK_TEST_CHECK(Ops->write(client, "b/level", dbItem) == LE_OK);
+        numLines++;
+    } while (sink.queueLen);
+
+    SINK_TEST_CHECK((numLines > 1) && (sink_test_readFile(buf, sizeof(buf)) > fileLen));
+
+    Ops->writeBatch(client, "b/level", dbItem, samples, timestamps, NUM_ARRAY_MEMBERS(samples));
+    Ops->end(client);
+    sink_test_readFile(buf, sizeof(buf));
+    SINK_TEST_CHECK(strstr(buf,
+                           "{\"key\":\"b/level\",\"timestamp\":10,\"value\":1.5}\n"
+                           "{\"key\":\"b/level\",\"timestamp\":11,\"value\":2.5}\n"));
+    SINK_TEST_CHECK((sink.fd < 0) && (sink.numWritten == 3 + numLines + 2));
+    unlink(FilePath);
+    NumChecks++;
+}
+
+static void sink_test_socket
+(
+    void
+)
+{
+    swi_mangoh_data_router_sink_t sink;
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    char buf[SINK_TEST_BUF_LEN];
+    uint32_t numQueued = 0;
+
+    printf("socket sink lines dropped while the server is not listening\n");
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_SINK_CFG_FLUSH_BYTES, 0);
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_SINK_CFG_QUEUE_BYTES, SINK_TEST_QUEUE_BYTES);
+    swi_mangoh_data_router_sink_init(&sink, SWI_MANGOH_DATA_ROUTER_SINK_TYPE_SOCKET);
+    void* client = Ops->start(&sink, "sink_test", "", "", &Db);
+    SINK_TEST_CHECK(client && (sink.fd < 0));
+
+    swi_mangoh_data_router_dbItem_t* dbItem =
+        sink_test_update("c/temp", DATAROUTER_FLOAT, 19.25, NULL, 5);
+    while (Ops->write(client, "c/temp", dbItem) == LE_OK)
+    {
+        numQueued++;
+    }
+
+    SINK_TEST_CHECK(numQueued && (sink.numDropped == 1) && (Ops->getFill(&sink) > 90));
+    SINK_TEST_CHECK(Ops->write(client, "c/temp", dbItem) == LE_OVERFLOW);
+    SINK_TEST_CHECK(sink.numDropped == 2);
+
+    // The queue is written once the server listens
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    LE_ASSERT(listenFd >= 0);
+    LE_ASSERT(strlen(SocketPath) < sizeof(addr.sun_path));
+    strcpy(addr.sun_path, SocketPath);
+    LE_ASSERT(!bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) && !listen(listenFd, 1));
+
+    le_test_AdvanceClock(SWI_MANGOH_DATA_ROUTER_SINK_FLUSH_INTERVAL_MS);
+    le_test_RunEvents();
+    SINK_TEST_CHECK((sink.fd >= 0) && !sink.queueLen);
+    int fd = accept(listenFd, NULL, NULL);
+    LE_ASSERT(fd >= 0);
+    ssize_t len = recv(fd, buf, sizeof(buf) - 1, MSG_DONTWAIT);
+    LE_ASSERT(len > 0);
+    buf[len] = '\0';
+
+    uint32_t numLines = 0;
+    for (const char* end = buf; (end = strchr(end, '\n')); end++)
+    {
+        numLines++;
+    }
+
+    SINK_TEST_CHECK(numLines == numQueued);
+    const char* line = "{\"key\":\"c/temp\",\"timestamp\":5,\"value\":19.25}\n";
+    SINK_TEST_CHECK(!strncmp(buf, line, strlen(line)));
+
+    // Shared by the sessions, closed with the last one
+    SINK_TEST_CHECK(Ops->start(&sink, "sink_test2", "", "", &Db) == client);
+    Ops->end(client);
+    SINK_TEST_CHECK((sink.fd >= 0) && (sink.numSessions == 1));
+    SINK_TEST_CHECK(Ops->write(client, "c/temp", dbItem) == LE_OK);
+    Ops->end(client);
+    SINK_TEST_CHECK((sink.fd < 0) && !sink.numSessions);
+
+    close(fd);
+    close(listenFd);
+    unlink(SocketPath);
+    NumChecks++;
+}
+
+int main
+(
+    void
+)
+{
+    le_test_SimulateClock();
+    swi_mangoh_data_router_db_init(&Db);
+
+    snprintf(FilePath, sizeof(FilePath), "/tmp/sink_test.%d.sink", (int)getpid());
+    snprintf(SocketPath, sizeof(SocketPath), "/tmp/sink_test.%d.sock", (int)getpid());
+    unlink(FilePath);
+    unlink(SocketPath);
+    le_test_SetCfgString(SWI_MANGOH_DATA_ROUTER_SINK_CFG_FILE_PATH, FilePath);
+    le_test_SetCfgString(SWI_MANGOH_DATA_ROUTER_SINK_CFG_SOCKET_PATH, SocketPath);
+
+    sink_test_file();
+    sink_test_socket();
+
+    printf("sink_test: %u checks passed\n", NumChecks);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,320 @@
+/**
+ * @file
+ *
+ * Store-and-forward throughput of the MQTT spool: a million pushes written while the broker is
+ * down, spooled to disk by mqtt.c, then replayed on reconnect to the stand-in broker.  The pushes
+ * are of the normal class, and a critical push written last is checked to be replayed first.  The
+ * client queues drop the oldest updates, so that every push is spilled to the spool, then a
+ * session with the keep latest queues checks that only the latest update of each key is spooled.
+ *
+ * The pushes are integer updates of SPOOL_BENCH_NUM_KEYS keys in turn, the value counting the
+ * pushes.  The replay runs on the simulated clock at the drain rate, the wall clock time of the
+ * append and of the replay is the cost of the spool and of the MQTT push path on the host.  The
+ * broker checks that every push arrives once and in order, and the replayed segments are checked
+ * to be deleted.
+ *
+ *   spool_bench [<pushes> [<drain rate>]]
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include "broker.h"
+#include "db.h"
+#include "mqtt.h"
+
+#define SPOOL_BENCH_NUM_PUSHES 1000000
+#define SPOOL_BENCH_DRAIN_RATE 100000
+#define SPOOL_BENCH_NUM_KEYS 16
+#define SPOOL_BENCH_MAX_SEGMENTS 4096
+#define SPOOL_BENCH_RECONNECT_MS 1000
+
+#define SPOOL_BENCH_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+static swi_mangoh_data_router_db_t Db;
+static swi_mangoh_data_router_mqtt_t Mqtt;
+static swi_mangoh_data_router_dbItem_t* Items[SPOOL_BENCH_NUM_KEYS];
+static uint64_t NumReceived;
+static uint64_t NumOutOfOrder;
+static uint64_t CriticalReceived = UINT64_MAX;
+static uint64_t NumLatestReceived;
+
+// The inbound updates are not exercised by this benchmark
+void swi_mangoh_data_router_notifySubscribers
+(
+    const char* key,
+    const swi_mangoh_data_router_dbItem_t* dbItem
+)
+{
+}
+
+// Every push is received once, in the order written, the critical push gives the count of the
+// pushes received before it
+static void spool_bench_receive
+(
+    const char* topic,
+    const char* payload
+)
+{
+    if (strstr(topic, "alarm"))
+    {
+        CriticalReceived = NumReceived;
+        return;
+    }
+
+    NumOutOfOrder += (strtoull(payload, NULL, 10) != NumReceived);
+    NumReceived++;
+}
+
+// Only the latest value of each key is received
+static void spool_bench_receiveLatest
+(
+    const char* topic,
+    const char* payload
+)
+{
+    NumOutOfOrder += (strtoull(payload, NULL, 10) < NumReceived - SPOOL_BENCH_NUM_KEYS);
+    NumLatestReceived++;
+}
+
+// Segment files and their size in bytes
+static uint64_t spool_bench_diskUsage
+(
+    const char* dir,
+    uint32_t* numSegments
+)
+{
+    char path[PATH_MAX];
+    struct stat st;
+    uint64_t numBytes = 0;
+    DIR* dirPtr = opendir(dir);
+
+    *numSegments = 0;
+    LE_ASSERT(dirPtr);
+    for (struct dirent* entry = readdir(dirPtr); entry; entry = readdir(dirPtr))
+    {
+        if (strstr(entry->d_name, SWI_MANGOH_DATA_ROUTER_SPOOL_SEGMENT_EXT))
+        {
+            snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+            LE_ASSERT(!stat(path, &st));
+            numBytes += st.st_size;
+            (*numSegments)++;
+        }
+    }
+
+    closedir(dirPtr);
+    return numBytes;
+}
+
+static void spool_bench_removeDir
+(
+    const char* dir
+)
+{
+    char path[PATH_MAX];
+    DIR* dirPtr = opendir(dir);
+
+    if (!dirPtr)
+    {
+        return;
+    }
+
+    for (struct dirent* entry = readdir(dirPtr); entry; entry = readdir(dirPtr))
+    {
+        if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, ".."))
+        {
+            snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+            unlink(path);
+        }
+    }
+
+    closedir(dirPtr);
+    rmdir(dir);
+}
+
+static void spool_bench_push
+(
+    uint32_t count,
+    swi_mangoh_data_router_mqtt_client_t* client
+)
+{
+    swi_mangoh_data_router_dbItem_t* dbItem = Items[count % SPOOL_BENCH_NUM_KEYS];
+
+    swi_mangoh_data_router_db_beginUpdate(dbItem);
+    swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_INTEGER);
+    swi_mangoh_data_router_db_setIntegerValue(dbItem, count);
+    swi_mangoh_data_router_db_setTimestamp(dbItem, 1500000000 + count);
+    swi_mangoh_data_router_db_endUpdate(&Db, dbItem);
+    SPOOL_BENCH_CHECK(swi_mangoh_data_router_mqttWrite(dbItem->key, dbItem, client) == LE_OK);
+}
+
+int main
+(
+    int argc,
+    char** argv
+)
+{
+    uint32_t numPushes = (argc > 1) ? atoi(argv[1]) : SPOOL_BENCH_NUM_PUSHES;
+    uint32_t drainRate = (argc > 2) ? atoi(argv[2]) : SPOOL_BENCH_DRAIN_RATE;
+    char baseDir[] = "/tmp/spool_benchXXXXXX";
+    char spoolDir[sizeof(baseDir) + 16];
+    char classDir[sizeof(spoolDir) + 16];
+    char key[32];
+    uint32_t numSegments = 0;
+    const broker_Stats_t* stats = broker_GetStats();
+
+    LE_ASSERT(mkdtemp(baseDir));
+    snprintf(spoolDir, sizeof(spoolDir), "%s/spool", baseDir);
+    swi_mangoh_data_router_spool_t* spool = &Mqtt.spool[DATAROUTER_PRIORITY_NORMAL];
+
+    le_test_SimulateClock();
+    le_test_SetCfgString(SWI_MANGOH_DATA_ROUTER_MQTT_CFG_SPOOL_PATH, spoolDir);
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_MQTT_CFG_SPOOL_MAX_SEGMENTS,
+                      SPOOL_BENCH_MAX_SEGMENTS);
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_MQTT_CFG_DRAIN_RATE, drainRate);
+    le_test_SetCfgString(SWI_MANGOH_DATA_ROUTER_MQTT_CFG_DROP_POLICY,
+                         SWI_MANGOH_DATA_ROUTER_QUEUE_DROP_OLDEST);
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_MQTT_CFG_RECONNECT_MIN, SPOOL_BENCH_RECONNECT_MS);
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_MQTT_CFG_RECONNECT_MAX, SPOOL_BENCH_RECONNECT_MS);
+    swi_mangoh_data_router_db_init(&Db);
+    for (uint32_t i = 0; i < SPOOL_BENCH_NUM_KEYS; i++)
+    {
+        snprintf(key, sizeof(key), "sensors/node%02u/count", i);
+        Items[i] = swi_mangoh_data_router_db_createDataItem(&Db, key);
+        LE_ASSERT(Items[i]);
+        Items[i]->priority = DATAROUTER_PRIORITY_NORMAL;
+    }
+
+    swi_mangoh_data_router_dbItem_t* alarm =
+        swi_mangoh_data_router_db_createDataItem(&Db, "sensors/alarm");
+    LE_ASSERT(alarm);
+    alarm->priority = DATAROUTER_PRIORITY_CRITICAL;
+
+    broker_SetUp(false);
+    broker_SetMessageHandler(spool_bench_receive);
+    swi_mangoh_data_router_mqtt_client_t* client = swi_mangoh_data_router_mqttSessionStart(
+        "spool_bench", "broker.local", "password", &Mqtt, &Db);
+    LE_ASSERT(client);
+    le_test_RunEvents();
+    SPOOL_BENCH_CHECK(Mqtt.spoolOpen);
+    SPOOL_BENCH_CHECK(!stats->connected);
+
+    printf("%u pushes spooled while the broker is down, replayed at %u/s\n",
+           numPushes, drainRate);
+    uint64_t startNs = le_test_NowNs();
+    for (uint32_t i = 0; i < numPushes; i++)
+    {
+        spool_bench_push(i, client);
+    }
+
+    swi_mangoh_data_router_db_beginUpdate(alarm);
+    swi_mangoh_data_router_db_setDataType(alarm, DATAROUTER_BOOLEAN);
+    swi_mangoh_data_router_db_setBooleanValue(alarm, true);
+    swi_mangoh_data_router_db_setTimestamp(alarm, 1500000000);
+    swi_mangoh_data_router_db_endUpdate(&Db, alarm);
+    SPOOL_BENCH_CHECK(swi_mangoh_data_router_mqttWrite(alarm->key, alarm, client) == LE_OK);
+
+    swi_mangoh_data_router_mqttFlush(&Mqtt);
+    double appendSecs = (le_test_NowNs() - startNs) / 1e9;
+    snprintf(classDir, sizeof(classDir), "%s/normal", spoolDir);
+    uint64_t numBytes = spool_bench_diskUsage(classDir, &numSegments);
+    printf("  append  %8.0f pushes/s  %.1f MB in %u segments, %.1f bytes/push\n",
+           numPushes / appendSecs, numBytes / 1e6, numSegments, (double)numBytes / numPushes);
+    SPOOL_BENCH_CHECK(!stats->numMessages);
+    SPOOL_BENCH_CHECK(!spool->numDroppedSegments);
+    SPOOL_BENCH_CHECK(!swi_mangoh_data_router_spool_isEmpty(
+        &Mqtt.spool[DATAROUTER_PRIORITY_CRITICAL]));
+
+    // Replayed from the connect on, the remaining timers are the reconnect and the flush timers
+    broker_SetUp(true);
+    while (!stats->connected)
+    {
+        SPOOL_BENCH_CHECK(le_test_RunNextTimer(SPOOL_BENCH_RECONNECT_MS));
+    }
+
+    startNs = le_test_NowNs();
+    while (Mqtt.replaying[DATAROUTER_PRIORITY_NORMAL])
+    {
+        SPOOL_BENCH_CHECK(le_test_RunNextTimer(SWI_MANGOH_DATA_ROUTER_MQTT_DRAIN_INTERVAL_MS));
+    }
+
+    double replaySecs = (le_test_NowNs() - startNs) / 1e9;
+    printf("  replay  %8.0f pushes/s  drained in %.1f s simulated, %.1f MB/s to the broker\n",
+           NumReceived / replaySecs, Mqtt.drainMs / 1e3, stats->numBytes / 1e6 / replaySecs);
+
+    SPOOL_BENCH_CHECK(NumReceived == numPushes);
+    SPOOL_BENCH_CHECK(!NumOutOfOrder);
+    SPOOL_BENCH_CHECK(!CriticalReceived);
+    SPOOL_BENCH_CHECK(Mqtt.numDrained == numPushes + 1);
+    SPOOL_BENCH_CHECK(swi_mangoh_data_router_spool_isEmpty(spool));
+    spool_bench_diskUsage(classDir, &numSegments);
+    SPOOL_BENCH_CHECK(numSegments <= 1);
+
+    // Once drained, the pushes go straight to the broker
+    spool_bench_push(numPushes, client);
+    SPOOL_BENCH_CHECK(NumReceived == numPushes + 1);
+    SPOOL_BENCH_CHECK(!NumOutOfOrder);
+
+    // The keep latest queues coalesce the updates of a key before they are spooled
+    le_test_SetCfgString(SWI_MANGOH_DATA_ROUTER_MQTT_CFG_DROP_POLICY,
+                         SWI_MANGOH_DATA_ROUTER_QUEUE_KEEP_LATEST);
+    swi_mangoh_data_router_mqtt_client_t* latest = swi_mangoh_data_router_mqttSessionStart(
+        "spool_bench_latest", "broker.local", "password", &Mqtt, &Db);
+    LE_ASSERT(latest);
+    broker_SetUp(false);
+    broker_Drop();
+    le_test_RunEvents();
+    SPOOL_BENCH_CHECK(!stats->connected);
+
+    uint64_t numSpooled = Mqtt.classStats[DATAROUTER_PRIORITY_NORMAL].numSpooled;
+    for (uint32_t i = 0; i < 100 * SPOOL_BENCH_NUM_KEYS; i++)
+    {
+        spool_bench_push(numPushes + 1 + i, latest);
+    }
+
+    NumReceived = numPushes + 1 + 100 * SPOOL_BENCH_NUM_KEYS;
+    le_test_AdvanceClock(SWI_MANGOH_DATA_ROUTER_MQTT_SPILL_INTERVAL_MS);
+    SPOOL_BENCH_CHECK(!latest->outstandingRequests[DATAROUTER_PRIORITY_NORMAL].numEntries);
+    SPOOL_BENCH_CHECK(Mqtt.classStats[DATAROUTER_PRIORITY_NORMAL].numSpooled ==
+                      numSpooled + SPOOL_BENCH_NUM_KEYS);
+    printf("  coalesced %u pushes of %u keys to %u spooled records\n",
+           100 * SPOOL_BENCH_NUM_KEYS, SPOOL_BENCH_NUM_KEYS, SPOOL_BENCH_NUM_KEYS);
+
+    broker_SetMessageHandler(spool_bench_receiveLatest);
+    broker_SetUp(true);
+    while (!stats->connected)
+    {
+        SPOOL_BENCH_CHECK(le_test_RunNextTimer(SPOOL_BENCH_RECONNECT_MS));
+    }
+
+    le_test_AdvanceClock(SWI_MANGOH_DATA_ROUTER_MQTT_DRAIN_INTERVAL_MS);
+    SPOOL_BENCH_CHECK(NumLatestReceived == SPOOL_BENCH_NUM_KEYS);
+    SPOOL_BENCH_CHECK(!NumOutOfOrder);
+
+    swi_mangoh_data_router_mqttSessionEnd(latest);
+    swi_mangoh_data_router_mqttSessionEnd(client);
+    le_test_RunEvents();
+    for (uint32_t priority = 0; priority < SWI_MANGOH_DATA_ROUTER_PRIORITY_NUM; priority++)
+    {
+        snprintf(classDir, sizeof(classDir), "%s/%s", spoolDir,
+                 swi_mangoh_data_router_priority_getName(priority));
+        spool_bench_removeDir(classDir);
+    }
+
+    spool_bench_removeDir(spoolDir);
+    spool_bench_removeDir(baseDir);
+    return EXIT_SUCCESS;
+}
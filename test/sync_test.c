@@ -0,0 +1,218 @@
+/**
+ * @file
+ *
+ * Test of the full state sync of sync.c on the simulated clock: the snapshots walk the database
+ * key index in slices on the slice timer, pass the items with a value once each, start over when
+ * the index is replaced between two slices, and only pass the items updated since the previous
+ * snapshot when dirty only.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc. Use of this work is subject to license.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "db.h"
+#include "sync.h"
+
+#define SYNC_TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+#define SYNC_TEST_INTERVAL_MS (60 * 1000)
+#define SYNC_TEST_SLICE_ITEMS 16
+#define SYNC_TEST_KEYS_MAX_NUM 256
+#define SYNC_TEST_KEY_MAX_LEN 32
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Items passed by a sync
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t numItems;                    ///< Items passed
+    uint32_t numDone;                     ///< Snapshots completed
+    uint32_t seen[SYNC_TEST_KEYS_MAX_NUM]; ///< Times each key was passed
+} sync_test_snapshot_t;
+
+static uint32_t NumChecks;
+
+static void sync_test_handler
+(
+    const swi_mangoh_data_router_dbItem_t* dbItem,
+    void* context
+)
+{
+    sync_test_snapshot_t* snapshot = context;
+
+    if (!dbItem)
+    {
+        snapshot->numDone++;
+        return;
+    }
+
+    uint32_t key = strtoul(dbItem->key + strlen("sync/"), NULL, 10);
+    LE_ASSERT(key < SYNC_TEST_KEYS_MAX_NUM);
+    snapshot->seen[key]++;
+    snapshot->numItems++;
+}
+
+// Writes a value to each of the keys sync/<first> to sync/<first + num - 1>
+static void sync_test_writeKeys
+(
+    swi_mangoh_data_router_db_t* db,
+    uint32_t first,
+    uint32_t num
+)
+{
+    for (uint32_t i = first; i < first + num; i++)
+    {
+        char key[SYNC_TEST_KEY_MAX_LEN];
+
+        snprintf(key, sizeof(key), "sync/%u", i);
+        swi_mangoh_data_router_dbItem_t* dbItem = swi_mangoh_data_router_db_getDataItem(db, key);
+        if (!dbItem)
+        {
+            dbItem = swi_mangoh_data_router_db_createDataItem(db, key);
+            LE_ASSERT(dbItem);
+        }
+
+        swi_mangoh_data_router_db_beginUpdate(dbItem);
+        swi_mangoh_data_router_db_setDataType(dbItem, DATAROUTER_INTEGER);
+        swi_mangoh_data_router_db_setIntegerValue(dbItem, i);
+        swi_mangoh_data_router_db_setTimestamp(dbItem, i);
+        swi_mangoh_data_router_db_endUpdate(db, dbItem);
+    }
+}
+
+// Runs the timers up to the start of the next snapshot
+static void sync_test_startSnapshot
+(
+    swi_mangoh_data_router_sync_t* sync
+)
+{
+    while (!sync->index)
+    {
+        LE_ASSERT(le_test_RunNextTimer(SYNC_TEST_INTERVAL_MS));
+    }
+}
+
+// Runs the timers up to the end of the next snapshot
+static void sync_test_runSnapshot
+(
+    swi_mangoh_data_router_sync_t* sync
+)
+{
+    sync_test_startSnapshot(sync);
+    while (sync->index)
+    {
+        LE_ASSERT(le_test_RunNextTimer(SWI_MANGOH_DATA_ROUTER_SYNC_SLICE_INTERVAL_MS));
+    }
+}
+
+static void sync_test_slices
+(
+    void
+)
+{
+    static swi_mangoh_data_router_db_t db;
+    static swi_mangoh_data_router_sync_t sync;
+    static sync_test_snapshot_t snapshot;
+    uint32_t numSlices = SWI_MANGOH_DATA_ROUTER_DB_INDEX_INIT_SIZE / SYNC_TEST_SLICE_ITEMS;
+
+    printf("snapshot walked in slices, items without a value skipped\n");
+    swi_mangoh_data_router_db_init(&db);
+    sync_test_writeKeys(&db, 0, 30);
+    LE_ASSERT(swi_mangoh_data_router_db_createDataItem(&db, "sync/100"));
+    swi_mangoh_data_router_sync_init(&sync, &db, sync_test_handler, &snapshot);
+
+    sync_test_startSnapshot(&sync);
+    SYNC_TEST_CHECK(!snapshot.numDone && (snapshot.numItems < 30));
+    for (uint32_t i = 1; i < numSlices; i++)
+    {
+        SYNC_TEST_CHECK(!snapshot.numDone);
+        LE_ASSERT(le_test_RunNextTimer(SWI_MANGOH_DATA_ROUTER_SYNC_SLICE_INTERVAL_MS));
+    }
+
+    SYNC_TEST_CHECK((snapshot.numDone == 1) && (snapshot.numItems == 30));
+    SYNC_TEST_CHECK(!snapshot.seen[100] && (sync.numSnapshots == 1) && !sync.index);
+
+    // Every item goes in each snapshot
+    sync_test_runSnapshot(&sync);
+    SYNC_TEST_CHECK((snapshot.numDone == 2) && (snapshot.numItems == 60));
+
+    // The index is replaced halfway through a snapshot, the walk starts over
+    memset(&snapshot, 0, sizeof(snapshot));
+    sync_test_startSnapshot(&sync);
+    LE_ASSERT(le_test_RunNextTimer(SWI_MANGOH_DATA_ROUTER_SYNC_SLICE_INTERVAL_MS));
+    sync_test_writeKeys(&db, 30, 70);
+    SYNC_TEST_CHECK(sync.index && (sync.index != db.index));
+    while (sync.index)
+    {
+        LE_ASSERT(le_test_RunNextTimer(SWI_MANGOH_DATA_ROUTER_SYNC_SLICE_INTERVAL_MS));
+    }
+
+    SYNC_TEST_CHECK(snapshot.numDone == 1);
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        SYNC_TEST_CHECK(snapshot.seen[i]);
+    }
+
+    NumChecks++;
+}
+
+static void sync_test_dirtyOnly
+(
+    void
+)
+{
+    static swi_mangoh_data_router_db_t db;
+    static swi_mangoh_data_router_sync_t sync;
+    static sync_test_snapshot_t snapshot;
+
+    printf("dirty only snapshots pass the items updated since the previous one\n");
+    le_test_SetCfgString(SWI_MANGOH_DATA_ROUTER_SYNC_CFG_DIRTY_ONLY, "true");
+    swi_mangoh_data_router_db_init(&db);
+    sync_test_writeKeys(&db, 0, 20);
+    swi_mangoh_data_router_sync_init(&sync, &db, sync_test_handler, &snapshot);
+    SYNC_TEST_CHECK(sync.dirtyOnly);
+
+    sync_test_runSnapshot(&sync);
+    SYNC_TEST_CHECK((snapshot.numDone == 1) && (snapshot.numItems == 20));
+
+    sync_test_writeKeys(&db, 5, 3);
+    memset(&snapshot, 0, sizeof(snapshot));
+    sync_test_runSnapshot(&sync);
+    SYNC_TEST_CHECK((snapshot.numDone == 1) && (snapshot.numItems == 3));
+    SYNC_TEST_CHECK(snapshot.seen[5] && snapshot.seen[6] && snapshot.seen[7]);
+
+    // Nothing updated, the snapshot is empty but still completed
+    memset(&snapshot, 0, sizeof(snapshot));
+    sync_test_runSnapshot(&sync);
+    SYNC_TEST_CHECK((snapshot.numDone == 1) && !snapshot.numItems);
+    NumChecks++;
+}
+
+int main
+(
+    void
+)
+{
+    le_test_SimulateClock();
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_SYNC_CFG_INTERVAL, SYNC_TEST_INTERVAL_MS / 60000);
+    le_test_SetCfgInt(SWI_MANGOH_DATA_ROUTER_SYNC_CFG_SLICE_ITEMS, SYNC_TEST_SLICE_ITEMS);
+
+    sync_test_slices();
+    sync_test_dirtyOnly();
+
+    printf("sync_test: %u checks passed\n", NumChecks);
+    return EXIT_SUCCESS;
+}